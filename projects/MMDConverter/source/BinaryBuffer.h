@@ -0,0 +1,96 @@
+﻿/**
+ *  @brief  メモリ上のバイナリバッファ (キャッシュやファイル出力用のシリアライズ).
+ *  @date   2026.10.19
+ */
+
+#ifndef _BINARYBUFFER_H
+#define _BINARYBUFFER_H
+
+#include "GlobalHeader.h"
+
+#include <vector>
+#include <string>
+#include <string.h>
+
+/**
+ * 書き込み/読み込みを行うバイナリバッファ.
+ * stream_interfaceと同じく、書き込みはリトルエンディアンの生データをそのまま格納する.
+ */
+class CBinaryBuffer
+{
+private:
+	std::vector<unsigned char> m_data;		///< データ.
+	size_t m_readPos;						///< 読み込み位置.
+
+public:
+	CBinaryBuffer() : m_readPos(0) { }
+
+	void Clear() {
+		m_data.clear();
+		m_readPos = 0;
+	}
+
+	/**
+	 * 書き込みバッファの確保 (サイズが分かっている場合に、再確保を避ける).
+	 */
+	void Reserve(const size_t size) { m_data.reserve(size); }
+
+	size_t GetSize() const { return m_data.size(); }
+	const unsigned char* GetData() const { return m_data.empty() ? NULL : &(m_data[0]); }
+	std::vector<unsigned char>& GetBuffer() { return m_data; }
+
+	/**
+	 * 書き込み.
+	 */
+	void Write(const size_t size, const void* data) {
+		if (size == 0) return;
+		const size_t pos = m_data.size();
+		m_data.resize(pos + size);
+		memcpy(&(m_data[pos]), data, size);
+	}
+	void WriteInt(const int v) { Write(sizeof(int), &v); }
+	void WriteFloat(const float v) { Write(sizeof(float), &v); }
+
+	/**
+	 * 指定サイズの領域を末尾に追加し、その先頭を返す (呼び出し側で直接書き込む場合用).
+	 * 次の書き込みまでの間のみ有効.
+	 */
+	unsigned char* Append(const size_t size) {
+		const size_t pos = m_data.size();
+		m_data.resize(pos + size);
+		return (size == 0) ? NULL : &(m_data[pos]);
+	}
+
+	/**
+	 * 要素数と要素を書き込み (要素はPOD型であること).
+	 */
+	template<typename T> void WriteVector(const std::vector<T>& v) {
+		WriteInt((int)v.size());
+		if (!v.empty()) Write(sizeof(T) * v.size(), &(v[0]));
+	}
+
+	/**
+	 * 読み込み (バッファが足りない場合はfalse).
+	 */
+	bool Read(const size_t size, void* data) {
+		if (m_readPos + size > m_data.size()) return false;
+		if (size > 0) memcpy(data, &(m_data[m_readPos]), size);
+		m_readPos += size;
+		return true;
+	}
+	bool ReadInt(int& v) { return Read(sizeof(int), &v); }
+	bool ReadFloat(float& v) { return Read(sizeof(float), &v); }
+
+	template<typename T> bool ReadVector(std::vector<T>& v) {
+		int cou = 0;
+		if (!ReadInt(cou) || cou < 0) return false;
+		if (m_readPos + sizeof(T) * (size_t)cou > m_data.size()) return false;
+		v.resize(cou);
+		return (cou == 0) ? true : Read(sizeof(T) * cou, &(v[0]));
+	}
+
+	void SetReadPos(const size_t pos) { m_readPos = pos; }
+	size_t GetReadPos() const { return m_readPos; }
+};
+
+#endif
@@ -0,0 +1,241 @@
+﻿/**
+ *  @brief  エクスポート処理のバックグラウンド実行と進捗.
+ *  @date   2026.10.19
+ */
+
+#include "ExportTask.h"
+
+#include <chrono>
+#include <algorithm>
+
+#if SXWINDOWS
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <ApplicationServices/ApplicationServices.h>
+#endif
+
+#define EXPORT_TASK_POLL_MSEC		100		///< メインスレッドで進捗を確認する間隔 (ミリ秒).
+
+//---------------------------------------------------------------------------------------.
+
+CExportProgress::CExportProgress() : m_step(0), m_stepCount(0), m_canceled(false)
+{
+}
+
+/**
+ * 全体のステップ数を追加.
+ */
+void CExportProgress::AddStepCount(const int count)
+{
+	m_stepCount += count;
+}
+
+/**
+ * ステップを1つ進める.
+ */
+bool CExportProgress::Step()
+{
+	m_step++;
+	return !m_canceled;
+}
+
+/**
+ * 進捗 (0 - 100).
+ */
+int CExportProgress::GetPercent() const
+{
+	const int stepCount = m_stepCount;
+	if (stepCount <= 0) return 0;
+	const int step = std::min((int)m_step, stepCount);
+	return (step * 100) / stepCount;
+}
+
+//---------------------------------------------------------------------------------------.
+
+std::atomic<CExportTask *> CExportTask::s_pRunningTask(NULL);
+std::thread::id CExportTask::s_mainThreadID;
+
+CExportTask::CExportTask(sxsdk::shade_interface& shade, const std::string& title) : m_shade(shade), m_title(title)
+{
+	m_finished = false;
+}
+
+CExportTask::~CExportTask()
+{
+}
+
+/**
+ * funcをワーカースレッドで実行し、完了するまでメインスレッドで進捗の表示とShade 3Dの呼び出しの代行を行う.
+ */
+bool CExportTask::Run(const std::function<bool(CExportProgress&)>& func)
+{
+	// 入れ子で呼ばれた場合は、そのまま実行.
+	if (s_pRunningTask) return func(m_progress);
+
+	s_mainThreadID = std::this_thread::get_id();
+	m_finished = false;
+	s_pRunningTask = this;
+
+	// ワーカーで発生した例外は、メインスレッドでメッセージに出す (キャンセルと区別する).
+	bool result = false;
+	std::exception_ptr error;
+	std::thread worker([this, &func, &result, &error]() {
+		try {
+			result = func(m_progress);
+		} catch (...) {
+			error  = std::current_exception();
+			result = false;
+		}
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_finished = true;
+		m_cond.notify_all();
+	});
+
+#if SXWINDOWS
+	m_shade.message(m_shade.gettext("msg_export_cancel_key"));
+#endif
+
+	int lastPercent = 0;
+	while (true) {
+		bool finished = false;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_cond.wait_for(lock, std::chrono::milliseconds(EXPORT_TASK_POLL_MSEC), [this]() { return m_finished || !m_hostCalls.empty(); });
+			finished = m_finished;
+		}
+		m_RunHostCalls();
+		if (finished) break;
+
+		// 進捗は10%ごとに表示.
+		const int percent = m_progress.GetPercent();
+		if (percent / 10 != lastPercent / 10) {
+			m_ShowProgress(percent);
+			lastPercent = percent;
+		}
+
+		if (!m_progress.IsCanceled() && m_IsCancelKeyDown()) m_progress.Cancel();
+		m_ProcessPaintMessages();
+	}
+	worker.join();
+	s_pRunningTask = NULL;
+
+	if (error) {
+		m_ShowError(error);
+		return false;
+	}
+	if (m_progress.IsCanceled()) {
+		m_shade.message(m_shade.gettext("msg_export_canceled"));
+		return false;
+	}
+	return result;
+}
+
+/**
+ * 呼び出し待ちの処理をすべて実行.
+ */
+void CExportTask::m_RunHostCalls()
+{
+	while (true) {
+		HOST_CALL* pCall = NULL;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_hostCalls.empty()) break;
+			pCall = m_hostCalls.front();
+			m_hostCalls.pop_front();
+		}
+
+		try {
+			(*(pCall->pFunc))();
+		} catch (...) {
+			pCall->error = std::current_exception();
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		pCall->done = true;
+		m_cond.notify_all();
+	}
+}
+
+/**
+ * Shade 3Dの呼び出しを、メインスレッドで行う.
+ */
+void CExportTask::CallOnMainThread(const std::function<void()>& func)
+{
+	CExportTask* pTask = s_pRunningTask;
+	if (!pTask || std::this_thread::get_id() == s_mainThreadID) {
+		func();
+		return;
+	}
+
+	HOST_CALL call;
+	call.pFunc = &func;
+	{
+		std::unique_lock<std::mutex> lock(pTask->m_mutex);
+		pTask->m_hostCalls.push_back(&call);
+		pTask->m_cond.notify_all();
+		pTask->m_cond.wait(lock, [&call]() { return call.done; });
+	}
+	if (call.error) std::rethrow_exception(call.error);
+}
+
+/**
+ * 進捗を表示.
+ */
+void CExportTask::m_ShowProgress(const int percent)
+{
+	char szStr[512];
+	snprintf(szStr, sizeof(szStr), m_shade.gettext("msg_export_progress"), m_title.c_str(), percent);
+	m_shade.message(szStr);
+}
+
+/**
+ * ワーカーで発生した例外をメッセージに出す.
+ */
+void CExportTask::m_ShowError(const std::exception_ptr& error)
+{
+	std::string str = m_title + std::string(" : ") + m_shade.gettext("msg_export_error");
+	try {
+		std::rethrow_exception(error);
+	} catch (const std::exception& e) {
+		str += std::string(" (") + e.what() + std::string(")");
+	} catch (...) { }
+	m_shade.message(str.c_str());
+}
+
+/**
+ * キャンセルのキー(Esc)が押されたか.
+ * Windowsでは、Shade 3Dのウィンドウがアクティブな場合のみ判定する.
+ * Macでは、SDKに中断の問い合わせがないため、キーボードの状態を直接参照する
+ * (アクティブなアプリケーションは判定しない. ApplicationServicesのリンクが必要).
+ */
+bool CExportTask::m_IsCancelKeyDown()
+{
+#if SXWINDOWS
+	HWND hWnd = ::GetForegroundWindow();
+	if (!hWnd) return false;
+	DWORD processID = 0;
+	::GetWindowThreadProcessId(hWnd, &processID);
+	if (processID != ::GetCurrentProcessId()) return false;
+	return (::GetAsyncKeyState(VK_ESCAPE) & 0x8000) != 0;
+#elif defined(__APPLE__)
+	const CGKeyCode escapeKeyCode = 0x35;		// kVK_Escape.
+	return CGEventSourceKeyState(kCGEventSourceStateCombinedSessionState, escapeKeyCode);
+#else
+	return false;
+#endif
+}
+
+/**
+ * 待機中に、ホストのウィンドウの再描画のみ行う.
+ * 入力メッセージは処理しないため、エクスポート中にシーンが変更されることはない.
+ * Windowsのみ. Macではイベントループを回せないため、完了までウィンドウは再描画されない.
+ */
+void CExportTask::m_ProcessPaintMessages()
+{
+#if SXWINDOWS
+	MSG msg;
+	while (::PeekMessage(&msg, NULL, WM_PAINT, WM_PAINT, PM_REMOVE)) {
+		::DispatchMessage(&msg);
+	}
+#endif
+}
@@ -0,0 +1,152 @@
+﻿/**
+ *  @brief  エクスポート処理のバックグラウンド実行と進捗.
+ *  @date   2026.10.19
+ */
+
+#ifndef _EXPORTTASK_H
+#define _EXPORTTASK_H
+
+#include "GlobalHeader.h"
+
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <exception>
+
+/*
+	エクスポートは、以下の順に処理する.
+	  1. メインスレッドで、シーンからスナップショットを取得 (CModelSnapshot/CMotionSnapshot).
+	  2. CExportTask::Runで、変換/テクスチャのエンコードと保存/出力バッファの作成をワーカースレッドで行う.
+	     この間メインスレッドは、進捗の表示とキャンセルの確認、ワーカーからのShade 3Dの呼び出しの代行を行う.
+	     do_exportの中で待機するため、メインスレッドは完了までブロックされる
+	     (Windowsでは待機中にウィンドウの再描画のみ行う. Macでは再描画されない).
+	  3. メインスレッドで、出力バッファをstreamに書き込む.
+
+	Shade 3Dの関数 (encode/decode/divide_polygonなど) はメインスレッドから呼ぶ必要があるため、
+	ワーカースレッドからはCExportTask::CallOnMainThreadを経由して呼ぶ.
+	CExportTask::Runの実行中でない場合は、呼び出し元でそのまま実行される.
+*/
+
+/**
+ * エクスポートの進捗とキャンセル要求.
+ * 進捗はワーカースレッドから進め、メインスレッドから参照する.
+ */
+class CExportProgress
+{
+private:
+	std::atomic<int> m_step;					///< 完了したステップ数.
+	std::atomic<int> m_stepCount;				///< 全体のステップ数.
+	std::atomic<bool> m_canceled;				///< キャンセル要求.
+
+public:
+	CExportProgress();
+
+	/**
+	 * 全体のステップ数を追加.
+	 */
+	void AddStepCount(const int count);
+
+	/**
+	 * ステップを1つ進める.
+	 * @return キャンセルされている場合はfalse.
+	 */
+	bool Step();
+
+	/**
+	 * キャンセルを要求 (任意のスレッドから呼ぶことができる).
+	 */
+	void Cancel() { m_canceled = true; }
+	bool IsCanceled() const { return m_canceled; }
+
+	/**
+	 * 進捗 (0 - 100).
+	 */
+	int GetPercent() const;
+};
+
+/**
+ * 重い処理をワーカースレッドで実行するクラス.
+ */
+class CExportTask
+{
+private:
+	/**
+	 * ワーカースレッドからの、メインスレッドでの呼び出し要求.
+	 */
+	class HOST_CALL {
+	public:
+		const std::function<void()>* pFunc;
+		bool done;
+		std::exception_ptr error;
+
+		HOST_CALL() {
+			pFunc = NULL;
+			done  = false;
+		}
+	};
+
+	sxsdk::shade_interface& m_shade;
+	std::string m_title;						///< 進捗表示での見出し (出力ファイル名).
+	CExportProgress m_progress;
+
+	std::mutex m_mutex;
+	std::condition_variable m_cond;
+	std::deque<HOST_CALL *> m_hostCalls;		///< メインスレッドでの呼び出し待ち.
+	bool m_finished;							///< ワーカーの処理が完了したか.
+
+	static std::atomic<CExportTask *> s_pRunningTask;	///< Runの実行中のタスク.
+	static std::thread::id s_mainThreadID;				///< Runを呼んだスレッド.
+
+	/**
+	 * 呼び出し待ちの処理をすべて実行 (メインスレッド).
+	 */
+	void m_RunHostCalls();
+
+	/**
+	 * 進捗を表示 (メインスレッド).
+	 */
+	void m_ShowProgress(const int percent);
+
+	/**
+	 * ワーカーで発生した例外をメッセージに出す (メインスレッド).
+	 */
+	void m_ShowError(const std::exception_ptr& error);
+
+	/**
+	 * キャンセルのキー(Esc)が押されたか (Windows/Mac).
+	 */
+	bool m_IsCancelKeyDown();
+
+	/**
+	 * 待機中に、ホストのウィンドウの再描画のみ行う (Windowsのみ).
+	 */
+	void m_ProcessPaintMessages();
+
+public:
+	/**
+	 * @param[in] title   進捗表示での見出し.
+	 */
+	CExportTask(sxsdk::shade_interface& shade, const std::string& title);
+	virtual ~CExportTask();
+
+	CExportProgress& GetProgress() { return m_progress; }
+
+	/**
+	 * funcをワーカースレッドで実行し、完了するまでメインスレッドで進捗の表示とShade 3Dの呼び出しの代行を行う.
+	 * funcはシーンの参照を持たないこと.
+	 * funcで例外が発生した場合は、エラーとしてメッセージに出す.
+	 * @return funcの戻り値。キャンセルされた場合、例外が発生した場合はfalse.
+	 */
+	bool Run(const std::function<bool(CExportProgress&)>& func);
+
+	/**
+	 * Shade 3Dの呼び出しを、メインスレッドで行う.
+	 * ワーカースレッドから呼ばれた場合は、メインスレッドで実行されるまで待つ.
+	 */
+	static void CallOnMainThread(const std::function<void()>& func);
+};
+
+#endif
@@ -5,6 +5,13 @@
 
 #include "FacialSkin.h"
 #include "Util.h"
+#include "StageCache.h"
+#include "VertexTransform.h"
+
+#include <map>
+#include <tuple>
+#include <algorithm>
+#include <math.h>
 
 namespace {
 	// 表情名の変換一覧.
@@ -29,19 +36,20 @@ namespace {
 
 		{""           , ""}
 	};
+
+	// 表情の移動量を比較する際の量子化の単位 (出力時の座標系).
+	const float g_skinDeltaQuantum = 1e-5f;
 }
 
 CFacialSkin::CFacialSkin(sxsdk::shade_interface* shade)
 {
 	m_shade = shade;
 
-	m_skinTypeName.push_back("base");
-	m_skinTypeName.push_back("eyebrow");
-	m_skinTypeName.push_back("eye");
-	m_skinTypeName.push_back("mouth");
-	m_skinTypeName.push_back("other");
 	m_pBSPSearch = NULL;
 	m_scale = 0.01f;
+	m_pThreadPool = NULL;
+	m_duplicateSkinCount = 0;
+	m_emptySkinCount     = 0;
 }
 
 CFacialSkin::~CFacialSkin()
@@ -56,156 +64,98 @@ void CFacialSkin::Clear()
 {
 	m_faceSkinData.clear();
 	m_skinGroupIndex.clear();
+	m_meshVertices.clear();
+	m_duplicateSkinCount = 0;
+	m_emptySkinCount     = 0;
 	if (m_pBSPSearch) delete m_pBSPSearch;
 	m_pBSPSearch = NULL;
 }
 
 /**
- * skinのパートを探す.
+ * 表情データを直接指定 (キャッシュファイルからの復元用).
  */
-sxsdk::shape_class* CFacialSkin::m_GetSkinPart(sxsdk::scene_interface* scene)
+void CFacialSkin::SetSkinData(const std::vector<FACE_SKIN_DATA>& skinData, const std::vector<int>& skinGroupIndex, const float scale)
 {
-	sxsdk::shape_class& rootShape = scene->get_shape();
-	if (!rootShape.has_son()) return NULL;
-
-	sxsdk::shape_class* pRetSkinShape = NULL;
-	sxsdk::shape_class* pShape = rootShape.get_son();
-	while (pShape->has_bro()) {
-		pShape = pShape->get_bro();
-		if (strcmp(pShape->get_name(), "skin") == 0) {
-			pRetSkinShape = pShape;
-			break;
-		}
-	}
-
-	return pRetSkinShape;
-}
-
-/**
- * 指定のSkinTypeのパートを探す.
- */
-sxsdk::shape_class* CFacialSkin::m_GetSkinTypePart(sxsdk::shape_class* pSkinPart, const int skinType)
-{
-	if (!(pSkinPart->has_son())) return NULL;
-	if (skinType < 0 || skinType >= m_skinTypeName.size()) return NULL;
-
-	sxsdk::shape_class* pRetShape = NULL;
-	sxsdk::shape_class* pShape = pSkinPart->get_son();
-	while (pShape->has_bro()) {
-		pShape = pShape->get_bro();
-		if (strcmp(pShape->get_name(), m_skinTypeName[skinType].c_str()) == 0) {
-			pRetShape = pShape;
-			break;
-		}
-	}
-
-	return pRetShape;
+	Clear();
+	m_faceSkinData   = skinData;
+	m_skinGroupIndex = skinGroupIndex;
+	m_scale          = scale;
 }
 
 /**
- * 指定の形状のメッシュ情報を格納.
+ * スナップショットから、face skin用のメッシュ情報を格納.
+ * 表情の種類ごとに、先頭のポリゴンメッシュがbaseとなる.
  */
-bool CFacialSkin::m_AddMesh(sxsdk::shape_class* pShape, const int skinType, FACE_SKIN_DATA& skinData, const bool firstF)
+bool CFacialSkin::SetSnapshot(const CModelSnapshot& snapshot, const float scale)
 {
-	if (pShape->get_type() != sxsdk::enums::polygon_mesh) return false;
-
-	sxsdk::polygon_mesh_class& pmesh = pShape->get_polygon_mesh();
-	const int verCou = pmesh.get_total_number_of_control_points();
-	if (verCou <= 0) return false;
-
-	skinData.name   = pShape->get_name();
-	skinData.pShape = pShape;
-	skinData.type   = skinType;
-	skinData.v_data.clear();
-	skinData.baseSkin = firstF;
-
-	const sxsdk::mat4 lwMat = pShape->get_local_to_world_matrix();
+	Clear();
+	m_scale = scale;
+	if (snapshot.morphs.empty() && snapshot.morphGroupIndex.empty()) return false;
 
-	FACE_SKIN_VERTEX_DATA vData;
-	for (int i = 0; i < verCou; i++) {
-		sxsdk::vertex_class& v = pmesh.vertex(i);
-		vData.pos = v.get_position() * lwMat;
+	// 対象のポリゴンメッシュの頂点 (BSPの空間は、m_GetNearVertexで必要になった時点で作成する).
+	m_meshVertices = snapshot.positions;
 
-		if (firstF) {
-			// オリジナルの頂点番号を取得.
-			vData.vert_index = m_GetNearVertex(vData.pos);
+	// 表情ごとの、同じ種類の先頭(base)の番号.
+	const std::vector<SNAPSHOT_MORPH>& morphs = snapshot.morphs;
+	const int mCou = morphs.size();
+	std::vector<int> morphBaseIndex(mCou, -1);
+	{
+		int baseIndex = -1;
+		for (int i = 0; i < mCou; i++) {
+			if (morphs[i].base_skin) baseIndex = i;
+			if (baseIndex >= 0 && morphs[baseIndex].type == morphs[i].type) morphBaseIndex[i] = baseIndex;
 		}
-
-		skinData.v_data.push_back(vData);
 	}
 
-	return true;
-}
+	// 表情ごとに、ワールド座標への変換と頂点数の判定を並列に行う.
+	// baseと頂点数が異なる表情は出力しない.
+	std::vector<FACE_SKIN_DATA> skins(mCou);
+	std::vector<char> validList(mCou, 0);
+	auto convertMorph = [&morphs, &morphBaseIndex, &skins, &validList](int i) {
+		const SNAPSHOT_MORPH& morph = morphs[i];
+		const int baseIndex = morphBaseIndex[i];
+		if (baseIndex < 0 || morphs[baseIndex].positions.Size() != morph.positions.Size()) return;
+
+		FACE_SKIN_DATA& skinData = skins[i];
+		skinData.name     = morph.name;
+		skinData.type     = morph.type;
+		skinData.baseSkin = morph.base_skin;
+		skinData.ResizeVertices(morph.positions.Size());
+		skinData.pos = morph.positions;
+		VertexTransform::TransformPositions(skinData.pos, morph.local_to_world);
+		validList[i] = 1;
+	};
+	if (m_pThreadPool) {
+		m_pThreadPool->ParallelFor(0, mCou, convertMorph);
+	} else {
+		for (int i = 0; i < mCou; i++) convertMorph(i);
+	}
 
-/**
- * 現在のシーンから、face skin用のメッシュ情報を取得.
- */
-bool CFacialSkin::StoreSkinData(sxsdk::scene_interface* scene, sxsdk::shape_class *pTargetMesh, const float scale)
-{
-	Clear();
-	m_scale = scale;
+	// 有効な表情を、種類ごとにbaseを先頭として格納.
+	m_faceSkinData.reserve(mCou);
+	for (int i = 0; i < mCou; i++) {
+		if (!validList[i]) continue;
+		if (skins[i].baseSkin) m_skinGroupIndex.push_back(m_faceSkinData.size());
+		m_faceSkinData.push_back(FACE_SKIN_DATA());
+		std::swap(m_faceSkinData.back(), skins[i]);
+	}
 
-	// [skin]のパートを取得.
-	sxsdk::shape_class* skinPart = m_GetSkinPart(scene);
-	if (!skinPart) return false;
-
-	// BSPの作成.
-	if (!m_SetMeshVertices(pTargetMesh)) return false;
-
-	// 各skin用パートを取得し、その中のポリゴンメッシュを格納.
-	for (int loop = 1; loop < m_skinTypeName.size(); loop++) {
-		sxsdk::shape_class* pTypePart = m_GetSkinTypePart(skinPart, loop);
-		if (!pTypePart || !(pTypePart->has_son())) continue;
-
-		const int skinIndex = m_faceSkinData.size();
-		bool firstF = true;
-		FACE_SKIN_DATA skinData;
-		sxsdk::shape_class *pShape = pTypePart->get_son();
-		while (pShape->has_bro()) {
-			pShape = pShape->get_bro();
-			if (m_AddMesh(pShape, loop, skinData, firstF)) {
-				if (!firstF) {		// m_faceSkinData[skinIndex] での頂点数と同じ数である必要がある.
-					if (m_faceSkinData[skinIndex].v_data.size() != skinData.v_data.size()) continue;
-				}
-				m_faceSkinData.push_back(skinData);
-			}
-			firstF = false;
-		}
-		if (!firstF) {
-			m_skinGroupIndex.push_back(skinIndex);
-		}
+	// baseの表情のみ、オリジナルの頂点番号を取得 (頂点の検索は、m_MatchBaseVertices内で並列に行う).
+	for (int i = 0; i < m_skinGroupIndex.size(); i++) {
+		m_MatchBaseVertices(m_faceSkinData[m_skinGroupIndex[i]]);
 	}
 
 	return true;
 }
 
 /**
- * 指定のポリゴンメッシュの頂点を取得し、BSPの空間に格納.
+ * BSPの空間を作成.
  */
-bool CFacialSkin::m_SetMeshVertices(sxsdk::shape_class* pShape)
+void CFacialSkin::m_BuildBSPSearch()
 {
-	if (pShape->get_type() != sxsdk::enums::polygon_mesh) return false;
-
-	if (m_pBSPSearch) delete m_pBSPSearch;
-	m_pBSPSearch = NULL;
-
-	std::vector<sxsdk::vec3> vers;
-
-	sxsdk::polygon_mesh_class& pmesh = pShape->get_polygon_mesh();
-	const int verCou = pmesh.get_total_number_of_control_points();
-	if (verCou <= 0) return false;
-	const sxsdk::mat4 lwMat = pShape->get_local_to_world_matrix();
-
-	vers.resize(verCou);
-	for (int i = 0; i < verCou; i++) {
-		vers[i] = pmesh.vertex(i).get_position() * lwMat;
-	}
-
-	// BSPの作成.
-	m_pBSPSearch = new CBSPSearch(vers);
+	if (m_pBSPSearch || m_meshVertices.empty()) return;
+	m_pBSPSearch = new CBSPSearch(m_meshVertices);
 	m_pBSPSearch->build();
-
-	return true;
 }
 
 /**
@@ -213,6 +163,7 @@ bool CFacialSkin::m_SetMeshVertices(sxsdk::shape_class* pShape)
  */
 int CFacialSkin::m_GetNearVertex(sxsdk::vec3& pos, const float dist)
 {
+	m_BuildBSPSearch();
 	if (!m_pBSPSearch) return -1;
 
 	std::vector<int> indices;
@@ -233,31 +184,80 @@ int CFacialSkin::m_GetNearVertex(sxsdk::vec3& pos, const float dist)
 	return minIndex;
 }
 
+/**
+ * baseの表情の頂点に、対象のポリゴンメッシュの頂点番号を割り当てる.
+ */
+void CFacialSkin::m_MatchBaseVertices(FACE_SKIN_DATA& skinData)
+{
+	const int vCou = skinData.GetVerticesCount();
+	if (vCou == 0) return;
+
+	uint64_t key = 0;
+	if (!m_meshVertices.empty()) key = Util::CalcHash(&(m_meshVertices[0]), sizeof(sxsdk::vec3) * m_meshVertices.size());
+	key = Util::CalcHash(&(skinData.pos.x[0]), sizeof(float) * vCou, key);
+	key = Util::CalcHash(&(skinData.pos.y[0]), sizeof(float) * vCou, key);
+	key = Util::CalcHash(&(skinData.pos.z[0]), sizeof(float) * vCou, key);
+
+	{
+		std::vector<int> indices;
+		CBinaryBuffer buff;
+		if (StageCache::Load("facial_base_match", key, buff) && buff.ReadVector(indices) && indices.size() == vCou) {
+			skinData.vert_index.swap(indices);
+			return;
+		}
+	}
+
+	// BSPを先に作成しておき、各頂点の検索は並列に行う.
+	m_BuildBSPSearch();
+	auto matchVertex = [this, &skinData](int i) {
+		sxsdk::vec3 pos = skinData.pos.Get(i);
+		skinData.vert_index[i] = m_GetNearVertex(pos);
+	};
+	if (m_pThreadPool) {
+		m_pThreadPool->ParallelFor(0, vCou, matchVertex, 256);
+	} else {
+		for (int i = 0; i < vCou; i++) matchVertex(i);
+	}
+
+	CBinaryBuffer buff;
+	buff.WriteVector(skinData.vert_index);
+	StageCache::Store("facial_base_match", key, buff);
+}
+
 /**
  * 頂点の最適化の反映（法線/UVの違いで頂点が増える場合）.
  */
-void CFacialSkin::UpdateVertices(std::vector< std::vector<int> >& sameVertexList)
+void CFacialSkin::UpdateVertices(const std::vector<int>& sameOffsets, const std::vector<int>& sameIndices)
 {
-	if (m_faceSkinData.size() == 0) return;
+	if (m_faceSkinData.size() == 0 || sameOffsets.empty()) return;
+	const int orgVCou = (int)sameOffsets.size() - 1;
 
 	// baseの頂点を増加.
+	// 増加後の頂点数を先に求めて確保し、元の頂点ごとに増加した頂点を末尾に並べる.
 	for (int loop = 0; loop < m_faceSkinData.size(); loop++) {
 		FACE_SKIN_DATA& skinData = m_faceSkinData[loop];
 		if (!skinData.baseSkin) continue;
 		
-		const int vCou = skinData.v_data.size();
-		FACE_SKIN_VERTEX_DATA vData2;
+		const int vCou = skinData.GetVerticesCount();
+		int addCou = 0;
+		for (int i = 0; i < vCou; i++) {
+			const int vIndex = skinData.vert_index[i];
+			if (vIndex >= 0 && vIndex < orgVCou) addCou += sameOffsets[vIndex + 1] - sameOffsets[vIndex];
+		}
+		if (addCou == 0) continue;
+
+		skinData.ResizeVertices(vCou + addCou);
+		CVec3ArraySoA& pos = skinData.pos;
+		int iPos = vCou;
 		for (int i = 0; i < vCou; i++) {
-			FACE_SKIN_VERTEX_DATA& vData = skinData.v_data[i];
-			std::vector<int>& vSameList  = sameVertexList[vData.vert_index];
-
-			if (vSameList.size() > 0) {
-				for (int j = 0; j < vSameList.size(); j++) {
-					vData2.pos            = vData.pos;
-					vData2.vert_index     = vSameList[j];
-					vData2.org_i          = i;
-					skinData.v_data.push_back(vData2);
-				}
+			const int vIndex = skinData.vert_index[i];
+			if (vIndex < 0 || vIndex >= orgVCou) continue;
+			for (int j = sameOffsets[vIndex]; j < sameOffsets[vIndex + 1]; j++, iPos++) {
+				skinData.vert_index[iPos] = sameIndices[j];
+				skinData.org_i[iPos]      = i;
+				pos.x[iPos] = pos.x[i];
+				pos.y[iPos] = pos.y[i];
+				pos.z[iPos] = pos.z[i];
 			}
 		}
 	}
@@ -273,18 +273,122 @@ void CFacialSkin::UpdateVertices(std::vector< std::vector<int> >& sameVertexList
 			continue;
 		}
 		FACE_SKIN_DATA& baseSkinData = m_faceSkinData[baseIndex];
-		if (baseSkinData.v_data.size() == skinData.v_data.size()) continue;
-
-		FACE_SKIN_VERTEX_DATA vData2;
-		const int stPos = skinData.v_data.size();
-		for (int i = stPos; i < baseSkinData.v_data.size(); i++) {
-			FACE_SKIN_VERTEX_DATA& vData = baseSkinData.v_data[i];
-			vData2.pos = skinData.v_data[vData.org_i].pos;
-			skinData.v_data.push_back(vData2);
+		const int baseVCou = baseSkinData.GetVerticesCount();
+		if (baseVCou <= skinData.GetVerticesCount()) continue;
+
+		const int stPos = skinData.GetVerticesCount();
+		skinData.ResizeVertices(baseVCou);
+		CVec3ArraySoA& pos = skinData.pos;
+		for (int i = stPos; i < baseVCou; i++) {
+			const int orgI = baseSkinData.org_i[i];
+			pos.x[i] = pos.x[orgI];
+			pos.y[i] = pos.y[orgI];
+			pos.z[i] = pos.z[orgI];
 		}
 	}
 }
 
+/**
+ * baseからの移動量が他の表情と同一の表情と、頂点が移動しない表情を検出.
+ * 移動量は出力時の座標系で量子化し、移動する頂点の(頂点番号, 移動量)の並びで比較する.
+ */
+void CFacialSkin::FindDuplicateSkins(const bool removeF)
+{
+	m_duplicateSkinCount = 0;
+	m_emptySkinCount     = 0;
+	const int sCou = m_faceSkinData.size();
+	if (sCou == 0) return;
+
+	// 表情ごとの、同じ種類の先頭(base)の番号.
+	std::vector<int> skinBaseIndex(sCou, -1);
+	{
+		int baseIndex = -1;
+		for (int i = 0; i < sCou; i++) {
+			if (m_faceSkinData[i].baseSkin) baseIndex = i;
+			skinBaseIndex[i] = baseIndex;
+		}
+	}
+
+	// 表情ごとに、移動する頂点の(頂点番号, 量子化した移動量)を並べてハッシュを計算.
+	// 頂点番号はbaseで割り当てた対象のポリゴンメッシュの頂点番号を使うため、種類の異なる表情同士も比較できる.
+	// 対象のポリゴンメッシュの頂点が見つからなかった頂点は、出力に影響しないため除く.
+	const float qScale = m_scale / g_skinDeltaQuantum;
+	std::vector< std::vector<int> > deltaKeys(sCou);
+	std::vector<uint64_t> deltaHashes(sCou, 0);
+	auto calcDeltaKey = [this, &skinBaseIndex, &deltaKeys, &deltaHashes, qScale](int i) {
+		const FACE_SKIN_DATA& skinData = m_faceSkinData[i];
+		const int baseIndex = skinBaseIndex[i];
+		if (skinData.baseSkin || baseIndex < 0) return;
+		const FACE_SKIN_DATA& baseSkinData = m_faceSkinData[baseIndex];
+		const int vCou = std::min(skinData.GetVerticesCount(), baseSkinData.GetVerticesCount());
+
+		std::vector< std::tuple<int, int, int, int> > deltas;
+		for (int j = 0; j < vCou; j++) {
+			const int vIndex = baseSkinData.vert_index[j];
+			if (vIndex < 0) continue;
+			const int qx = (int)floorf((skinData.pos.x[j] - baseSkinData.pos.x[j]) * qScale + 0.5f);
+			const int qy = (int)floorf((skinData.pos.y[j] - baseSkinData.pos.y[j]) * qScale + 0.5f);
+			const int qz = (int)floorf((skinData.pos.z[j] - baseSkinData.pos.z[j]) * qScale + 0.5f);
+			if (qx == 0 && qy == 0 && qz == 0) continue;
+			deltas.push_back(std::make_tuple(vIndex, qx, qy, qz));
+		}
+		if (deltas.empty()) return;
+		std::sort(deltas.begin(), deltas.end());
+
+		std::vector<int>& keys = deltaKeys[i];
+		keys.resize(deltas.size() * 4);
+		for (int j = 0; j < deltas.size(); j++) {
+			keys[j * 4 + 0] = std::get<0>(deltas[j]);
+			keys[j * 4 + 1] = std::get<1>(deltas[j]);
+			keys[j * 4 + 2] = std::get<2>(deltas[j]);
+			keys[j * 4 + 3] = std::get<3>(deltas[j]);
+		}
+		deltaHashes[i] = Util::CalcHash(&(keys[0]), sizeof(int) * keys.size());
+	};
+	if (m_pThreadPool) {
+		m_pThreadPool->ParallelFor(0, sCou, calcDeltaKey);
+	} else {
+		for (int i = 0; i < sCou; i++) calcDeltaKey(i);
+	}
+
+	// 前にある表情と同一のもの、移動しないものを検出.
+	std::vector<char> removeList(sCou, 0);
+	std::map< uint64_t, std::vector<int> > hashSkins;
+	for (int i = 0; i < sCou; i++) {
+		if (m_faceSkinData[i].baseSkin || skinBaseIndex[i] < 0) continue;
+		if (deltaKeys[i].empty()) {
+			m_emptySkinCount++;
+			removeList[i] = 1;
+			continue;
+		}
+		std::vector<int>& list = hashSkins[deltaHashes[i]];
+		bool sameF = false;
+		for (int j = 0; j < list.size() && !sameF; j++) {
+			sameF = (deltaKeys[list[j]] == deltaKeys[i]);
+		}
+		if (sameF) {
+			m_duplicateSkinCount++;
+			removeList[i] = 1;
+		} else {
+			list.push_back(i);
+		}
+	}
+	if (!removeF || (m_duplicateSkinCount + m_emptySkinCount) == 0) return;
+
+	// 表情を削除し、種類ごとの先頭のインデックスを作り直す.
+	// 表情名と表情枠は出力時にm_faceSkinDataから作成されるため、並びは自動的に一致する.
+	std::vector<FACE_SKIN_DATA> skinData;
+	skinData.reserve(sCou - m_duplicateSkinCount - m_emptySkinCount);
+	m_skinGroupIndex.clear();
+	for (int i = 0; i < sCou; i++) {
+		if (removeList[i]) continue;
+		if (m_faceSkinData[i].baseSkin) m_skinGroupIndex.push_back(skinData.size());
+		skinData.push_back(FACE_SKIN_DATA());
+		std::swap(skinData.back(), m_faceSkinData[i]);
+	}
+	m_faceSkinData.swap(skinData);
+}
+
 /**
  * 指定の英語名を日本語に変換できる場合に変換.
  */
@@ -304,10 +408,24 @@ std::string CFacialSkin::m_ConvSkinName_EngToJP(const std::string skinName)
 }
 
 
+/**
+ * エクスポートする表情名をShift-JISに変換して保持.
+ */
+void CFacialSkin::PrepareExport()
+{
+	m_exportSkinNames.resize(m_faceSkinData.size());
+	m_exportSkinNamesEng.resize(m_faceSkinData.size());
+	for (int i = 0; i < m_faceSkinData.size(); i++) {
+		const FACE_SKIN_DATA& skinData = m_faceSkinData[i];
+		m_exportSkinNames[i]    = Util::ConvUTF8ToSJIS(*m_shade, m_ConvSkinName_EngToJP(skinData.name));
+		m_exportSkinNamesEng[i] = Util::ConvUTF8ToSJIS(*m_shade, skinData.name);
+	}
+}
+
 /**
  * 表情データをエクスポート.
  */
-bool CFacialSkin::ExportSkinData(sxsdk::stream_interface *stream)
+bool CFacialSkin::ExportSkinData(CBinaryBuffer& buff)
 {
 	int curSkinType       = -1;
 	int skinTypeBaseIndex = -1;
@@ -320,47 +438,49 @@ bool CFacialSkin::ExportSkinData(sxsdk::stream_interface *stream)
 	}
 	sCou++;		// baseの分を追加.
 
+	// 出力サイズを求めて、バッファを確保.
+	{
+		size_t size = 2 + 25;
+		for (int i = 0; i < m_skinGroupIndex.size(); i++) size += m_faceSkinData[m_skinGroupIndex[i]].GetVerticesCount() * 16;
+		for (int i = 0; i < m_faceSkinData.size(); i++) {
+			if (!m_faceSkinData[i].baseSkin) size += 25 + m_faceSkinData[i].GetVerticesCount() * 16;
+		}
+		buff.Reserve(size);
+	}
+
 	unsigned short sVal = (unsigned short)sCou;
-	stream->write(2, &sVal);
+	buff.Write(2, &sVal);
 
 	//-------------------------------------------------------.
-	//	基準となるbase用の頂点をまとめる.
+	//	基準となるbase用の頂点を、表情の種類ごとの順に出力.
 	//-------------------------------------------------------.
 	char cVal;
 	int iVal;
 	char szName[64];
-	sxsdk::vec3 v;
-	std::vector<FACE_SKIN_VERTEX_DATA> baseVersList;
 	std::vector<int> skinVOffset;
+	int baseVCou = 0;
 	for (int i = 0; i < m_skinGroupIndex.size(); i++) {
-		const int sIndex = m_skinGroupIndex[i];
-		FACE_SKIN_DATA& skinData = m_faceSkinData[sIndex];
-
-		skinVOffset.push_back(baseVersList.size());
-		for (int j = 0; j < skinData.v_data.size(); j++) {
-			baseVersList.push_back(skinData.v_data[j]);
-		}
+		skinVOffset.push_back(baseVCou);
+		baseVCou += m_faceSkinData[m_skinGroupIndex[i]].GetVerticesCount();
 	}
 	{
 		std::string str = "base";
 		memset(szName, 0, 24);
 		strcpy(szName, str.c_str());
-		stream->write(20, szName);
+		buff.Write(20, szName);
 
-		iVal = baseVersList.size();
-		stream->write(4, &iVal);
+		iVal = baseVCou;
+		buff.Write(4, &iVal);
 
 		cVal = skin_type_base;
-		stream->write(1, &cVal);
-
-		for (int j = 0; j < baseVersList.size(); j++) {
-			FACE_SKIN_VERTEX_DATA& vData = baseVersList[j];
-			v = vData.pos * m_scale;
-			v.z = -v.z;
-			stream->write(4, &vData.vert_index);
-			stream->write(4, &v.x);
-			stream->write(4, &v.y);
-			stream->write(4, &v.z);
+		buff.Write(1, &cVal);
+
+		// 位置は、PMDの座標系への変換をまとめて行い、頂点番号と合わせて直接書き込む.
+		for (int i = 0; i < m_skinGroupIndex.size(); i++) {
+			const FACE_SKIN_DATA& skinData = m_faceSkinData[m_skinGroupIndex[i]];
+			const int vCou = skinData.GetVerticesCount();
+			if (vCou == 0) continue;
+			VertexTransform::PackScaleFlipZ(&(skinData.vert_index[0]), 0, skinData.pos, NULL, m_scale, buff.Append((size_t)vCou * 16));
 		}
 	}
 
@@ -381,32 +501,25 @@ bool CFacialSkin::ExportSkinData(sxsdk::stream_interface *stream)
 		}
 		const int offsetI = (offsetIPos >= 0) ? skinVOffset[offsetIPos] : 0;
 
-		std::string str = Util::ConvUTF8ToSJIS(*m_shade, m_ConvSkinName_EngToJP(skinData.name));
+		const std::string& str = m_exportSkinNames[i];
 		memset(szName, 0, 24);
 		if (str.length() < 20) {
 			strcpy(szName, str.c_str());
 		} else {
 			strncpy(szName, str.c_str(), 19);
 		}
-		stream->write(20, szName);
+		buff.Write(20, szName);
 
-		iVal = skinData.v_data.size();
-		stream->write(4, &iVal);
+		const int vCou = skinData.GetVerticesCount();
+		iVal = vCou;
+		buff.Write(4, &iVal);
 
 		cVal = (char)skinData.type;
-		stream->write(1, &cVal);
-
-		for (int j = 0; j < skinData.v_data.size(); j++) {
-			FACE_SKIN_VERTEX_DATA& vDataBase = baseSkinData.v_data[j];
-			FACE_SKIN_VERTEX_DATA& vData     = skinData.v_data[j];
-
-			v = (vData.pos - vDataBase.pos) * m_scale;
-			v.z = -v.z;
-			iVal = j + offsetI;
-			stream->write(4, &iVal);
-			stream->write(4, &v.x);
-			stream->write(4, &v.y);
-			stream->write(4, &v.z);
+		buff.Write(1, &cVal);
+
+		// baseからの移動量は、PMDの座標系への変換をまとめて行い、baseでの頂点番号と合わせて直接書き込む.
+		if (vCou > 0) {
+			VertexTransform::PackScaleFlipZ(NULL, offsetI, skinData.pos, &(baseSkinData.pos), m_scale, buff.Append((size_t)vCou * 16));
 		}
 	}
 
@@ -417,7 +530,7 @@ bool CFacialSkin::ExportSkinData(sxsdk::stream_interface *stream)
 /**
  * 表情枠データをエクスポート.
  */
-bool CFacialSkin::ExportSkinFrameData(sxsdk::stream_interface *stream)
+bool CFacialSkin::ExportSkinFrameData(CBinaryBuffer& buff)
 {
 	// baseを除く表情数を取得.
 	int sCou = 0;
@@ -428,7 +541,7 @@ bool CFacialSkin::ExportSkinFrameData(sxsdk::stream_interface *stream)
 	}
 
 	unsigned char cVal = (int)sCou;
-	stream->write(1, &cVal);
+	buff.Write(1, &cVal);
 	unsigned short sVal;
 
 	int skinPos = 0;
@@ -437,7 +550,7 @@ bool CFacialSkin::ExportSkinFrameData(sxsdk::stream_interface *stream)
 		if (skinData.baseSkin) continue;
 
 		sVal = (unsigned short)(skinPos + 1);		// baseは除いたインデックス.
-		stream->write(2, &sVal);
+		buff.Write(2, &sVal);
 
 		skinPos++;
 	}
@@ -448,21 +561,21 @@ bool CFacialSkin::ExportSkinFrameData(sxsdk::stream_interface *stream)
 /**
  * 英語の表情名をエクスポート.
  */
-bool CFacialSkin::ExportEnglishSkinName(sxsdk::stream_interface *stream)
+bool CFacialSkin::ExportEnglishSkinName(CBinaryBuffer& buff)
 {
 	char szName[40];
 	for (int i = 0; i < m_faceSkinData.size(); i++) {
 		FACE_SKIN_DATA& skinData = m_faceSkinData[i];
 		if (skinData.baseSkin) continue;
 
-		std::string str = Util::ConvUTF8ToSJIS(*m_shade, skinData.name);
+		const std::string& str = m_exportSkinNamesEng[i];
 		memset(szName, 0, 24);
 		if (str.length() < 20) {
 			strcpy(szName, str.c_str());
 		} else {
 			strncpy(szName, str.c_str(), 19);
 		}
-		stream->write(20, szName);
+		buff.Write(20, szName);
 	}
 
 	return true;
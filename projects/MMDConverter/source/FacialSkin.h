@@ -32,6 +32,10 @@
 
 #include "GlobalHeader.h"
 #include "BSPSearch.h"
+#include "ThreadPool.h"
+#include "BinaryBuffer.h"
+#include "SceneSnapshot.h"
+#include "VertexTransform.h"
 
 /**
  * 表情の種類.
@@ -44,40 +48,36 @@ enum {
 	skin_type_other,			///< その他.
 };
 
-/**
- * 表情での頂点データ.
- */
-class FACE_SKIN_VERTEX_DATA {
-public:
-	int vert_index;					///< 頂点番号（baseの場合は頂点リストにある番号、base以外はbaseの番号）.
-	sxsdk::vec3 pos;				///< 頂点位置（baseの場合は頂点座標、base以外の場合はオフセット値）.
-	int org_i;						///< 頂点が増加する場合の、元の FACE_SKIN_DATA::v_data でのインデックス.
-	FACE_SKIN_VERTEX_DATA() {
-		vert_index = -1;
-		pos        = sxsdk::vec3(0, 0, 0);
-		org_i      = -1;
-	}
-};
-
 /**
  * 表情データ（格納用）.
+ * 頂点情報は、出力時にまとめて変換できるように要素ごとの配列で持つ.
  */
 class FACE_SKIN_DATA {
 public:
 	std::string name;								///< 表情名.
 	int type;										///< 表情の種類 (skin_type_xxx).
-	std::vector<FACE_SKIN_VERTEX_DATA> v_data;		///< 表情用の頂点情報.
+	std::vector<int> vert_index;					///< 頂点ごとの頂点番号（baseの場合は頂点リストにある番号、base以外は未使用）.
+	CVec3ArraySoA pos;								///< 頂点ごとのワールド座標での位置.
+	std::vector<int> org_i;							///< 頂点が増加する場合の、元の頂点のインデックス.
 
-	sxsdk::shape_class* pShape;						///< 対応するポリゴンメッシュ.
 	bool baseSkin;									///< 各表情の先頭はbase.
 
 	FACE_SKIN_DATA() {
 		name     = "";
 		type     = skin_type_base;
-		pShape   = NULL;
 		baseSkin = false;
 	}
 
+	int GetVerticesCount() const { return (int)vert_index.size(); }
+
+	/**
+	 * 頂点数を変更 (追加した頂点の番号は-1).
+	 */
+	void ResizeVertices(const int count) {
+		vert_index.resize(count, -1);
+		pos.Resize(count);
+		org_i.resize(count, -1);
+	}
 };
 
 class CFacialSkin
@@ -88,36 +88,34 @@ private:
 	std::vector<FACE_SKIN_DATA> m_faceSkinData;		///< face skin情報.
 	std::vector<int> m_skinGroupIndex;				///< skinの種類ごとの先頭のインデックス.
 
-	std::vector<std::string> m_skinTypeName;		///< skinTypeに対応する名称.
-
 	CBSPSearch* m_pBSPSearch;						///< 頂点を検索するクラス.
+	std::vector<sxsdk::vec3> m_meshVertices;		///< 対象のポリゴンメッシュのワールド座標での頂点 (BSPは必要になった時点で作成).
 
 	float m_scale;									///< 出力時のスケーリング.
+	CThreadPool* m_pThreadPool;						///< 頂点の対応付けの並列化用 (NULLの場合は逐次処理).
 
-	/**
-	 * skinのパートを探す.
-	 */
-	sxsdk::shape_class* m_GetSkinPart(sxsdk::scene_interface* scene);
+	std::vector<std::string> m_exportSkinNames;		///< 出力用にShift-JISに変換した表情名 (m_faceSkinDataと同じ並び).
+	std::vector<std::string> m_exportSkinNamesEng;	///< 出力用にShift-JISに変換した英語の表情名.
 
-	/**
-	 * 指定のSkinTypeのパートを探す.
-	 */
-	sxsdk::shape_class* m_GetSkinTypePart(sxsdk::shape_class* pSkinPart, const int skinType);
+	int m_duplicateSkinCount;						///< 他の表情と移動量が同一の表情の数.
+	int m_emptySkinCount;							///< 頂点が移動しない表情の数.
 
 	/**
-	 * 指定の形状のメッシュ情報を格納.
+	 * BSPの空間を作成 (作成済みの場合は何もしない).
 	 */
-	bool m_AddMesh(sxsdk::shape_class* pShape, const int skinType, FACE_SKIN_DATA& skinData, const bool firstF = false);
+	void m_BuildBSPSearch();
 
 	/**
-	 * 指定のポリゴンメッシュの頂点を取得し、BSP構造に格納.
+	 * 指定の頂点の一番近くにある頂点インデックスを取得.
+	 * BSPが作成済みの場合は、複数スレッドから同時に呼ぶことができる.
 	 */
-	bool m_SetMeshVertices(sxsdk::shape_class* pShape);
+	int m_GetNearVertex(sxsdk::vec3& pos, const float dist = (float)1e-3);
 
 	/**
-	 * 指定の頂点の一番近くにある頂点インデックスを取得.
+	 * baseの表情の頂点に、対象のポリゴンメッシュの頂点番号を割り当てる.
+	 * 頂点位置が前回と同じ場合は、キャッシュした結果を使用する.
 	 */
-	int m_GetNearVertex(sxsdk::vec3& pos, const float dist = (float)1e-3);
+	void m_MatchBaseVertices(FACE_SKIN_DATA& skinData);
 
 	/**
 	 * 指定の英語名を日本語に変換できる場合に変換.
@@ -134,29 +132,64 @@ public:
 	void Clear();
 
 	/**
-	 * 現在のシーンから、face skin用のメッシュ情報を取得.
+	 * スナップショットから、face skin用のメッシュ情報を格納.
 	 */
-	bool StoreSkinData(sxsdk::scene_interface* scene, sxsdk::shape_class *pTargetMesh, const float scale);
+	bool SetSnapshot(const CModelSnapshot& snapshot, const float scale);
 
 	/**
 	 * 頂点の最適化の反映（法線/UVの違いで頂点が増える場合）.
+	 * @param[in] sameOffsets  元の頂点ごとの、増加した頂点の開始位置 (元の頂点数 + 1個).
+	 * @param[in] sameIndices  増加した頂点の頂点番号.
 	 */
-	void UpdateVertices(std::vector< std::vector<int> >& sameVertexList);
+	void UpdateVertices(const std::vector<int>& sameOffsets, const std::vector<int>& sameIndices);
+
+	/**
+	 * baseからの移動量が他の表情と同一の表情と、頂点が移動しない表情を検出.
+	 * 頂点の最適化の反映(UpdateVertices)の前に呼ぶこと.
+	 * @param[in] removeF  trueの場合は検出した表情を削除する (同一の表情は、最初のもののみ残す).
+	 */
+	void FindDuplicateSkins(const bool removeF);
+
+	int GetDuplicateSkinCount() const { return m_duplicateSkinCount; }
+	int GetEmptySkinCount() const { return m_emptySkinCount; }
+
+	/**
+	 * エクスポートする表情名をShift-JISに変換して保持.
+	 * Export系の関数はセクションごとに並列に呼ばれるため、先に呼んでおくこと.
+	 */
+	void PrepareExport();
 
 	/**
 	 * 表情データをエクスポート.
 	 */
-	bool ExportSkinData(sxsdk::stream_interface *stream);
+	bool ExportSkinData(CBinaryBuffer& buff);
 
 	/**
 	 * 表情枠データをエクスポート.
 	 */
-	bool ExportSkinFrameData(sxsdk::stream_interface *stream);
+	bool ExportSkinFrameData(CBinaryBuffer& buff);
 
 	/**
 	 * 英語の表情名をエクスポート.
 	 */
-	bool ExportEnglishSkinName(sxsdk::stream_interface *stream);
+	bool ExportEnglishSkinName(CBinaryBuffer& buff);
+
+	/**
+	 * 格納済みの表情データを取得.
+	 */
+	const std::vector<FACE_SKIN_DATA>& GetSkinData() const { return m_faceSkinData; }
+	const std::vector<int>& GetSkinGroupIndex() const { return m_skinGroupIndex; }
+	float GetScale() const { return m_scale; }
+
+	/**
+	 * 表情データを直接指定 (キャッシュファイルからの復元用).
+	 */
+	void SetSkinData(const std::vector<FACE_SKIN_DATA>& skinData, const std::vector<int>& skinGroupIndex, const float scale);
+
+	/**
+	 * 並列処理に使用するスレッドプールを指定 (NULLの場合は逐次処理).
+	 */
+	void SetThreadPool(CThreadPool* pPool) { m_pThreadPool = pPool; }
 
 };
 
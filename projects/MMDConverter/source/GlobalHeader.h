@@ -33,8 +33,22 @@
 /**
  * streamでのバージョン.
  */
-#define MMD_PMD_DLG_VERSION			0x100			// PMDファイルエクスポート時に出るダイアログ.
-#define MMD_VMD_DLG_VERSION			0x100			// VMDファイルエクスポート時に出るダイアログ.
+#define MMD_PMD_DLG_VERSION_100		0x100
+#define MMD_PMD_DLG_VERSION_101		0x101			// マテリアルの統合を追加.
+#define MMD_PMD_DLG_VERSION_102		0x102			// テクスチャアトラスを追加.
+#define MMD_PMD_DLG_VERSION_103		0x103			// テクスチャのキャッシュを追加.
+#define MMD_PMD_DLG_VERSION_104		0x104			// テクスチャのリサイズを追加.
+#define MMD_PMD_DLG_VERSION_105		0x105			// モデルキャッシュの出力を追加.
+#define MMD_PMD_DLG_VERSION_106		0x106			// ワーカースレッド数を追加.
+#define MMD_PMD_DLG_VERSION_107		0x107			// 一括出力を追加.
+#define MMD_PMD_DLG_VERSION_108		0x108			// メッシュの統合を追加.
+#define MMD_PMD_DLG_VERSION_109		0x109			// 法線の生成を追加.
+#define MMD_PMD_DLG_VERSION_10A		0x10A			// 頂点の統合(許容値)を追加.
+#define MMD_PMD_DLG_VERSION_10B		0x10B			// 重複した表情の削除を追加.
+#define MMD_PMD_DLG_VERSION			MMD_PMD_DLG_VERSION_10B			// PMDファイルエクスポート時に出るダイアログ.
+#define MMD_VMD_DLG_VERSION_100		0x100
+#define MMD_VMD_DLG_VERSION_101		0x101			// 一括出力を追加.
+#define MMD_VMD_DLG_VERSION			MMD_VMD_DLG_VERSION_101			// VMDファイルエクスポート時に出るダイアログ.
 
 /**
  * PMDをエクスポートする際のダイアログ情報.
@@ -46,6 +60,21 @@ public:
 	bool toonEdge;					// トゥーンのエッジ処理を行うかどうか.
 	bool humanConvertBoneName;		// 人体ボーンの名称に自動変更する.
 	bool humanAutoIK;				// IKを自動的に割り当て.
+	bool mergeMaterials;			// 同一パラメータのマテリアルを1つにまとめる.
+	bool textureAtlas;				// テクスチャをアトラスにまとめる.
+	bool textureCache;				// 変更のないテクスチャは再出力しない.
+	int textureMaxSize;				// テクスチャの最大サイズ (0の場合は制限なし).
+	bool texturePowerOfTwo;			// テクスチャサイズを2の累乗にする.
+	bool writeModelCache;			// 変換後の情報をキャッシュファイル(.mmdcache)に出力.
+	int threadCount;				// 変換処理で使用するスレッド数 (0の場合は自動).
+	bool exportAllMeshes;			// ボーンの割り当てられたすべてのポリゴンメッシュを、それぞれのファイルに出力.
+	bool mergeMeshes;				// 同じボーンルートを持つポリゴンメッシュを、1つのモデルに統合.
+	bool generateNormals;			// 法線をプラグイン内で生成 (Shade 3Dの法線を使用しない).
+	float smoothingAngle;			// 法線生成時のスムーズ角度 (度).
+	bool weldVertices;				// 法線/UVの差が許容値以内の頂点を、1つの頂点にまとめる.
+	float weldNormalAngle;			// 頂点をまとめる法線の角度の許容値 (度).
+	float weldUVDistance;			// 頂点をまとめるUVの距離の許容値.
+	bool removeDuplicateMorphs;		// 重複した表情と、頂点が移動しない表情を削除.
 
 	std::string note_jp;			// 日本語説明文.
 	std::string note_en;			// 英語説明文.
@@ -56,6 +85,21 @@ public:
 		boneOffsetMoveRootOnly = true;
 		humanConvertBoneName = true;
 		humanAutoIK = true;
+		mergeMaterials = true;
+		textureAtlas   = false;
+		textureCache   = true;
+		textureMaxSize    = 0;
+		texturePowerOfTwo = false;
+		writeModelCache   = false;
+		threadCount       = 0;
+		exportAllMeshes   = false;
+		mergeMeshes       = false;
+		generateNormals   = false;
+		smoothingAngle    = 60.0f;
+		weldVertices      = false;
+		weldNormalAngle   = 1.0f;
+		weldUVDistance    = 0.0005f;
+		removeDuplicateMorphs = false;
 
 		note_jp = "Modeling Shade 3D";
 		note_en = "Modeling Shade 3D";
@@ -69,10 +113,12 @@ class CVMDDlgInfo {
 public:
 	float scale;					// Scale (default 0.01).
 	bool humanConvertBoneName;		// 人体ボーンの名称に自動変更する.
+	bool exportAllMeshes;			// ボーンの割り当てられたすべてのポリゴンメッシュを、それぞれのファイルに出力.
 
 	CVMDDlgInfo() {
 		scale    = 0.01f;
 		humanConvertBoneName = true;
+		exportAllMeshes      = false;
 	}
 };
 
@@ -0,0 +1,532 @@
+﻿/**
+ *  @brief  画像処理 (PNGエンコードなど、Shade 3Dの呼び出しを伴わないもの).
+ *  @date   2026.10.19
+ */
+
+#include "ImageUtil.h"
+#include "Util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <math.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define IMAGEUTIL_USE_SSE2
+#endif
+
+/*
+	PNGのIDATは、固定ハフマン符号のDeflate(LZ77)で圧縮する.
+	外部ライブラリ(zlib)を使わず、ワーカースレッドから並列に呼び出せるようにしている.
+*/
+
+namespace {
+	//-----------------------------------------------------.
+	// CRC32 / Adler32.
+	//-----------------------------------------------------.
+	class CCRC32Table {
+	public:
+		uint32_t table[256];
+		CCRC32Table() {
+			for (uint32_t i = 0; i < 256; i++) {
+				uint32_t c = i;
+				for (int j = 0; j < 8; j++) {
+					c = (c & 1) ? (0xedb88320U ^ (c >> 1)) : (c >> 1);
+				}
+				table[i] = c;
+			}
+		}
+	};
+	const CCRC32Table g_crcTable;
+
+	uint32_t UpdateCRC32(uint32_t crc, const unsigned char* data, const size_t size) {
+		uint32_t c = crc ^ 0xffffffffU;
+		for (size_t i = 0; i < size; i++) {
+			c = g_crcTable.table[(c ^ data[i]) & 0xff] ^ (c >> 8);
+		}
+		return c ^ 0xffffffffU;
+	}
+
+	uint32_t CalcAdler32(const unsigned char* data, const size_t size) {
+		uint32_t a = 1, b = 0;
+		size_t pos = 0;
+		while (pos < size) {
+			const size_t n = std::min(size - pos, (size_t)5552);
+			for (size_t i = 0; i < n; i++) {
+				a += data[pos + i];
+				b += a;
+			}
+			a %= 65521;
+			b %= 65521;
+			pos += n;
+		}
+		return (b << 16) | a;
+	}
+
+	void PushU32BE(std::vector<unsigned char>& buff, const uint32_t v) {
+		buff.push_back((unsigned char)((v >> 24) & 0xff));
+		buff.push_back((unsigned char)((v >> 16) & 0xff));
+		buff.push_back((unsigned char)((v >>  8) & 0xff));
+		buff.push_back((unsigned char)( v        & 0xff));
+	}
+
+	/**
+	 * PNGのチャンクを追加.
+	 */
+	void PushChunk(std::vector<unsigned char>& buff, const char* type, const std::vector<unsigned char>& data) {
+		PushU32BE(buff, (uint32_t)data.size());
+		const size_t typePos = buff.size();
+		buff.insert(buff.end(), type, type + 4);
+		if (!data.empty()) buff.insert(buff.end(), data.begin(), data.end());
+		PushU32BE(buff, UpdateCRC32(0, &(buff[typePos]), buff.size() - typePos));
+	}
+
+	//-----------------------------------------------------.
+	// Deflate (固定ハフマン符号).
+	//-----------------------------------------------------.
+	const int lengthBase[29]  = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	const int lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0,  0,  1,  1,  1,  1,  2,  2,  2,  2,  3,  3,  3,  3,  4,  4,  4,   4,   5,   5,   5,   5,   0 };
+	const int distBase[30]    = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	const int distExtra[30]   = { 0, 0, 0, 0, 1, 1, 2,  2,  3,  3,  4,  4,  5,  5,   6,   6,   7,   7,   8,   8,    9,    9,   10,   10,   11,   11,   12,    12,    13,    13 };
+
+	const int windowSize  = 32768;
+	const int hashBits    = 15;
+	const int maxChain    = 48;
+	const int minMatch    = 3;
+	const int maxMatch    = 258;
+
+	/**
+	 * LSBから詰めるビット出力.
+	 */
+	class CBitWriter {
+	private:
+		std::vector<unsigned char>& m_buff;
+		uint32_t m_bits;
+		int m_bitCount;
+	public:
+		CBitWriter(std::vector<unsigned char>& buff) : m_buff(buff), m_bits(0), m_bitCount(0) { }
+
+		void Write(const uint32_t value, const int count) {
+			m_bits |= (value << m_bitCount);
+			m_bitCount += count;
+			while (m_bitCount >= 8) {
+				m_buff.push_back((unsigned char)(m_bits & 0xff));
+				m_bits >>= 8;
+				m_bitCount -= 8;
+			}
+		}
+
+		/**
+		 * ハフマン符号はMSBから格納するため、ビットを反転して出力.
+		 */
+		void WriteHuffman(const uint32_t code, const int count) {
+			uint32_t rev = 0;
+			for (int i = 0; i < count; i++) {
+				rev = (rev << 1) | ((code >> i) & 1);
+			}
+			Write(rev, count);
+		}
+
+		void Flush() {
+			if (m_bitCount > 0) {
+				m_buff.push_back((unsigned char)(m_bits & 0xff));
+				m_bits = 0;
+				m_bitCount = 0;
+			}
+		}
+	};
+
+	void WriteLiteral(CBitWriter& writer, const int lit) {
+		if (lit <= 143)      writer.WriteHuffman(0x30 + lit, 8);
+		else if (lit <= 255) writer.WriteHuffman(0x190 + (lit - 144), 9);
+		else if (lit <= 279) writer.WriteHuffman(lit - 256, 7);
+		else                 writer.WriteHuffman(0xc0 + (lit - 280), 8);
+	}
+
+	void WriteMatch(CBitWriter& writer, const int length, const int distance) {
+		int li = 28;
+		while (lengthBase[li] > length) li--;
+		WriteLiteral(writer, 257 + li);
+		if (lengthExtra[li] > 0) writer.Write(length - lengthBase[li], lengthExtra[li]);
+
+		int di = 29;
+		while (distBase[di] > distance) di--;
+		writer.WriteHuffman(di, 5);
+		if (distExtra[di] > 0) writer.Write(distance - distBase[di], distExtra[di]);
+	}
+
+	inline uint32_t Hash3(const unsigned char* p) {
+		const uint32_t v = ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | (uint32_t)p[2];
+		return (v * 2654435761U) >> (32 - hashBits);
+	}
+
+	/**
+	 * zlib形式で圧縮 (1つの固定ハフマンブロック).
+	 */
+	void Deflate(const std::vector<unsigned char>& src, std::vector<unsigned char>& dst) {
+		dst.clear();
+		dst.reserve(src.size() / 2 + 64);
+		dst.push_back(0x78);		// CMF : deflate, 32Kウィンドウ.
+		dst.push_back(0x01);		// FLG.
+
+		CBitWriter writer(dst);
+		writer.Write(1, 1);			// BFINAL.
+		writer.Write(1, 2);			// BTYPE : 固定ハフマン.
+
+		const int size = (int)src.size();
+		const unsigned char* pData = size > 0 ? &(src[0]) : NULL;
+
+		std::vector<int> head(1 << hashBits, -1);
+		std::vector<int> prev(windowSize, -1);
+
+		int pos = 0;
+		while (pos < size) {
+			int bestLen  = 0;
+			int bestDist = 0;
+			if (pos + minMatch <= size) {
+				const uint32_t h = Hash3(pData + pos);
+				int cand = head[h];
+				const int maxLen = std::min(maxMatch, size - pos);
+				for (int chain = 0; chain < maxChain && cand >= 0; chain++) {
+					const int dist = pos - cand;
+					if (dist > windowSize - 1) break;
+					if (pData[cand + bestLen] == pData[pos + bestLen]) {
+						int len = 0;
+						while (len < maxLen && pData[cand + len] == pData[pos + len]) len++;
+						if (len > bestLen) {
+							bestLen  = len;
+							bestDist = dist;
+							if (len >= maxLen) break;
+						}
+					}
+					cand = prev[cand & (windowSize - 1)];
+				}
+			}
+
+			const int step = (bestLen >= minMatch) ? bestLen : 1;
+			if (bestLen >= minMatch) {
+				WriteMatch(writer, bestLen, bestDist);
+			} else {
+				WriteLiteral(writer, pData[pos]);
+			}
+
+			// ハッシュチェーンに登録.
+			for (int i = 0; i < step; i++) {
+				const int p = pos + i;
+				if (p + minMatch > size) break;
+				const uint32_t h = Hash3(pData + p);
+				prev[p & (windowSize - 1)] = head[h];
+				head[h] = p;
+			}
+			pos += step;
+		}
+		WriteLiteral(writer, 256);		// ブロックの終端.
+		writer.Flush();
+
+		PushU32BE(dst, CalcAdler32(pData, src.size()));
+	}
+
+	//-----------------------------------------------------.
+	// PNGのフィルタ.
+	//-----------------------------------------------------.
+	inline unsigned char Paeth(const int a, const int b, const int c) {
+		const int p  = a + b - c;
+		const int pa = abs(p - a);
+		const int pb = abs(p - b);
+		const int pc = abs(p - c);
+		if (pa <= pb && pa <= pc) return (unsigned char)a;
+		if (pb <= pc) return (unsigned char)b;
+		return (unsigned char)c;
+	}
+
+	/**
+	 * 1ライン分のフィルタを適用 (5種類のうち、差分の絶対値の和が最小のものを採用).
+	 */
+	void FilterLine(const unsigned char* cur, const unsigned char* prevLine, const int lineBytes, unsigned char* dst, std::vector<unsigned char>& work) {
+		const int bpp = 4;
+		work.resize(lineBytes * 5);
+
+		unsigned int bestSum = 0xffffffffU;
+		int bestType = 0;
+		for (int type = 0; type < 5; type++) {
+			unsigned char* out = &(work[type * lineBytes]);
+			unsigned int sum = 0;
+			for (int i = 0; i < lineBytes; i++) {
+				const int a = (i >= bpp) ? cur[i - bpp] : 0;
+				const int b = prevLine ? prevLine[i] : 0;
+				const int c = (prevLine && i >= bpp) ? prevLine[i - bpp] : 0;
+				unsigned char v;
+				switch (type) {
+				case 0:  v = cur[i]; break;
+				case 1:  v = (unsigned char)(cur[i] - a); break;
+				case 2:  v = (unsigned char)(cur[i] - b); break;
+				case 3:  v = (unsigned char)(cur[i] - ((a + b) >> 1)); break;
+				default: v = (unsigned char)(cur[i] - Paeth(a, b, c)); break;
+				}
+				out[i] = v;
+				sum += (v < 128) ? v : (256 - v);
+			}
+			if (sum < bestSum) {
+				bestSum  = sum;
+				bestType = type;
+			}
+		}
+
+		dst[0] = (unsigned char)bestType;
+		memcpy(dst + 1, &(work[bestType * lineBytes]), lineBytes);
+	}
+
+	//-----------------------------------------------------.
+	// リサイズ.
+	//-----------------------------------------------------.
+	/**
+	 * 1軸分のリサンプリングの重み.
+	 * 出力ピクセルiは、入力のstart[i]からcount[i]個のピクセルをweights[offset[i]...]で合成する.
+	 */
+	class CResampleWeights {
+	public:
+		std::vector<int> start, count, offset;
+		std::vector<float> weights;
+
+		CResampleWeights(const int srcSize, const int dstSize) {
+			start.resize(dstSize);
+			count.resize(dstSize);
+			offset.resize(dstSize);
+
+			const double scale = (double)dstSize / (double)srcSize;
+			std::vector<float> work;
+			for (int i = 0; i < dstSize; i++) {
+				int i0, i1;
+				work.clear();
+				if (scale < 1.0) {
+					// 縮小 : 出力ピクセルが覆う入力の範囲を、重なる面積で平均.
+					const double left  = (double)i / scale;
+					const double right = (double)(i + 1) / scale;
+					i0 = std::max(0, (int)floor(left));
+					i1 = std::min(srcSize - 1, (int)ceil(right) - 1);
+					for (int j = i0; j <= i1; j++) {
+						const double w = std::min(right, (double)(j + 1)) - std::max(left, (double)j);
+						work.push_back((float)std::max(0.0, w));
+					}
+				} else {
+					// 拡大 : 線形補間.
+					const double center = ((double)i + 0.5) / scale - 0.5;
+					const int j0 = (int)floor(center);
+					const float f = (float)(center - (double)j0);
+					const int c0 = std::max(0, std::min(srcSize - 1, j0));
+					const int c1 = std::max(0, std::min(srcSize - 1, j0 + 1));
+					i0 = std::min(c0, c1);
+					i1 = std::max(c0, c1);
+					work.resize(i1 - i0 + 1, 0.0f);
+					work[c0 - i0] += 1.0f - f;
+					work[c1 - i0] += f;
+				}
+
+				float sum = 0.0f;
+				for (int j = 0; j < work.size(); j++) sum += work[j];
+				if (sum <= 0.0f) sum = 1.0f;
+
+				start[i]  = i0;
+				count[i]  = work.size();
+				offset[i] = weights.size();
+				for (int j = 0; j < work.size(); j++) weights.push_back(work[j] / sum);
+			}
+		}
+	};
+
+	inline int RoundPowerOfTwo(const int size) {
+		int p = 1;
+		while (p * 2 <= size) p *= 2;
+		return (size - p > p * 2 - size) ? p * 2 : p;
+	}
+
+	inline int FloorPowerOfTwo(const int size) {
+		int p = 1;
+		while (p * 2 <= size) p *= 2;
+		return p;
+	}
+}
+
+/**
+ * RGBA 8bitのピクセルをPNG形式にエンコード.
+ */
+bool ImageUtil::EncodePNG(const int width, const int height, const sx::rgba8_class* pixels, std::vector<unsigned char>& retData)
+{
+	retData.clear();
+	if (width <= 0 || height <= 0 || !pixels) return false;
+
+	// フィルタを適用したライン列.
+	const int lineBytes = width * 4;
+	std::vector<unsigned char> raw;
+	raw.resize((size_t)(lineBytes + 1) * height);
+	{
+		std::vector<unsigned char> line, prevLine, work;
+		line.resize(lineBytes);
+		for (int y = 0; y < height; y++) {
+			const sx::rgba8_class* pLine = pixels + (size_t)y * width;
+			for (int x = 0; x < width; x++) {
+				line[x * 4 + 0] = pLine[x].red;
+				line[x * 4 + 1] = pLine[x].green;
+				line[x * 4 + 2] = pLine[x].blue;
+				line[x * 4 + 3] = pLine[x].alpha;
+			}
+			FilterLine(&(line[0]), (y > 0) ? &(prevLine[0]) : NULL, lineBytes, &(raw[(size_t)(lineBytes + 1) * y]), work);
+			prevLine.swap(line);
+			line.resize(lineBytes);
+		}
+	}
+
+	std::vector<unsigned char> chunk;
+
+	// シグネチャ.
+	const unsigned char signature[8] = { 0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a };
+	retData.insert(retData.end(), signature, signature + 8);
+
+	// IHDR.
+	PushU32BE(chunk, (uint32_t)width);
+	PushU32BE(chunk, (uint32_t)height);
+	chunk.push_back(8);		// ビット深度.
+	chunk.push_back(6);		// RGBA.
+	chunk.push_back(0);		// 圧縮方法.
+	chunk.push_back(0);		// フィルタ方法.
+	chunk.push_back(0);		// インターレースなし.
+	PushChunk(retData, "IHDR", chunk);
+
+	// IDAT.
+	Deflate(raw, chunk);
+	PushChunk(retData, "IDAT", chunk);
+
+	// IEND.
+	chunk.clear();
+	PushChunk(retData, "IEND", chunk);
+
+	return true;
+}
+
+/**
+ * RGBA 8bitのピクセルをPNGファイルとして保存.
+ */
+bool ImageUtil::SavePNG(const std::string& filePath, const int width, const int height, const sx::rgba8_class* pixels)
+{
+	std::vector<unsigned char> data;
+	if (!EncodePNG(width, height, pixels, data)) return false;
+
+	FILE* fp = Util::OpenFile(filePath, "wb");
+	if (!fp) return false;
+	const size_t wSize = fwrite(&(data[0]), 1, data.size(), fp);
+	fclose(fp);
+
+	return (wSize == data.size());
+}
+
+/**
+ * 最大サイズと2の累乗の指定から、出力する画像サイズを計算.
+ */
+bool ImageUtil::CalcResizeSize(const int width, const int height, const int maxSize, const bool powerOfTwo, int* pRetWidth, int* pRetHeight)
+{
+	int w = width;
+	int h = height;
+
+	// 縦横比を保って最大サイズに収める.
+	if (maxSize > 0 && (w > maxSize || h > maxSize)) {
+		const double scale = (double)maxSize / (double)std::max(w, h);
+		w = std::max(1, std::min(maxSize, (int)floor((double)w * scale + 0.5)));
+		h = std::max(1, std::min(maxSize, (int)floor((double)h * scale + 0.5)));
+	}
+
+	if (powerOfTwo) {
+		w = RoundPowerOfTwo(w);
+		h = RoundPowerOfTwo(h);
+		if (maxSize > 0) {
+			const int maxPow = FloorPowerOfTwo(maxSize);
+			w = std::min(w, maxPow);
+			h = std::min(h, maxPow);
+		}
+	}
+
+	*pRetWidth  = w;
+	*pRetHeight = h;
+	return (w != width || h != height);
+}
+
+/**
+ * 画像をリサイズ.
+ */
+void ImageUtil::Resize(const int srcWidth, const int srcHeight, const sx::rgba8_class* srcPixels, const int dstWidth, const int dstHeight, std::vector<sx::rgba8_class>& retPixels)
+{
+	retPixels.resize((size_t)dstWidth * dstHeight);
+	if (srcWidth <= 0 || srcHeight <= 0 || dstWidth <= 0 || dstHeight <= 0) return;
+
+	const CResampleWeights weightsX(srcWidth, dstWidth);
+	const CResampleWeights weightsY(srcHeight, dstHeight);
+
+	// 水平方向 : RGBA 8bit (srcWidth x srcHeight) -> RGBA float (dstWidth x srcHeight).
+	std::vector<float> work;
+	work.resize((size_t)dstWidth * srcHeight * 4);
+	for (int y = 0; y < srcHeight; y++) {
+		const sx::rgba8_class* pSrc = srcPixels + (size_t)y * srcWidth;
+		float* pDst = &(work[(size_t)y * dstWidth * 4]);
+		for (int x = 0; x < dstWidth; x++) {
+			const sx::rgba8_class* p = pSrc + weightsX.start[x];
+			const float* pW = &(weightsX.weights[weightsX.offset[x]]);
+			const int cou = weightsX.count[x];
+#if defined(IMAGEUTIL_USE_SSE2)
+			const __m128i zero = _mm_setzero_si128();
+			__m128 sum = _mm_setzero_ps();
+			for (int i = 0; i < cou; i++) {
+				int rgba;
+				memcpy(&rgba, p + i, 4);
+				const __m128i v16 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(rgba), zero);
+				const __m128 v = _mm_cvtepi32_ps(_mm_unpacklo_epi16(v16, zero));
+				sum = _mm_add_ps(sum, _mm_mul_ps(v, _mm_set1_ps(pW[i])));
+			}
+			_mm_storeu_ps(pDst + x * 4, sum);
+#else
+			float r = 0.0f, g = 0.0f, b = 0.0f, a = 0.0f;
+			for (int i = 0; i < cou; i++) {
+				r += (float)p[i].red   * pW[i];
+				g += (float)p[i].green * pW[i];
+				b += (float)p[i].blue  * pW[i];
+				a += (float)p[i].alpha * pW[i];
+			}
+			pDst[x * 4 + 0] = r;
+			pDst[x * 4 + 1] = g;
+			pDst[x * 4 + 2] = b;
+			pDst[x * 4 + 3] = a;
+#endif
+		}
+	}
+
+	// 垂直方向 : RGBA float (dstWidth x srcHeight) -> RGBA 8bit (dstWidth x dstHeight).
+	const size_t lineFloats = (size_t)dstWidth * 4;
+	for (int y = 0; y < dstHeight; y++) {
+		const float* pW = &(weightsY.weights[weightsY.offset[y]]);
+		const int cou = weightsY.count[y];
+		const float* pSrc = &(work[(size_t)weightsY.start[y] * lineFloats]);
+		sx::rgba8_class* pDst = &(retPixels[(size_t)y * dstWidth]);
+		for (int x = 0; x < dstWidth; x++) {
+#if defined(IMAGEUTIL_USE_SSE2)
+			__m128 sum = _mm_set1_ps(0.5f);
+			for (int i = 0; i < cou; i++) {
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(pSrc + i * lineFloats + x * 4), _mm_set1_ps(pW[i])));
+			}
+			const __m128i v32 = _mm_cvttps_epi32(sum);
+			const __m128i v16 = _mm_packs_epi32(v32, v32);
+			const int rgba = _mm_cvtsi128_si32(_mm_packus_epi16(v16, v16));
+			memcpy(pDst + x, &rgba, 4);
+#else
+			float v[4] = { 0.5f, 0.5f, 0.5f, 0.5f };
+			for (int i = 0; i < cou; i++) {
+				const float* p = pSrc + i * lineFloats + x * 4;
+				for (int c = 0; c < 4; c++) v[c] += p[c] * pW[i];
+			}
+			pDst[x].red   = (unsigned char)std::max(0, std::min(255, (int)v[0]));
+			pDst[x].green = (unsigned char)std::max(0, std::min(255, (int)v[1]));
+			pDst[x].blue  = (unsigned char)std::max(0, std::min(255, (int)v[2]));
+			pDst[x].alpha = (unsigned char)std::max(0, std::min(255, (int)v[3]));
+#endif
+		}
+	}
+}
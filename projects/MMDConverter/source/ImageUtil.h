@@ -0,0 +1,49 @@
+﻿/**
+ *  @brief  画像処理 (PNGエンコードなど、Shade 3Dの呼び出しを伴わないもの).
+ *  @date   2026.10.19
+ */
+
+#ifndef _IMAGEUTIL_H
+#define _IMAGEUTIL_H
+
+#include "GlobalHeader.h"
+
+#include <vector>
+#include <string>
+
+namespace ImageUtil {
+	/**
+	 * RGBA 8bitのピクセルをPNG形式にエンコード.
+	 * スレッドセーフ.
+	 * @param[in]  width, height   画像サイズ.
+	 * @param[in]  pixels          ピクセル (width * height).
+	 * @param[out] retData         PNGのバイト列.
+	 */
+	bool EncodePNG(const int width, const int height, const sx::rgba8_class* pixels, std::vector<unsigned char>& retData);
+
+	/**
+	 * RGBA 8bitのピクセルをPNGファイルとして保存.
+	 * スレッドセーフ.
+	 * @param[in]  filePath        保存するファイルのフルパス (UTF-8).
+	 */
+	bool SavePNG(const std::string& filePath, const int width, const int height, const sx::rgba8_class* pixels);
+
+	/**
+	 * 最大サイズと2の累乗の指定から、出力する画像サイズを計算.
+	 * @param[in]  width, height   元の画像サイズ.
+	 * @param[in]  maxSize         縦横の最大サイズ (0の場合は制限なし).
+	 * @param[in]  powerOfTwo      縦横それぞれを、近い2の累乗にする.
+	 * @param[out] pRetWidth, pRetHeight   出力する画像サイズ.
+	 * @return サイズが変わる場合はtrue.
+	 */
+	bool CalcResizeSize(const int width, const int height, const int maxSize, const bool powerOfTwo, int* pRetWidth, int* pRetHeight);
+
+	/**
+	 * 画像をリサイズ.
+	 * 縮小は面積平均(ボックスフィルタ)、拡大は線形補間で、水平/垂直の2パスで行う.
+	 * スレッドセーフ.
+	 */
+	void Resize(const int srcWidth, const int srcHeight, const sx::rgba8_class* srcPixels, const int dstWidth, const int dstHeight, std::vector<sx::rgba8_class>& retPixels);
+}
+
+#endif
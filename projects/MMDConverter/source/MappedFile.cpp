@@ -0,0 +1,112 @@
+﻿/**
+ *  @brief  ファイルのメモリマップ (読み込み専用).
+ *  @date   2026.10.19
+ */
+
+#include "MappedFile.h"
+
+#include <vector>
+
+#if SXWINDOWS
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+CMappedFile::CMappedFile()
+{
+	m_pData = NULL;
+	m_size  = 0;
+#if SXWINDOWS
+	m_hFile    = INVALID_HANDLE_VALUE;
+	m_hMapping = NULL;
+#else
+	m_fd = -1;
+#endif
+}
+
+CMappedFile::~CMappedFile()
+{
+	Close();
+}
+
+/**
+ * ファイルを開いてマップする (パスはUTF-8).
+ */
+bool CMappedFile::Open(const std::string& filePath)
+{
+	Close();
+
+#if SXWINDOWS
+	const int pathLen = ::MultiByteToWideChar(CP_UTF8, 0, filePath.c_str(), -1, NULL, 0);
+	if (pathLen <= 0) return false;
+	std::vector<wchar_t> wPath(pathLen);
+	::MultiByteToWideChar(CP_UTF8, 0, filePath.c_str(), -1, &(wPath[0]), pathLen);
+
+	HANDLE hFile = ::CreateFileW(&(wPath[0]), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (hFile == INVALID_HANDLE_VALUE) return false;
+	m_hFile = hFile;
+
+	LARGE_INTEGER size;
+	if (!::GetFileSizeEx(hFile, &size) || size.QuadPart <= 0) {
+		Close();
+		return false;
+	}
+
+	HANDLE hMapping = ::CreateFileMappingW(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!hMapping) {
+		Close();
+		return false;
+	}
+	m_hMapping = hMapping;
+
+	m_pData = (const unsigned char *)::MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+	if (!m_pData) {
+		Close();
+		return false;
+	}
+	m_size = (size_t)size.QuadPart;
+#else
+	m_fd = open(filePath.c_str(), O_RDONLY);
+	if (m_fd < 0) return false;
+
+	struct stat st;
+	if (fstat(m_fd, &st) != 0 || st.st_size <= 0) {
+		Close();
+		return false;
+	}
+
+	void* pData = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+	if (pData == MAP_FAILED) {
+		Close();
+		return false;
+	}
+	m_pData = (const unsigned char *)pData;
+	m_size  = (size_t)st.st_size;
+#endif
+
+	return true;
+}
+
+/**
+ * マップを解除してファイルを閉じる.
+ */
+void CMappedFile::Close()
+{
+#if SXWINDOWS
+	if (m_pData) ::UnmapViewOfFile(m_pData);
+	if (m_hMapping) ::CloseHandle((HANDLE)m_hMapping);
+	if (m_hFile != INVALID_HANDLE_VALUE) ::CloseHandle((HANDLE)m_hFile);
+	m_hMapping = NULL;
+	m_hFile    = INVALID_HANDLE_VALUE;
+#else
+	if (m_pData) munmap((void *)m_pData, m_size);
+	if (m_fd >= 0) close(m_fd);
+	m_fd = -1;
+#endif
+	m_pData = NULL;
+	m_size  = 0;
+}
@@ -0,0 +1,50 @@
+﻿/**
+ *  @brief  ファイルのメモリマップ (読み込み専用).
+ *  @date   2026.10.19
+ */
+
+#ifndef _MAPPEDFILE_H
+#define _MAPPEDFILE_H
+
+#include "GlobalHeader.h"
+
+#include <string>
+
+/**
+ * ファイル全体を読み込み専用でメモリにマップする.
+ * 大きなファイルでも、コピーせずにGetDataのポインタから直接参照できる.
+ */
+class CMappedFile
+{
+private:
+	const unsigned char* m_pData;		///< マップされた先頭.
+	size_t m_size;						///< ファイルのバイト数.
+
+#if SXWINDOWS
+	void* m_hFile;						///< ファイルハンドル.
+	void* m_hMapping;					///< マッピングオブジェクトのハンドル.
+#else
+	int m_fd;							///< ファイルディスクリプタ.
+#endif
+
+public:
+	CMappedFile();
+	virtual ~CMappedFile();
+
+	/**
+	 * ファイルを開いてマップする (パスはUTF-8).
+	 * @return 開けない場合、または空のファイルの場合はfalse.
+	 */
+	bool Open(const std::string& filePath);
+
+	/**
+	 * マップを解除してファイルを閉じる.
+	 */
+	void Close();
+
+	bool IsOpen() const { return (m_pData != NULL); }
+	const unsigned char* GetData() const { return m_pData; }
+	size_t GetSize() const { return m_size; }
+};
+
+#endif
@@ -0,0 +1,159 @@
+﻿/**
+ *  @brief  変換後のモデル情報のキャッシュファイル (.mmdcache).
+ *  @date   2026.10.19
+ */
+
+#include "ModelCache.h"
+#include "Util.h"
+
+#include <string.h>
+#include <algorithm>
+
+/**
+ * セクションを追加.
+ */
+void CModelCacheWriter::AddSection(const int id, const size_t elementSize, const size_t elementCount, const void* data)
+{
+	MMD_CACHE_SECTION section;
+	memset(&section, 0, sizeof(MMD_CACHE_SECTION));
+	section.id           = (uint32_t)id;
+	section.elementSize  = (uint32_t)elementSize;
+	section.elementCount = (uint32_t)elementCount;
+	section.size         = (uint64_t)elementSize * (uint64_t)elementCount;
+	m_sections.push_back(section);
+
+	m_sectionData.push_back(std::vector<unsigned char>());
+	if (section.size > 0 && data) {
+		const unsigned char* pData = (const unsigned char *)data;
+		m_sectionData.back().assign(pData, pData + section.size);
+	}
+}
+
+/**
+ * ファイルに保存 (パスはUTF-8).
+ */
+bool CModelCacheWriter::Save(const std::string& filePath)
+{
+	const int sCou = m_sections.size();
+
+	// セクションの配置位置を決める.
+	uint64_t offset = sizeof(MMD_CACHE_HEADER) + sizeof(MMD_CACHE_SECTION) * sCou;
+	for (int i = 0; i < sCou; i++) {
+		offset = (offset + MMD_CACHE_ALIGNMENT - 1) & ~((uint64_t)MMD_CACHE_ALIGNMENT - 1);
+		m_sections[i].offset = offset;
+		offset += m_sections[i].size;
+	}
+
+	MMD_CACHE_HEADER header;
+	memset(&header, 0, sizeof(MMD_CACHE_HEADER));
+	memcpy(header.magic, MMD_CACHE_MAGIC, 8);
+	header.version      = MMD_CACHE_VERSION;
+	header.sectionCount = (uint32_t)sCou;
+	header.fileSize     = offset;
+
+	CBinaryBuffer buff;
+	buff.Reserve((size_t)offset);
+	buff.Write(sizeof(MMD_CACHE_HEADER), &header);
+	if (sCou > 0) buff.Write(sizeof(MMD_CACHE_SECTION) * sCou, &(m_sections[0]));
+
+	const unsigned char zero[MMD_CACHE_ALIGNMENT] = { 0 };
+	for (int i = 0; i < sCou; i++) {
+		buff.Write((size_t)(m_sections[i].offset - buff.GetSize()), zero);
+		if (!m_sectionData[i].empty()) buff.Write(m_sectionData[i].size(), &(m_sectionData[i][0]));
+	}
+
+	FILE* fp = Util::OpenFile(filePath, "wb");
+	if (!fp) return false;
+	const size_t wSize = fwrite(buff.GetData(), 1, buff.GetSize(), fp);
+	fclose(fp);
+
+	return (wSize == buff.GetSize());
+}
+
+CModelCacheReader::CModelCacheReader()
+{
+	m_pSections    = NULL;
+	m_sectionCount = 0;
+}
+
+/**
+ * ファイルを開き、ヘッダとセクションテーブルを検証.
+ */
+bool CModelCacheReader::Open(const std::string& filePath)
+{
+	Close();
+	if (!m_file.Open(filePath)) return false;
+
+	const unsigned char* pData = m_file.GetData();
+	const uint64_t fileSize    = m_file.GetSize();
+	if (fileSize < sizeof(MMD_CACHE_HEADER)) {
+		Close();
+		return false;
+	}
+
+	const MMD_CACHE_HEADER* pHeader = (const MMD_CACHE_HEADER *)pData;
+	if (memcmp(pHeader->magic, MMD_CACHE_MAGIC, 8) != 0 || pHeader->version != MMD_CACHE_VERSION || pHeader->fileSize != fileSize) {
+		Close();
+		return false;
+	}
+	if (sizeof(MMD_CACHE_HEADER) + (uint64_t)sizeof(MMD_CACHE_SECTION) * pHeader->sectionCount > fileSize) {
+		Close();
+		return false;
+	}
+
+	m_pSections    = (const MMD_CACHE_SECTION *)(pData + sizeof(MMD_CACHE_HEADER));
+	m_sectionCount = (int)pHeader->sectionCount;
+
+	for (int i = 0; i < m_sectionCount; i++) {
+		const MMD_CACHE_SECTION& section = m_pSections[i];
+		if (section.size != (uint64_t)section.elementSize * section.elementCount || section.offset > fileSize || section.size > fileSize - section.offset) {
+			Close();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void CModelCacheReader::Close()
+{
+	m_file.Close();
+	m_pSections    = NULL;
+	m_sectionCount = 0;
+}
+
+/**
+ * セクションの先頭を取得.
+ */
+const void* CModelCacheReader::GetSection(const int id, const size_t elementSize, int* pRetCount) const
+{
+	*pRetCount = 0;
+	for (int i = 0; i < m_sectionCount; i++) {
+		const MMD_CACHE_SECTION& section = m_pSections[i];
+		if (section.id != (uint32_t)id) continue;
+		if (section.elementSize != elementSize) return NULL;
+		*pRetCount = (int)section.elementCount;
+		return m_file.GetData() + section.offset;
+	}
+	return NULL;
+}
+
+/**
+ * 固定長の文字列バッファにコピー (収まらない場合は切り詰め).
+ */
+void ModelCache::CopyString(char* dst, const size_t dstSize, const std::string& src)
+{
+	memset(dst, 0, dstSize);
+	const size_t len = std::min(src.length(), dstSize - 1);
+	if (len > 0) memcpy(dst, src.c_str(), len);
+}
+
+/**
+ * 固定長の文字列バッファから取得 (終端がない場合もバッファ内で打ち切る).
+ */
+std::string ModelCache::GetString(const char* src, const size_t srcSize)
+{
+	size_t len = 0;
+	while (len < srcSize && src[len] != '\0') len++;
+	return std::string(src, len);
+}
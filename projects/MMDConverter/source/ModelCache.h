@@ -0,0 +1,219 @@
+﻿/**
+ *  @brief  変換後のモデル情報のキャッシュファイル (.mmdcache).
+ *  @date   2026.10.19
+ */
+
+#ifndef _MODELCACHE_H
+#define _MODELCACHE_H
+
+#include "GlobalHeader.h"
+#include "BinaryBuffer.h"
+#include "MappedFile.h"
+
+#include <stdint.h>
+#include <vector>
+#include <string>
+
+/*
+	SetModel後(頂点の分割、マテリアル順の並び替え後)の情報を、そのままメモリにマップして参照できる形で保存する.
+	変換結果を外部のツールから参照するために使用 (エクスポータ自身は書き出しのみ行い、読み込みはしない).
+
+	[ヘッダ (MMD_CACHE_HEADER)]
+	[セクションテーブル (MMD_CACHE_SECTION x sectionCount)]
+	[各セクションのデータ (16バイト境界に配置、要素は固定長の構造体の配列)]
+
+	値はすべてリトルエンディアン、文字列はUTF-8でゼロ終端.
+*/
+
+#define MMD_CACHE_MAGIC			"MMDCACHE"		///< ファイル先頭の識別子 (8バイト).
+#define MMD_CACHE_VERSION		2				///< ファイルのバージョン.
+#define MMD_CACHE_ALIGNMENT		16				///< セクションの配置境界.
+#define MMD_CACHE_NAME_SIZE		64				///< 名前の最大バイト数(終端を含む).
+#define MMD_CACHE_TEXT_SIZE		512				///< コメントの最大バイト数(終端を含む).
+
+/**
+ * セクションの種類.
+ */
+enum {
+	mmd_cache_section_info = 1,				///< モデル情報 (MMD_CACHE_INFO x 1).
+	mmd_cache_section_vertices,				///< 頂点 (MMD_CACHE_VERTEX).
+	mmd_cache_section_triangles,			///< 三角形 (MMD_CACHE_TRIANGLE).
+	mmd_cache_section_materials,			///< マテリアル (MMD_CACHE_MATERIAL).
+	mmd_cache_section_bones,				///< ボーン (MMD_CACHE_BONE).
+	mmd_cache_section_iks,					///< IK (MMD_CACHE_IK).
+	mmd_cache_section_ik_children,			///< IK影響下のボーン番号 (int32).
+	mmd_cache_section_skins,				///< 表情 (MMD_CACHE_SKIN).
+	mmd_cache_section_skin_vertices,		///< 表情の頂点 (MMD_CACHE_SKIN_VERTEX).
+	mmd_cache_section_skin_groups,			///< 表情の種類ごとの先頭のインデックス (int32).
+	mmd_cache_section_bone_disps,			///< ボーン枠 (MMD_CACHE_BONE_DISP).
+	mmd_cache_section_bone_disp_items,		///< ボーン枠内のボーン (MMD_CACHE_BONE_DISP_ITEM).
+};
+
+typedef struct {
+	char magic[8];					///< MMD_CACHE_MAGIC.
+	uint32_t version;				///< MMD_CACHE_VERSION.
+	uint32_t sectionCount;			///< セクション数.
+	uint64_t fileSize;				///< ファイルのバイト数.
+	uint32_t reserved[2];
+} MMD_CACHE_HEADER;
+
+typedef struct {
+	uint32_t id;					///< セクションの種類 (mmd_cache_section_xxx).
+	uint32_t elementSize;			///< 要素のバイト数.
+	uint32_t elementCount;			///< 要素数.
+	uint32_t reserved;
+	uint64_t offset;				///< ファイル先頭からの位置.
+	uint64_t size;					///< バイト数.
+} MMD_CACHE_SECTION;
+
+typedef struct {
+	char model_name[MMD_CACHE_NAME_SIZE * 2];
+	char comment[MMD_CACHE_TEXT_SIZE];
+	char model_name_en[MMD_CACHE_NAME_SIZE * 2];
+	char comment_en[MMD_CACHE_TEXT_SIZE];
+	float scale;					///< 出力時のスケーリング.
+	int32_t human_rig_bones_type;	///< ボーン名の種類.
+	int32_t human_convert_bone_name;	///< ボーン名を自動的に変更 (0 or 1).
+	int32_t reserved;
+} MMD_CACHE_INFO;
+
+typedef struct {
+	float pos[3];
+	float normal[3];
+	float uv[2];
+	int32_t bone_num[2];
+	int32_t bone_weight;
+	int32_t edge_flag;
+} MMD_CACHE_VERTEX;
+
+typedef struct {
+	int32_t index[3];
+} MMD_CACHE_TRIANGLE;
+
+typedef struct {
+	float diffuse_color[3];
+	float alpha;
+	float specular;
+	float specular_color[3];
+	float ambient_color[3];
+	int32_t edge_flag;
+	int32_t toon_index;
+	int32_t face_vert_count;
+	char tex_file_name[MMD_CACHE_NAME_SIZE];
+} MMD_CACHE_MATERIAL;
+
+typedef struct {
+	char bone_name[MMD_CACHE_NAME_SIZE];
+	int32_t parent_bone_index;
+	int32_t tail_pos_bone_index;
+	int32_t bone_type;
+	int32_t ik_parent_bone_index;
+	float bone_head_pos[3];
+} MMD_CACHE_BONE;
+
+typedef struct {
+	int32_t ik_bone_index;
+	int32_t ik_target_bone_index;
+	int32_t iterations;
+	float control_weight;
+	int32_t child_offset;			///< mmd_cache_section_ik_children内の開始位置.
+	int32_t child_count;
+} MMD_CACHE_IK;
+
+typedef struct {
+	char name[MMD_CACHE_NAME_SIZE];
+	int32_t type;
+	int32_t base_skin;				///< baseの表情の場合は1.
+	int32_t vertex_offset;			///< mmd_cache_section_skin_vertices内の開始位置.
+	int32_t vertex_count;
+} MMD_CACHE_SKIN;
+
+typedef struct {
+	int32_t vert_index;
+	float pos[3];
+	int32_t org_i;
+} MMD_CACHE_SKIN_VERTEX;
+
+typedef struct {
+	char disp_name[MMD_CACHE_NAME_SIZE];
+	char disp_name_en[MMD_CACHE_NAME_SIZE];
+	int32_t item_offset;			///< mmd_cache_section_bone_disp_items内の開始位置.
+	int32_t item_count;
+} MMD_CACHE_BONE_DISP;
+
+typedef struct {
+	int32_t bone_disp_index;
+	int32_t bone_index;
+} MMD_CACHE_BONE_DISP_ITEM;
+
+/**
+ * キャッシュファイルの書き込み.
+ */
+class CModelCacheWriter
+{
+private:
+	std::vector<MMD_CACHE_SECTION> m_sections;
+	std::vector< std::vector<unsigned char> > m_sectionData;
+
+public:
+	/**
+	 * セクションを追加.
+	 */
+	void AddSection(const int id, const size_t elementSize, const size_t elementCount, const void* data);
+
+	template<typename T> void AddSection(const int id, const std::vector<T>& data) {
+		AddSection(id, sizeof(T), data.size(), data.empty() ? NULL : &(data[0]));
+	}
+
+	/**
+	 * ファイルに保存 (パスはUTF-8).
+	 */
+	bool Save(const std::string& filePath);
+};
+
+/**
+ * キャッシュファイルの読み込み (メモリマップ).
+ */
+class CModelCacheReader
+{
+private:
+	CMappedFile m_file;
+	const MMD_CACHE_SECTION* m_pSections;
+	int m_sectionCount;
+
+public:
+	CModelCacheReader();
+
+	/**
+	 * ファイルを開き、ヘッダとセクションテーブルを検証.
+	 */
+	bool Open(const std::string& filePath);
+	void Close();
+
+	/**
+	 * セクションの先頭を取得.
+	 * @param[in]  id             セクションの種類.
+	 * @param[in]  elementSize    要素のバイト数 (ファイル内と異なる場合はNULLを返す).
+	 * @param[out] pRetCount      要素数.
+	 * @return セクションがない場合はNULL.
+	 */
+	const void* GetSection(const int id, const size_t elementSize, int* pRetCount) const;
+
+	template<typename T> const T* GetSection(const int id, int* pRetCount) const {
+		return (const T *)GetSection(id, sizeof(T), pRetCount);
+	}
+};
+
+namespace ModelCache {
+	/**
+	 * 固定長の文字列バッファにコピー (収まらない場合は切り詰め).
+	 */
+	void CopyString(char* dst, const size_t dstSize, const std::string& src);
+
+	/**
+	 * 固定長の文字列バッファから取得 (終端がない場合もバッファ内で打ち切る).
+	 */
+	std::string GetString(const char* src, const size_t srcSize);
+}
+
+#endif
@@ -0,0 +1,131 @@
+﻿/**
+ *  @brief  ポリゴンメッシュの法線の生成 (スムーズ角度による法線の共有を指定できる).
+ *  @date   2026.10.19
+ */
+
+#include "NormalGenerator.h"
+
+#include <math.h>
+#include <algorithm>
+
+namespace {
+	inline float Dot(const sxsdk::vec3& a, const sxsdk::vec3& b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	/**
+	 * 正規化 (長さが0の場合はfalseを返す).
+	 */
+	inline bool Normalize(sxsdk::vec3& v)
+	{
+		const float len = sqrtf(Dot(v, v));
+		if (len <= 0.0f) return false;
+		v = v / len;
+		return true;
+	}
+
+	/**
+	 * [begin, end)の範囲でfunc(chunkBegin, chunkEnd)を呼ぶ (プールがある場合は並列に呼ぶ).
+	 */
+	void ForRange(CThreadPool* pPool, const int begin, const int end, const std::function<void(int, int)>& func)
+	{
+		if (pPool) {
+			pPool->ParallelForRange(begin, end, func, 256);
+		} else {
+			func(begin, end);
+		}
+	}
+}
+
+/**
+ * 面頂点ごとの法線を計算.
+ */
+void NormalGenerator::ComputeCornerNormals(const std::vector<sxsdk::vec3>& positions, const std::vector<int>& faceOffsets, const std::vector<int>& faceIndices, const float smoothingAngle, CThreadPool* pPool, std::vector<sxsdk::vec3>& retNormals)
+{
+	const int verCou    = positions.size();
+	const int faceCou   = std::max(0, (int)faceOffsets.size() - 1);
+	const int cornerCou = faceIndices.size();
+	retNormals.clear();
+	retNormals.resize(cornerCou, sxsdk::vec3(0, 1, 0));
+	if (verCou == 0 || faceCou == 0) return;
+
+	//---------------------------------------------------------.
+	// 面の法線 (Newellの方法) と、面頂点の角度.
+	//---------------------------------------------------------.
+	std::vector<sxsdk::vec3> faceNormals(faceCou, sxsdk::vec3(0, 0, 0));
+	std::vector<float> cornerAngles(cornerCou, 0.0f);
+	std::vector<int> cornerFaces(cornerCou, -1);
+	ForRange(pPool, 0, faceCou, [&](int begin, int end) {
+		for (int f = begin; f < end; f++) {
+			const int cStart = faceOffsets[f];
+			const int vCou   = faceOffsets[f + 1] - cStart;
+			if (vCou < 3) continue;
+
+			sxsdk::vec3 n(0, 0, 0);
+			for (int j = 0; j < vCou; j++) {
+				const sxsdk::vec3& p0 = positions[faceIndices[cStart + j]];
+				const sxsdk::vec3& p1 = positions[faceIndices[cStart + (j + 1) % vCou]];
+				n.x += (p0.y - p1.y) * (p0.z + p1.z);
+				n.y += (p0.z - p1.z) * (p0.x + p1.x);
+				n.z += (p0.x - p1.x) * (p0.y + p1.y);
+			}
+			if (!Normalize(n)) continue;
+			faceNormals[f] = n;
+
+			for (int j = 0; j < vCou; j++) {
+				const sxsdk::vec3& p  = positions[faceIndices[cStart + j]];
+				sxsdk::vec3 e0 = positions[faceIndices[cStart + (j + vCou - 1) % vCou]] - p;
+				sxsdk::vec3 e1 = positions[faceIndices[cStart + (j + 1) % vCou]] - p;
+				cornerFaces[cStart + j] = f;
+				if (!Normalize(e0) || !Normalize(e1)) continue;
+				cornerAngles[cStart + j] = acosf(std::max(-1.0f, std::min(1.0f, Dot(e0, e1))));
+			}
+		}
+	});
+
+	//---------------------------------------------------------.
+	// 頂点ごとの面頂点のリスト (面頂点番号の昇順).
+	//---------------------------------------------------------.
+	std::vector<int> vertexCornerOffsets(verCou + 1, 0);
+	for (int c = 0; c < cornerCou; c++) {
+		const int vIndex = faceIndices[c];
+		if (cornerFaces[c] >= 0 && vIndex >= 0 && vIndex < verCou) vertexCornerOffsets[vIndex + 1]++;
+	}
+	for (int i = 0; i < verCou; i++) vertexCornerOffsets[i + 1] += vertexCornerOffsets[i];
+	std::vector<int> vertexCorners(vertexCornerOffsets[verCou]);
+	{
+		std::vector<int> fillPos(vertexCornerOffsets.begin(), vertexCornerOffsets.end() - 1);
+		for (int c = 0; c < cornerCou; c++) {
+			const int vIndex = faceIndices[c];
+			if (cornerFaces[c] >= 0 && vIndex >= 0 && vIndex < verCou) vertexCorners[fillPos[vIndex]++] = c;
+		}
+	}
+
+	//---------------------------------------------------------.
+	// 面頂点の法線.
+	// 面の法線の角度がスムーズ角度以内の面を、面頂点の角度で重み付けして平均する.
+	//---------------------------------------------------------.
+	const float angle = std::max(0.0f, std::min(180.0f, smoothingAngle));
+	const float cosThreshold = cosf(angle * (float)(3.14159265358979 / 180.0));
+	ForRange(pPool, 0, verCou, [&](int begin, int end) {
+		for (int v = begin; v < end; v++) {
+			const int cStart = vertexCornerOffsets[v];
+			const int cEnd   = vertexCornerOffsets[v + 1];
+			for (int i = cStart; i < cEnd; i++) {
+				const int c = vertexCorners[i];
+				const sxsdk::vec3& fn = faceNormals[cornerFaces[c]];
+
+				sxsdk::vec3 n(0, 0, 0);
+				for (int j = cStart; j < cEnd; j++) {
+					const int c2 = vertexCorners[j];
+					const sxsdk::vec3& fn2 = faceNormals[cornerFaces[c2]];
+					if (c2 != c && Dot(fn, fn2) < cosThreshold) continue;
+					n += fn2 * cornerAngles[c2];
+				}
+				if (!Normalize(n)) n = fn;
+				retNormals[c] = n;
+			}
+		}
+	});
+}
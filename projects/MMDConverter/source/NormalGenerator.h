@@ -0,0 +1,35 @@
+﻿/**
+ *  @brief  ポリゴンメッシュの法線の生成 (スムーズ角度による法線の共有を指定できる).
+ *  @date   2026.10.19
+ */
+
+#ifndef _NORMALGENERATOR_H
+#define _NORMALGENERATOR_H
+
+#include "GlobalHeader.h"
+#include "ThreadPool.h"
+
+#include <vector>
+
+/*
+	面の法線はNewellの方法で求め、面頂点の法線は、同じ頂点を共有する面のうち
+	面の法線の角度がスムーズ角度以内のものを、面頂点の角度で重み付けして平均する.
+	同じ頂点の面頂点で共有する面が同じ場合は、同じ順番で加算するため法線も一致する.
+	(m_OptimizeVertexNormalUVで、同じ法線を持つ面頂点は1つの頂点にまとめられる).
+*/
+
+namespace NormalGenerator {
+	/**
+	 * 面頂点ごとの法線を計算.
+	 * シーンは参照しないため、ワーカースレッドから呼べる.
+	 * @param[in]  positions       頂点位置.
+	 * @param[in]  faceOffsets     面ごとの面頂点の開始位置 (面数 + 1個).
+	 * @param[in]  faceIndices     面頂点ごとの頂点番号.
+	 * @param[in]  smoothingAngle  スムーズ角度 (度). 面の法線の角度がこれ以内の場合に法線を共有する.
+	 * @param[in]  pPool           並列処理に使用するスレッドプール (NULLの場合は呼び出したスレッドで処理).
+	 * @param[out] retNormals      面頂点ごとの法線.
+	 */
+	void ComputeCornerNormals(const std::vector<sxsdk::vec3>& positions, const std::vector<int>& faceOffsets, const std::vector<int>& faceIndices, const float smoothingAngle, CThreadPool* pPool, std::vector<sxsdk::vec3>& retNormals);
+}
+
+#endif
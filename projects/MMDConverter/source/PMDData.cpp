@@ -6,6 +6,18 @@
 #include "PMDData.h"
 #include "Util.h"
 #include "RigCtrl.h"
+#include "TextureAtlas.h"
+#include "TextureWriter.h"
+#include "StageCache.h"
+#include "ModelCache.h"
+#include "PMDReader.h"
+#include "StageGraph.h"
+#include "VertexTransform.h"
+#include "NormalGenerator.h"
+
+#include <map>
+#include <algorithm>
+#include <math.h>
 
 namespace {
 
@@ -31,6 +43,47 @@ namespace {
 			m_triangleIndex[offset + 2] = i2;
 		}
 	};
+
+	/**
+	 * マテリアルの出力パラメータからハッシュ値を計算.
+	 */
+	uint64_t CalcMaterialHash(const PMD_MATERIAL_DATA& mData) {
+		uint64_t hash = Util::CalcHash(&mData.diffuse_color, sizeof(sxsdk::vec3));
+		hash = Util::CalcHash(&mData.alpha, sizeof(float), hash);
+		hash = Util::CalcHash(&mData.specular, sizeof(float), hash);
+		hash = Util::CalcHash(&mData.specular_color, sizeof(sxsdk::vec3), hash);
+		hash = Util::CalcHash(&mData.ambient_color, sizeof(sxsdk::vec3), hash);
+		hash = Util::CalcHash(&mData.edge_flag, sizeof(int), hash);
+		hash = Util::CalcHash(&mData.toon_index, sizeof(int), hash);
+		hash = Util::CalcHash(mData.tex_file_name.c_str(), mData.tex_file_name.length(), hash);
+		return hash;
+	}
+
+	/**
+	 * 2つのマテリアルの出力パラメータが同一か.
+	 */
+	bool IsSameMaterial(const PMD_MATERIAL_DATA& mData0, const PMD_MATERIAL_DATA& mData1) {
+		if (mData0.diffuse_color.x != mData1.diffuse_color.x || mData0.diffuse_color.y != mData1.diffuse_color.y || mData0.diffuse_color.z != mData1.diffuse_color.z) return false;
+		if (mData0.alpha != mData1.alpha || mData0.specular != mData1.specular) return false;
+		if (mData0.specular_color.x != mData1.specular_color.x || mData0.specular_color.y != mData1.specular_color.y || mData0.specular_color.z != mData1.specular_color.z) return false;
+		if (mData0.ambient_color.x != mData1.ambient_color.x || mData0.ambient_color.y != mData1.ambient_color.y || mData0.ambient_color.z != mData1.ambient_color.z) return false;
+		if (mData0.edge_flag != mData1.edge_flag || mData0.toon_index != mData1.toon_index) return false;
+		return (mData0.tex_file_name.compare(mData1.tex_file_name) == 0);
+	}
+
+	/**
+	 * キャッシュ内の[offset, offset + count)が、要素数totalの範囲に収まるか (オーバーフローしないように比較).
+	 */
+	bool IsCacheRangeValid(const int offset, const int count, const int total) {
+		return (offset >= 0 && count >= 0 && offset <= total && count <= total - offset);
+	}
+
+	/**
+	 * ボーン番号がボーン数boneCountの範囲内か (-1は参照なし).
+	 */
+	bool IsCacheBoneIndexValid(const int boneIndex, const int boneCount) {
+		return (boneIndex == -1 || (boneIndex >= 0 && boneIndex < boneCount));
+	}
 }
 
 extern std::string leg_ik_name_jp[] = {
@@ -60,11 +113,17 @@ extern std::string leg_ik_name_en[] = {
 CPMDData::CPMDData(sxsdk::shade_interface *shade) {
 	m_shade = shade;
 	m_pFacialSkin = NULL;
-
+	m_pTextureWriter = NULL;
+	m_pThreadPool = NULL;
+	m_pSharedThreadPool = NULL;
+	m_pSharedTextureCache = NULL;
+	m_pProgress = NULL;
 }
 
 CPMDData::~CPMDData() {
 	if (m_pFacialSkin) delete m_pFacialSkin;
+	if (m_pTextureWriter) delete m_pTextureWriter;
+	if (m_pThreadPool && m_pThreadPool != m_pSharedThreadPool) delete m_pThreadPool;
 }
 
 /**
@@ -74,6 +133,7 @@ void CPMDData::m_Init ()
 {
 	m_vertices.clear();
 	m_triangles.clear();
+	m_triangleWork.Clear();
 
 	m_modelName = "model name";
 	m_comment = "comment";
@@ -99,14 +159,34 @@ void CPMDData::m_Init ()
 	m_scale = 0.01f;
 	m_toonEdge = true;
 	m_boneMoveRootOnly = false;
+	m_mergeMaterials   = true;
+	m_textureAtlas     = false;
+	m_textureCache     = true;
+	m_textureMaxSize    = 0;
+	m_texturePowerOfTwo = false;
+	m_threadCount       = 0;
+	m_weldVertices      = false;
+	m_weldNormalAngle   = 1.0f;
+	m_weldUVDistance    = 0.0005f;
+	m_weldedVertexCount = 0;
+	m_textureFailedCount = 0;
+	m_removeDuplicateMorphs = false;
 	m_humanRigBonesNameCheck = 0.0f;
 	m_humanRigBonesType      = 0;
+	m_pSkeleton.reset();
 
-	m_pBoneRoot = NULL;
 
 	if (m_pFacialSkin) delete m_pFacialSkin;
 	m_pFacialSkin = NULL;
-	m_orgSameVertexList.clear();
+	if (m_pTextureWriter) delete m_pTextureWriter;
+	m_pTextureWriter = NULL;
+
+	// テクスチャの保存タスクが残っている可能性があるため、プールはCTextureWriterの後に破棄する.
+	if (m_pThreadPool && m_pThreadPool != m_pSharedThreadPool) delete m_pThreadPool;
+	m_pThreadPool = NULL;
+	m_pProgress = NULL;
+	m_orgSameVertexOffsets.clear();
+	m_orgSameVertexIndices.clear();
 }
 
 /**
@@ -163,29 +243,55 @@ std::string CPMDData::GetFileFullPathName(std::string fileName)
  * Shadeの形状データからPMD情報に変換.
  */
 bool CPMDData::SetModel(sxsdk::shape_class& shape, sxsdk::stream_interface *stream, const CPMDDlgInfo& pmdDlgData)
+{
+	CModelSnapshot snapshot;
+	if (!CaptureModel(shape, stream, pmdDlgData, snapshot)) return false;
+	if (!ConvertModel(snapshot, pmdDlgData)) return false;
+
+	// 範囲チェック.
+	const char* errorID = GetLimitErrorID();
+	if (errorID) {
+		m_shade->show_message_box(m_shade->gettext(errorID), false);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * 複数のモデルを並列に変換する場合に共有する、スレッドプールとテクスチャのキャッシュを指定.
+ */
+void CPMDData::SetSharedResources(CThreadPool* pPool, CTextureCache* pTextureCache)
+{
+	m_pSharedThreadPool   = pPool;
+	m_pSharedTextureCache = pTextureCache;
+}
+
+/**
+ * 出力設定を保持し、変換に必要なシーン情報をスナップショットとして取得.
+ */
+bool CPMDData::CaptureModel(sxsdk::shape_class& shape, sxsdk::stream_interface *stream, const CPMDDlgInfo& pmdDlgData, CModelSnapshot& retSnapshot, const std::vector<sxsdk::shape_class *>* pMergeShapes)
 {
 	Clear();
 
 	m_scale                = pmdDlgData.scale;
 	m_toonEdge             = pmdDlgData.toonEdge;
 	m_boneMoveRootOnly     = pmdDlgData.boneOffsetMoveRootOnly;
+	m_mergeMaterials       = pmdDlgData.mergeMaterials;
+	m_textureAtlas         = pmdDlgData.textureAtlas;
+	m_textureCache         = pmdDlgData.textureCache;
+	m_textureMaxSize        = pmdDlgData.textureMaxSize;
+	m_texturePowerOfTwo     = pmdDlgData.texturePowerOfTwo;
+	m_threadCount          = pmdDlgData.threadCount;
+	m_weldVertices         = pmdDlgData.weldVertices;
+	m_weldNormalAngle      = pmdDlgData.weldNormalAngle;
+	m_weldUVDistance       = pmdDlgData.weldUVDistance;
+	m_removeDuplicateMorphs = pmdDlgData.removeDuplicateMorphs;
 	m_humanConvertBoneName = pmdDlgData.humanConvertBoneName;
 
-	{
-		// ファイル名のフルパスより、セパレータ以降のファイル名をカット.
-		char *pPos;
-		char szFilePath[512];
-		strcpy(szFilePath, stream->get_name());
+	m_pThreadPool = m_pSharedThreadPool ? m_pSharedThreadPool : new CThreadPool(m_threadCount);
 
-#if SXWINDOWS
-		pPos = strrchr(szFilePath, '\\');
-		if(pPos) *pPos = '\0';
-#else
-		pPos = strrchr(szFilePath, '/');
-		if(pPos) *pPos = '\0';
-#endif
-		m_filePath = szFilePath;
-	}
+	m_filePath = Util::GetDirectoryToStream(stream);
 
 	m_modelName    = shape.get_name();
 	m_modelNameEng = m_modelName;
@@ -198,152 +304,274 @@ bool CPMDData::SetModel(sxsdk::shape_class& shape, sxsdk::stream_interface *stre
 		return false;
 	}
 
-	// 一度シーケンスOffにする（初期姿勢になるわけではないが、、、）.
-	compointer<sxsdk::scene_interface> scene(shape.get_scene_interface());
+	// 変換に必要なシーン情報を、スナップショットとしてまとめて取得.
+	// 以降の変換処理はスナップショットのみを参照する.
+	if (!retSnapshot.Capture(*m_shade, shape, true, !pmdDlgData.generateNormals)) return false;
+
+	// 同じボーンルートを持つポリゴンメッシュを連結し、1つのモデルとする.
+	if (pMergeShapes) {
+		for (int i = 0; i < pMergeShapes->size(); i++) {
+			sxsdk::shape_class* pShape = (*pMergeShapes)[i];
+			if (pShape == &shape) continue;
+
+			CModelSnapshot mergeSnapshot;
+			if (!mergeSnapshot.Capture(*m_shade, *pShape, false, !pmdDlgData.generateNormals)) continue;
+			retSnapshot.Append(mergeSnapshot);
+		}
+	}
+	return true;
+}
+
+/**
+ * スナップショットからPMD情報に変換 (シーンは参照しない).
+ */
+bool CPMDData::ConvertModel(CModelSnapshot& snapshot, const CPMDDlgInfo& pmdDlgData, CExportProgress* pProgress)
+{
+	m_pProgress = pProgress;
+	const bool ret = m_ConvertSnapshot(snapshot, pmdDlgData);
+	m_pProgress = NULL;
+	return ret;
+}
 
-	const bool dirtyF       = scene->get_dirty();
-	const bool sequenceMode = scene->get_sequence_mode();
-	if (sequenceMode) scene->set_sequence_mode(false);
+/**
+ * スナップショットからPMD情報に変換.
+ * 各処理はステージとして依存関係を指定し、依存しないステージは並列に実行する.
+ * 進捗はPMD_CONVERT_STEP_COUNTステップ進む.
+ */
+bool CPMDData::m_ConvertSnapshot(CModelSnapshot& snapshot, const CPMDDlgInfo& pmdDlgData)
+{
+	// 前回の表情データを破棄 (表情のステージで作り直す).
+	if (m_pFacialSkin) delete m_pFacialSkin;
+	m_pFacialSkin = NULL;
 
-	const sxsdk::mat4 lwMat = shape.get_local_to_world_matrix();
+	CStageGraph graph;
 
-	if (shape.get_type() == sxsdk::enums::polygon_mesh) {
-		sxsdk::polygon_mesh_class& pmesh = shape.get_polygon_mesh();
+	// 法線をプラグイン内で生成する場合は、三角形分割と並行して面頂点の法線を計算し、後から三角形に割り当てる.
+	const bool generateNormals = snapshot.faceNormals.size() != snapshot.faceIndices.size();
+	std::vector<int> triCorners;
 
+	// 頂点と三角形 (三角形分割でShade 3Dを呼び出す).
+	const int stageTriangles = graph.AddStage([this, &snapshot, &triCorners, generateNormals]() {
 		// 頂点情報を格納 (この段階では、頂点ごとの法線とＵＶは格納していない).
-		const int verCou = pmesh.get_total_number_of_control_points();
-		if (verCou <= 0) return false;
+		const int verCou = snapshot.positions.size();
 		m_vertices.resize(verCou);
-		PMD_VERTEX_DATA vData;
 		for (int i = 0; i < verCou; i++) {
-			sxsdk::vertex_class& v = pmesh.vertex(i);
-			vData.pos = v.get_position() * lwMat;
-
-			// スキンでの頂点の補間 （スキン変形後のものにする）.
-		//	const sxsdk::mat4 skin_m = v.get_skin().get_skin_world_matrix();
-		//	vData.pos = vData.pos * skin_m;
-
-			m_vertices[i] = vData;
-
+			m_vertices[i].pos = snapshot.positions[i];
 		}
 
-		pmesh.setup_normal();
-
-		// 面情報を格納.
-		PMD_TRIANGLE_DATA triData;
-		int indicesList[512];
-		std::vector<sxsdk::vec3> normals;
-		std::vector<sxsdk::vec3> vertices;
-		std::vector<sxsdk::vec2> uvs;
-		normals.resize(512);
-		uvs.resize(512);
-		const int faceCou = pmesh.get_number_of_faces();
-		for (int i = 0; i < faceCou; i++) {
-			sxsdk::face_class& f = pmesh.face(i);
-			const int vCou = f.get_number_of_vertices();
-			if (vCou > 510) continue;
-			pmesh.get_face_n_deprecated(i, indicesList, &(normals[0]));		// 法線はこれじゃないと正しく取得できない.
-			f.get_vertex_indices(indicesList);
-			//f.get_normals(&(normals[0]));
-
-			for (int j = 0; j < vCou; j++) uvs[j] = f.get_face_uv(0, j);
-
-			if (vCou == 3) {
-				triData.index[0]  = indicesList[0];
-				triData.index[1]  = indicesList[1];
-				triData.index[2]  = indicesList[2];
-				triData.normal[0] = normals[0];
-				triData.normal[1] = normals[1];
-				triData.normal[2] = normals[2];
-				triData.uv[0]     = uvs[0];
-				triData.uv[1]     = uvs[1];
-				triData.uv[2]     = uvs[2];
-				triData.orgFaceIndex = i;
-
-				m_triangles.push_back(triData);
-			} else {
-				// 三角形分割を行う.
-				vertices.resize(vCou);
-				for (int j = 0; j < vCou; j++) vertices[j] = m_vertices[indicesList[j]].pos;
-				::m_triangleIndex.clear();
-				::CDivideTrianglesOutput divC;
-				m_shade->divide_polygon(divC, vCou, &(vertices[0]), true);
-
-				const int triCou = ::m_triangleIndex.size() / 3;
-				int iPos = 0;
-				for (int j = 0; j < triCou; j++) {
-					triData.index[0]  = indicesList[m_triangleIndex[iPos + 0]];
-					triData.index[1]  = indicesList[m_triangleIndex[iPos + 1]];
-					triData.index[2]  = indicesList[m_triangleIndex[iPos + 2]];
-					triData.normal[0] = normals[m_triangleIndex[iPos + 0]];
-					triData.normal[1] = normals[m_triangleIndex[iPos + 1]];
-					triData.normal[2] = normals[m_triangleIndex[iPos + 2]];
-					triData.uv[0]     = uvs[m_triangleIndex[iPos + 0]];
-					triData.uv[1]     = uvs[m_triangleIndex[iPos + 1]];
-					triData.uv[2]     = uvs[m_triangleIndex[iPos + 2]];
-					triData.orgFaceIndex = i;
-					m_triangles.push_back(triData);
-					iPos += 3;
-				}
+		// 三角形分割.
+		std::vector<int> triFaces;
+		m_TriangulateFaces(snapshot.faceOffsets, snapshot.faceIndices, triCorners, triFaces);
+
+		// 三角形情報を格納 (面頂点ごとの法線/UVは、頂点の分割まで作業用として別に持つ).
+		const int triCou = triFaces.size();
+		m_triangles.resize(triCou);
+		m_triangleWork.normals.resize(triCou * 3);
+		m_triangleWork.uvs.resize(triCou * 3);
+		for (int i = 0; i < triCou; i++) {
+			PMD_TRIANGLE_DATA& triData = m_triangles[i];
+			for (int j = 0; j < 3; j++) {
+				const int cIndex = triCorners[i * 3 + j];
+				triData.index[j] = snapshot.faceIndices[cIndex];
+				if (!generateNormals) m_triangleWork.normals[i * 3 + j] = snapshot.faceNormals[cIndex];
+				m_triangleWork.uvs[i * 3 + j] = snapshot.faceUVs[cIndex];
 			}
 		}
+		m_triangleWork.orgFaceIndices.swap(triFaces);
+		m_StepProgress();
+	}, true);
+
+	// 法線の生成と、三角形への割り当て.
+	int stageTrianglesReady = stageTriangles;
+	if (generateNormals) {
+		const int stageNormals = graph.AddStage([this, &snapshot, &pmdDlgData]() {
+			NormalGenerator::ComputeCornerNormals(snapshot.positions, snapshot.faceOffsets, snapshot.faceIndices, pmdDlgData.smoothingAngle, m_pThreadPool, snapshot.faceNormals);
+		});
+		stageTrianglesReady = graph.AddStage([this, &snapshot, &triCorners]() {
+			for (int i = 0; i < triCorners.size(); i++) {
+				m_triangleWork.normals[i] = snapshot.faceNormals[triCorners[i]];
+			}
+		});
+		graph.AddDependency(stageTrianglesReady, stageTriangles);
+		graph.AddDependency(stageTrianglesReady, stageNormals);
 	}
 
 	// 表情のデータを取得する.
-	{
-		if (m_pFacialSkin) delete m_pFacialSkin;
+	const int stageFacial = graph.AddStage([this, &snapshot]() {
 		m_pFacialSkin = new CFacialSkin(m_shade);
-		m_pFacialSkin->StoreSkinData(scene, &shape, m_scale);
-	}
+		m_pFacialSkin->SetThreadPool(m_pThreadPool);
+		m_pFacialSkin->SetSnapshot(snapshot, m_scale);
 
-	// ボーンの保持.
-	m_SetBones(shape);
+		// 重複した表情と、頂点が移動しない表情を検出 (指定がある場合は削除).
+		m_pFacialSkin->FindDuplicateSkins(m_removeDuplicateMorphs);
+		m_StepProgress();
+	});
 
-	// 頂点に対応するボーンとスキンの保持.
-	m_SetVertexSkins(shape);
+	// ボーンの保持 (ボーン名の判定はボーン構造のキャッシュで済んでいる).
+	const int stageBones = graph.AddStage([this, &snapshot]() {
+		m_SetBones(snapshot);
+	});
 
-	// 法線/UVを、頂点ごとに割り当て.
-	m_OptimizeVertexNormalUV();
+	// 頂点に対応するボーンとスキンの保持.
+	const int stageSkins = graph.AddStage([this, &snapshot]() {
+		m_SetVertexSkins(snapshot);
+		m_StepProgress();
+	});
+	graph.AddDependency(stageSkins, stageTriangles);
+	graph.AddDependency(stageSkins, stageBones);
+
+	// マテリアルとテクスチャ.
+	const int stageMaterials = graph.AddStage([this, &snapshot]() {
+		// マテリアルを保持 (三角形はマテリアル順に並び替えられる).
+		m_SetMaterials(snapshot);
+
+		// テクスチャのピクセルを登録 (内容が同一のテクスチャは1つにまとめられる).
+		m_pTextureWriter = new CTextureWriter(m_filePath, m_textureCache, m_pThreadPool, m_pSharedTextureCache);
+		m_pTextureWriter->SetResize(m_textureMaxSize, m_texturePowerOfTwo);
+		m_StoreTextures(snapshot);
+
+		// テクスチャをアトラスにまとめる (三角形のUVも変換される).
+		if (m_textureAtlas) m_BuildTextureAtlas();
+
+		// 同一のマテリアルを統合.
+		if (m_mergeMaterials) m_MergeMaterials();
+
+		// テクスチャの保存を開始。以降の変換処理と並行して、ワーカースレッドで保存される.
+		m_WriteTextures();
+		m_StepProgress();
+	});
+	graph.AddDependency(stageMaterials, stageTrianglesReady);
+
+	// 法線/UVを、頂点ごとに割り当て (頂点の複製時にボーンとスキンも複製される).
+	// 以降は三角形の頂点番号のみを参照するため、作業用の法線/UVは解放する.
+	const int stageSplit = graph.AddStage([this]() {
+		m_OptimizeVertexNormalUV();
+		m_triangleWork.Clear();
+	});
+	graph.AddDependency(stageSplit, stageSkins);
+	graph.AddDependency(stageSplit, stageMaterials);
 
 	// 表情データに、頂点最適化後の情報を渡す.
-	if (m_pFacialSkin) {
-		m_pFacialSkin->UpdateVertices(m_orgSameVertexList);
-	}
+	const int stageFacialUpdate = graph.AddStage([this]() {
+		if (m_pFacialSkin) {
+			m_pFacialSkin->UpdateVertices(m_orgSameVertexOffsets, m_orgSameVertexIndices);
+		}
+		m_StepProgress();
+	});
+	graph.AddDependency(stageFacialUpdate, stageFacial);
+	graph.AddDependency(stageFacialUpdate, stageSplit);
+
+	// IKと表示枠 (ボーン名の変換でShade 3Dを呼び出す).
+	// ボーンが追加されるため、ボーンを参照するスキンの保持の後に行う.
+	const int stageIKs = graph.AddStage([this, &snapshot, &pmdDlgData]() {
+		// IK情報を保持.
+		m_SetIKs(snapshot);
+
+		// 足のIK(4つ分)を自動的に登録.
+		if (pmdDlgData.humanAutoIK) m_SetHumanBoneIKs();
+
+		// ボーンの表示枠情報の設定.
+		m_SetBonesDisp();
+		m_StepProgress();
+	}, true);
+	graph.AddDependency(stageIKs, stageBones);
+	graph.AddDependency(stageIKs, stageSkins);
+
+	if (!graph.Run(m_pThreadPool, m_pProgress)) return false;
+	return (m_pProgress == NULL || !m_pProgress->IsCanceled());
+}
 
-	// マテリアルを保持.
-	m_SetMaterials(scene, shape);
+/**
+ * 変換結果がPMDの制限を超える場合は、エラーメッセージのIDを返す.
+ */
+const char* CPMDData::GetLimitErrorID() const
+{
+	if (m_vertices.size() > 65535) return "msg_mesh_vertex_65535";
+	if (m_triangles.size() > 65535) return "msg_mesh_triangle_65535";
+	if (m_bones.size() > 500) return "msg_mesh_bone_500";
+	return NULL;
+}
 
-	// IK情報を保持.
-	m_SetIKs(scene, shape);
+/**
+ * 進捗を1ステップ進める.
+ */
+bool CPMDData::m_StepProgress()
+{
+	if (!m_pProgress) return true;
+	return m_pProgress->Step();
+}
 
-	// 足のIK(4つ分)を自動的に登録.
-	if (pmdDlgData.humanAutoIK) m_SetHumanBoneIKs();
+/**
+ * 面を三角形分割.
+ * 頂点位置と面の頂点番号が前回と同じ場合は、キャッシュした結果を使用する.
+ */
+void CPMDData::m_TriangulateFaces(const std::vector<int>& faceOffsets, const std::vector<int>& faceIndices, std::vector<int>& retTriCorners, std::vector<int>& retTriFaces)
+{
+	retTriCorners.clear();
+	retTriFaces.clear();
 
-	// ボーンの表示枠情報の設定.
-	m_SetBonesDisp();
+	const int faceCou = (int)faceOffsets.size() - 1;
+	if (faceCou <= 0) return;
 
-	scene->set_sequence_mode(sequenceMode);
-	scene->set_dirty(dirtyF);		// 保存フラグを元に戻す.
+	uint64_t key = Util::CalcHash(&(faceOffsets[0]), sizeof(int) * faceOffsets.size());
+	if (!faceIndices.empty()) key = Util::CalcHash(&(faceIndices[0]), sizeof(int) * faceIndices.size(), key);
+	for (int i = 0; i < m_vertices.size(); i++) key = Util::CalcHash(&(m_vertices[i].pos), sizeof(sxsdk::vec3), key);
 
-	// 範囲チェック.
-	if (m_vertices.size() > 65535) {
-		m_shade->show_message_box(m_shade->gettext("msg_mesh_vertex_65535"), false);
-		return false;
-	}
-	if (m_triangles.size() > 65535) {
-		m_shade->show_message_box(m_shade->gettext("msg_mesh_triangle_65535"), false);
-		return false;
+	{
+		CBinaryBuffer buff;
+		if (StageCache::Load("triangulate", key, buff)) {
+			if (buff.ReadVector(retTriCorners) && buff.ReadVector(retTriFaces)) return;
+			retTriCorners.clear();
+			retTriFaces.clear();
+		}
 	}
-	if (m_bones.size() > 500) {
-		m_shade->show_message_box(m_shade->gettext("msg_mesh_bone_500"), false);
-		return false;
+
+	// 三角形以外の面の分割はShade 3Dで行うため、まとめてメインスレッドで分割する.
+	std::vector< std::vector<int> > polygonTriangles;
+	polygonTriangles.resize(faceCou);
+	CExportTask::CallOnMainThread([&]() {
+		std::vector<sxsdk::vec3> vertices;
+		for (int i = 0; i < faceCou; i++) {
+			const int offset = faceOffsets[i];
+			const int vCou   = faceOffsets[i + 1] - offset;
+			if (vCou <= 3) continue;
+
+			vertices.resize(vCou);
+			for (int j = 0; j < vCou; j++) vertices[j] = m_vertices[faceIndices[offset + j]].pos;
+			::m_triangleIndex.clear();
+			::CDivideTrianglesOutput divC;
+			m_shade->divide_polygon(divC, vCou, &(vertices[0]), true);
+			polygonTriangles[i].swap(::m_triangleIndex);
+		}
+	});
+
+	for (int i = 0; i < faceCou; i++) {
+		const int offset = faceOffsets[i];
+		const int vCou   = faceOffsets[i + 1] - offset;
+		if (vCou == 3) {
+			retTriCorners.push_back(offset + 0);
+			retTriCorners.push_back(offset + 1);
+			retTriCorners.push_back(offset + 2);
+			retTriFaces.push_back(i);
+			continue;
+		}
+		if (vCou <= 0) continue;
+
+		const std::vector<int>& triangleIndex = polygonTriangles[i];
+		const int triCou = triangleIndex.size() / 3;
+		for (int j = 0; j < triCou * 3; j++) retTriCorners.push_back(offset + triangleIndex[j]);
+		for (int j = 0; j < triCou; j++) retTriFaces.push_back(i);
 	}
 
-	return true;
+	CBinaryBuffer buff;
+	buff.WriteVector(retTriCorners);
+	buff.WriteVector(retTriFaces);
+	StageCache::Store("triangulate", key, buff);
 }
 
 /**
  * UV/法線が異なる頂点で頂点を増やして対応.
+ * 入力(頂点と三角形)が前回と同じ場合は、キャッシュした結果を使用する.
  */
 void CPMDData::m_OptimizeVertexNormalUV()
 {
@@ -352,6 +580,40 @@ void CPMDData::m_OptimizeVertexNormalUV()
 	if (vCou == 0 || triCou == 0) return;
 
 	const int orgVCou = vCou;
+	m_weldedVertexCount = 0;
+
+	const std::vector<sxsdk::vec3>& cornerNormals = m_triangleWork.normals;
+	const std::vector<sxsdk::vec2>& cornerUVs     = m_triangleWork.uvs;
+	if (cornerNormals.size() != triCou * 3 || cornerUVs.size() != triCou * 3) return;
+
+	uint64_t key = Util::CalcHash(&(m_vertices[0]), sizeof(PMD_VERTEX_DATA) * vCou);
+	key = Util::CalcHash(&(m_triangles[0]), sizeof(PMD_TRIANGLE_DATA) * triCou, key);
+	key = Util::CalcHash(&(cornerNormals[0]), sizeof(sxsdk::vec3) * triCou * 3, key);
+	key = Util::CalcHash(&(cornerUVs[0]), sizeof(sxsdk::vec2) * triCou * 3, key);
+	if (m_weldVertices) {
+		const float weldParams[2] = { m_weldNormalAngle, m_weldUVDistance };
+		key = Util::CalcHash(weldParams, sizeof(float) * 2, key);
+	}
+	{
+		CBinaryBuffer buff;
+		if (StageCache::Load("split_vertices", key, buff)) {
+			std::vector<PMD_VERTEX_DATA> vertices;
+			std::vector<int> triIndices, sameOffsets, sameIndices;
+			int weldedCount = 0;
+			if (buff.ReadVector(vertices) && buff.ReadVector(triIndices) && buff.ReadVector(sameOffsets) && buff.ReadVector(sameIndices) && buff.ReadInt(weldedCount)) {
+				if (triIndices.size() == triCou * 3 && sameOffsets.size() == orgVCou + 1 && sameOffsets[orgVCou] == sameIndices.size()) {
+					m_vertices.swap(vertices);
+					for (int i = 0; i < triCou; i++) {
+						for (int j = 0; j < 3; j++) m_triangles[i].index[j] = triIndices[i * 3 + j];
+					}
+					m_orgSameVertexOffsets.swap(sameOffsets);
+					m_orgSameVertexIndices.swap(sameIndices);
+					m_weldedVertexCount = weldedCount;
+					return;
+				}
+			}
+		}
+	}
 
 	// 頂点ごとの共有三角形インデックスを一時的に保持.
 	std::vector< std::vector<int> > verticesTri;
@@ -364,72 +626,144 @@ void CPMDData::m_OptimizeVertexNormalUV()
 		verticesTri[triData.index[2]].push_back(i);
 	}
 
-	m_orgSameVertexList.clear();
-	m_orgSameVertexList.resize(orgVCou);
-	for (int i = 0; i < orgVCou; i++) m_orgSameVertexList[i].clear();
-
-	std::vector<int> verticesSIndex;
+	// 面頂点の法線/UVが同じとみなすか.
+	// 許容値で統合する場合は、法線の角度とUVの距離で判定する (法線は正規化済み).
+	const bool weldF = m_weldVertices;
+	const float weldNormalCos = cosf(std::max(0.0f, std::min(180.0f, m_weldNormalAngle)) * (float)(3.14159265358979 / 180.0));
+	const float weldUVDist2   = m_weldUVDistance * m_weldUVDistance;
+	auto isSameNormalUV = [weldF, weldNormalCos, weldUVDist2](const sxsdk::vec3& n0, const sxsdk::vec2& uv0, const sxsdk::vec3& n1, const sxsdk::vec2& uv1) {
+		if (sx::zero(n0 - n1) && sx::zero(uv0 - uv1)) return true;
+		if (!weldF) return false;
+		const float dotV = n0.x * n1.x + n0.y * n1.y + n0.z * n1.z;
+		const float du = uv0.x - uv1.x;
+		const float dv = uv0.y - uv1.y;
+		return (dotV >= weldNormalCos && (du * du + dv * dv) <= weldUVDist2);
+	};
 
 	// 頂点ごとでUVが異なる場合の頂点の増加.
-	for (int i = 0; i < orgVCou; i++) {
-		std::vector<int>& vTriIndex = verticesTri[i];
+	// 頂点ごとに独立しているため並列に処理する。三角形の頂点番号はここでは書き換えず、
+	// 増やした頂点の頂点内での番号をcornerVariantに保持しておき、後で通し番号に置き換える.
+	// 許容値で統合する場合、まとめた頂点は最初に現れた面頂点の法線/UVを使用する.
+	std::vector<int> cornerVariant(triCou * 3, -1);
+	std::vector< std::vector<PMD_VERTEX_DATA> > variants(orgVCou);
+	std::vector<int> weldedCounts(weldF ? orgVCou : 0, 0);
+	m_pThreadPool->ParallelFor(0, orgVCou, [this, &verticesTri, &cornerNormals, &cornerUVs, &cornerVariant, &variants, &weldedCounts, &isSameNormalUV, weldF](int i) {
+		const std::vector<int>& vTriIndex = verticesTri[i];
 		const int vvCou = vTriIndex.size();
-		if (vvCou == 0) continue;
+		if (vvCou == 0) return;
 
-		const PMD_TRIANGLE_DATA& triData0 = m_triangles[vTriIndex[0]];
+		// 三角形の中で、頂点iを参照していてまだ置き換えていない頂点の位置.
+		auto findCorner = [this, &cornerVariant, i](const int triIndex) {
+			const PMD_TRIANGLE_DATA& triData = m_triangles[triIndex];
+			for (int j = 0; j < 3; j++) {
+				if (triData.index[j] == i && cornerVariant[triIndex * 3 + j] < 0) return j;
+			}
+			return -1;
+		};
 
-		int i0 = -1;
-		if (triData0.index[0] == i) i0 = 0;
-		else if (triData0.index[1] == i) i0 = 1;
-		else if (triData0.index[2] == i) i0 = 2;
-		if (i0 < 0) continue;
+		const int i0 = findCorner(vTriIndex[0]);
+		if (i0 < 0) return;
 
-		const sxsdk::vec3& n0  = triData0.normal[i0];
-		const sxsdk::vec2& uv0 = triData0.uv[i0];
+		const sxsdk::vec3& n0  = cornerNormals[vTriIndex[0] * 3 + i0];
+		const sxsdk::vec2& uv0 = cornerUVs[vTriIndex[0] * 3 + i0];
 
 		PMD_VERTEX_DATA vData0 = m_vertices[i];
 		vData0.normal = n0;
 		vData0.uv     = uv0;
 		m_vertices[i] = vData0;
 
-		if (vvCou == 1) continue;
+		if (vvCou == 1) return;
 
-		verticesSIndex.clear();
-		for (int j = 1; j < vvCou; j++) {
-			PMD_TRIANGLE_DATA& triData1 = m_triangles[vTriIndex[j]];
+		// 許容値で統合する場合に、統合しなかった場合の頂点数を数えるための法線/UVのリスト.
+		std::vector< std::pair<sxsdk::vec3, sxsdk::vec2> > exactList;
+		if (weldF) exactList.push_back(std::make_pair(n0, uv0));
 
-			int i1 = -1;
-			if (triData1.index[0] == i) i1 = 0;
-			else if (triData1.index[1] == i) i1 = 1;
-			else if (triData1.index[2] == i) i1 = 2;
+		std::vector<PMD_VERTEX_DATA>& vVariants = variants[i];
+		for (int j = 1; j < vvCou; j++) {
+			const int i1 = findCorner(vTriIndex[j]);
 			if (i1 < 0) continue;
 
-			const sxsdk::vec3& n1  = triData1.normal[i1];
-			const sxsdk::vec2& uv1 = triData1.uv[i1];
+			const sxsdk::vec3& n1  = cornerNormals[vTriIndex[j] * 3 + i1];
+			const sxsdk::vec2& uv1 = cornerUVs[vTriIndex[j] * 3 + i1];
 
-			if (sx::zero(n0 - n1) && sx::zero(uv0 - uv1)) continue; 
+			if (weldF) {
+				bool foundF = false;
+				for (int k = 0; k < exactList.size() && !foundF; k++) {
+					foundF = sx::zero(exactList[k].first - n1) && sx::zero(exactList[k].second - uv1);
+				}
+				if (!foundF) exactList.push_back(std::make_pair(n1, uv1));
+			}
+
+			if (isSameNormalUV(n0, uv0, n1, uv1)) continue;
 
 			int index = -1;
-			for (int k = 0; k < verticesSIndex.size(); k++) {
-				PMD_VERTEX_DATA& vData2 = m_vertices[verticesSIndex[k]];
-				if (sx::zero(vData2.normal - n1) && sx::zero(vData2.uv - uv1)) {
-					index = verticesSIndex[k];
+			for (int k = 0; k < vVariants.size(); k++) {
+				if (isSameNormalUV(vVariants[k].normal, vVariants[k].uv, n1, uv1)) {
+					index = k;
 					break;
 				}
 			}
-			if (index >= 0) {
-				triData1.index[i1] = index;
-			} else {
+			if (index < 0) {
 				PMD_VERTEX_DATA vData = vData0;
 				vData.normal = n1;
 				vData.uv     = uv1;
-				m_vertices.push_back(vData);
-				triData1.index[i1] = m_vertices.size() - 1;
-				verticesSIndex.push_back(triData1.index[i1]);
-
-				m_orgSameVertexList[i].push_back(triData1.index[i1]);		// 表情(FacialSkin)を格納する際の頂点情報用.
+				vVariants.push_back(vData);
+				index = vVariants.size() - 1;
 			}
+			cornerVariant[vTriIndex[j] * 3 + i1] = index;
 		}
+		if (weldF) weldedCounts[i] = (int)exactList.size() - (1 + (int)vVariants.size());
+	}, 256);
+	for (int i = 0; i < weldedCounts.size(); i++) m_weldedVertexCount += weldedCounts[i];
+
+	// 増やした頂点の通し番号 (元の頂点順に末尾に追加).
+	std::vector<int> variantBase(orgVCou);
+	int newVCou = orgVCou;
+	for (int i = 0; i < orgVCou; i++) {
+		variantBase[i] = newVCou;
+		newVCou += variants[i].size();
+	}
+	m_vertices.resize(newVCou);
+
+	m_pThreadPool->ParallelFor(0, orgVCou, [this, &variants, &variantBase](int i) {
+		const std::vector<PMD_VERTEX_DATA>& vVariants = variants[i];
+		for (int k = 0; k < vVariants.size(); k++) {
+			m_vertices[variantBase[i] + k] = vVariants[k];
+		}
+	}, 256);
+
+	// 表情(FacialSkin)を格納する際の頂点情報用.
+	// 増やした頂点は元の頂点順に連続して並ぶため、元の頂点ごとの範囲として保持する.
+	m_orgSameVertexOffsets.resize(orgVCou + 1);
+	for (int i = 0; i < orgVCou; i++) m_orgSameVertexOffsets[i] = variantBase[i] - orgVCou;
+	m_orgSameVertexOffsets[orgVCou] = newVCou - orgVCou;
+	m_orgSameVertexIndices.resize(newVCou - orgVCou);
+	for (int i = 0; i < m_orgSameVertexIndices.size(); i++) m_orgSameVertexIndices[i] = orgVCou + i;
+
+	// 三角形の頂点番号を、増やした頂点に置き換え.
+	m_pThreadPool->ParallelFor(0, triCou, [this, &cornerVariant, &variantBase](int i) {
+		PMD_TRIANGLE_DATA& triData = m_triangles[i];
+		for (int j = 0; j < 3; j++) {
+			const int index = cornerVariant[i * 3 + j];
+			if (index >= 0) triData.index[j] = variantBase[triData.index[j]] + index;
+		}
+	}, 1024);
+
+	// 結果をキャッシュに格納.
+	{
+		std::vector<int> triIndices;
+		triIndices.resize(triCou * 3);
+		for (int i = 0; i < triCou; i++) {
+			for (int j = 0; j < 3; j++) triIndices[i * 3 + j] = m_triangles[i].index[j];
+		}
+
+		CBinaryBuffer buff;
+		buff.WriteVector(m_vertices);
+		buff.WriteVector(triIndices);
+		buff.WriteVector(m_orgSameVertexOffsets);
+		buff.WriteVector(m_orgSameVertexIndices);
+		buff.WriteInt(m_weldedVertexCount);
+		StageCache::Store("split_vertices", key, buff);
 	}
 }
 
@@ -437,53 +771,30 @@ void CPMDData::m_OptimizeVertexNormalUV()
 /**
  * マテリアルの保持.
  */
-void CPMDData::m_SetMaterials(sxsdk::scene_interface* scene, sxsdk::shape_class& shape)
+void CPMDData::m_SetMaterials(const CModelSnapshot& snapshot)
 {
-	const int type = shape.get_type();
-	if (type != sxsdk::enums::polygon_mesh) return;
-
-	sxsdk::polygon_mesh_class& pmesh = shape.get_polygon_mesh();
-	const int faceGroupCou = pmesh.get_number_of_face_groups();
+	const std::vector<SNAPSHOT_MATERIAL>& materials = snapshot.materials;
+	if (materials.empty()) return;
+	const int faceGroupCou = (int)materials.size() - 1;
 
 	//---------------------------------------------------------.
-	// とりあえず、shapeに関連する全部のマテリアルを格納.
+	// shapeに関連する全部のマテリアルごとの三角形数.
+	// [0]は形状自身の表面材質、[1]以降はフェイスグループの表面材質.
 	//---------------------------------------------------------.
-	std::vector<sxsdk::surface_class *> shapeSurfaces;
-	std::vector<sxsdk::master_surface_class *> shapeMasterSurfaces;
 	std::vector<int> shapeSurfacesCou;
-
-	if (shape.has_surface()) {
-		shapeSurfaces.push_back(shape.get_surface());
-	} else {
-		shapeSurfaces.push_back(NULL);
-	}
-	shapeMasterSurfaces.push_back(NULL);
-
-	const int faceGroupOffset = shapeSurfaces.size();
-	for (int i = 0; i < faceGroupCou; i++) {
-		sxsdk::master_surface_class *mSurface = pmesh.get_face_group_surface(i);
-		if (mSurface) {
-			shapeSurfaces.push_back(mSurface->get_surface());
-			shapeMasterSurfaces.push_back(mSurface);
-		} else {
-			shapeSurfaces.push_back(NULL);
-			shapeMasterSurfaces.push_back(NULL);
-		}
-	}
-	shapeSurfacesCou.resize(shapeSurfaces.size());
-	for (int i = 0; i < shapeSurfacesCou.size(); i++) shapeSurfacesCou[i] = 0;
+	shapeSurfacesCou.resize(materials.size(), 0);
 
 	//---------------------------------------------------------.
 	//	面ごとのsurfaceを保持.
 	//---------------------------------------------------------.
-	const int faceCou = pmesh.get_number_of_faces();
+	const int faceCou = snapshot.faceGroups.size();
 	std::vector<int> faceSurfaceIndex;
 	faceSurfaceIndex.resize(faceCou);
 	for (int i = 0; i < faceCou; i++) {
 		faceSurfaceIndex[i] = -1;
-		const int fIndex = pmesh.get_face_group_index(i);
-		if (fIndex >= 0 && shapeSurfaces[faceGroupOffset + fIndex] != NULL) {
-			faceSurfaceIndex[i] = faceGroupOffset + fIndex;
+		const int fIndex = snapshot.faceGroups[i];
+		if (fIndex >= 0 && fIndex < faceGroupCou && materials[1 + fIndex].has_surface) {
+			faceSurfaceIndex[i] = 1 + fIndex;
 		}
 	}
 
@@ -491,8 +802,7 @@ void CPMDData::m_SetMaterials(sxsdk::scene_interface* scene, sxsdk::shape_class&
 	std::vector<int> triSurfaceIndex;
 	triSurfaceIndex.resize(triCou);
 	for (int i = 0; i < triCou; i++) {
-		PMD_TRIANGLE_DATA& triData = m_triangles[i];
-		const int orgFaceIndex = triData.orgFaceIndex;
+		const int orgFaceIndex = m_triangleWork.orgFaceIndices[i];
 		triSurfaceIndex[i] = faceSurfaceIndex[orgFaceIndex];
 		if (triSurfaceIndex[i] >= 0) {
 			shapeSurfacesCou[triSurfaceIndex[i]]++;
@@ -501,158 +811,288 @@ void CPMDData::m_SetMaterials(sxsdk::scene_interface* scene, sxsdk::shape_class&
 		}
 	}
 
-	// 環境光の影響は、光源から取得.
-	sxsdk::rgb_class ambientCol = sxsdk::rgb_class(0.2f, 0.2f, 0.2f);
-	{
-		compointer<sxsdk::distant_light_interface> distantLight(scene->get_distant_light_interface());
-		if (distantLight) {
-			if ((distantLight->get_number_of_lights()) > 0) {
-				sxsdk::distant_light_item_class& LInfo = distantLight->distant_light_item(0);
-				const float ambVal = LInfo.get_ambient();
-				const sxsdk::rgb_class ambCol = LInfo.get_light_color();
-				ambientCol = ambCol * ambVal;
-			}
-		}
-	}
-
 	//---------------------------------------------------------.
 	// PMD用に並び替え.
 	//---------------------------------------------------------.
-	std::vector<PMD_TRIANGLE_DATA> oldTriangles = m_triangles;
-	m_triangles.clear();
+	std::vector<int> triOrder;
+	triOrder.reserve(triCou);
 	for (int loop = 0; loop < shapeSurfacesCou.size(); loop++) {
 		if (shapeSurfacesCou[loop] == 0) continue;
 		const int sIndex = loop;
 		int cou = 0;
-		for (int i = 0; i < oldTriangles.size(); i++) {
+		for (int i = 0; i < triCou; i++) {
 			const int sIndex2 = (triSurfaceIndex[i] < 0) ? 0 : triSurfaceIndex[i];
 			if (sIndex != sIndex2) continue;
-			m_triangles.push_back(oldTriangles[i]);
+			triOrder.push_back(i);
 			cou++;
 		}
 		if (cou == 0) continue;
 
-		sxsdk::surface_class* pSurface = shapeSurfaces[loop];
+		const SNAPSHOT_MATERIAL& surface = materials[loop];
 		PMD_MATERIAL_DATA material;
-		if (pSurface) {
-			sxsdk::rgb_class col = (pSurface->get_diffuse_color()) * (pSurface->get_diffuse());
-			material.diffuse_color = sxsdk::vec3(col.red, col.green, col.blue);
-
-			float specularVal = pSurface->get_highlight();
-			if (specularVal < 0.0f) specularVal = 0.0f;
-			if (specularVal > 1.0f) specularVal = 1.0f;
-			material.specular = (pSurface->get_highlight_size()) * 20.0f;
-			col = (pSurface->get_highlight_color()) * specularVal;
-			material.specular_color = sxsdk::vec3(col.red, col.green, col.blue);
-
-			material.alpha = 1.0f - (pSurface->get_transparency());
-
-			sxsdk::rgb_class ambCol = ambientCol;
-			if (pSurface->get_has_ambient()) {
-				ambCol = ambCol * ((pSurface->get_ambient_color()) * (pSurface->get_ambient()));
-			}
-			material.ambient_color = sxsdk::vec3(ambCol.red, ambCol.green, ambCol.blue);
+		if (surface.has_surface) {
+			material.diffuse_color  = surface.diffuse_color;
+			material.alpha          = surface.alpha;
+			material.specular       = surface.specular;
+			material.specular_color = surface.specular_color;
+			material.ambient_color  = surface.ambient_color;
 		}
 		// 対応する面頂点リストのデータ数.
 		material.face_vert_count = cou * 3;
+		material.surface_index   = loop;
 
-		// テクスチャを保存.
+		// テクスチャ名 (保存はm_WriteTexturesで行う).
 		if (loop >= 1) {
-			const int mappingCou = pSurface->get_number_of_mapping_layers();
-			if (mappingCou > 0) {
-				int mappingIndex = -1;
-				for (int i = 0; i < mappingCou; i++) {
-					sxsdk::mapping_layer_class& mLayer = pSurface->mapping_layer(i);
-					if (mLayer.get_type() == sxsdk::enums::diffuse_mapping && mLayer.get_pattern() == sxsdk::enums::image_pattern) {
-						mappingIndex = i;
-						break;
-					}
-				}
-				if (mappingIndex >= 0) {
-					sxsdk::mapping_layer_class& mLayer = pSurface->mapping_layer(mappingIndex);
-					compointer<sxsdk::image_interface> image(mLayer.get_image_interface());
-					if (image && image->has_image()) {
-						// テクスチャ名は20バイト以内.
-						char szName[64];
-						sprintf(szName, "tex_%d.png", loop);
-						material.tex_file_name = szName;
-
-						sxsdk::master_image_class* pMImage = Util::GetMasterImageFromImage(scene, image);
-						if (pMImage) {
-							std::string name = pMImage->get_name();
-
-							// 末尾から見て「\」「/」がある場合はカット.
-							{
-								int pos = name.find_last_of("\\");
-								if (pos != std::string::npos) {
-									name = name.substr(pos + 1);
-								}
-								pos = name.find_last_of("/");
-								if (pos != std::string::npos) {
-									name = name.substr(pos + 1);
-								}
-							}
-
-							// 末尾の「.」以降をカット.
-							{
-								int pos = name.find_last_of(".");
-								if (pos != std::string::npos) {
-									name = name.substr(0, pos);
-								}
-							}
-							name = name + ".png";
-
-							if (name.length() < 20) {
-								strcpy(szName, name.c_str());
-								material.tex_file_name = szName;
-							}
-						}
+			material.tex_file_name       = surface.tex_file_name;
+			material.texture_layer_index = surface.texture_layer_index;
+		}
 
-						image->save(GetFileFullPathName(szName).c_str());
-					}
-				}
+		material.edge_flag = m_toonEdge ? 1 : 0;		// トゥーンのエッジ表現.
+
+		m_materials.push_back(material);
+	}
+
+	m_ReorderTriangles(triOrder);
+}
+
+/**
+ * 同一パラメータのマテリアルを統合し、三角形を連続した範囲にまとめる.
+ * m_trianglesはマテリアル順に並んでいるため、統合されるマテリアルの三角形範囲を統合先の位置に移動する.
+ */
+void CPMDData::m_MergeMaterials()
+{
+	const int mCou = m_materials.size();
+	if (mCou <= 1) return;
+
+	// マテリアルごとの三角形の開始位置.
+	std::vector<int> triOffset;
+	triOffset.resize(mCou + 1, 0);
+	for (int i = 0; i < mCou; i++) {
+		triOffset[i + 1] = triOffset[i] + m_materials[i].face_vert_count / 3;
+	}
+	if (triOffset[mCou] != (int)m_triangles.size()) return;
+
+	// 出力パラメータのハッシュより、同一のマテリアルを探す.
+	std::map< uint64_t, std::vector<int> > hashMaterials;
+	std::vector<int> mergeIndex;		// 統合先のマテリアル番号.
+	mergeIndex.resize(mCou, -1);
+	int mergeCou = 0;
+	for (int i = 0; i < mCou; i++) {
+		std::vector<int>& list = hashMaterials[::CalcMaterialHash(m_materials[i])];
+		for (int j = 0; j < list.size(); j++) {
+			if (::IsSameMaterial(m_materials[list[j]], m_materials[i])) {
+				mergeIndex[i] = list[j];
+				mergeCou++;
+				break;
 			}
 		}
+		if (mergeIndex[i] < 0) {
+			mergeIndex[i] = i;
+			list.push_back(i);
+		}
+	}
+	if (mergeCou == 0) return;
 
-		material.edge_flag = m_toonEdge ? 1 : 0;		// トゥーンのエッジ表現.
+	// 統合先のマテリアルの位置に、三角形をまとめて並び替え.
+	std::vector<int> triOrder;
+	std::vector<PMD_MATERIAL_DATA> oldMaterials;
+	triOrder.reserve(m_triangles.size());
+	oldMaterials.swap(m_materials);
 
+	for (int i = 0; i < mCou; i++) {
+		if (mergeIndex[i] != i) continue;
+		PMD_MATERIAL_DATA material = oldMaterials[i];
+		material.face_vert_count = 0;
+		for (int j = i; j < mCou; j++) {
+			if (mergeIndex[j] != i) continue;
+			for (int k = triOffset[j]; k < triOffset[j + 1]; k++) triOrder.push_back(k);
+			material.face_vert_count += oldMaterials[j].face_vert_count;
+		}
 		m_materials.push_back(material);
 	}
+
+	m_ReorderTriangles(triOrder);
 }
 
 /**
- * 指定のボーン名がすでに格納済みか.
+ * 三角形を指定の順に並び替え (作業用の法線/UVも合わせて並び替える).
  */
-int CPMDData::m_FindBone(const std::string boneName)
+void CPMDData::m_ReorderTriangles(const std::vector<int>& triOrder)
 {
-	if (boneName.size() == 0) return -1;
+	const int triCou = triOrder.size();
+	{
+		std::vector<PMD_TRIANGLE_DATA> triangles(triCou);
+		for (int i = 0; i < triCou; i++) triangles[i] = m_triangles[triOrder[i]];
+		m_triangles.swap(triangles);
+	}
 
-	int boneIndex = -1;
-	for (int i = 0; i < m_bones.size(); i++) {
-		if (m_bones[i].bone_name.compare(boneName) == 0) {
-			boneIndex = i;
-			break;
+	PMD_TRIANGLE_WORK& work = m_triangleWork;
+	if (!work.normals.empty()) {
+		std::vector<sxsdk::vec3> normals(triCou * 3);
+		for (int i = 0; i < triCou; i++) {
+			for (int j = 0; j < 3; j++) normals[i * 3 + j] = work.normals[triOrder[i] * 3 + j];
+		}
+		work.normals.swap(normals);
+	}
+	if (!work.uvs.empty()) {
+		std::vector<sxsdk::vec2> uvs(triCou * 3);
+		for (int i = 0; i < triCou; i++) {
+			for (int j = 0; j < 3; j++) uvs[i * 3 + j] = work.uvs[triOrder[i] * 3 + j];
+		}
+		work.uvs.swap(uvs);
+	}
+	if (!work.orgFaceIndices.empty()) {
+		std::vector<int> orgFaceIndices(triCou);
+		for (int i = 0; i < triCou; i++) orgFaceIndices[i] = work.orgFaceIndices[triOrder[i]];
+		work.orgFaceIndices.swap(orgFaceIndices);
+	}
+}
+
+/**
+ * テクスチャをアトラスにまとめ、三角形のUVをアトラス上のものに変換.
+ * UVが0.0-1.0の範囲に収まる(繰り返しのない)マテリアルのテクスチャのみを対象とする.
+ */
+void CPMDData::m_BuildTextureAtlas()
+{
+	const int mCou = m_materials.size();
+	if (mCou <= 1) return;
+
+	// マテリアルごとの三角形の開始位置.
+	std::vector<int> triOffset;
+	triOffset.resize(mCou + 1, 0);
+	for (int i = 0; i < mCou; i++) {
+		triOffset[i + 1] = triOffset[i] + m_materials[i].face_vert_count / 3;
+	}
+	if (triOffset[mCou] != (int)m_triangles.size()) return;
+
+	//---------------------------------------------------------.
+	// アトラスに格納できるテクスチャのピクセルを取得.
+	//---------------------------------------------------------.
+	const float uvMargin = 1e-4f;
+	CTextureAtlas textureAtlas;
+	std::map<int, int> texIndexMap;		// CTextureWriterでのテクスチャ番号に対応するアトラス内のテクスチャ番号.
+	std::vector<int> materialTexIndex;
+	materialTexIndex.resize(mCou, -1);
+
+	for (int i = 0; i < mCou; i++) {
+		PMD_MATERIAL_DATA& material = m_materials[i];
+		if (material.texture_index < 0) continue;
+
+		bool chkF = true;
+		for (int j = triOffset[i] * 3; j < triOffset[i + 1] * 3; j++) {
+			const sxsdk::vec2& uv = m_triangleWork.uvs[j];
+			if (uv.x < -uvMargin || uv.x > 1.0f + uvMargin || uv.y < -uvMargin || uv.y > 1.0f + uvMargin) {
+				chkF = false;
+				break;
+			}
+		}
+		if (!chkF) continue;
+
+		std::map<int, int>::iterator it = texIndexMap.find(material.texture_index);
+		if (it != texIndexMap.end()) {
+			materialTexIndex[i] = it->second;
+			continue;
+		}
+
+		const TEXTURE_WRITER_DATA& tex = m_pTextureWriter->GetTexture(material.texture_index);
+		if (tex.width + TEXTURE_ATLAS_PADDING * 2 > TEXTURE_ATLAS_MAX_SIZE || tex.height + TEXTURE_ATLAS_PADDING * 2 > TEXTURE_ATLAS_MAX_SIZE) continue;
+
+		if (!tex.pixels) continue;
+		std::vector<sx::rgba8_class> pixels(*tex.pixels);
+		const int texIndex = textureAtlas.AddTexture(tex.width, tex.height, pixels);
+		texIndexMap[material.texture_index] = texIndex;
+		materialTexIndex[i] = texIndex;
+	}
+
+	// 2つ以上のテクスチャがない場合は、アトラスにしない.
+	if (textureAtlas.GetTexturesCount() <= 1) return;
+
+	//---------------------------------------------------------.
+	// テクスチャを配置して、アトラス画像をCTextureWriterに登録.
+	//---------------------------------------------------------.
+	const int atlasCou = textureAtlas.Build(TEXTURE_ATLAS_MAX_SIZE, m_pThreadPool);
+	if (atlasCou == 0) return;
+
+	std::vector<int> atlasTexIndex;
+	atlasTexIndex.resize(atlasCou, -1);
+	for (int i = 0; i < atlasCou; i++) {
+		const ATLAS_IMAGE_DATA& atlas = textureAtlas.GetAtlas(i);
+
+		char szName[64];
+		sprintf(szName, "atlas_%d.png", i);
+
+		std::vector<sx::rgba8_class> pixels(atlas.pixels);
+		atlasTexIndex[i] = m_pTextureWriter->AddTexture(atlas.width, atlas.height, pixels, szName);
+	}
+
+	//---------------------------------------------------------.
+	// マテリアルのテクスチャとUVを、アトラスのものに置き換え.
+	//---------------------------------------------------------.
+	for (int i = 0; i < mCou; i++) {
+		const int texIndex = materialTexIndex[i];
+		if (texIndex < 0) continue;
+		const int atlasIndex = textureAtlas.GetTexture(texIndex).atlas_index;
+		if (atlasIndex < 0 || atlasTexIndex[atlasIndex] < 0) continue;
+
+		PMD_MATERIAL_DATA& material = m_materials[i];
+		material.texture_index = atlasTexIndex[atlasIndex];
+		material.tex_file_name = m_pTextureWriter->GetTexture(material.texture_index).file_name;
+
+		for (int j = triOffset[i] * 3; j < triOffset[i + 1] * 3; j++) {
+			sxsdk::vec2 uv = m_triangleWork.uvs[j];
+			uv.x = std::max(0.0f, std::min(1.0f, uv.x));
+			uv.y = std::max(0.0f, std::min(1.0f, uv.y));
+			m_triangleWork.uvs[j] = textureAtlas.ConvUV(texIndex, uv);
+		}
+	}
+}
+
+/**
+ * マテリアルのテクスチャのピクセルをCTextureWriterに登録.
+ * ピクセルの内容が同一のテクスチャは同じファイル名となるため、m_MergeMaterialsでマテリアルも統合される.
+ * スナップショットのピクセルはCTextureWriterに移される.
+ */
+void CPMDData::m_StoreTextures(CModelSnapshot& snapshot)
+{
+	for (int i = 0; i < m_materials.size(); i++) {
+		PMD_MATERIAL_DATA& material = m_materials[i];
+		if (material.texture_layer_index < 0 || material.surface_index < 0 || material.surface_index >= snapshot.materials.size()) continue;
+
+		SNAPSHOT_MATERIAL& surface = snapshot.materials[material.surface_index];
+		if (surface.tex_pixels.empty()) continue;
+
+		material.texture_index = m_pTextureWriter->AddTexture(surface.tex_width, surface.tex_height, surface.tex_pixels, material.tex_file_name);
+		if (material.texture_index >= 0) {
+			material.tex_file_name = m_pTextureWriter->GetTexture(material.texture_index).file_name;
 		}
 	}
-	return boneIndex;
 }
 
 /**
- * 指定のボーン形状がすでに格納済みか.
+ * マテリアルが参照するテクスチャの保存を開始 (保存はワーカースレッドで行われる).
  */
-int CPMDData::m_FindBone(sxsdk::shape_class* pShape)
+void CPMDData::m_WriteTextures()
 {
-	if (!pShape) return -1;
+	for (int i = 0; i < m_materials.size(); i++) {
+		m_pTextureWriter->Write(m_materials[i].texture_index);
+	}
+}
+
+/**
+ * 指定のボーン名がすでに格納済みか.
+ */
+int CPMDData::m_FindBone(const std::string boneName)
+{
+	if (boneName.size() == 0) return -1;
 
 	int boneIndex = -1;
 	for (int i = 0; i < m_bones.size(); i++) {
-		if (m_bones[i].pShadeShape == pShape) {
+		if (m_bones[i].bone_name.compare(boneName) == 0) {
 			boneIndex = i;
 			break;
 		}
 	}
 	return boneIndex;
-
 }
 
 /**
@@ -679,85 +1119,49 @@ std::vector<int> CPMDData::m_GetBonesList(const int endBoneIndex, const int star
 /**
  * ボーンの保持.
  */
-void CPMDData::m_SetBones(sxsdk::shape_class& shape)
+void CPMDData::m_SetBones(const CModelSnapshot& snapshot)
 {
-	const int skin_type = shape.get_skin_type();
-	if (skin_type != 1) {		// 頂点ブレンドのスキンでない場合はスキップ.
-		return;
-	}
-	if (shape.get_type() != sxsdk::enums::polygon_mesh) return;
-
-	// 関連するボーンを取得.
-	sxsdk::shape_class *pBoneRoot = Util::GetBoneRoot(shape);
-	if (!pBoneRoot) return;
-	m_pBoneRoot = pBoneRoot;
+	m_pSkeleton = snapshot.skeleton;
+	if (!m_pSkeleton || m_pSkeleton->bones.empty()) return;
+	const std::vector<SKELETON_BONE>& bones = m_pSkeleton->bones;
 
-	// MMDのボーン名とどれくらい一致するか判定.
-	m_humanRigBonesNameCheck = 0.0f;
-	m_humanRigBonesType      = human_rig_type_default;
-	{
-		CRigCtrl rigCtrl(m_shade);
-		m_humanRigBonesNameCheck = rigCtrl.CheckMMDBones(*pBoneRoot, &m_humanRigBonesType);
-	}
+	// MMDのボーン名とどれくらい一致するかは、ボーン構造のキャッシュで判定済み.
+	m_humanRigBonesNameCheck = m_pSkeleton->rigNameCheck;
+	m_humanRigBonesType      = m_pSkeleton->rigType;
 
-	// ボーン情報を格納.
+	// ボーン情報を格納 (ルートから深さ優先の順).
 	m_bones.clear();
-	m_SetBoneLoop(0, -1, pBoneRoot);
-/*
-	{
-		char szStr[256];
-		for (int i = 0; i < m_bones.size(); i++) {
-			PMD_BONE_DATA& boneData = m_bones[i];
-			sxsdk::vec3 v = boneData.bone_head_pos;
-			sprintf(szStr, "%d : [%s] (%f, %f, %f) parent = %d tail = %d", i, boneData.bone_name.c_str(), v.x, v.y, v.z, boneData.parent_bone_index, boneData.tail_pos_bone_index);
-			m_shade->message(szStr);
+	for (int i = 0; i < bones.size(); i++) {
+		const SKELETON_BONE& bone = bones[i];
+
+		PMD_BONE_DATA boneData;
+		boneData.bone_head_pos = snapshot.boneHeadPositions[i];
+		boneData.bone_name     = bone.name;
+		if (bone.parent_index >= 0) {
+			boneData.parent_bone_index = bone.parent_index;
 		}
-	}
-*/
-}
-
-void CPMDData::m_SetBoneLoop(const int depth, const int parentBoneIndex, sxsdk::shape_class* pBoneShape)
-{
-	if (!Util::IsBone(*pBoneShape)) return;
+		const int curBoneIndex = m_bones.size();
 
-	const sxsdk::mat4 lwMat = pBoneShape->get_local_to_world_matrix();
-
-	PMD_BONE_DATA boneData;
-	boneData.pShadeShape   = pBoneShape;
-	boneData.bone_head_pos = sxsdk::vec3(0, 0, 0) * (pBoneShape->get_transformation()) * lwMat;
-	boneData.bone_name     = pBoneShape->get_name();
-	if (parentBoneIndex >= 0) {
-		boneData.parent_bone_index = parentBoneIndex;
-	}
-	const int curBoneIndex = m_bones.size();
-
-	// ボーンの移動/回転フラグ指定.
-	if (m_boneMoveRootOnly) {
-		if (depth == 0) boneData.bone_type = bone_type_rotate_trans;
-		else boneData.bone_type = bone_type_rotate;
-	} else {
-		boneData.bone_type = bone_type_rotate_trans;
-	}
-
-	// 末端ノードは非表示にする.
-	if (!(pBoneShape->has_son())) {
-		boneData.bone_type = bone_type_hide;
-	}
-
-	m_bones.push_back(boneData);
+		// ボーンの移動/回転フラグ指定.
+		if (m_boneMoveRootOnly) {
+			if (bone.depth == 0) boneData.bone_type = bone_type_rotate_trans;
+			else boneData.bone_type = bone_type_rotate;
+		} else {
+			boneData.bone_type = bone_type_rotate_trans;
+		}
 
-	if (parentBoneIndex >= 0) {
-		PMD_BONE_DATA& parentBoneData = m_bones[parentBoneIndex];
-		if (parentBoneData.tail_pos_bone_index <= 0) {
-			parentBoneData.tail_pos_bone_index = curBoneIndex;
+		// 末端ノードは非表示にする.
+		if (!bone.has_son) {
+			boneData.bone_type = bone_type_hide;
 		}
-	}
 
-	if (pBoneShape->has_son()) {
-		sxsdk::shape_class* pShape = pBoneShape->get_son();
-		while (pShape->has_bro()) {
-			pShape = pShape->get_bro();
-			m_SetBoneLoop(depth + 1, curBoneIndex, pShape);
+		m_bones.push_back(boneData);
+
+		if (bone.parent_index >= 0) {
+			PMD_BONE_DATA& parentBoneData = m_bones[bone.parent_index];
+			if (parentBoneData.tail_pos_bone_index <= 0) {
+				parentBoneData.tail_pos_bone_index = curBoneIndex;
+			}
 		}
 	}
 }
@@ -765,50 +1169,48 @@ void CPMDData::m_SetBoneLoop(const int depth, const int parentBoneIndex, sxsdk::
 /**
  * 頂点に対応するボーンとスキン値の保持.
  */
-void CPMDData::m_SetVertexSkins(sxsdk::shape_class& shape)
+void CPMDData::m_SetVertexSkins(const CModelSnapshot& snapshot)
 {
-	if (shape.get_type() != sxsdk::enums::polygon_mesh) return;
-	sxsdk::polygon_mesh_class& pmesh = shape.get_polygon_mesh();
+	const int vCou = m_vertices.size();
+	if (vCou + 1 != snapshot.bindOffsets.size()) return;
 
-	const int vCou   = m_vertices.size();
-	const int verCou = pmesh.get_total_number_of_control_points();
-	if (vCou != verCou) return;
+	// バインド先の形状名ごとのボーン番号.
+	std::vector<int> bindBoneIndex;
+	bindBoneIndex.resize(snapshot.bindNames.size());
+	for (int i = 0; i < snapshot.bindNames.size(); i++) {
+		bindBoneIndex[i] = m_FindBone(snapshot.bindNames[i]);
+	}
 
 	// 頂点ごとのスキン情報を取得.
 	// MMDでは、1頂点に影響を与えることができるボーンは2つ。
-	std::vector<sxsdk::skin_bind_class *> skins;
+	std::vector<SNAPSHOT_SKIN_BIND> skins;
 	for (int i = 0; i < vCou; i++) {
 		PMD_VERTEX_DATA& vData = m_vertices[i];
 		vData.bone_num[0] = -1;
 		vData.bone_num[1] = -1;
 		vData.bone_weight = 0;
 
-		sxsdk::vertex_class& v = pmesh.vertex(i);
-		sxsdk::skin_class& skin = v.get_skin();
-		int bind_cou = skin.get_number_of_binds();
+		const int bindStart = snapshot.bindOffsets[i];
+		const int bind_cou  = snapshot.bindOffsets[i + 1] - bindStart;
 		if (bind_cou <= 0) continue;
 
-		skins.clear();
-		for (int j = 0; j < bind_cou; j++) {
-			sxsdk::skin_bind_class* pSkinBind = &(skin.get_bind(j));
-			skins.push_back(pSkinBind);
-		}
+		skins.assign(snapshot.binds.begin() + bindStart, snapshot.binds.begin() + bindStart + bind_cou);
 
 		for (int j = 0; j < skins.size(); j++) {
 			for (int k = j + 1; k < skins.size(); k++) {
-				if ((skins[j]->get_weight()) < (skins[k]->get_weight())) {
+				if (skins[j].weight < skins[k].weight) {
 					std::swap(skins[j], skins[k]);
 				}
 			}
 		}
 
-		int bone0     = m_FindBone(skins[0]->get_shape()->get_name());
-		float weight0 = skins[0]->get_weight();
+		int bone0     = bindBoneIndex[skins[0].name_index];
+		float weight0 = skins[0].weight;
 		int bone1     = -1;
 		float weight1 = 0.0f;
 		if (skins.size() > 1) {
-			bone1   = m_FindBone(skins[1]->get_shape()->get_name());
-			weight1 = skins[1]->get_weight();
+			bone1   = bindBoneIndex[skins[1].name_index];
+			weight1 = skins[1].weight;
 		}
 
 		if (bone0 >= 0 && bone1 >= 0) {
@@ -830,63 +1232,30 @@ void CPMDData::m_SetVertexSkins(sxsdk::shape_class& shape)
  * 例 : IK「左足IK」 ... ボーンとして「左足IK」（左足首の位置に配置、親なし）。ボーンとして「左足IK先」（左足首より少し+Z方向に配置。親は左足IK）.
  *                       IK「左足IK」は、targetボーンを「左足首」とし、影響下のボーンとして「左足」「左ひざ」を持つ.
  */
-void CPMDData::m_SetIKs(sxsdk::scene_interface* scene, sxsdk::shape_class& shape)
-{
-	if (!m_pBoneRoot) return;
-
-	try {
-		sxsdk::ik_class& ik = scene->get_ik();
-		const int ikCou = ik.get_number_of_ik();
-		if (ikCou == 0) return;
-		m_SetIKsLoop(ik, scene, *m_pBoneRoot);
-	} catch (...) { }
-}
-
-void CPMDData::m_SetIKsLoop(sxsdk::ik_class& ik, sxsdk::scene_interface* scene, sxsdk::shape_class& shape)
+void CPMDData::m_SetIKs(const CModelSnapshot& snapshot)
 {
-	if (!Util::IsBone(shape)) return;
-
-	int ikType = ik.has_ik(shape, false);
-	if (ikType & 0x02) {		// IK Endを持つ場合.
-		sxsdk::ik_data_class& ikData = ik.get_ik_data(shape);
-		m_AddIK(ikData.get_root_shape(), ikData.get_end_shape(), ikData.get_goal_shape());
-	}
-
-	if (shape.has_son()) {
-		sxsdk::shape_class* pShape = shape.get_son();
-		while (pShape->has_bro()) {
-			pShape = pShape->get_bro();
-			m_SetIKsLoop(ik, scene, *pShape);
-		}
+	for (int i = 0; i < snapshot.iks.size(); i++) {
+		const SNAPSHOT_IK& ik = snapshot.iks[i];
+		m_AddIK(ik.root_bone, ik.end_bone, ik.goal_pos);
 	}
 }
 
 /**
  * 指定のIK情報を格納。この際に、IK用ボーンも生成.
+ * @param[in] ikRootBoneIndex   IK rootのボーン番号.
+ * @param[in] ikEndBoneIndex    IK endのボーン番号.
+ * @param[in] goalWPos          goalのワールド座標位置.
  */
-bool CPMDData::m_AddIK(sxsdk::shape_class* ikRootShape, sxsdk::shape_class* ikEndShape, sxsdk::shape_class* ikGoalShape)
+bool CPMDData::m_AddIK(const int ikRootBoneIndex, const int ikEndBoneIndex, const sxsdk::vec3& goalWPos)
 {
-	if (ikRootShape == NULL || ikEndShape == NULL || ikGoalShape == NULL) return false;
-
-	const int ikRootBoneIndex = m_FindBone(ikRootShape);
-	const int ikEndBoneIndex  = m_FindBone(ikEndShape);
 	if (ikRootBoneIndex < 0 || ikEndBoneIndex < 0) return false;
+	if (ikRootBoneIndex >= m_bones.size() || ikEndBoneIndex >= m_bones.size()) return false;
 
 	// ルートノードでは、IKの割り当てはできない.
 	if (ikRootBoneIndex == 0 || ikEndBoneIndex == 0) {
 		return false;
 	}
 
-	// goalのワールド座標位置.
-	// ※ IKでのgoalはボールジョイント.
-	sxsdk::vec3 goalWPos = sxsdk::vec3(0, 0, 0);
-	if (ikGoalShape->get_type() == sxsdk::enums::part) {
-		if (ikGoalShape->get_part().get_part_type() == sxsdk::enums::ball_joint) {
-			compointer<sxsdk::ball_joint_interface> ball(ikGoalShape->get_ball_joint_interface());
-			goalWPos = (ball->get_position()) * (ikGoalShape->get_local_to_world_matrix());
-		}
-	}
-
 	float zureDist = 0.0f;
 	{
 		// 「左足首」.
@@ -1676,119 +2045,665 @@ void CPMDData::m_SetBonesDisp()
  */
 bool CPMDData::Export(sxsdk::stream_interface *stream, CPMDDlgInfo& pmdInfo)
 {
-	m_WriteHeader(stream);
-	m_WriteVertices(stream);
-	m_WriteFaces(stream);
-	m_WriteMaterials(stream);
-	m_WriteBones(stream);
-	m_WriteIKs(stream);
-	m_WriteSkins(stream);
-	m_WriteSkinWaku(stream);
-	m_WriteBoneWaku(stream);
-	m_WriteBoneList(stream);
-
-	m_WriteExEnglishInfo(stream);
-
-	m_WriteToonTextureList(stream);
-	m_WritePhysicsRigidbodyList(stream);
-	m_WritePhysicsJointList(stream);
+	std::vector<CBinaryBuffer> sectionBuffers;
+	EncodeSections(sectionBuffers);
+	WriteSections(stream, sectionBuffers);
 
 	return false;
 }
 
+/**
+ * PMDの各セクションをバッファに格納し、テクスチャの保存の完了を待つ.
+ */
+bool CPMDData::EncodeSections(std::vector<CBinaryBuffer>& retSectionBuffers, CExportProgress* pProgress)
+{
+	m_pProgress = pProgress;
+
+	// Shadeのテキスト変換を使う文字列は、先にShift-JISにしておく.
+	// ワーカースレッドから呼ばれた場合は、ボーンや表情ごとに呼び出しを代行させないように、まとめてメインスレッドで変換する.
+	CExportTask::CallOnMainThread([this]() {
+		m_PrepareExportNames();
+		if (m_pFacialSkin) m_pFacialSkin->PrepareExport();
+	});
+	bool ret = m_StepProgress();
+
+	if (ret) {
+		// キャッシュから復元した場合はプールがないため、ここで作成.
+		if (!m_pThreadPool) m_pThreadPool = m_pSharedThreadPool ? m_pSharedThreadPool : new CThreadPool(m_threadCount);
+
+		// 各セクションは独立しているため、並列にバッファに格納する.
+		retSectionBuffers.clear();
+		retSectionBuffers.resize(pmd_section_count);
+		m_pThreadPool->ParallelFor(0, pmd_section_count, [this, &retSectionBuffers](int index) {
+			m_WriteSection(index, retSectionBuffers[index]);
+		});
+		ret = m_StepProgress();
+	}
+
+	// テクスチャの保存が完了するのを待つ (キャンセルされた場合も、保存中のタスクは完了させる).
+	// 保存に失敗したテクスチャがあってもPMDは出力し、失敗した数は呼び出し側でメッセージに出す.
+	m_textureFailedCount = 0;
+	if (m_pTextureWriter && !m_pTextureWriter->Wait()) m_textureFailedCount = m_pTextureWriter->GetFailedCount();
+	if (ret) ret = m_StepProgress();
+
+	m_pProgress = NULL;
+	return ret;
+}
+
+/**
+ * EncodeSectionsで格納したバッファを、PMDの順番でstreamに出力.
+ */
+void CPMDData::WriteSections(sxsdk::stream_interface *stream, const std::vector<CBinaryBuffer>& sectionBuffers)
+{
+	for (int i = 0; i < sectionBuffers.size(); i++) {
+		const CBinaryBuffer& buff = sectionBuffers[i];
+		if (buff.GetSize() > 0) stream->write(buff.GetSize(), buff.GetData());
+	}
+}
+
+/**
+ * EncodeSectionsで格納したバッファを、PMDの順番でファイルに出力.
+ */
+bool CPMDData::WriteSections(const std::string& filePath, const std::vector<CBinaryBuffer>& sectionBuffers)
+{
+	FILE* fp = Util::OpenFile(filePath, "wb");
+	if (!fp) return false;
+
+	bool ret = true;
+	for (int i = 0; i < sectionBuffers.size(); i++) {
+		const CBinaryBuffer& buff = sectionBuffers[i];
+		if (buff.GetSize() > 0 && fwrite(buff.GetData(), 1, buff.GetSize(), fp) != buff.GetSize()) ret = false;
+	}
+	fclose(fp);
+	return ret;
+}
+
+/**
+ * 出力する文字列をShift-JISに変換して保持.
+ */
+void CPMDData::m_PrepareExportNames()
+{
+	PMD_EXPORT_NAMES& names = m_exportNames;
+
+	names.modelName    = Util::ConvUTF8ToSJIS(*m_shade, m_modelName);
+	names.comment      = Util::ConvUTF8ToSJIS(*m_shade, m_comment);
+	names.modelNameEng = Util::ConvUTF8ToSJIS(*m_shade, m_modelNameEng);
+	names.commentEng   = Util::ConvUTF8ToSJIS(*m_shade, m_commentEng);
+
+	names.texFileNames.resize(m_materials.size());
+	for (int i = 0; i < m_materials.size(); i++) {
+		names.texFileNames[i] = Util::ConvUTF8ToSJIS(*m_shade, m_materials[i].tex_file_name);
+	}
+
+	// IKのボーン名の照合用に、日本語名をまとめてUTF-8に変換しておく (ボーンごとにメインスレッドでの変換を行わない).
+	std::vector<std::string> ikNamesJP;
+	for (int j = 0; j < 10; j++) {
+		const std::string ikName = Util::GetUTF8Text(*m_shade, leg_ik_name_jp[j]);
+		if (ikName.length() == 0) break;
+		ikNamesJP.push_back(ikName);
+	}
+
+	names.boneNames.resize(m_bones.size());
+	names.boneNamesEng.resize(m_bones.size());
+	for (int i = 0; i < m_bones.size(); i++) {
+		PMD_BONE_DATA& boneData = m_bones[i];
+
+		// シーン上のボーンは、ボーン構造のキャッシュで変換済みの名前を使う.
+		const SKELETON_BONE* pSkeletonBone = NULL;
+		if (m_pSkeleton && i < m_pSkeleton->bones.size()) pSkeletonBone = &(m_pSkeleton->bones[i]);
+
+		// ボーン名をMMDの日本語のものに置き換え.
+		std::string str = boneData.bone_name;
+		if (m_humanConvertBoneName && m_humanRigBonesType != human_rig_type_mmd_jp) {
+			if (pSkeletonBone) {
+				str = pSkeletonBone->name_jp;
+			} else {
+				const int index = CRigCtrl::GetHumanBoneIndex(m_shade, str, m_humanRigBonesType);
+				if (index >= 0) {
+					str = CRigCtrl::GetHumanBoneName(m_shade, index, human_rig_type_mmd_jp);
+				}
+			}
+		}
+		names.boneNames[i] = Util::ConvUTF8ToSJIS(*m_shade, str);
+
+		// 英語のボーン名.
+		std::string boneName = boneData.bone_name;
+		if (m_humanConvertBoneName && m_humanRigBonesType != human_rig_type_mmd_en) {
+			if (pSkeletonBone) {
+				boneName = pSkeletonBone->name_en;
+			} else {
+				const int index = CRigCtrl::GetHumanBoneIndex(m_shade, boneName, m_humanRigBonesType);
+				if (index >= 0) {
+					boneName = CRigCtrl::GetHumanBoneName(m_shade, index, human_rig_type_mmd_en);
+				}
+			}
+		}
+		if (boneData.bone_type == bone_type_ik || boneData.bone_type == bone_type_hide || boneData.bone_type == bone_type_ik_c) {
+			for (int j = 0; j < ikNamesJP.size(); j++) {
+				if (ikNamesJP[j].compare(boneName) == 0) {
+					boneName = leg_ik_name_en[j];
+					break;
+				}
+			}
+		}
+		names.boneNamesEng[i] = Util::ConvUTF8ToSJIS(*m_shade, boneName);
+	}
+
+	names.boneDispNames.resize(m_bonesDisp.size());
+	for (int i = 0; i < m_bonesDisp.size(); i++) {
+		names.boneDispNames[i] = Util::ConvUTF8ToSJIS(*m_shade, m_bonesDisp[i].disp_name);
+	}
+}
+
+/**
+ * 指定のセクションをバッファに格納 (ワーカースレッドから呼ばれる).
+ */
+void CPMDData::m_WriteSection(const int section, CBinaryBuffer& buff)
+{
+	switch (section) {
+	case pmd_section_header:        m_WriteHeader(buff);                break;
+	case pmd_section_vertices:      m_WriteVertices(buff);              break;
+	case pmd_section_faces:         m_WriteFaces(buff);                 break;
+	case pmd_section_materials:     m_WriteMaterials(buff);             break;
+	case pmd_section_bones:         m_WriteBones(buff);                 break;
+	case pmd_section_iks:           m_WriteIKs(buff);                   break;
+	case pmd_section_skins:         m_WriteSkins(buff);                 break;
+	case pmd_section_skin_frames:   m_WriteSkinWaku(buff);              break;
+	case pmd_section_bone_frames:   m_WriteBoneWaku(buff);              break;
+	case pmd_section_bone_disps:    m_WriteBoneList(buff);              break;
+	case pmd_section_english:       m_WriteExEnglishInfo(buff);         break;
+	case pmd_section_toon_textures: m_WriteToonTextureList(buff);       break;
+	case pmd_section_rigidbodies:   m_WritePhysicsRigidbodyList(buff);  break;
+	case pmd_section_joints:        m_WritePhysicsJointList(buff);      break;
+	}
+}
+
+/**
+ * 変換後の情報をキャッシュファイル(.mmdcache)として出力先ディレクトリに保存.
+ */
+bool CPMDData::SaveModelCache(const std::string& fileName)
+{
+	CModelCacheWriter writer;
+
+	{
+		std::vector<MMD_CACHE_INFO> infos(1);
+		MMD_CACHE_INFO& info = infos[0];
+		memset(&info, 0, sizeof(MMD_CACHE_INFO));
+		ModelCache::CopyString(info.model_name,    sizeof(info.model_name),    m_modelName);
+		ModelCache::CopyString(info.comment,       sizeof(info.comment),       m_comment);
+		ModelCache::CopyString(info.model_name_en, sizeof(info.model_name_en), m_modelNameEng);
+		ModelCache::CopyString(info.comment_en,    sizeof(info.comment_en),    m_commentEng);
+		info.scale                   = m_scale;
+		info.human_rig_bones_type    = m_humanRigBonesType;
+		info.human_convert_bone_name = m_humanConvertBoneName ? 1 : 0;
+		writer.AddSection(mmd_cache_section_info, infos);
+	}
+
+	{
+		std::vector<MMD_CACHE_VERTEX> vertices(m_vertices.size());
+		for (size_t i = 0; i < m_vertices.size(); i++) {
+			const PMD_VERTEX_DATA& vData = m_vertices[i];
+			MMD_CACHE_VERTEX& cData = vertices[i];
+			cData.pos[0]      = vData.pos.x;
+			cData.pos[1]      = vData.pos.y;
+			cData.pos[2]      = vData.pos.z;
+			cData.normal[0]   = vData.normal.x;
+			cData.normal[1]   = vData.normal.y;
+			cData.normal[2]   = vData.normal.z;
+			cData.uv[0]       = vData.uv.x;
+			cData.uv[1]       = vData.uv.y;
+			cData.bone_num[0] = vData.bone_num[0];
+			cData.bone_num[1] = vData.bone_num[1];
+			cData.bone_weight = vData.bone_weight;
+			cData.edge_flag   = vData.edge_flag;
+		}
+		writer.AddSection(mmd_cache_section_vertices, vertices);
+	}
+
+	{
+		std::vector<MMD_CACHE_TRIANGLE> triangles(m_triangles.size());
+		for (size_t i = 0; i < m_triangles.size(); i++) {
+			const PMD_TRIANGLE_DATA& triData = m_triangles[i];
+			MMD_CACHE_TRIANGLE& cData = triangles[i];
+			for (int j = 0; j < 3; j++) cData.index[j] = triData.index[j];
+		}
+		writer.AddSection(mmd_cache_section_triangles, triangles);
+	}
+
+	{
+		std::vector<MMD_CACHE_MATERIAL> materials(m_materials.size());
+		for (size_t i = 0; i < m_materials.size(); i++) {
+			const PMD_MATERIAL_DATA& mData = m_materials[i];
+			MMD_CACHE_MATERIAL& cData = materials[i];
+			memset(&cData, 0, sizeof(MMD_CACHE_MATERIAL));
+			cData.diffuse_color[0]  = mData.diffuse_color.x;
+			cData.diffuse_color[1]  = mData.diffuse_color.y;
+			cData.diffuse_color[2]  = mData.diffuse_color.z;
+			cData.alpha             = mData.alpha;
+			cData.specular          = mData.specular;
+			cData.specular_color[0] = mData.specular_color.x;
+			cData.specular_color[1] = mData.specular_color.y;
+			cData.specular_color[2] = mData.specular_color.z;
+			cData.ambient_color[0]  = mData.ambient_color.x;
+			cData.ambient_color[1]  = mData.ambient_color.y;
+			cData.ambient_color[2]  = mData.ambient_color.z;
+			cData.edge_flag         = mData.edge_flag;
+			cData.toon_index        = mData.toon_index;
+			cData.face_vert_count   = mData.face_vert_count;
+			ModelCache::CopyString(cData.tex_file_name, sizeof(cData.tex_file_name), mData.tex_file_name);
+		}
+		writer.AddSection(mmd_cache_section_materials, materials);
+	}
+
+	{
+		std::vector<MMD_CACHE_BONE> bones(m_bones.size());
+		for (size_t i = 0; i < m_bones.size(); i++) {
+			const PMD_BONE_DATA& boneData = m_bones[i];
+			MMD_CACHE_BONE& cData = bones[i];
+			memset(&cData, 0, sizeof(MMD_CACHE_BONE));
+			ModelCache::CopyString(cData.bone_name, sizeof(cData.bone_name), boneData.bone_name);
+			cData.parent_bone_index    = boneData.parent_bone_index;
+			cData.tail_pos_bone_index  = boneData.tail_pos_bone_index;
+			cData.bone_type            = boneData.bone_type;
+			cData.ik_parent_bone_index = boneData.ik_parent_bone_index;
+			cData.bone_head_pos[0]     = boneData.bone_head_pos.x;
+			cData.bone_head_pos[1]     = boneData.bone_head_pos.y;
+			cData.bone_head_pos[2]     = boneData.bone_head_pos.z;
+		}
+		writer.AddSection(mmd_cache_section_bones, bones);
+	}
+
+	{
+		std::vector<MMD_CACHE_IK> iks(m_IKs.size());
+		std::vector<int32_t> ikChildren;
+		for (size_t i = 0; i < m_IKs.size(); i++) {
+			const PMD_IK_DATA& ikData = m_IKs[i];
+			MMD_CACHE_IK& cData = iks[i];
+			cData.ik_bone_index        = ikData.ik_bone_index;
+			cData.ik_target_bone_index = ikData.ik_target_bone_index;
+			cData.iterations           = ikData.iterations;
+			cData.control_weight       = ikData.control_weight;
+			cData.child_offset         = (int32_t)ikChildren.size();
+			cData.child_count          = (int32_t)ikData.ik_child_bone_index.size();
+			ikChildren.insert(ikChildren.end(), ikData.ik_child_bone_index.begin(), ikData.ik_child_bone_index.end());
+		}
+		writer.AddSection(mmd_cache_section_iks, iks);
+		writer.AddSection(mmd_cache_section_ik_children, ikChildren);
+	}
+
+	{
+		std::vector<MMD_CACHE_SKIN> skins;
+		std::vector<MMD_CACHE_SKIN_VERTEX> skinVertices;
+		std::vector<int32_t> skinGroups;
+		if (m_pFacialSkin) {
+			const std::vector<FACE_SKIN_DATA>& skinData = m_pFacialSkin->GetSkinData();
+			skins.resize(skinData.size());
+			for (size_t i = 0; i < skinData.size(); i++) {
+				const FACE_SKIN_DATA& sData = skinData[i];
+				MMD_CACHE_SKIN& cData = skins[i];
+				memset(&cData, 0, sizeof(MMD_CACHE_SKIN));
+				ModelCache::CopyString(cData.name, sizeof(cData.name), sData.name);
+				cData.type          = sData.type;
+				cData.base_skin     = sData.baseSkin ? 1 : 0;
+				cData.vertex_offset = (int32_t)skinVertices.size();
+				cData.vertex_count  = (int32_t)sData.GetVerticesCount();
+
+				for (int j = 0; j < sData.GetVerticesCount(); j++) {
+					MMD_CACHE_SKIN_VERTEX cvData;
+					cvData.vert_index = sData.vert_index[j];
+					cvData.pos[0]     = sData.pos.x[j];
+					cvData.pos[1]     = sData.pos.y[j];
+					cvData.pos[2]     = sData.pos.z[j];
+					cvData.org_i      = sData.org_i[j];
+					skinVertices.push_back(cvData);
+				}
+			}
+			const std::vector<int>& groupIndex = m_pFacialSkin->GetSkinGroupIndex();
+			skinGroups.assign(groupIndex.begin(), groupIndex.end());
+		}
+		writer.AddSection(mmd_cache_section_skins, skins);
+		writer.AddSection(mmd_cache_section_skin_vertices, skinVertices);
+		writer.AddSection(mmd_cache_section_skin_groups, skinGroups);
+	}
+
+	{
+		std::vector<MMD_CACHE_BONE_DISP> boneDisps(m_bonesDisp.size());
+		std::vector<MMD_CACHE_BONE_DISP_ITEM> boneDispItems;
+		for (size_t i = 0; i < m_bonesDisp.size(); i++) {
+			const PMD_BONE_DISP_DATA& dispData = m_bonesDisp[i];
+			MMD_CACHE_BONE_DISP& cData = boneDisps[i];
+			memset(&cData, 0, sizeof(MMD_CACHE_BONE_DISP));
+			ModelCache::CopyString(cData.disp_name,    sizeof(cData.disp_name),    dispData.disp_name);
+			ModelCache::CopyString(cData.disp_name_en, sizeof(cData.disp_name_en), dispData.disp_name_en);
+			cData.item_offset = (int32_t)boneDispItems.size();
+			cData.item_count  = (int32_t)dispData.data.size();
+
+			for (size_t j = 0; j < dispData.data.size(); j++) {
+				MMD_CACHE_BONE_DISP_ITEM item;
+				item.bone_disp_index = dispData.data[j].bone_disp_index;
+				item.bone_index      = dispData.data[j].bone_index;
+				boneDispItems.push_back(item);
+			}
+		}
+		writer.AddSection(mmd_cache_section_bone_disps, boneDisps);
+		writer.AddSection(mmd_cache_section_bone_disp_items, boneDispItems);
+	}
+
+	return writer.Save(GetFileFullPathName(fileName));
+}
+
+/**
+ * キャッシュファイル(.mmdcache)から変換後の情報を復元.
+ */
+bool CPMDData::LoadModelCache(const std::string& filePath)
+{
+	CModelCacheReader reader;
+	if (!reader.Open(filePath)) return false;
+
+	int infoCou, vCou, triCou, mCou, bCou, ikCou, ikChildCou, sCou, svCou, sgCou, bdCou, bdItemCou;
+	const MMD_CACHE_INFO* pInfo                  = reader.GetSection<MMD_CACHE_INFO>(mmd_cache_section_info, &infoCou);
+	const MMD_CACHE_VERTEX* pVertices            = reader.GetSection<MMD_CACHE_VERTEX>(mmd_cache_section_vertices, &vCou);
+	const MMD_CACHE_TRIANGLE* pTriangles         = reader.GetSection<MMD_CACHE_TRIANGLE>(mmd_cache_section_triangles, &triCou);
+	const MMD_CACHE_MATERIAL* pMaterials         = reader.GetSection<MMD_CACHE_MATERIAL>(mmd_cache_section_materials, &mCou);
+	const MMD_CACHE_BONE* pBones                 = reader.GetSection<MMD_CACHE_BONE>(mmd_cache_section_bones, &bCou);
+	const MMD_CACHE_IK* pIKs                     = reader.GetSection<MMD_CACHE_IK>(mmd_cache_section_iks, &ikCou);
+	const int32_t* pIKChildren                   = reader.GetSection<int32_t>(mmd_cache_section_ik_children, &ikChildCou);
+	const MMD_CACHE_SKIN* pSkins                 = reader.GetSection<MMD_CACHE_SKIN>(mmd_cache_section_skins, &sCou);
+	const MMD_CACHE_SKIN_VERTEX* pSkinVertices   = reader.GetSection<MMD_CACHE_SKIN_VERTEX>(mmd_cache_section_skin_vertices, &svCou);
+	const int32_t* pSkinGroups                   = reader.GetSection<int32_t>(mmd_cache_section_skin_groups, &sgCou);
+	const MMD_CACHE_BONE_DISP* pBoneDisps        = reader.GetSection<MMD_CACHE_BONE_DISP>(mmd_cache_section_bone_disps, &bdCou);
+	const MMD_CACHE_BONE_DISP_ITEM* pBoneDispItems = reader.GetSection<MMD_CACHE_BONE_DISP_ITEM>(mmd_cache_section_bone_disp_items, &bdItemCou);
+
+	// 参照番号が範囲内かチェック.
+	if (!pInfo || infoCou != 1) return false;
+	for (int i = 0; i < vCou; i++) {
+		for (int j = 0; j < 2; j++) {
+			if (!::IsCacheBoneIndexValid(pVertices[i].bone_num[j], bCou)) return false;
+		}
+	}
+	for (int i = 0; i < triCou; i++) {
+		for (int j = 0; j < 3; j++) {
+			if (pTriangles[i].index[j] < 0 || pTriangles[i].index[j] >= vCou) return false;
+		}
+	}
+	{
+		int64_t faceVertCou = 0;
+		for (int i = 0; i < mCou; i++) {
+			if (pMaterials[i].face_vert_count < 0 || (pMaterials[i].face_vert_count % 3) != 0) return false;
+			faceVertCou += pMaterials[i].face_vert_count;
+		}
+		if (faceVertCou != (int64_t)triCou * 3) return false;
+	}
+	for (int i = 0; i < bCou; i++) {
+		if (!::IsCacheBoneIndexValid(pBones[i].parent_bone_index, bCou)) return false;
+		if (!::IsCacheBoneIndexValid(pBones[i].tail_pos_bone_index, bCou)) return false;
+		if (!::IsCacheBoneIndexValid(pBones[i].ik_parent_bone_index, bCou)) return false;
+	}
+	for (int i = 0; i < ikCou; i++) {
+		if (pIKs[i].ik_bone_index < 0 || pIKs[i].ik_bone_index >= bCou) return false;
+		if (pIKs[i].ik_target_bone_index < 0 || pIKs[i].ik_target_bone_index >= bCou) return false;
+		if (!::IsCacheRangeValid(pIKs[i].child_offset, pIKs[i].child_count, ikChildCou)) return false;
+		for (int j = 0; j < pIKs[i].child_count; j++) {
+			const int boneIndex = pIKChildren[pIKs[i].child_offset + j];
+			if (boneIndex < 0 || boneIndex >= bCou) return false;
+		}
+	}
+	{
+		// 表情の種類ごとの先頭(base)より頂点数が多い場合は出力時に範囲外を参照するため、不正とする.
+		// 表情の種類ごとの先頭のインデックスは、baseの表情の並びと一致している必要がある.
+		int curSkinType = -1;
+		int skinTypeBaseIndex = -1;
+		int skinGroupPos = 0;
+		for (int i = 0; i < sCou; i++) {
+			if (!::IsCacheRangeValid(pSkins[i].vertex_offset, pSkins[i].vertex_count, svCou)) return false;
+			if (curSkinType != pSkins[i].type) {
+				curSkinType       = pSkins[i].type;
+				skinTypeBaseIndex = i;
+			}
+			if (pSkins[i].vertex_count > pSkins[skinTypeBaseIndex].vertex_count) return false;
+
+			if (pSkins[i].base_skin != 0) {
+				if (skinGroupPos >= sgCou || pSkinGroups[skinGroupPos] != i) return false;
+				skinGroupPos++;
+
+				// baseの頂点番号は、そのままPMDの頂点番号として出力される.
+				for (int j = 0; j < pSkins[i].vertex_count; j++) {
+					const int vIndex = pSkinVertices[pSkins[i].vertex_offset + j].vert_index;
+					if (vIndex < 0 || vIndex >= vCou) return false;
+				}
+			}
+		}
+		if (skinGroupPos != sgCou) return false;
+	}
+	for (int i = 0; i < bdCou; i++) {
+		if (!::IsCacheRangeValid(pBoneDisps[i].item_offset, pBoneDisps[i].item_count, bdItemCou)) return false;
+		for (int j = 0; j < pBoneDisps[i].item_count; j++) {
+			const int boneIndex = pBoneDispItems[pBoneDisps[i].item_offset + j].bone_index;
+			if (boneIndex < 0 || boneIndex >= bCou) return false;
+		}
+	}
+
+	Clear();
+
+	m_modelName            = ModelCache::GetString(pInfo->model_name,    sizeof(pInfo->model_name));
+	m_comment              = ModelCache::GetString(pInfo->comment,       sizeof(pInfo->comment));
+	m_modelNameEng         = ModelCache::GetString(pInfo->model_name_en, sizeof(pInfo->model_name_en));
+	m_commentEng           = ModelCache::GetString(pInfo->comment_en,    sizeof(pInfo->comment_en));
+	m_scale                = pInfo->scale;
+	m_humanRigBonesType    = pInfo->human_rig_bones_type;
+	m_humanConvertBoneName = (pInfo->human_convert_bone_name != 0);
+
+	{
+		const size_t sepPos = filePath.find_last_of("\\/");
+		m_filePath = (sepPos != std::string::npos) ? filePath.substr(0, sepPos) : std::string("");
+	}
+
+	m_vertices.resize(vCou);
+	for (int i = 0; i < vCou; i++) {
+		const MMD_CACHE_VERTEX& cData = pVertices[i];
+		PMD_VERTEX_DATA& vData = m_vertices[i];
+		vData.pos         = sxsdk::vec3(cData.pos[0], cData.pos[1], cData.pos[2]);
+		vData.normal      = sxsdk::vec3(cData.normal[0], cData.normal[1], cData.normal[2]);
+		vData.uv          = sxsdk::vec2(cData.uv[0], cData.uv[1]);
+		vData.bone_num[0] = cData.bone_num[0];
+		vData.bone_num[1] = cData.bone_num[1];
+		vData.bone_weight = cData.bone_weight;
+		vData.edge_flag   = cData.edge_flag;
+	}
+
+	m_triangles.resize(triCou);
+	m_triangleWork.Clear();
+	for (int i = 0; i < triCou; i++) {
+		PMD_TRIANGLE_DATA& triData = m_triangles[i];
+		for (int j = 0; j < 3; j++) triData.index[j] = pTriangles[i].index[j];
+	}
+
+	m_materials.resize(mCou);
+	for (int i = 0; i < mCou; i++) {
+		const MMD_CACHE_MATERIAL& cData = pMaterials[i];
+		PMD_MATERIAL_DATA& mData = m_materials[i];
+		mData.diffuse_color   = sxsdk::vec3(cData.diffuse_color[0], cData.diffuse_color[1], cData.diffuse_color[2]);
+		mData.alpha           = cData.alpha;
+		mData.specular        = cData.specular;
+		mData.specular_color  = sxsdk::vec3(cData.specular_color[0], cData.specular_color[1], cData.specular_color[2]);
+		mData.ambient_color   = sxsdk::vec3(cData.ambient_color[0], cData.ambient_color[1], cData.ambient_color[2]);
+		mData.edge_flag       = cData.edge_flag;
+		mData.toon_index      = cData.toon_index;
+		mData.face_vert_count = cData.face_vert_count;
+		mData.tex_file_name   = ModelCache::GetString(cData.tex_file_name, sizeof(cData.tex_file_name));
+	}
+	m_materialCount = mCou;
+
+	m_bones.resize(bCou);
+	for (int i = 0; i < bCou; i++) {
+		const MMD_CACHE_BONE& cData = pBones[i];
+		PMD_BONE_DATA& boneData = m_bones[i];
+		boneData.bone_name            = ModelCache::GetString(cData.bone_name, sizeof(cData.bone_name));
+		boneData.parent_bone_index    = cData.parent_bone_index;
+		boneData.tail_pos_bone_index  = cData.tail_pos_bone_index;
+		boneData.bone_type            = cData.bone_type;
+		boneData.ik_parent_bone_index = cData.ik_parent_bone_index;
+		boneData.bone_head_pos        = sxsdk::vec3(cData.bone_head_pos[0], cData.bone_head_pos[1], cData.bone_head_pos[2]);
+	}
+	m_boneCount = bCou;
+
+	m_IKs.resize(ikCou);
+	for (int i = 0; i < ikCou; i++) {
+		const MMD_CACHE_IK& cData = pIKs[i];
+		PMD_IK_DATA& ikData = m_IKs[i];
+		ikData.ik_bone_index        = cData.ik_bone_index;
+		ikData.ik_target_bone_index = cData.ik_target_bone_index;
+		ikData.iterations           = cData.iterations;
+		ikData.control_weight       = cData.control_weight;
+		ikData.ik_child_bone_index.assign(pIKChildren + cData.child_offset, pIKChildren + cData.child_offset + cData.child_count);
+	}
+	m_IKCount = ikCou;
+
+	{
+		std::vector<FACE_SKIN_DATA> skinData(sCou);
+		for (int i = 0; i < sCou; i++) {
+			const MMD_CACHE_SKIN& cData = pSkins[i];
+			FACE_SKIN_DATA& sData = skinData[i];
+			sData.name     = ModelCache::GetString(cData.name, sizeof(cData.name));
+			sData.type     = cData.type;
+			sData.baseSkin = (cData.base_skin != 0);
+			sData.ResizeVertices(cData.vertex_count);
+			for (int j = 0; j < cData.vertex_count; j++) {
+				const MMD_CACHE_SKIN_VERTEX& cvData = pSkinVertices[cData.vertex_offset + j];
+				sData.vert_index[j] = cvData.vert_index;
+				sData.pos.x[j]      = cvData.pos[0];
+				sData.pos.y[j]      = cvData.pos[1];
+				sData.pos.z[j]      = cvData.pos[2];
+				sData.org_i[j]      = cvData.org_i;
+			}
+		}
+		std::vector<int> skinGroupIndex(pSkinGroups, pSkinGroups + sgCou);
+
+		m_pFacialSkin = new CFacialSkin(m_shade);
+		m_pFacialSkin->SetSkinData(skinData, skinGroupIndex, m_scale);
+		m_SkinCount = sCou;
+	}
+
+	m_bonesDisp.resize(bdCou);
+	for (int i = 0; i < bdCou; i++) {
+		const MMD_CACHE_BONE_DISP& cData = pBoneDisps[i];
+		PMD_BONE_DISP_DATA& dispData = m_bonesDisp[i];
+		dispData.disp_name    = ModelCache::GetString(cData.disp_name,    sizeof(cData.disp_name));
+		dispData.disp_name_en = ModelCache::GetString(cData.disp_name_en, sizeof(cData.disp_name_en));
+		dispData.data.resize(cData.item_count);
+		for (int j = 0; j < cData.item_count; j++) {
+			dispData.data[j].bone_disp_index = pBoneDispItems[cData.item_offset + j].bone_disp_index;
+			dispData.data[j].bone_index      = pBoneDispItems[cData.item_offset + j].bone_index;
+		}
+	}
+	m_boneDispCount = bdCou;
+
+	return true;
+}
+
 /**
  * ヘッダ部の出力.
  */
-void CPMDData::m_WriteHeader(sxsdk::stream_interface *stream)
+void CPMDData::m_WriteHeader(CBinaryBuffer& buff)
 {
 	char szBuff[300];
 
+	buff.Reserve(PMD_HEADER_SIZE);
+
 	sprintf(szBuff, "Pmd");
-	stream->write(3, szBuff);
+	buff.Write(3, szBuff);
 
 	float version = 1.0f;
-	stream->write(4, &version);
+	buff.Write(4, &version);
 
 	memset(szBuff, 0, 20);
-	std::string str = Util::ConvUTF8ToSJIS(*m_shade, m_modelName);
+	std::string str = m_exportNames.modelName;
 	if (str.size() > 19) {
 		strncpy(szBuff, str.c_str(), 19);
 	} else {
 		strcpy(szBuff, str.c_str());
 	}
-	stream->write(20, szBuff);
+	buff.Write(20, szBuff);
 
 	memset(szBuff, 0, 256);
-	str = Util::ConvUTF8ToSJIS(*m_shade, m_comment);
+	str = m_exportNames.comment;
 	if (str.size() > 255) {
 		strncpy(szBuff, str.c_str(), 255);
 	} else {
 		strcpy(szBuff, str.c_str());
 	}
-	stream->write(256, szBuff);
+	buff.Write(256, szBuff);
 }
 
 /**
  * 頂点の出力.
  */
-void CPMDData::m_WriteVertices(sxsdk::stream_interface *stream)
+void CPMDData::m_WriteVertices(CBinaryBuffer& buff)
 {
 	int verCou = m_vertices.size();
-	stream->write(4, &verCou);
+	buff.Reserve(4 + (size_t)verCou * PMD_VERTEX_DATA_SIZE);
+	buff.Write(4, &verCou);
+
+	// 位置と法線は、PMDの座標系への変換をまとめて行う.
+	CVec3ArraySoA positions, normals;
+	positions.Resize(verCou);
+	normals.Resize(verCou);
+	for (int i = 0; i < verCou; i++) {
+		positions.Set(i, m_vertices[i].pos);
+		normals.Set(i, m_vertices[i].normal);
+	}
+	VertexTransform::ScaleFlipZ(positions, m_scale);
+	VertexTransform::ScaleFlipZ(normals, 1.0f);
 
-	sxsdk::vec3 v;
 	unsigned short sVal;
 	char cVal;
 	for (int i = 0; i < verCou; i++) {
 		PMD_VERTEX_DATA& vData = m_vertices[i];
-		sxsdk::vec3 v = vData.pos * m_scale;
-		v.z = -v.z;
-		stream->write(4, &v.x);
-		stream->write(4, &v.y);
-		stream->write(4, &v.z);
+		buff.Write(4, &positions.x[i]);
+		buff.Write(4, &positions.y[i]);
+		buff.Write(4, &positions.z[i]);
 
-		v = vData.normal;
-		v.z = -v.z;
-		stream->write(4, &v.x);
-		stream->write(4, &v.y);
-		stream->write(4, &v.z);
+		buff.Write(4, &normals.x[i]);
+		buff.Write(4, &normals.y[i]);
+		buff.Write(4, &normals.z[i]);
 
-		stream->write(4, &vData.uv.x);
-		stream->write(4, &vData.uv.y);
+		buff.Write(4, &vData.uv.x);
+		buff.Write(4, &vData.uv.y);
 
 		if (vData.bone_num[0] < 0) sVal = 0;	//0xffff;
 		else sVal = (unsigned short)vData.bone_num[0];
-		stream->write(2, &sVal);
+		buff.Write(2, &sVal);
 
 		if (vData.bone_num[1] < 0) sVal = 0;	//0xffff;
 		else sVal = (unsigned short)vData.bone_num[1];
-		stream->write(2, &sVal);
+		buff.Write(2, &sVal);
 
 		cVal = (char)vData.bone_weight;
-		stream->write(1, &cVal);
+		buff.Write(1, &cVal);
 
 		cVal = (char)vData.edge_flag;
-		stream->write(1, &cVal);
+		buff.Write(1, &cVal);
 	}
 }
 
 /**
  * 面の出力.
  */
-void CPMDData::m_WriteFaces(sxsdk::stream_interface *stream)
+void CPMDData::m_WriteFaces(CBinaryBuffer& buff)
 {
 	unsigned  short sVal;
 	const int triCou = m_triangles.size();
 
 	const int verCou = triCou * 3;
-	stream->write(4, &verCou);
+	buff.Reserve(4 + (size_t)verCou * 2);
+	buff.Write(4, &verCou);
 
 	for (int i = 0; i < triCou; i++) {
-		PMD_TRIANGLE_DATA& triData = m_triangles[i];
+		const PMD_TRIANGLE_DATA& triData = m_triangles[i];
 		for (int j = 0; j < 3; j++) {
 			//sVal = (unsigned short)triData.index[j];
 			sVal = (unsigned short)triData.index[2 - j];		// -Zの逆転を行っているため、面の順番も入れ替え.
-			stream->write(2, &sVal);
+			buff.Write(2, &sVal);
 		}
 	}
 }
@@ -1796,51 +2711,53 @@ void CPMDData::m_WriteFaces(sxsdk::stream_interface *stream)
 /**
  * マテリアルの出力.
  */
-void CPMDData::m_WriteMaterials(sxsdk::stream_interface *stream)
+void CPMDData::m_WriteMaterials(CBinaryBuffer& buff)
 {
 	const int mCou = m_materials.size();
-	stream->write(4, &mCou);
+	buff.Reserve(4 + (size_t)mCou * PMD_MATERIAL_DATA_SIZE);
+	buff.Write(4, &mCou);
 	
 	char szStr[64];
 	char cVal;
 	for (int i = 0; i < mCou; i++) {
 		PMD_MATERIAL_DATA& mData = m_materials[i];
-		stream->write(4, &mData.diffuse_color.x);
-		stream->write(4, &mData.diffuse_color.y);
-		stream->write(4, &mData.diffuse_color.z);
-		stream->write(4, &mData.alpha);
-		stream->write(4, &mData.specular);
-		stream->write(4, &mData.specular_color.x);
-		stream->write(4, &mData.specular_color.y);
-		stream->write(4, &mData.specular_color.z);
-		stream->write(4, &mData.ambient_color.x);
-		stream->write(4, &mData.ambient_color.y);
-		stream->write(4, &mData.ambient_color.z);
+		buff.Write(4, &mData.diffuse_color.x);
+		buff.Write(4, &mData.diffuse_color.y);
+		buff.Write(4, &mData.diffuse_color.z);
+		buff.Write(4, &mData.alpha);
+		buff.Write(4, &mData.specular);
+		buff.Write(4, &mData.specular_color.x);
+		buff.Write(4, &mData.specular_color.y);
+		buff.Write(4, &mData.specular_color.z);
+		buff.Write(4, &mData.ambient_color.x);
+		buff.Write(4, &mData.ambient_color.y);
+		buff.Write(4, &mData.ambient_color.z);
 
 		cVal = (char)mData.toon_index;
-		stream->write(1, &cVal);
+		buff.Write(1, &cVal);
 
 		cVal = (char)mData.edge_flag;
-		stream->write(1, &cVal);
+		buff.Write(1, &cVal);
 
-		stream->write(4, &mData.face_vert_count);
+		buff.Write(4, &mData.face_vert_count);
 
 		memset(szStr, 0, 24);
-		std::string str = Util::ConvUTF8ToSJIS(*m_shade, mData.tex_file_name);
+		const std::string& str = m_exportNames.texFileNames[i];
 		if (str.size() < 20) {
 			strcpy(szStr, str.c_str());
 		}
-		stream->write(20, szStr);
+		buff.Write(20, szStr);
 	}
 }
 
 /**
  * ボーンの出力.
  */
-void CPMDData::m_WriteBones(sxsdk::stream_interface *stream)
+void CPMDData::m_WriteBones(CBinaryBuffer& buff)
 {
 	unsigned short sCou = (unsigned short)m_bones.size();
-	stream->write(2, &sCou);
+	buff.Reserve(2 + (size_t)sCou * PMD_BONE_DATA_SIZE);
+	buff.Write(2, &sCou);
 
 	char szStr[256];
 	char cVal;
@@ -1849,70 +2766,67 @@ void CPMDData::m_WriteBones(sxsdk::stream_interface *stream)
 	for (int i = 0; i < m_bones.size(); i++) {
 		PMD_BONE_DATA& boneData = m_bones[i];
 
-		// ボーン名をMMDの日本語のものに置き換え.
-		std::string str = boneData.bone_name;
-		if (m_humanConvertBoneName && m_humanRigBonesType != human_rig_type_mmd_jp) {
-			const int index = CRigCtrl::GetHumanBoneIndex(m_shade, str, m_humanRigBonesType);
-			if (index >= 0) {
-				str = CRigCtrl::GetHumanBoneName(m_shade, index, human_rig_type_mmd_jp);
-			}
-		}
+		const std::string& str = m_exportNames.boneNames[i];
 		memset(szStr, 0, 20);
-		str = Util::ConvUTF8ToSJIS(*m_shade, str);
 		if (str.size() < 20) {
 			strcpy(szStr, str.c_str());
 		}
-		stream->write(20, szStr);
+		buff.Write(20, szStr);
 
 		if (boneData.parent_bone_index < 0) sVal = 0xffff;
 		else {
 			sVal = (unsigned short)boneData.parent_bone_index;
 		}
-		stream->write(2, &sVal);
+		buff.Write(2, &sVal);
 
 		sVal = (unsigned short)boneData.tail_pos_bone_index;
-		stream->write(2, &sVal);
+		buff.Write(2, &sVal);
 
 		cVal = (char)boneData.bone_type;
-		stream->write(1, &cVal);
+		buff.Write(1, &cVal);
 
 		sVal = (unsigned short)boneData.ik_parent_bone_index;
-		stream->write(2, &sVal);
+		buff.Write(2, &sVal);
 
 		v = boneData.bone_head_pos * m_scale;
 		v.z = -v.z;
-		stream->write(4, &v.x);
-		stream->write(4, &v.y);
-		stream->write(4, &v.z);
+		buff.Write(4, &v.x);
+		buff.Write(4, &v.y);
+		buff.Write(4, &v.z);
 	}
 }
 
 /**
  * IKの出力.
  */
-void CPMDData::m_WriteIKs(sxsdk::stream_interface *stream)
+void CPMDData::m_WriteIKs(CBinaryBuffer& buff)
 {
 	int ikCou = m_IKs.size();
+	{
+		size_t size = 2;
+		for (int i = 0; i < ikCou; i++) size += 11 + m_IKs[i].ik_child_bone_index.size() * 2;
+		buff.Reserve(size);
+	}
 
 	unsigned short sDat = (unsigned short)ikCou;
-	stream->write(2, &sDat);
+	buff.Write(2, &sDat);
 
 	char cDat;
 	for (int i = 0; i < ikCou; i++) {
 		PMD_IK_DATA& ikData = m_IKs[i];
 
 		sDat = (unsigned short)ikData.ik_bone_index;
-		stream->write(2, &sDat);
+		buff.Write(2, &sDat);
 		sDat = (unsigned short)ikData.ik_target_bone_index;
-		stream->write(2, &sDat);
+		buff.Write(2, &sDat);
 		cDat = (char)ikData.ik_child_bone_index.size();
-		stream->write(1, &cDat);
+		buff.Write(1, &cDat);
 		sDat = (unsigned short)ikData.iterations;
-		stream->write(2, &sDat);
-		stream->write(4, &ikData.control_weight);
+		buff.Write(2, &sDat);
+		buff.Write(4, &ikData.control_weight);
 		for (int j = 0; j < ikData.ik_child_bone_index.size(); j++) {
 			sDat = (unsigned short)ikData.ik_child_bone_index[j];
-			stream->write(2, &sDat);
+			buff.Write(2, &sDat);
 		}
 	}
 
@@ -1921,39 +2835,39 @@ void CPMDData::m_WriteIKs(sxsdk::stream_interface *stream)
 /**
  * Skin(表情)の出力.
  */
-void CPMDData::m_WriteSkins(sxsdk::stream_interface *stream)
+void CPMDData::m_WriteSkins(CBinaryBuffer& buff)
 {
-	m_pFacialSkin->ExportSkinData(stream);
+	m_pFacialSkin->ExportSkinData(buff);
 }
 
 /**
  * 表情枠情報の出力.
  */
-void CPMDData::m_WriteSkinWaku(sxsdk::stream_interface *stream)
+void CPMDData::m_WriteSkinWaku(CBinaryBuffer& buff)
 {
-	m_pFacialSkin->ExportSkinFrameData(stream);
+	m_pFacialSkin->ExportSkinFrameData(buff);
 }
 
 /**
  * ボーン枠情報の出力.
  */
-void CPMDData::m_WriteBoneWaku(sxsdk::stream_interface *stream)
+void CPMDData::m_WriteBoneWaku(CBinaryBuffer& buff)
 {
 	int bdCou = m_bonesDisp.size();
 	if (bdCou > 255) bdCou = 255;
 	unsigned char cVal = (unsigned char)bdCou;
 
-	stream->write(1, &cVal);
+	buff.Write(1, &cVal);
 	if (bdCou > 0) {
 		char szStr[256];
 		for (int i = 0; i < bdCou; i++) {
-			std::string str = Util::ConvUTF8ToSJIS(*m_shade, m_bonesDisp[i].disp_name);
+			std::string str = m_exportNames.boneDispNames[i];
 			if (str.length() > 48) str = str.substr(0, 48);
 			const int len = str.length();
 			memcpy(szStr, str.c_str(), len);
 			szStr[len + 0] = 0x0a;
 			szStr[len + 1] = 0;
-			stream->write(50, szStr);
+			buff.Write(50, szStr);
 		}
 	}
 }
@@ -1961,7 +2875,7 @@ void CPMDData::m_WriteBoneWaku(sxsdk::stream_interface *stream)
 /**
  * ボーン枠用の表示リストの出力.
  */
-void CPMDData::m_WriteBoneList(sxsdk::stream_interface *stream)
+void CPMDData::m_WriteBoneList(CBinaryBuffer& buff)
 {
 	int bdCou = m_bonesDisp.size();
 	if (bdCou > 255) bdCou = 255;
@@ -1970,7 +2884,8 @@ void CPMDData::m_WriteBoneList(sxsdk::stream_interface *stream)
 	for (int i = 0; i < bdCou; i++) {
 		iCou += m_bonesDisp[i].data.size();
 	}
-	stream->write(4, &iCou);
+	buff.Reserve(4 + (size_t)iCou * 3);
+	buff.Write(4, &iCou);
 
 	if (iCou > 0) {
 		short sVal;
@@ -1981,8 +2896,8 @@ void CPMDData::m_WriteBoneList(sxsdk::stream_interface *stream)
 			for (int j = 0; j < cou; j++) {
 				sVal = (short)dispData.data[j].bone_index;
 				cVal = (unsigned char)dispData.data[j].bone_disp_index + 1;
-				stream->write(2, &sVal);
-				stream->write(1, &cVal);
+				buff.Write(2, &sVal);
+				buff.Write(1, &cVal);
 			}
 		}
 	}
@@ -1992,90 +2907,70 @@ void CPMDData::m_WriteBoneList(sxsdk::stream_interface *stream)
 /**
  * 英語情報の出力.
  */
-void CPMDData::m_WriteExEnglishInfo(sxsdk::stream_interface *stream)
+void CPMDData::m_WriteExEnglishInfo(CBinaryBuffer& buff)
 {
-	m_WriteEnglishHeader(stream);
-	m_WriteEnglishBones(stream);
-	m_WriteEnglishSkins(stream);
-	m_WriteEnglishBoneWaku(stream);
+	m_WriteEnglishHeader(buff);
+	m_WriteEnglishBones(buff);
+	m_WriteEnglishSkins(buff);
+	m_WriteEnglishBoneWaku(buff);
 }
 
 /**
  * 英語ヘッダの出力.
  */
-void CPMDData::m_WriteEnglishHeader(sxsdk::stream_interface *stream)
+void CPMDData::m_WriteEnglishHeader(CBinaryBuffer& buff)
 {
 	char cVal = 1;
-	stream->write(1, &cVal);
+	buff.Write(1, &cVal);
 
 	char szStr[300];
 	memset(szStr, 0, 20);
-	std::string str = Util::ConvUTF8ToSJIS(*m_shade, m_modelNameEng);
+	std::string str = m_exportNames.modelNameEng;
 	if (str.length() < 20) {
 		strcpy(szStr, str.c_str());
 	}
-	stream->write(20, szStr);
+	buff.Write(20, szStr);
 
 	memset(szStr, 0, 256);
-	str = Util::ConvUTF8ToSJIS(*m_shade, m_commentEng);
+	str = m_exportNames.commentEng;
 	if (str.size() > 255) {
 		strncpy(szStr, str.c_str(), 255);
 	} else {
 		strcpy(szStr, str.c_str());
 	}
-	stream->write(256, szStr);
+	buff.Write(256, szStr);
 }
 
 /**
  * 英語ボーン名リストの出力.
  */
-void CPMDData::m_WriteEnglishBones(sxsdk::stream_interface *stream)
+void CPMDData::m_WriteEnglishBones(CBinaryBuffer& buff)
 {
 	const int bCou = m_bones.size();
 
 	char szStr[40];
 	for (int i = 0; i < bCou; i++) {
-		PMD_BONE_DATA& boneData = m_bones[i];
-		std::string boneName = boneData.bone_name;
-
-		if (m_humanConvertBoneName && m_humanRigBonesType != human_rig_type_mmd_en) {
-			const int index = CRigCtrl::GetHumanBoneIndex(m_shade, boneName, m_humanRigBonesType);
-			if (index >= 0) {
-				boneName = CRigCtrl::GetHumanBoneName(m_shade, index, human_rig_type_mmd_en);
-			}
-		}
-		if (boneData.bone_type == bone_type_ik || boneData.bone_type == bone_type_hide || boneData.bone_type == bone_type_ik_c) {
-			for (int j = 0; j < 10; j++) {
-				std::string ikName = Util::GetUTF8Text(*m_shade, leg_ik_name_jp[j]);
-				if (ikName.length() == 0) break;
-				if (ikName.compare(boneName) == 0) {
-					boneName = leg_ik_name_en[j];
-					break;
-				}
-			}
-		}
-
+		const std::string& str = m_exportNames.boneNamesEng[i];
 		memset(szStr, 0, 20);
-		std::string str = Util::ConvUTF8ToSJIS(*m_shade, boneName);
 		if (str.size() < 20) {
 			strcpy(szStr, str.c_str());
 		}
-		stream->write(20, szStr);
+		buff.Write(20, szStr);
 	}
 }
 
 /**
  * 英語表情名リストの出力.
  */
-void CPMDData::m_WriteEnglishSkins(sxsdk::stream_interface *stream)
+void CPMDData::m_WriteEnglishSkins(CBinaryBuffer& buff)
 {
-	m_pFacialSkin->ExportEnglishSkinName(stream);
+	m_pFacialSkin->ExportEnglishSkinName(buff);
 }
 
 /**
  * 英語ボーン枠情報の出力.
  */
-void CPMDData::m_WriteEnglishBoneWaku(sxsdk::stream_interface *stream)
+void CPMDData::m_WriteEnglishBoneWaku(CBinaryBuffer& buff)
 {
 	int bdCou = m_bonesDisp.size();
 	if (bdCou > 255) bdCou = 255;
@@ -2089,7 +2984,7 @@ void CPMDData::m_WriteEnglishBoneWaku(sxsdk::stream_interface *stream)
 			memcpy(szStr, str.c_str(), len);
 			szStr[len + 0] = 0x0a;
 			szStr[len + 1] = 0;
-			stream->write(50, szStr);
+			buff.Write(50, szStr);
 		}
 	}
 }
@@ -2097,7 +2992,7 @@ void CPMDData::m_WriteEnglishBoneWaku(sxsdk::stream_interface *stream)
 /**
  * トゥーンテクスチャリストの出力.
  */
-void CPMDData::m_WriteToonTextureList(sxsdk::stream_interface *stream)
+void CPMDData::m_WriteToonTextureList(CBinaryBuffer& buff)
 {
 	// 数は10個固定.
 	const int tCou = 10;
@@ -2105,7 +3000,7 @@ void CPMDData::m_WriteToonTextureList(sxsdk::stream_interface *stream)
 	char szStr[256];
 	memset(szStr, 0, 120);
 	for (int i = 0; i < tCou; i++) {
-		stream->write(100, szStr);
+		buff.Write(100, szStr);
 	}
 }
 
@@ -2113,19 +3008,19 @@ void CPMDData::m_WriteToonTextureList(sxsdk::stream_interface *stream)
 /**
  * 物理演算用の剛体リストを出力.
  */
-void CPMDData::m_WritePhysicsRigidbodyList(sxsdk::stream_interface *stream)
+void CPMDData::m_WritePhysicsRigidbodyList(CBinaryBuffer& buff)
 {
 	int rCou = 0;
-	stream->write(4, &rCou);
+	buff.Write(4, &rCou);
 }
 
 /**
  * 物理演算用のジョイントリストを出力.
  */
-void CPMDData::m_WritePhysicsJointList(sxsdk::stream_interface *stream)
+void CPMDData::m_WritePhysicsJointList(CBinaryBuffer& buff)
 {
 	int jointCou = 0;
 
-	stream->write(4, &jointCou);
+	buff.Write(4, &jointCou);
 }
 
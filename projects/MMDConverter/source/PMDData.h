@@ -8,6 +8,11 @@
 
 #include "GlobalHeader.h"
 #include "FacialSkin.h"
+#include "TextureWriter.h"
+#include "BinaryBuffer.h"
+#include "ThreadPool.h"
+#include "SceneSnapshot.h"
+#include "ExportTask.h"
 
 #include <vector>
 #include <string>
@@ -22,12 +27,16 @@
 	頂点/法線/UVは、各頂点ごとに与えられる.
 */
 
+#define PMD_HEADER_SIZE					283			///< ヘッダ部のバイト数.
 #define PMD_VERTEX_DATA_SIZE			38			///< 頂点情報のバイト数.
 #define PMD_MATERIAL_DATA_SIZE			70			///< マテリアル情報のバイト数.
 #define PMD_BONE_DATA_SIZE				39			///< ボーン情報のバイト数. 
 #define PMD_RIGIDBODY_DATA_SIZE			83			///< 剛体情報のバイト数. 
 #define PMD_RIGIDBODY_JOINT_DATA_SIZE	124			///< 剛体のジョイント情報のバイト数. 
 
+#define PMD_CONVERT_STEP_COUNT			6			///< ConvertModelでの進捗のステップ数.
+#define PMD_ENCODE_STEP_COUNT			3			///< EncodeSectionsでの進捗のステップ数.
+
 /**
  * 頂点データ（格納用）.
  */
@@ -54,14 +63,31 @@ public:
 /**
  * 三角形データ（格納用）.
  */
-typedef struct {
-	int index[3];
+class PMD_TRIANGLE_DATA {
+public:
+	int index[3];					///< 頂点番号.
+
+	PMD_TRIANGLE_DATA() {
+		index[0] = index[1] = index[2] = 0;
+	}
+};
 
-	// 以下、作業用.
-	sxsdk::vec3 normal[3];
-	sxsdk::vec2 uv[3];
-	int orgFaceIndex;		// 元のShadeでの面番号.
-} PMD_TRIANGLE_DATA;
+/**
+ * 三角形の作業用データ.
+ * 頂点の分割が終わるまでの間のみ保持し、分割後は解放する.
+ */
+class PMD_TRIANGLE_WORK {
+public:
+	std::vector<sxsdk::vec3> normals;		///< 面頂点ごとの法線 (三角形数 x 3).
+	std::vector<sxsdk::vec2> uvs;			///< 面頂点ごとのUV (三角形数 x 3).
+	std::vector<int> orgFaceIndices;		///< 三角形ごとの元のShadeでの面番号.
+
+	void Clear() {
+		std::vector<sxsdk::vec3>().swap(normals);
+		std::vector<sxsdk::vec2>().swap(uvs);
+		std::vector<int>().swap(orgFaceIndices);
+	}
+};
 
 /**
  * マテリアルデータ（格納用）.
@@ -78,7 +104,10 @@ public:
 	int face_vert_count;			///< マテリアルを割り当てる面頂点数.
 	std::string tex_file_name;		///< テクスチャファイル名(20バイトギリギリもあり).
 
-	sxsdk::master_surface_class* masterSurface;		///< Shadeでのmaster surface.
+	// 以下、PMD出力では使われない.
+	int surface_index;								///< CModelSnapshot::materialsでの表面材質番号 (ない場合は-1).
+	int texture_layer_index;						///< テクスチャとして出力するマッピングレイヤ番号 (ない場合は-1).
+	int texture_index;								///< CTextureWriterに登録したテクスチャ番号 (ない場合は-1).
 
 	PMD_MATERIAL_DATA() {
 		diffuse_color = sxsdk::vec3(1, 1, 1);
@@ -90,7 +119,9 @@ public:
 		toon_index = 0;
 		face_vert_count = 0;
 		tex_file_name = "";
-		masterSurface = NULL;
+		surface_index = -1;
+		texture_layer_index = -1;
+		texture_index       = -1;
 	}
 };
 
@@ -120,9 +151,6 @@ public:
 	int ik_parent_bone_index;				///< IKボーン番号(影響IKボーン。ない場合は0).
 	sxsdk::vec3 bone_head_pos;				///< ボーンのヘッダの位置.
 
-	// 以下、PMD出力では使われない.
-	sxsdk::shape_class* pShadeShape;		///< Shadeでのボーンに対応する形状ポインタ.
-
 	PMD_BONE_DATA() {
 		bone_name = "";
 		parent_bone_index    = -1;
@@ -130,7 +158,6 @@ public:
 		bone_type            = bone_type_rotate_trans;
 		ik_parent_bone_index = 0;
 		bone_head_pos        = sxsdk::vec3(0, 0, 0);
-		pShadeShape          = NULL;
 	}
 };
 
@@ -256,6 +283,22 @@ public:
 	}
 };
 
+/**
+ * 出力時にShift-JISに変換した文字列.
+ * Shadeのテキスト変換はメインスレッドで行い、各セクションの格納はワーカースレッドで行うため.
+ */
+class PMD_EXPORT_NAMES {
+public:
+	std::string modelName;						///< 形状名.
+	std::string comment;						///< コメント文.
+	std::string modelNameEng;					///< 形状名（英語）.
+	std::string commentEng;						///< コメント文（英語）.
+	std::vector<std::string> texFileNames;		///< マテリアルごとのテクスチャファイル名.
+	std::vector<std::string> boneNames;			///< ボーン名 (MMDの名前に置き換え後).
+	std::vector<std::string> boneNamesEng;		///< 英語のボーン名.
+	std::vector<std::string> boneDispNames;		///< ボーン枠の表示名.
+};
+
 /*****************************************************/
 
 class CPMDData
@@ -281,6 +324,7 @@ private:
 
 	std::vector<PMD_VERTEX_DATA> m_vertices;			///< 頂点情報.
 	std::vector<PMD_TRIANGLE_DATA> m_triangles;			///< 面頂点番号（三角形面）.
+	PMD_TRIANGLE_WORK m_triangleWork;					///< 三角形の作業用の法線/UV (頂点の分割後は空).
 
 	std::vector<PMD_MATERIAL_DATA> m_materials;			///< マテリアルの格納バッファ.
 	std::vector<PMD_BONE_DATA> m_bones;					///< ボーンの格納バッファ.
@@ -297,16 +341,35 @@ private:
 	float m_scale;										///< 出力時のスケーリング.
 	bool m_toonEdge;									///< Toonのエッジを反映するか.
 	bool m_boneMoveRootOnly;							///< ボーンの移動処理はRootのみに限定.
+	bool m_mergeMaterials;								///< 同一パラメータのマテリアルを統合.
+	bool m_textureAtlas;								///< テクスチャをアトラスにまとめる.
+	bool m_textureCache;								///< 変更のないテクスチャは再出力しない.
+	int m_textureMaxSize;								///< テクスチャの最大サイズ (0の場合は制限なし).
+	bool m_texturePowerOfTwo;							///< テクスチャサイズを2の累乗にする.
+	int m_threadCount;									///< 変換処理で使用するスレッド数 (0の場合は自動).
+	bool m_weldVertices;								///< 法線/UVの差が許容値以内の頂点を1つにまとめる.
+	float m_weldNormalAngle;							///< 頂点をまとめる法線の角度の許容値 (度).
+	float m_weldUVDistance;								///< 頂点をまとめるUVの距離の許容値.
+	int m_weldedVertexCount;							///< 許容値によりまとめた(増やさずに済んだ)頂点数.
+	int m_textureFailedCount;							///< 保存に失敗したテクスチャ数.
+	bool m_removeDuplicateMorphs;						///< 重複した表情と、頂点が移動しない表情を削除.
 
 	float m_humanRigBonesNameCheck;						///< ボーンがMMD形式のボーンである割合 (1.0で完全一致).
 	int m_humanRigBonesType;							///< ボーン名の種類 (human_rig_type_default / human_rig_type_mmd_jp / human_rig_type_mmd_en).
 	bool m_humanConvertBoneName;						///< ボーン名を自動的に変更.
-
-	sxsdk::shape_class* m_pBoneRoot;					///< ボーンのルート.
+	std::shared_ptr<const CSkeletonModel> m_pSkeleton;	///< ボーン構造 (m_bonesの先頭のボーンに対応。キャッシュから読み込んだ場合はNULL).
 
 	CFacialSkin* m_pFacialSkin;							///< フェイシャルスキンでの表情管理用.
+	CTextureWriter* m_pTextureWriter;					///< テクスチャの出力用.
+	CThreadPool* m_pThreadPool;							///< 変換処理の並列化用.
+	CThreadPool* m_pSharedThreadPool;					///< 他のモデルと共有するスレッドプール (NULLの場合はm_pThreadPoolを作成する).
+	CTextureCache* m_pSharedTextureCache;				///< 他のモデルと共有するテクスチャのキャッシュ (NULLの場合は共有しない).
+	CExportProgress* m_pProgress;						///< 変換処理の進捗 (NULLの場合は報告しない).
+
+	std::vector<int> m_orgSameVertexOffsets;			///< 元の頂点ごとの、増加した頂点の開始位置 (元の頂点数 + 1個)。表情の格納時に使用.
+	std::vector<int> m_orgSameVertexIndices;			///< 同一頂点がUV/法線の都合で増加した場合の頂点番号 (元の頂点ごと).
 
-	std::vector< std::vector<int> > m_orgSameVertexList;	///< 同一頂点がUV/法線の都合で増加した場合リスト。表情の格納時に使用.
+	PMD_EXPORT_NAMES m_exportNames;						///< 出力用にShift-JISに変換した文字列.
 
 	/**
 	 * 初期化処理.
@@ -318,31 +381,73 @@ private:
 	 */
 	void m_Term ();
 
+	/**
+	 * スナップショットからPMD情報に変換 (ConvertModelから呼ばれる).
+	 */
+	bool m_ConvertSnapshot(CModelSnapshot& snapshot, const CPMDDlgInfo& pmdDlgData);
+
+	/**
+	 * 進捗を1ステップ進める.
+	 * @return キャンセルされている場合はfalse.
+	 */
+	bool m_StepProgress();
+
+	/**
+	 * 面を三角形分割.
+	 * @param[in]  faceOffsets   面ごとの面頂点の開始位置 (面数 + 1個).
+	 * @param[in]  faceIndices   面頂点ごとの頂点番号.
+	 * @param[out] retTriCorners 三角形ごとの面頂点の位置 (3つずつ).
+	 * @param[out] retTriFaces   三角形ごとの元の面番号.
+	 */
+	void m_TriangulateFaces(const std::vector<int>& faceOffsets, const std::vector<int>& faceIndices, std::vector<int>& retTriCorners, std::vector<int>& retTriFaces);
+
 	/**
 	 * UV/法線が異なる頂点で頂点を増やして対応.
+	 * m_weldVerticesがtrueの場合は、法線/UVの差が許容値以内の面頂点は同じ頂点とする.
 	 */
 	void m_OptimizeVertexNormalUV();
 
 	/**
 	 * マテリアルの保持.
 	 */
-	void m_SetMaterials(sxsdk::scene_interface* scene, sxsdk::shape_class& shape);
+	void m_SetMaterials(const CModelSnapshot& snapshot);
 
 	/**
-	 * ボーンの保持.
+	 * 同一パラメータのマテリアルを統合し、三角形を連続した範囲にまとめる.
 	 */
-	void m_SetBones(sxsdk::shape_class& shape);
-	void m_SetBoneLoop(const int depth, const int parentBoneIndex, sxsdk::shape_class* pBoneShape);
+	void m_MergeMaterials();
 
 	/**
-	 * 指定のボーン名がすでに格納済みか.
+	 * 三角形を指定の順に並び替え (作業用の法線/UVも合わせて並び替える).
+	 * @param[in] triOrder  並び替え後の三角形ごとの、元の三角形番号.
 	 */
-	int m_FindBone(const std::string boneName);
+	void m_ReorderTriangles(const std::vector<int>& triOrder);
+
+	/**
+	 * テクスチャをアトラスにまとめ、三角形のUVをアトラス上のものに変換.
+	 */
+	void m_BuildTextureAtlas();
+
+	/**
+	 * マテリアルのテクスチャのピクセルをCTextureWriterに登録.
+	 * スナップショットのピクセルはCTextureWriterに移される.
+	 */
+	void m_StoreTextures(CModelSnapshot& snapshot);
+
+	/**
+	 * マテリアルが参照するテクスチャの保存を開始 (保存はワーカースレッドで行われる).
+	 */
+	void m_WriteTextures();
+
+	/**
+	 * ボーンの保持.
+	 */
+	void m_SetBones(const CModelSnapshot& snapshot);
 
 	/**
-	 * 指定のボーン形状がすでに格納済みか.
+	 * 指定のボーン名がすでに格納済みか.
 	 */
-	int m_FindBone(sxsdk::shape_class* pShape);
+	int m_FindBone(const std::string boneName);
 
 	/**
 	 * 指定のボーン間に存在するボーン番号を取得。endBoneIndexから親をたどるとstartBoneIndexに行き着くのが保証されているとする.
@@ -352,13 +457,12 @@ private:
 	/**
 	 * 頂点に対応するボーンとスキン値の保持.
 	 */
-	void m_SetVertexSkins(sxsdk::shape_class& shape);
+	void m_SetVertexSkins(const CModelSnapshot& snapshot);
 
 	/**
 	 * IK情報の格納.
 	 */
-	void m_SetIKs(sxsdk::scene_interface* scene, sxsdk::shape_class& shape);
-	void m_SetIKsLoop(sxsdk::ik_class& ik, sxsdk::scene_interface* scene, sxsdk::shape_class& shape);
+	void m_SetIKs(const CModelSnapshot& snapshot);
 
 	/**
 	 * 人体時のIK情報を自動で追加、IK用ボーンも追加される.
@@ -372,103 +476,116 @@ private:
 
 	/**
 	 * 指定のIK情報を格納。この際に、IK用ボーンも生成.
+	 * @param[in] ikRootBoneIndex   IK rootのボーン番号.
+	 * @param[in] ikEndBoneIndex    IK endのボーン番号.
+	 * @param[in] goalWPos          goalのワールド座標位置.
 	 */
-	bool m_AddIK(sxsdk::shape_class* ikRootShape, sxsdk::shape_class* ikEndShape, sxsdk::shape_class* ikGoalShape);
+	bool m_AddIK(const int ikRootBoneIndex, const int ikEndBoneIndex, const sxsdk::vec3& goalWPos);
 
 	/**
 	 * 表示枠情報を設定.
 	 */
 	void m_SetBonesDisp();
 
+	/**
+	 * 出力する文字列をShift-JISに変換して保持.
+	 */
+	void m_PrepareExportNames();
+
+	/**
+	 * 指定のセクション(pmd_section_xxx)をバッファに格納 (ワーカースレッドから呼ばれる).
+	 */
+	void m_WriteSection(const int section, CBinaryBuffer& buff);
+
 	/**
 	 * ヘッダ部の出力.
 	 */
-	void m_WriteHeader(sxsdk::stream_interface *stream);
+	void m_WriteHeader(CBinaryBuffer& buff);
 
 	/**
 	 * 頂点の出力.
 	 */
-	void m_WriteVertices(sxsdk::stream_interface *stream);
+	void m_WriteVertices(CBinaryBuffer& buff);
 
 	/**
 	 * 面の出力.
 	 */
-	void m_WriteFaces(sxsdk::stream_interface *stream);
+	void m_WriteFaces(CBinaryBuffer& buff);
 
 	/**
 	 * マテリアルの出力.
 	 */
-	void m_WriteMaterials(sxsdk::stream_interface *stream);
+	void m_WriteMaterials(CBinaryBuffer& buff);
 
 	/**
 	 * ボーンの出力.
 	 */
-	void m_WriteBones(sxsdk::stream_interface *stream);
+	void m_WriteBones(CBinaryBuffer& buff);
 
 	/**
 	 * IKの出力.
 	 */
-	void m_WriteIKs(sxsdk::stream_interface *stream);
+	void m_WriteIKs(CBinaryBuffer& buff);
 
 	/**
 	 * Skin(表情)の出力.
 	 */
-	void m_WriteSkins(sxsdk::stream_interface *stream);
+	void m_WriteSkins(CBinaryBuffer& buff);
 
 	/**
 	 * 表情枠情報の出力.
 	 */
-	void m_WriteSkinWaku(sxsdk::stream_interface *stream);
+	void m_WriteSkinWaku(CBinaryBuffer& buff);
 
 	/**
 	 * ボーン枠情報の出力.
 	 */
-	void m_WriteBoneWaku(sxsdk::stream_interface *stream);
+	void m_WriteBoneWaku(CBinaryBuffer& buff);
 
 	/**
 	 * ボーン枠用の表示リストの出力.
 	 */
-	void m_WriteBoneList(sxsdk::stream_interface *stream);
+	void m_WriteBoneList(CBinaryBuffer& buff);
 
 	/**
 	 * 英語情報の出力.
 	 */
-	void m_WriteExEnglishInfo(sxsdk::stream_interface *stream);
+	void m_WriteExEnglishInfo(CBinaryBuffer& buff);
 
 	/**
 	 * 英語ヘッダの出力.
 	 */
-	void m_WriteEnglishHeader(sxsdk::stream_interface *stream);
+	void m_WriteEnglishHeader(CBinaryBuffer& buff);
 
 	/**
 	 * 英語ボーン名リストの出力.
 	 */
-	void m_WriteEnglishBones(sxsdk::stream_interface *stream);
+	void m_WriteEnglishBones(CBinaryBuffer& buff);
 
 	/**
 	 * 英語表情名リストの出力.
 	 */
-	void m_WriteEnglishSkins(sxsdk::stream_interface *stream);
+	void m_WriteEnglishSkins(CBinaryBuffer& buff);
 
 	/**
 	 * 英語ボーン枠情報の出力.
 	 */
-	void m_WriteEnglishBoneWaku(sxsdk::stream_interface *stream);
+	void m_WriteEnglishBoneWaku(CBinaryBuffer& buff);
 
 	/**
 	 * トゥーンテクスチャリストの出力.
 	 */
-	void m_WriteToonTextureList(sxsdk::stream_interface *stream);
+	void m_WriteToonTextureList(CBinaryBuffer& buff);
 
 	/**
 	 * 物理演算用の剛体リストを出力.
 	 */
-	void m_WritePhysicsRigidbodyList(sxsdk::stream_interface *stream);
+	void m_WritePhysicsRigidbodyList(CBinaryBuffer& buff);
 
 	/**
 	 * 物理演算用のジョイントリストを出力.
 	 */
-	void m_WritePhysicsJointList(sxsdk::stream_interface *stream);
+	void m_WritePhysicsJointList(CBinaryBuffer& buff);
 
 	/**
 	 * 指定のファイル名のフルパスを取得.
@@ -497,6 +614,65 @@ public:
 	 */
 	bool Export(sxsdk::stream_interface *stream, CPMDDlgInfo& pmdInfo);
 
+	/**
+	 * 複数のモデルを並列に変換する場合に共有する、スレッドプールとテクスチャのキャッシュを指定 (CaptureModelの前に呼ぶこと).
+	 * 指定したものはこのクラスでは破棄しないため、このクラスより後に破棄すること.
+	 */
+	void SetSharedResources(CThreadPool* pPool, CTextureCache* pTextureCache);
+
+	/**
+	 * 出力設定を保持し、変換に必要なシーン情報をスナップショットとして取得 (メインスレッドから呼ぶこと).
+	 * SetModelを、CaptureModel/ConvertModel/GetLimitErrorIDに分けたもの.
+	 * @param[in]  pMergeShapes  shapeと同じボーンルートを持ち、1つのモデルに統合するポリゴンメッシュ (NULLの場合は統合しない).
+	 */
+	bool CaptureModel(sxsdk::shape_class& shape, sxsdk::stream_interface *stream, const CPMDDlgInfo& pmdDlgData, CModelSnapshot& retSnapshot, const std::vector<sxsdk::shape_class *>* pMergeShapes = NULL);
+
+	/**
+	 * スナップショットからPMD情報に変換 (シーンは参照しないため、ワーカースレッドから呼ぶことができる).
+	 * @param[in] pProgress   進捗 (PMD_CONVERT_STEP_COUNTステップ進む).
+	 * @return キャンセルされた場合はfalse.
+	 */
+	bool ConvertModel(CModelSnapshot& snapshot, const CPMDDlgInfo& pmdDlgData, CExportProgress* pProgress = NULL);
+
+	/**
+	 * 変換結果がPMDの制限を超える場合は、エラーメッセージのIDを返す (制限内の場合はNULL).
+	 */
+	const char* GetLimitErrorID() const;
+
+	/**
+	 * 許容値による頂点の統合で、増やさずに済んだ頂点数を取得.
+	 */
+	int GetWeldedVertexCount() const { return m_weldedVertexCount; }
+
+	/**
+	 * 他の表情と移動量が同一の表情の数と、頂点が移動しない表情の数を取得.
+	 */
+	int GetDuplicateMorphCount() const { return m_pFacialSkin ? m_pFacialSkin->GetDuplicateSkinCount() : 0; }
+	int GetEmptyMorphCount() const { return m_pFacialSkin ? m_pFacialSkin->GetEmptySkinCount() : 0; }
+
+	/**
+	 * 保存に失敗したテクスチャ数を取得 (EncodeSectionsの後に参照すること).
+	 */
+	int GetTextureFailedCount() const { return m_textureFailedCount; }
+
+	/**
+	 * PMDの各セクションをバッファに格納し、テクスチャの保存の完了を待つ (ワーカースレッドから呼ぶことができる).
+	 * @param[in] pProgress   進捗 (PMD_ENCODE_STEP_COUNTステップ進む).
+	 * @return キャンセルされた場合はfalse.
+	 */
+	bool EncodeSections(std::vector<CBinaryBuffer>& retSectionBuffers, CExportProgress* pProgress = NULL);
+
+	/**
+	 * EncodeSectionsで格納したバッファを、PMDの順番でstreamに出力 (メインスレッドから呼ぶこと).
+	 */
+	void WriteSections(sxsdk::stream_interface *stream, const std::vector<CBinaryBuffer>& sectionBuffers);
+
+	/**
+	 * EncodeSectionsで格納したバッファを、PMDの順番でファイルに出力 (一括出力で、stream以外に出力する場合).
+	 * @param[in]  filePath  ファイルのフルパス (UTF-8).
+	 */
+	bool WriteSections(const std::string& filePath, const std::vector<CBinaryBuffer>& sectionBuffers);
+
 	/**
 	 * Meshの頂点の数.
 	 */
@@ -506,6 +682,20 @@ public:
 	 * Meshを構成する三角形の数.
 	 */
 	int GetTrianglesCount() { return m_triangles.size(); }
+
+	/**
+	 * 変換後の情報をキャッシュファイル(.mmdcache)として出力先ディレクトリに保存.
+	 * SetModelの後に呼ぶこと.
+	 * @param[in]  fileName  ファイル名.
+	 */
+	bool SaveModelCache(const std::string& fileName);
+
+	/**
+	 * キャッシュファイル(.mmdcache)から変換後の情報を復元.
+	 * エクスポータ自身は書き出しのみで、この関数は呼ばない (キャッシュを読み込む側の参照実装).
+	 * @param[in]  filePath  ファイルのフルパス (UTF-8).
+	 */
+	bool LoadModelCache(const std::string& filePath);
 };
 
 #endif
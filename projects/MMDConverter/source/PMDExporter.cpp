@@ -7,6 +7,9 @@
 #include "ShapeStack.h"
 #include "StreamCtrl.h"
 #include "Util.h"
+#include "ExportTask.h"
+#include "StageGraph.h"
+#include "SceneSnapshot.h"
 
 enum {
 	dlg_scale_id = 101,						// scale.
@@ -15,12 +18,71 @@ enum {
 	dlg_human_conv_bones_name_id = 401,		// 人体ボーンの名称をMMD向けに変更.
 	dlg_human_auto_ik = 402,				// IKの自動割り当て.
 
+	dlg_merge_materials_id = 601,			// 同一マテリアルの統合.
+	dlg_texture_atlas_id = 602,				// テクスチャアトラスの作成.
+	dlg_texture_cache_id = 603,				// テクスチャのキャッシュを使用.
+	dlg_texture_max_size_id = 604,			// テクスチャの最大サイズ.
+	dlg_texture_power_of_two_id = 605,		// テクスチャサイズを2の累乗にする.
+
+	dlg_write_model_cache_id = 701,			// モデルキャッシュ(.mmdcache)を出力.
+	dlg_thread_count_id = 702,				// 変換処理で使用するスレッド数.
+	dlg_export_all_meshes_id = 703,			// ボーンの割り当てられたすべてのメッシュを出力.
+	dlg_merge_meshes_id = 704,				// 同じボーンルートを持つメッシュを統合.
+
+	dlg_generate_normals_id = 801,			// 法線をプラグイン内で生成.
+	dlg_smoothing_angle_id = 802,			// 法線生成時のスムーズ角度.
+	dlg_weld_vertices_id = 803,				// 法線/UVの差が許容値以内の頂点をまとめる.
+	dlg_weld_normal_angle_id = 804,			// 頂点をまとめる法線の角度の許容値.
+	dlg_weld_uv_distance_id = 805,			// 頂点をまとめるUVの距離の許容値.
+
+	dlg_remove_duplicate_morphs_id = 901,	// 重複した表情と、頂点が移動しない表情を削除.
+
 	dlg_note_japanese_txt_id = 501,			// 「日本語」.
 	dlg_note_japanese_area_id = 502,		// 「日本語」のテキスト入力.
 	dlg_note_english_txt_id = 503,			// 「英語」.
 	dlg_note_english_area_id = 504,			// 「英語」のテキスト入力.
 };
 
+namespace {
+	/**
+	 * 一括出力での、モデルごとの情報.
+	 */
+	class PMD_BATCH_ITEM {
+	public:
+		sxsdk::shape_class* pShape;					///< 出力するポリゴンメッシュ.
+		std::string fileName;						///< 出力ファイル名.
+		std::string filePath;						///< 出力ファイルのフルパス (streamに出力する場合は空).
+		CPMDData* pPMDData;
+		CModelSnapshot snapshot;
+		const char* errorID;						///< 範囲チェックでのエラー、または変換中のエラー.
+		std::string errorDetail;					///< 変換中に発生した例外の内容.
+		std::vector<CBinaryBuffer> sectionBuffers;	///< PMDの各セクションのバッファ.
+		bool converted;								///< 変換とバッファの作成が完了した.
+
+		PMD_BATCH_ITEM() {
+			pShape    = NULL;
+			pPMDData  = NULL;
+			errorID   = NULL;
+			converted = false;
+		}
+		~PMD_BATCH_ITEM() {
+			if (pPMDData) delete pPMDData;
+		}
+	};
+
+	/**
+	 * 変換後の情報のキャッシュファイル名 (model.pmd -> model.mmdcache).
+	 */
+	std::string GetModelCacheFileName(const std::string& fileName)
+	{
+		std::string cacheFileName = fileName;
+		const size_t extPos = cacheFileName.find_last_of('.');
+		if (extPos != std::string::npos) cacheFileName = cacheFileName.substr(0, extPos);
+		cacheFileName += ".mmdcache";
+		return cacheFileName;
+	}
+}
+
 CPMDExporter::CPMDExporter(sxsdk::shade_interface &shade) : shade(shade)
 {
 	m_pCurrentShape = NULL;
@@ -57,6 +119,9 @@ void CPMDExporter::do_export (sxsdk::plugin_exporter_interface *plugin_exporter,
 {
 	compointer<sxsdk::scene_interface> scene(shade.get_scene_interface());
 
+	// シーンが切り替わった場合は、前のシーンのキャッシュを破棄 (ボーン名の変換表もここで準備).
+	SceneSnapshot::BeginExport(shade, scene);
+
 	//------------------------------------------------------//
 	//	ボーンの割り当てられたポリゴンメッシュを選択		//
 	//------------------------------------------------------//
@@ -88,32 +153,46 @@ void CPMDExporter::do_export (sxsdk::plugin_exporter_interface *plugin_exporter,
 		}
 	}
 	if (!chkF) {
-		if (meshShapeList.size() == 1) {
+		if (meshShapeList.size() == 1 || m_dlgData.exportAllMeshes) {
 			targetShape = meshShapeList[0];
+		} else if (m_dlgData.mergeMeshes) {
+			// すべてのメッシュが同じボーンルートを持つ場合は、統合して1つのモデルとする.
+			bool sameRootF = true;
+			for (int i = 1; i < boneShapeList.size(); i++) {
+				if (boneShapeList[i] != boneShapeList[0]) {
+					sameRootF = false;
+					break;
+				}
+			}
+			if (sameRootF) targetShape = meshShapeList[0];
 		}
 	}
 
+	//------------------------------------------------------//
+	//	一括出力											//
+	//------------------------------------------------------//
+	if (m_dlgData.exportAllMeshes && meshShapeList.size() > 1) {
+		try {
+			m_pluginExporter = plugin_exporter;
+			m_pluginExporter->AddRef();
+
+			m_stream = m_pluginExporter->get_stream_interface();
+
+			m_ExportAllMeshes(meshShapeList, boneShapeList, targetShape);
+		} catch (...) { }
+
+		// ダイアログのstream情報を保存.
+		StreamCtrl::SavePMDDlgInfo(&shade, m_dlgData);
+		return;
+	}
+
 	//------------------------------------------------------//
 	//	条件に合うかチェック								//
 	//------------------------------------------------------//
 	{
-		if (targetShape->get_type() != sxsdk::enums::polygon_mesh) {
-			shade.show_message_box(shade.gettext("msg_select_polygonmesh"), false);
-			return;
-		}
-		const int skin_type = targetShape->get_skin_type();
-		if (skin_type != 1) {		// 頂点ブレンドのスキンでない場合はスキップ.
-			shade.show_message_box(shade.gettext("msg_skin_vertex_blend"), false);
-			return;
-		}
-
-		sxsdk::polygon_mesh_class& pmesh = targetShape->get_polygon_mesh();
-		if (pmesh.get_number_of_faces() > 65535) {
-			shade.show_message_box(shade.gettext("msg_mesh_triangle_65535"), false);
-			return;
-		}
-		if (pmesh.get_total_number_of_control_points() > 65535) {
-			shade.show_message_box(shade.gettext("msg_mesh_vertex_65535"), false);
+		const char* errorID = m_GetMeshErrorID(*targetShape);
+		if (errorID) {
+			shade.show_message_box(shade.gettext(errorID), false);
 			return;
 		}
 	}
@@ -147,14 +226,50 @@ void CPMDExporter::do_export (sxsdk::plugin_exporter_interface *plugin_exporter,
 	//m_pluginExporter->do_export();
 
 	try {
-		if (m_pmdData->SetModel(*targetShape, m_stream, m_dlgData)) {
-			// PMD形式で出力.
-			m_pmdData->Export(m_stream, m_dlgData);
+		// 同じボーンルートを持つポリゴンメッシュを統合する場合.
+		std::vector<sxsdk::shape_class *> mergeShapes;
+		if (m_dlgData.mergeMeshes) m_GetMergeShapes(targetShape, meshShapeList, boneShapeList, mergeShapes, true);
+
+		// シーンの情報は、メインスレッドでスナップショットとして取得.
+		CModelSnapshot snapshot;
+		if (m_pmdData->CaptureModel(*targetShape, m_stream, m_dlgData, snapshot, m_dlgData.mergeMeshes ? &mergeShapes : NULL)) {
+			const std::string fileName = Util::GetFileNameToStream(m_stream);
+
+			// 変換後の情報のキャッシュファイル名 (model.pmd -> model.mmdcache).
+			const std::string cacheFileName = GetModelCacheFileName(fileName);
+
+			// 変換、テクスチャの保存、PMDのバッファの作成はワーカースレッドで行う.
+			// ワーカーはシーンを参照せず、スナップショットのみを使用する.
+			CPMDData* pmdData = m_pmdData;
+			const CPMDDlgInfo dlgData = m_dlgData;
+			const char* errorID = NULL;
+			std::vector<CBinaryBuffer> sectionBuffers;
+
+			CExportTask task(shade, fileName);
+			task.GetProgress().AddStepCount(PMD_CONVERT_STEP_COUNT + PMD_ENCODE_STEP_COUNT);
+			const bool ret = task.Run([&](CExportProgress& progress) {
+				if (!pmdData->ConvertModel(snapshot, dlgData, &progress)) return false;
+				snapshot.Clear();
+
+				// 範囲チェック.
+				errorID = pmdData->GetLimitErrorID();
+				if (errorID) return false;
+
+				if (!pmdData->EncodeSections(sectionBuffers, &progress)) return false;
+				if (dlgData.writeModelCache) pmdData->SaveModelCache(cacheFileName);
+				return true;
+			});
+			if (errorID) shade.show_message_box(shade.gettext(errorID), false);
+
+			if (ret) {
+				// PMD形式で出力.
+				m_pmdData->WriteSections(m_stream, sectionBuffers);
 
-			{
-				const std::string fileName = Util::GetFileNameToStream(m_stream);
 				std::string str = fileName + std::string(" ") + shade.gettext("msg_finish_export");
 				shade.message(str.c_str());
+				m_ShowWeldedVertexCount(*m_pmdData);
+				m_ShowDuplicateMorphCount(*m_pmdData);
+				m_ShowTextureFailedCount(*m_pmdData);
 			}
 		}
 		delete m_pmdData;
@@ -172,6 +287,236 @@ void CPMDExporter::do_export (sxsdk::plugin_exporter_interface *plugin_exporter,
 	StreamCtrl::SavePMDDlgInfo(&shade, m_dlgData);
 }
 
+/**
+ * 出力できないポリゴンメッシュの場合は、メッセージのIDを返す.
+ */
+const char* CPMDExporter::m_GetMeshErrorID(sxsdk::shape_class& shape)
+{
+	if (shape.get_type() != sxsdk::enums::polygon_mesh) return "msg_select_polygonmesh";
+
+	const int skin_type = shape.get_skin_type();
+	if (skin_type != 1) return "msg_skin_vertex_blend";		// 頂点ブレンドのスキンでない場合はスキップ.
+
+	sxsdk::polygon_mesh_class& pmesh = shape.get_polygon_mesh();
+	if (pmesh.get_number_of_faces() > 65535) return "msg_mesh_triangle_65535";
+	if (pmesh.get_total_number_of_control_points() > 65535) return "msg_mesh_vertex_65535";
+
+	return NULL;
+}
+
+/**
+ * 許容値による頂点の統合で、増やさずに済んだ頂点数をメッセージに出す.
+ */
+void CPMDExporter::m_ShowWeldedVertexCount(const CPMDData& pmdData)
+{
+	if (!m_dlgData.weldVertices) return;
+
+	char szStr[256];
+	snprintf(szStr, sizeof(szStr), shade.gettext("msg_weld_vertices"), pmdData.GetWeldedVertexCount());
+	shade.message(szStr);
+}
+
+/**
+ * 重複した表情と、頂点が移動しない表情の数をメッセージに出す.
+ */
+void CPMDExporter::m_ShowDuplicateMorphCount(const CPMDData& pmdData)
+{
+	const int duplicateCou = pmdData.GetDuplicateMorphCount();
+	const int emptyCou     = pmdData.GetEmptyMorphCount();
+	if (duplicateCou == 0 && emptyCou == 0) return;
+
+	char szStr[256];
+	snprintf(szStr, sizeof(szStr), shade.gettext(m_dlgData.removeDuplicateMorphs ? "msg_remove_duplicate_morphs" : "msg_found_duplicate_morphs"), duplicateCou, emptyCou);
+	shade.message(szStr);
+}
+
+/**
+ * 保存に失敗したテクスチャの数をメッセージに出す.
+ */
+void CPMDExporter::m_ShowTextureFailedCount(const CPMDData& pmdData)
+{
+	const int failedCou = pmdData.GetTextureFailedCount();
+	if (failedCou == 0) return;
+
+	char szStr[256];
+	snprintf(szStr, sizeof(szStr), shade.gettext("msg_texture_write_failed"), failedCou);
+	shade.message(szStr);
+}
+
+/**
+ * 指定のポリゴンメッシュと同じボーンルートを持ち、1つのモデルに統合するポリゴンメッシュを取得.
+ */
+void CPMDExporter::m_GetMergeShapes(sxsdk::shape_class* targetShape, const std::vector<sxsdk::shape_class *>& meshShapeList, const std::vector<sxsdk::shape_class *>& boneShapeList, std::vector<sxsdk::shape_class *>& retShapes, const bool showErrors)
+{
+	retShapes.clear();
+
+	sxsdk::shape_class* pBoneRoot = NULL;
+	for (int i = 0; i < meshShapeList.size(); i++) {
+		if (meshShapeList[i] == targetShape) {
+			pBoneRoot = boneShapeList[i];
+			break;
+		}
+	}
+	if (!pBoneRoot) return;
+
+	for (int i = 0; i < meshShapeList.size(); i++) {
+		sxsdk::shape_class* pShape = meshShapeList[i];
+		if (pShape == targetShape || boneShapeList[i] != pBoneRoot) continue;
+
+		const char* errorID = m_GetMeshErrorID(*pShape);
+		if (errorID) {
+			if (showErrors) {
+				const std::string str = std::string(pShape->get_name()) + std::string(" : ") + shade.gettext(errorID);
+				shade.message(str.c_str());
+			}
+			continue;
+		}
+		retShapes.push_back(pShape);
+	}
+}
+
+/**
+ * ボーンの割り当てられたすべてのポリゴンメッシュを、それぞれのPMDファイルに出力 (一括出力).
+ * シーンの情報はメインスレッドですべてスナップショットとして取得し、
+ * モデルごとの変換は、スレッドプールとテクスチャのキャッシュを共有して並列に行う.
+ */
+void CPMDExporter::m_ExportAllMeshes(const std::vector<sxsdk::shape_class *>& meshShapeList, const std::vector<sxsdk::shape_class *>& boneShapeList, sxsdk::shape_class* targetShape)
+{
+	const std::string streamFileName = Util::GetFileNameToStream(m_stream);
+	const std::string dirPath        = Util::GetDirectoryToStream(m_stream);
+
+	// 出力ファイル名が重ならないように、使用済みの名前を保持.
+	std::set<std::string> usedFileNames;
+	usedFileNames.insert(streamFileName);
+
+	// プールとテクスチャのキャッシュは、CPMDDataより後に破棄する.
+	CThreadPool pool(m_dlgData.threadCount);
+	CTextureCache textureCache(dirPath, m_dlgData.textureCache);
+	std::vector<PMD_BATCH_ITEM *> items;
+
+	// メッシュを統合する場合の、出力済みのボーンルート.
+	std::set<sxsdk::shape_class *> mergedBoneRoots;
+
+	// シーンの情報は、メインスレッドでスナップショットとして取得.
+	for (int i = 0; i < meshShapeList.size(); i++) {
+		sxsdk::shape_class* pShape = meshShapeList[i];
+
+		const char* errorID = m_GetMeshErrorID(*pShape);
+		if (errorID) {
+			const std::string str = std::string(pShape->get_name()) + std::string(" : ") + shade.gettext(errorID);
+			shade.message(str.c_str());
+			continue;
+		}
+
+		// 同じボーンルートを持つポリゴンメッシュは1つのモデルに統合する.
+		// ボーンルートにtargetShapeが含まれる場合は、それを統合先とする.
+		std::vector<sxsdk::shape_class *> mergeShapes;
+		if (m_dlgData.mergeMeshes) {
+			sxsdk::shape_class* pBoneRoot = boneShapeList[i];
+			if (mergedBoneRoots.find(pBoneRoot) != mergedBoneRoots.end()) continue;
+			mergedBoneRoots.insert(pBoneRoot);
+
+			for (int j = 0; j < meshShapeList.size(); j++) {
+				if (meshShapeList[j] == targetShape && boneShapeList[j] == pBoneRoot && !m_GetMeshErrorID(*targetShape)) {
+					pShape = targetShape;
+					break;
+				}
+			}
+			m_GetMergeShapes(pShape, meshShapeList, boneShapeList, mergeShapes, false);
+		}
+		const std::string shapeName = pShape->get_name();
+
+		PMD_BATCH_ITEM* pItem = new PMD_BATCH_ITEM();
+		pItem->pShape = pShape;
+		if (pShape == targetShape) {
+			pItem->fileName = streamFileName;
+		} else {
+			pItem->fileName = Util::GetBatchFileName(shapeName, ".pmd", usedFileNames);
+#if SXWINDOWS
+			pItem->filePath = dirPath + "\\" + pItem->fileName;
+#else
+			pItem->filePath = dirPath + "/" + pItem->fileName;
+#endif
+		}
+
+		pItem->pPMDData = new CPMDData(&shade);
+		pItem->pPMDData->SetSharedResources(&pool, &textureCache);
+		if (!pItem->pPMDData->CaptureModel(*pShape, m_stream, m_dlgData, pItem->snapshot, m_dlgData.mergeMeshes ? &mergeShapes : NULL)) {
+			delete pItem;
+			continue;
+		}
+		items.push_back(pItem);
+	}
+
+	if (!items.empty()) {
+		// 変換、テクスチャの保存、PMDのバッファの作成はワーカースレッドで行う.
+		// モデルごとの変換は互いに独立しているため、それぞれをステージとして並列に実行する.
+		const CPMDDlgInfo dlgData = m_dlgData;
+
+		CExportTask task(shade, streamFileName);
+		task.GetProgress().AddStepCount((PMD_CONVERT_STEP_COUNT + PMD_ENCODE_STEP_COUNT) * items.size());
+		const bool ret = task.Run([&](CExportProgress& progress) {
+			CStageGraph graph;
+			for (int i = 0; i < items.size(); i++) {
+				PMD_BATCH_ITEM* pItem = items[i];
+				graph.AddStage([pItem, &dlgData, &progress]() {
+					// 例外はモデルごとのエラーとして記録し、他のモデルの出力は続ける.
+					try {
+						CPMDData* pmdData = pItem->pPMDData;
+						if (!pmdData->ConvertModel(pItem->snapshot, dlgData, &progress)) return;
+						pItem->snapshot.Clear();
+
+						// 範囲チェック.
+						pItem->errorID = pmdData->GetLimitErrorID();
+						if (pItem->errorID) return;
+
+						if (!pmdData->EncodeSections(pItem->sectionBuffers, &progress)) return;
+						if (dlgData.writeModelCache) pmdData->SaveModelCache(GetModelCacheFileName(pItem->fileName));
+						pItem->converted = true;
+					} catch (const std::exception& e) {
+						pItem->errorID     = "msg_export_error";
+						pItem->errorDetail = e.what();
+					} catch (...) {
+						pItem->errorID = "msg_export_error";
+					}
+				});
+			}
+			return graph.Run(&pool, &progress);
+		});
+
+		// テクスチャのキャッシュ情報は、すべてのモデルの出力後に一度だけ保存.
+		textureCache.Save();
+
+		// PMD形式で出力.
+		for (int i = 0; i < items.size(); i++) {
+			PMD_BATCH_ITEM* pItem = items[i];
+			if (pItem->errorID) {
+				std::string str = std::string(pItem->pShape->get_name()) + std::string(" : ") + shade.gettext(pItem->errorID);
+				if (!pItem->errorDetail.empty()) str += std::string(" (") + pItem->errorDetail + std::string(")");
+				shade.message(str.c_str());
+			}
+			if (!ret || !pItem->converted) continue;
+
+			bool writeF = true;
+			if (pItem->filePath.empty()) {
+				pItem->pPMDData->WriteSections(m_stream, pItem->sectionBuffers);
+			} else {
+				writeF = pItem->pPMDData->WriteSections(pItem->filePath, pItem->sectionBuffers);
+			}
+			const std::string str = pItem->fileName + std::string(" ") + shade.gettext(writeF ? "msg_finish_export" : "msg_export_write_failed");
+			shade.message(str.c_str());
+			if (writeF) {
+				m_ShowWeldedVertexCount(*(pItem->pPMDData));
+				m_ShowDuplicateMorphCount(*(pItem->pPMDData));
+				m_ShowTextureFailedCount(*(pItem->pPMDData));
+			}
+		}
+	}
+
+	for (int i = 0; i < items.size(); i++) delete items[i];
+	items.clear();
+}
+
 /********************************************************************/
 /* エクスポートのコールバックとして呼ばれる							*/
 /********************************************************************/
@@ -348,6 +693,51 @@ void CPMDExporter::load_dialog_data (sxsdk::dialog_interface &d,void *)
 	item = &(d.get_dialog_item(dlg_human_auto_ik));
 	item->set_bool(m_dlgData.humanAutoIK);
 
+	item = &(d.get_dialog_item(dlg_merge_materials_id));
+	item->set_bool(m_dlgData.mergeMaterials);
+
+	item = &(d.get_dialog_item(dlg_texture_atlas_id));
+	item->set_bool(m_dlgData.textureAtlas);
+
+	item = &(d.get_dialog_item(dlg_texture_cache_id));
+	item->set_bool(m_dlgData.textureCache);
+
+	item = &(d.get_dialog_item(dlg_texture_max_size_id));
+	item->set_int(m_dlgData.textureMaxSize);
+
+	item = &(d.get_dialog_item(dlg_texture_power_of_two_id));
+	item->set_bool(m_dlgData.texturePowerOfTwo);
+
+	item = &(d.get_dialog_item(dlg_write_model_cache_id));
+	item->set_bool(m_dlgData.writeModelCache);
+
+	item = &(d.get_dialog_item(dlg_thread_count_id));
+	item->set_int(m_dlgData.threadCount);
+
+	item = &(d.get_dialog_item(dlg_export_all_meshes_id));
+	item->set_bool(m_dlgData.exportAllMeshes);
+
+	item = &(d.get_dialog_item(dlg_merge_meshes_id));
+	item->set_bool(m_dlgData.mergeMeshes);
+
+	item = &(d.get_dialog_item(dlg_generate_normals_id));
+	item->set_bool(m_dlgData.generateNormals);
+
+	item = &(d.get_dialog_item(dlg_smoothing_angle_id));
+	item->set_float(m_dlgData.smoothingAngle);
+
+	item = &(d.get_dialog_item(dlg_weld_vertices_id));
+	item->set_bool(m_dlgData.weldVertices);
+
+	item = &(d.get_dialog_item(dlg_weld_normal_angle_id));
+	item->set_float(m_dlgData.weldNormalAngle);
+
+	item = &(d.get_dialog_item(dlg_weld_uv_distance_id));
+	item->set_float(m_dlgData.weldUVDistance);
+
+	item = &(d.get_dialog_item(dlg_remove_duplicate_morphs_id));
+	item->set_bool(m_dlgData.removeDuplicateMorphs);
+
 	item = &(d.get_dialog_item(dlg_note_japanese_txt_id));
 	item->set_text("");
 	item = &(d.get_dialog_item(dlg_note_english_txt_id));
@@ -392,6 +782,81 @@ bool CPMDExporter::respond (sxsdk::dialog_interface &dialog, sxsdk::dialog_item_
 		return true;
 	}
 
+	if (id == dlg_merge_materials_id) {
+		m_dlgData.mergeMaterials = item.get_bool();
+		return true;
+	}
+
+	if (id == dlg_texture_atlas_id) {
+		m_dlgData.textureAtlas = item.get_bool();
+		return true;
+	}
+
+	if (id == dlg_texture_cache_id) {
+		m_dlgData.textureCache = item.get_bool();
+		return true;
+	}
+
+	if (id == dlg_texture_max_size_id) {
+		m_dlgData.textureMaxSize = std::max(0, item.get_int());
+		return true;
+	}
+
+	if (id == dlg_texture_power_of_two_id) {
+		m_dlgData.texturePowerOfTwo = item.get_bool();
+		return true;
+	}
+
+	if (id == dlg_write_model_cache_id) {
+		m_dlgData.writeModelCache = item.get_bool();
+		return true;
+	}
+
+	if (id == dlg_thread_count_id) {
+		m_dlgData.threadCount = std::max(0, item.get_int());
+		return true;
+	}
+
+	if (id == dlg_export_all_meshes_id) {
+		m_dlgData.exportAllMeshes = item.get_bool();
+		return true;
+	}
+
+	if (id == dlg_merge_meshes_id) {
+		m_dlgData.mergeMeshes = item.get_bool();
+		return true;
+	}
+
+	if (id == dlg_generate_normals_id) {
+		m_dlgData.generateNormals = item.get_bool();
+		return true;
+	}
+
+	if (id == dlg_smoothing_angle_id) {
+		m_dlgData.smoothingAngle = std::max(0.0f, std::min(180.0f, item.get_float()));
+		return true;
+	}
+
+	if (id == dlg_weld_vertices_id) {
+		m_dlgData.weldVertices = item.get_bool();
+		return true;
+	}
+
+	if (id == dlg_weld_normal_angle_id) {
+		m_dlgData.weldNormalAngle = std::max(0.0f, std::min(180.0f, item.get_float()));
+		return true;
+	}
+
+	if (id == dlg_weld_uv_distance_id) {
+		m_dlgData.weldUVDistance = std::max(0.0f, item.get_float());
+		return true;
+	}
+
+	if (id == dlg_remove_duplicate_morphs_id) {
+		m_dlgData.removeDuplicateMorphs = item.get_bool();
+		return true;
+	}
+
 	if (id == dlg_note_japanese_area_id) {
 		m_dlgData.note_jp = item.get_text();
 		return true;
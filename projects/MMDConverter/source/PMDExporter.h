@@ -34,6 +34,39 @@ private:
 
 	CPMDDlgInfo m_dlgData;						///< Exportダイアログの情報.
 
+	/**
+	 * 出力できないポリゴンメッシュの場合は、メッセージのIDを返す.
+	 */
+	const char* m_GetMeshErrorID(sxsdk::shape_class& shape);
+
+	/**
+	 * 許容値による頂点の統合で、増やさずに済んだ頂点数をメッセージに出す.
+	 */
+	void m_ShowWeldedVertexCount(const CPMDData& pmdData);
+
+	/**
+	 * 重複した表情と、頂点が移動しない表情の数をメッセージに出す.
+	 */
+	void m_ShowDuplicateMorphCount(const CPMDData& pmdData);
+
+	/**
+	 * 保存に失敗したテクスチャの数をメッセージに出す.
+	 */
+	void m_ShowTextureFailedCount(const CPMDData& pmdData);
+
+	/**
+	 * 指定のポリゴンメッシュと同じボーンルートを持ち、1つのモデルに統合するポリゴンメッシュを取得.
+	 * 出力できないポリゴンメッシュは除外する (showErrorsがtrueの場合はメッセージを出す).
+	 */
+	void m_GetMergeShapes(sxsdk::shape_class* targetShape, const std::vector<sxsdk::shape_class *>& meshShapeList, const std::vector<sxsdk::shape_class *>& boneShapeList, std::vector<sxsdk::shape_class *>& retShapes, const bool showErrors);
+
+	/**
+	 * ボーンの割り当てられたすべてのポリゴンメッシュを、それぞれのPMDファイルに出力 (一括出力).
+	 * targetShapeはstreamに、それ以外はstreamと同じディレクトリの「形状名.pmd」に出力する.
+	 * メッシュの統合が指定されている場合は、ボーンルートごとに1つのPMDファイルとする.
+	 */
+	void m_ExportAllMeshes(const std::vector<sxsdk::shape_class *>& meshShapeList, const std::vector<sxsdk::shape_class *>& boneShapeList, sxsdk::shape_class* targetShape);
+
 	virtual sx::uuid_class get_uuid (void *) { return MMD_PMD_EXPORTER_INTERFACE_ID; }
 	virtual int get_shade_version () const { return SHADE_BUILD_NUMBER; }
 
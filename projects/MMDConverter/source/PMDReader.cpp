@@ -0,0 +1,733 @@
+﻿/**
+ *  @brief  PMDファイルの読み込みと構造の検証 (メモリマップ).
+ *  @date   2026.10.19
+ */
+
+#include "PMDReader.h"
+#include "PMDData.h"
+
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <math.h>
+
+#define PMD_IK_HEADER_SIZE		11						///< IKの子ボーンを除くバイト数.
+#define PMD_SKIN_HEADER_SIZE	25						///< 表情の頂点を除くバイト数.
+#define PMD_SKIN_VERTEX_SIZE	16						///< 表情の頂点のバイト数.
+#define PMD_BONE_FRAME_SIZE		50						///< ボーン枠名のバイト数.
+#define PMD_BONE_DISP_SIZE		3						///< ボーン枠用表示リストの要素のバイト数.
+#define PMD_TOON_TEXTURE_SIZE	100						///< トゥーンテクスチャ名のバイト数.
+#define PMD_TOON_TEXTURE_COUNT	10						///< トゥーンテクスチャの数.
+
+namespace {
+	inline unsigned int ReadU8(const unsigned char* p) { return p[0]; }
+	inline unsigned int ReadU16(const unsigned char* p) { return (unsigned int)p[0] | ((unsigned int)p[1] << 8); }
+	inline unsigned int ReadU32(const unsigned char* p) { return (unsigned int)p[0] | ((unsigned int)p[1] << 8) | ((unsigned int)p[2] << 16) | ((unsigned int)p[3] << 24); }
+	inline float ReadFloat(const unsigned char* p) {
+		float v;
+		memcpy(&v, p, 4);
+		return v;
+	}
+	inline void ReadFloats(const unsigned char* p, const int count, float* v) {
+		memcpy(v, p, 4 * count);
+	}
+
+	/**
+	 * 固定長の文字列を取得 (0または改行で終端).
+	 */
+	std::string ReadString(const unsigned char* p, const size_t size) {
+		size_t len = 0;
+		while (len < size && p[len] != 0 && p[len] != 0x0a) len++;
+		return std::string((const char *)p, len);
+	}
+
+	/**
+	 * メッセージを追加 (maxCount個まで).
+	 */
+	void AddMessage(std::vector<std::string>& messages, const int maxCount, const char* format, ...) {
+		if ((int)messages.size() >= maxCount) return;
+		char szStr[512];
+		va_list args;
+		va_start(args, format);
+		vsnprintf(szStr, sizeof(szStr), format, args);
+		va_end(args);
+		messages.push_back(szStr);
+	}
+
+	inline bool IsNear(const float* a, const float* b, const int count, const float tolerance) {
+		for (int i = 0; i < count; i++) {
+			if (fabsf(a[i] - b[i]) > tolerance) return false;
+		}
+		return true;
+	}
+}
+
+CPMDReader::CPMDReader()
+{
+	m_pData = NULL;
+	m_size  = 0;
+	Close();
+}
+
+CPMDReader::~CPMDReader()
+{
+	Close();
+}
+
+void CPMDReader::Close()
+{
+	m_file.Close();
+	m_pData = NULL;
+	m_size  = 0;
+
+	for (int i = 0; i < pmd_section_count; i++) {
+		m_sectionOffset[i] = 0;
+		m_sectionSize[i]   = 0;
+		m_hasSection[i]    = false;
+	}
+	m_vertexCount    = 0;
+	m_faceVertCount  = 0;
+	m_materialCount  = 0;
+	m_boneCount      = 0;
+	m_ikCount        = 0;
+	m_skinCount      = 0;
+	m_skinFrameCount = 0;
+	m_boneFrameCount = 0;
+	m_boneDispCount  = 0;
+	m_rigidBodyCount = 0;
+	m_jointCount     = 0;
+	m_hasEnglish     = false;
+	m_ikOffsets.clear();
+	m_skinOffsets.clear();
+	m_errorMessage = "";
+}
+
+/**
+ * PMDファイルを開いて、各セクションの位置を求める (パスはUTF-8).
+ */
+bool CPMDReader::Open(const std::string& filePath)
+{
+	Close();
+	if (!m_file.Open(filePath)) return m_Error("Failed to open file.");
+	m_pData = m_file.GetData();
+	m_size  = m_file.GetSize();
+	return m_Parse();
+}
+
+/**
+ * メモリ上のPMDデータを参照.
+ */
+bool CPMDReader::OpenMemory(const unsigned char* data, const size_t size)
+{
+	Close();
+	m_pData = data;
+	m_size  = size;
+	return m_Parse();
+}
+
+/**
+ * エラーを記録してfalseを返す.
+ */
+bool CPMDReader::m_Error(const char* message)
+{
+	m_errorMessage = message;
+	return false;
+}
+
+/**
+ * 要素数(countSizeバイト)と、固定長の要素が続くセクションの位置を求める.
+ */
+bool CPMDReader::m_ParseFixedSection(size_t& pos, const int section, const int countSize, const size_t elementSize, int& retCount)
+{
+	if (!m_Has(pos, countSize)) return false;
+	const unsigned int count = (countSize == 1) ? ReadU8(m_pData + pos) : ((countSize == 2) ? ReadU16(m_pData + pos) : ReadU32(m_pData + pos));
+	const size_t start = pos + countSize;
+	if ((unsigned long long)count * elementSize > (unsigned long long)(m_size - start)) return false;
+
+	m_sectionOffset[section] = start;
+	m_sectionSize[section]   = (size_t)count * elementSize;
+	m_hasSection[section]    = true;
+	retCount = (int)count;
+	pos = start + m_sectionSize[section];
+	return true;
+}
+
+/**
+ * セクションの位置を求める.
+ */
+bool CPMDReader::m_Parse()
+{
+	size_t pos = 0;
+
+	if (!m_Has(0, PMD_HEADER_SIZE) || memcmp(m_pData, "Pmd", 3) != 0) return m_Error("Invalid header.");
+	m_sectionOffset[pmd_section_header] = 0;
+	m_sectionSize[pmd_section_header]   = PMD_HEADER_SIZE;
+	m_hasSection[pmd_section_header]    = true;
+	pos = PMD_HEADER_SIZE;
+
+	if (!m_ParseFixedSection(pos, pmd_section_vertices, 4, PMD_VERTEX_DATA_SIZE, m_vertexCount)) return m_Error("Vertices section is truncated.");
+	if (!m_ParseFixedSection(pos, pmd_section_faces, 4, 2, m_faceVertCount)) return m_Error("Faces section is truncated.");
+	if (!m_ParseFixedSection(pos, pmd_section_materials, 4, PMD_MATERIAL_DATA_SIZE, m_materialCount)) return m_Error("Materials section is truncated.");
+	if (!m_ParseFixedSection(pos, pmd_section_bones, 2, PMD_BONE_DATA_SIZE, m_boneCount)) return m_Error("Bones section is truncated.");
+
+	// IK (子ボーン数により可変長).
+	{
+		if (!m_Has(pos, 2)) return m_Error("IK section is truncated.");
+		const size_t start = pos;
+		m_ikCount = ReadU16(m_pData + pos);
+		pos += 2;
+		m_ikOffsets.resize(m_ikCount);
+		for (int i = 0; i < m_ikCount; i++) {
+			if (!m_Has(pos, PMD_IK_HEADER_SIZE)) return m_Error("IK section is truncated.");
+			m_ikOffsets[i] = pos;
+			const int chainCou = ReadU8(m_pData + pos + 4);
+			pos += PMD_IK_HEADER_SIZE;
+			if (!m_Has(pos, chainCou * 2)) return m_Error("IK section is truncated.");
+			pos += chainCou * 2;
+		}
+		m_sectionOffset[pmd_section_iks] = start + 2;
+		m_sectionSize[pmd_section_iks]   = pos - (start + 2);
+		m_hasSection[pmd_section_iks]    = true;
+	}
+
+	// 表情 (頂点数により可変長).
+	{
+		if (!m_Has(pos, 2)) return m_Error("Skins section is truncated.");
+		const size_t start = pos;
+		m_skinCount = ReadU16(m_pData + pos);
+		pos += 2;
+		m_skinOffsets.resize(m_skinCount);
+		for (int i = 0; i < m_skinCount; i++) {
+			if (!m_Has(pos, PMD_SKIN_HEADER_SIZE)) return m_Error("Skins section is truncated.");
+			m_skinOffsets[i] = pos;
+			const unsigned int vCou = ReadU32(m_pData + pos + 20);
+			pos += PMD_SKIN_HEADER_SIZE;
+			if ((unsigned long long)vCou * PMD_SKIN_VERTEX_SIZE > (unsigned long long)(m_size - pos)) return m_Error("Skins section is truncated.");
+			pos += (size_t)vCou * PMD_SKIN_VERTEX_SIZE;
+		}
+		m_sectionOffset[pmd_section_skins] = start + 2;
+		m_sectionSize[pmd_section_skins]   = pos - (start + 2);
+		m_hasSection[pmd_section_skins]    = true;
+	}
+
+	if (!m_ParseFixedSection(pos, pmd_section_skin_frames, 1, 2, m_skinFrameCount)) return m_Error("Skin frames section is truncated.");
+	if (!m_ParseFixedSection(pos, pmd_section_bone_frames, 1, PMD_BONE_FRAME_SIZE, m_boneFrameCount)) return m_Error("Bone frames section is truncated.");
+	if (!m_ParseFixedSection(pos, pmd_section_bone_disps, 4, PMD_BONE_DISP_SIZE, m_boneDispCount)) return m_Error("Bone display list section is truncated.");
+
+	// 以下は拡張部分のため、存在しない場合もある.
+	if (pos == m_size) return true;
+
+	{
+		const size_t start = pos;
+		m_hasEnglish = (ReadU8(m_pData + pos) != 0);
+		pos++;
+		if (m_hasEnglish) {
+			const size_t skinNameCou = (m_skinCount > 0) ? (m_skinCount - 1) : 0;
+			const size_t size = 20 + 256 + (size_t)m_boneCount * 20 + skinNameCou * 20 + (size_t)m_boneFrameCount * PMD_BONE_FRAME_SIZE;
+			if (!m_Has(pos, size)) return m_Error("English section is truncated.");
+			pos += size;
+		}
+		m_sectionOffset[pmd_section_english] = start + 1;
+		m_sectionSize[pmd_section_english]   = pos - (start + 1);
+		m_hasSection[pmd_section_english]    = true;
+	}
+	if (pos == m_size) return true;
+
+	if (!m_Has(pos, PMD_TOON_TEXTURE_SIZE * PMD_TOON_TEXTURE_COUNT)) return m_Error("Toon texture section is truncated.");
+	m_sectionOffset[pmd_section_toon_textures] = pos;
+	m_sectionSize[pmd_section_toon_textures]   = PMD_TOON_TEXTURE_SIZE * PMD_TOON_TEXTURE_COUNT;
+	m_hasSection[pmd_section_toon_textures]    = true;
+	pos += PMD_TOON_TEXTURE_SIZE * PMD_TOON_TEXTURE_COUNT;
+	if (pos == m_size) return true;
+
+	if (!m_ParseFixedSection(pos, pmd_section_rigidbodies, 4, PMD_RIGIDBODY_DATA_SIZE, m_rigidBodyCount)) return m_Error("Rigid body section is truncated.");
+	if (!m_ParseFixedSection(pos, pmd_section_joints, 4, PMD_RIGIDBODY_JOINT_DATA_SIZE, m_jointCount)) return m_Error("Joint section is truncated.");
+
+	if (pos != m_size) return m_Error("Unknown data after the joint section.");
+
+	return true;
+}
+
+std::string CPMDReader::GetModelName() const
+{
+	return m_pData ? ReadString(m_pData + 7, 20) : std::string("");
+}
+
+std::string CPMDReader::GetComment() const
+{
+	return m_pData ? ReadString(m_pData + 27, 256) : std::string("");
+}
+
+std::string CPMDReader::GetModelNameEnglish() const
+{
+	return m_hasEnglish ? ReadString(m_pData + m_sectionOffset[pmd_section_english], 20) : std::string("");
+}
+
+std::string CPMDReader::GetCommentEnglish() const
+{
+	return m_hasEnglish ? ReadString(m_pData + m_sectionOffset[pmd_section_english] + 20, 256) : std::string("");
+}
+
+void CPMDReader::GetVertex(const int index, PMD_READ_VERTEX& retData) const
+{
+	const unsigned char* p = m_pData + m_sectionOffset[pmd_section_vertices] + (size_t)index * PMD_VERTEX_DATA_SIZE;
+	ReadFloats(p, 3, retData.pos);
+	ReadFloats(p + 12, 3, retData.normal);
+	ReadFloats(p + 24, 2, retData.uv);
+	retData.bone_num[0] = ReadU16(p + 32);
+	retData.bone_num[1] = ReadU16(p + 34);
+	retData.bone_weight = ReadU8(p + 36);
+	retData.edge_flag   = ReadU8(p + 37);
+}
+
+int CPMDReader::GetFaceIndex(const int index) const
+{
+	return ReadU16(m_pData + m_sectionOffset[pmd_section_faces] + (size_t)index * 2);
+}
+
+void CPMDReader::GetMaterial(const int index, PMD_READ_MATERIAL& retData) const
+{
+	const unsigned char* p = m_pData + m_sectionOffset[pmd_section_materials] + (size_t)index * PMD_MATERIAL_DATA_SIZE;
+	ReadFloats(p, 3, retData.diffuse_color);
+	retData.alpha    = ReadFloat(p + 12);
+	retData.specular = ReadFloat(p + 16);
+	ReadFloats(p + 20, 3, retData.specular_color);
+	ReadFloats(p + 32, 3, retData.ambient_color);
+	retData.toon_index      = ReadU8(p + 44);
+	retData.edge_flag       = ReadU8(p + 45);
+	retData.face_vert_count = (int)ReadU32(p + 46);
+	retData.tex_file_name   = ReadString(p + 50, 20);
+}
+
+void CPMDReader::GetBone(const int index, PMD_READ_BONE& retData) const
+{
+	const unsigned char* p = m_pData + m_sectionOffset[pmd_section_bones] + (size_t)index * PMD_BONE_DATA_SIZE;
+	retData.bone_name = ReadString(p, 20);
+	const int parent  = ReadU16(p + 20);
+	retData.parent_bone_index    = (parent == 0xffff) ? -1 : parent;
+	retData.tail_pos_bone_index  = ReadU16(p + 22);
+	retData.bone_type            = ReadU8(p + 24);
+	retData.ik_parent_bone_index = ReadU16(p + 25);
+	ReadFloats(p + 27, 3, retData.bone_head_pos);
+}
+
+void CPMDReader::GetIK(const int index, PMD_READ_IK& retData) const
+{
+	const unsigned char* p = m_pData + m_ikOffsets[index];
+	retData.ik_bone_index        = ReadU16(p);
+	retData.ik_target_bone_index = ReadU16(p + 2);
+	const int chainCou           = ReadU8(p + 4);
+	retData.iterations           = ReadU16(p + 5);
+	retData.control_weight       = ReadFloat(p + 7);
+	retData.ik_child_bone_index.resize(chainCou);
+	for (int i = 0; i < chainCou; i++) {
+		retData.ik_child_bone_index[i] = ReadU16(p + PMD_IK_HEADER_SIZE + i * 2);
+	}
+}
+
+void CPMDReader::GetSkin(const int index, PMD_READ_SKIN& retData) const
+{
+	const unsigned char* p = m_pData + m_skinOffsets[index];
+	retData.name         = ReadString(p, 20);
+	retData.vertex_count = (int)ReadU32(p + 20);
+	retData.type         = ReadU8(p + 24);
+}
+
+void CPMDReader::GetSkinVertex(const int skinIndex, const int index, PMD_READ_SKIN_VERTEX& retData) const
+{
+	const unsigned char* p = m_pData + m_skinOffsets[skinIndex] + PMD_SKIN_HEADER_SIZE + (size_t)index * PMD_SKIN_VERTEX_SIZE;
+	retData.vert_index = (int)ReadU32(p);
+	ReadFloats(p + 4, 3, retData.pos);
+}
+
+int CPMDReader::GetSkinFrame(const int index) const
+{
+	return ReadU16(m_pData + m_sectionOffset[pmd_section_skin_frames] + (size_t)index * 2);
+}
+
+std::string CPMDReader::GetBoneFrameName(const int index) const
+{
+	return ReadString(m_pData + m_sectionOffset[pmd_section_bone_frames] + (size_t)index * PMD_BONE_FRAME_SIZE, PMD_BONE_FRAME_SIZE);
+}
+
+void CPMDReader::GetBoneDisp(const int index, PMD_READ_BONE_DISP_ITEM& retData) const
+{
+	const unsigned char* p = m_pData + m_sectionOffset[pmd_section_bone_disps] + (size_t)index * PMD_BONE_DISP_SIZE;
+	retData.bone_index      = ReadU16(p);
+	retData.bone_disp_index = ReadU8(p + 2);
+}
+
+std::string CPMDReader::GetBoneNameEnglish(const int index) const
+{
+	if (!m_hasEnglish) return "";
+	return ReadString(m_pData + m_sectionOffset[pmd_section_english] + 20 + 256 + (size_t)index * 20, 20);
+}
+
+std::string CPMDReader::GetSkinNameEnglish(const int index) const
+{
+	if (!m_hasEnglish) return "";
+	return ReadString(m_pData + m_sectionOffset[pmd_section_english] + 20 + 256 + (size_t)(m_boneCount + index) * 20, 20);
+}
+
+std::string CPMDReader::GetBoneFrameNameEnglish(const int index) const
+{
+	if (!m_hasEnglish) return "";
+	const size_t skinNameCou = (m_skinCount > 0) ? (m_skinCount - 1) : 0;
+	return ReadString(m_pData + m_sectionOffset[pmd_section_english] + 20 + 256 + ((size_t)m_boneCount + skinNameCou) * 20 + (size_t)index * PMD_BONE_FRAME_SIZE, PMD_BONE_FRAME_SIZE);
+}
+
+std::string CPMDReader::GetToonTextureName(const int index) const
+{
+	if (!m_hasSection[pmd_section_toon_textures]) return "";
+	return ReadString(m_pData + m_sectionOffset[pmd_section_toon_textures] + (size_t)index * PMD_TOON_TEXTURE_SIZE, PMD_TOON_TEXTURE_SIZE);
+}
+
+void CPMDReader::GetRigidBody(const int index, PMD_READ_RIGIDBODY& retData) const
+{
+	const unsigned char* p = m_pData + m_sectionOffset[pmd_section_rigidbodies] + (size_t)index * PMD_RIGIDBODY_DATA_SIZE;
+	retData.name         = ReadString(p, 20);
+	const int boneIndex  = ReadU16(p + 20);
+	retData.bone_index   = (boneIndex == 0xffff) ? -1 : boneIndex;
+	retData.group_index  = ReadU8(p + 22);
+	retData.group_target = ReadU16(p + 23);
+	retData.type         = ReadU8(p + 25);
+	ReadFloats(p + 26, 3, retData.shape_size);
+	ReadFloats(p + 38, 3, retData.pos);
+	ReadFloats(p + 50, 3, retData.rot);
+	retData.weight         = ReadFloat(p + 62);
+	retData.pos_dim        = ReadFloat(p + 66);
+	retData.rot_dim        = ReadFloat(p + 70);
+	retData.recoil         = ReadFloat(p + 74);
+	retData.friction       = ReadFloat(p + 78);
+	retData.rigidbody_type = ReadU8(p + 82);
+}
+
+void CPMDReader::GetJoint(const int index, PMD_READ_RIGIDBODY_JOINT& retData) const
+{
+	const unsigned char* p = m_pData + m_sectionOffset[pmd_section_joints] + (size_t)index * PMD_RIGIDBODY_JOINT_DATA_SIZE;
+	retData.name    = ReadString(p, 20);
+	retData.joint_a = (int)ReadU32(p + 20);
+	retData.joint_b = (int)ReadU32(p + 24);
+	ReadFloats(p + 28, 3, retData.pos);
+	ReadFloats(p + 40, 3, retData.rot);
+	ReadFloats(p + 52, 3, retData.constrain_pos1);
+	ReadFloats(p + 64, 3, retData.constrain_pos2);
+	ReadFloats(p + 76, 3, retData.constrain_rot1);
+	ReadFloats(p + 88, 3, retData.constrain_rot2);
+	ReadFloats(p + 100, 3, retData.spring_pos);
+	ReadFloats(p + 112, 3, retData.spring_rot);
+}
+
+/**
+ * インデックスの範囲など、構造を検証.
+ */
+bool CPMDReader::Validate(std::vector<std::string>& retErrors, const int maxErrors) const
+{
+	retErrors.clear();
+	if (!m_pData) {
+		AddMessage(retErrors, maxErrors, "Not opened.");
+		return false;
+	}
+
+	// 頂点.
+	{
+		PMD_READ_VERTEX vData;
+		for (int i = 0; i < m_vertexCount; i++) {
+			GetVertex(i, vData);
+			for (int j = 0; j < 2; j++) {
+				if (m_boneCount > 0 && vData.bone_num[j] >= m_boneCount) {
+					AddMessage(retErrors, maxErrors, "vertex[%d] : bone_num[%d] (%d) is out of range.", i, j, vData.bone_num[j]);
+				}
+			}
+			if (vData.bone_weight > 100) {
+				AddMessage(retErrors, maxErrors, "vertex[%d] : bone_weight (%d) is greater than 100.", i, vData.bone_weight);
+			}
+		}
+	}
+
+	// 面.
+	if ((m_faceVertCount % 3) != 0) {
+		AddMessage(retErrors, maxErrors, "faces : face vertex count (%d) is not a multiple of 3.", m_faceVertCount);
+	}
+	for (int i = 0; i < m_faceVertCount; i++) {
+		const int index = GetFaceIndex(i);
+		if (index >= m_vertexCount) {
+			AddMessage(retErrors, maxErrors, "face vertex[%d] : index (%d) is out of range.", i, index);
+		}
+	}
+
+	// マテリアル.
+	{
+		PMD_READ_MATERIAL mData;
+		long long faceVertCou = 0;
+		for (int i = 0; i < m_materialCount; i++) {
+			GetMaterial(i, mData);
+			faceVertCou += mData.face_vert_count;
+			if ((mData.face_vert_count % 3) != 0) {
+				AddMessage(retErrors, maxErrors, "material[%d] : face_vert_count (%d) is not a multiple of 3.", i, mData.face_vert_count);
+			}
+		}
+		if (faceVertCou != m_faceVertCount) {
+			AddMessage(retErrors, maxErrors, "materials : total face_vert_count (%lld) does not match face vertex count (%d).", faceVertCou, m_faceVertCount);
+		}
+	}
+
+	// ボーン.
+	{
+		PMD_READ_BONE boneData;
+		for (int i = 0; i < m_boneCount; i++) {
+			GetBone(i, boneData);
+			if (boneData.parent_bone_index >= m_boneCount || boneData.parent_bone_index == i) {
+				AddMessage(retErrors, maxErrors, "bone[%d] : parent_bone_index (%d) is invalid.", i, boneData.parent_bone_index);
+			}
+			if (boneData.tail_pos_bone_index >= m_boneCount) {
+				AddMessage(retErrors, maxErrors, "bone[%d] : tail_pos_bone_index (%d) is out of range.", i, boneData.tail_pos_bone_index);
+			}
+			if (boneData.ik_parent_bone_index >= m_boneCount) {
+				AddMessage(retErrors, maxErrors, "bone[%d] : ik_parent_bone_index (%d) is out of range.", i, boneData.ik_parent_bone_index);
+			}
+			if (boneData.bone_type > bone_type_rotate_v) {
+				AddMessage(retErrors, maxErrors, "bone[%d] : bone_type (%d) is unknown.", i, boneData.bone_type);
+			}
+		}
+	}
+
+	// IK.
+	{
+		PMD_READ_IK ikData;
+		for (int i = 0; i < m_ikCount; i++) {
+			GetIK(i, ikData);
+			if (ikData.ik_bone_index >= m_boneCount) {
+				AddMessage(retErrors, maxErrors, "ik[%d] : ik_bone_index (%d) is out of range.", i, ikData.ik_bone_index);
+			}
+			if (ikData.ik_target_bone_index >= m_boneCount) {
+				AddMessage(retErrors, maxErrors, "ik[%d] : ik_target_bone_index (%d) is out of range.", i, ikData.ik_target_bone_index);
+			}
+			for (size_t j = 0; j < ikData.ik_child_bone_index.size(); j++) {
+				if (ikData.ik_child_bone_index[j] >= m_boneCount) {
+					AddMessage(retErrors, maxErrors, "ik[%d] : ik_child_bone_index[%d] (%d) is out of range.", i, (int)j, ikData.ik_child_bone_index[j]);
+				}
+			}
+		}
+	}
+
+	// 表情 (先頭はbaseで、base以外の頂点番号はbase内の番号).
+	if (m_skinCount > 0) {
+		PMD_READ_SKIN skinData;
+		PMD_READ_SKIN_VERTEX vData;
+		GetSkin(0, skinData);
+		const int baseVertCou = skinData.vertex_count;
+		if (skinData.type != skin_type_base) {
+			AddMessage(retErrors, maxErrors, "skin[0] : the first skin is not base.");
+		}
+		for (int i = 0; i < m_skinCount; i++) {
+			GetSkin(i, skinData);
+			if (i > 0 && skinData.type == skin_type_base) {
+				AddMessage(retErrors, maxErrors, "skin[%d] : base skin appears twice.", i);
+			}
+			if (skinData.type > skin_type_other) {
+				AddMessage(retErrors, maxErrors, "skin[%d] : type (%d) is unknown.", i, skinData.type);
+			}
+			const int maxIndex = (i == 0) ? m_vertexCount : baseVertCou;
+			for (int j = 0; j < skinData.vertex_count; j++) {
+				GetSkinVertex(i, j, vData);
+				if (vData.vert_index < 0 || vData.vert_index >= maxIndex) {
+					AddMessage(retErrors, maxErrors, "skin[%d] : vertex[%d] index (%d) is out of range.", i, j, vData.vert_index);
+				}
+			}
+		}
+	}
+
+	// 表情枠 (baseを除いた表情番号).
+	for (int i = 0; i < m_skinFrameCount; i++) {
+		const int index = GetSkinFrame(i);
+		if (index <= 0 || index >= m_skinCount) {
+			AddMessage(retErrors, maxErrors, "skin frame[%d] : skin index (%d) is out of range.", i, index);
+		}
+	}
+
+	// ボーン枠用表示リスト.
+	{
+		PMD_READ_BONE_DISP_ITEM item;
+		for (int i = 0; i < m_boneDispCount; i++) {
+			GetBoneDisp(i, item);
+			if (item.bone_index >= m_boneCount) {
+				AddMessage(retErrors, maxErrors, "bone disp[%d] : bone_index (%d) is out of range.", i, item.bone_index);
+			}
+			if (item.bone_disp_index <= 0 || item.bone_disp_index > m_boneFrameCount) {
+				AddMessage(retErrors, maxErrors, "bone disp[%d] : bone_disp_index (%d) is out of range.", i, item.bone_disp_index);
+			}
+		}
+	}
+
+	// 剛体.
+	{
+		PMD_READ_RIGIDBODY rData;
+		for (int i = 0; i < m_rigidBodyCount; i++) {
+			GetRigidBody(i, rData);
+			if (rData.bone_index >= m_boneCount) {
+				AddMessage(retErrors, maxErrors, "rigid body[%d] : bone_index (%d) is out of range.", i, rData.bone_index);
+			}
+			if (rData.type > rigidbody_type_capsule) {
+				AddMessage(retErrors, maxErrors, "rigid body[%d] : type (%d) is unknown.", i, rData.type);
+			}
+			if (rData.rigidbody_type > rigidbody_bone_type_dynamic2) {
+				AddMessage(retErrors, maxErrors, "rigid body[%d] : rigidbody_type (%d) is unknown.", i, rData.rigidbody_type);
+			}
+		}
+	}
+
+	// ジョイント.
+	{
+		PMD_READ_RIGIDBODY_JOINT jData;
+		for (int i = 0; i < m_jointCount; i++) {
+			GetJoint(i, jData);
+			if (jData.joint_a < 0 || jData.joint_a >= m_rigidBodyCount || jData.joint_b < 0 || jData.joint_b >= m_rigidBodyCount) {
+				AddMessage(retErrors, maxErrors, "joint[%d] : rigid body index (%d, %d) is out of range.", i, jData.joint_a, jData.joint_b);
+			}
+		}
+	}
+
+	return retErrors.empty();
+}
+
+/**
+ * 他のPMDとの差分を取得.
+ */
+bool CPMDReader::Compare(const CPMDReader& other, const float tolerance, std::vector<std::string>& retDiffs, const int maxDiffs) const
+{
+	retDiffs.clear();
+	if (!m_pData || !other.m_pData) {
+		AddMessage(retDiffs, maxDiffs, "Not opened.");
+		return false;
+	}
+
+	if (GetModelName() != other.GetModelName()) AddMessage(retDiffs, maxDiffs, "header : model name differs.");
+	if (GetComment() != other.GetComment()) AddMessage(retDiffs, maxDiffs, "header : comment differs.");
+
+	// 頂点.
+	if (m_vertexCount != other.m_vertexCount) {
+		AddMessage(retDiffs, maxDiffs, "vertices : count %d != %d.", m_vertexCount, other.m_vertexCount);
+	} else {
+		PMD_READ_VERTEX v0, v1;
+		for (int i = 0; i < m_vertexCount; i++) {
+			GetVertex(i, v0);
+			other.GetVertex(i, v1);
+			if (!IsNear(v0.pos, v1.pos, 3, tolerance) || !IsNear(v0.normal, v1.normal, 3, tolerance) || !IsNear(v0.uv, v1.uv, 2, tolerance)) {
+				AddMessage(retDiffs, maxDiffs, "vertex[%d] : position/normal/uv differs.", i);
+			}
+			if (v0.bone_num[0] != v1.bone_num[0] || v0.bone_num[1] != v1.bone_num[1] || v0.bone_weight != v1.bone_weight || v0.edge_flag != v1.edge_flag) {
+				AddMessage(retDiffs, maxDiffs, "vertex[%d] : bone/weight/edge differs.", i);
+			}
+		}
+	}
+
+	// 面.
+	if (m_faceVertCount != other.m_faceVertCount) {
+		AddMessage(retDiffs, maxDiffs, "faces : count %d != %d.", m_faceVertCount, other.m_faceVertCount);
+	} else if (memcmp(GetSectionData(pmd_section_faces), other.GetSectionData(pmd_section_faces), (size_t)m_faceVertCount * 2) != 0) {
+		for (int i = 0; i < m_faceVertCount; i++) {
+			if (GetFaceIndex(i) != other.GetFaceIndex(i)) {
+				AddMessage(retDiffs, maxDiffs, "face vertex[%d] : %d != %d.", i, GetFaceIndex(i), other.GetFaceIndex(i));
+			}
+		}
+	}
+
+	// マテリアル.
+	if (m_materialCount != other.m_materialCount) {
+		AddMessage(retDiffs, maxDiffs, "materials : count %d != %d.", m_materialCount, other.m_materialCount);
+	} else {
+		PMD_READ_MATERIAL m0, m1;
+		for (int i = 0; i < m_materialCount; i++) {
+			GetMaterial(i, m0);
+			other.GetMaterial(i, m1);
+			if (!IsNear(m0.diffuse_color, m1.diffuse_color, 3, tolerance) || !IsNear(&m0.alpha, &m1.alpha, 1, tolerance) || !IsNear(&m0.specular, &m1.specular, 1, tolerance)
+				|| !IsNear(m0.specular_color, m1.specular_color, 3, tolerance) || !IsNear(m0.ambient_color, m1.ambient_color, 3, tolerance)) {
+				AddMessage(retDiffs, maxDiffs, "material[%d] : color differs.", i);
+			}
+			if (m0.toon_index != m1.toon_index || m0.edge_flag != m1.edge_flag || m0.face_vert_count != m1.face_vert_count || m0.tex_file_name != m1.tex_file_name) {
+				AddMessage(retDiffs, maxDiffs, "material[%d] : toon/edge/face count/texture differs.", i);
+			}
+		}
+	}
+
+	// ボーン.
+	if (m_boneCount != other.m_boneCount) {
+		AddMessage(retDiffs, maxDiffs, "bones : count %d != %d.", m_boneCount, other.m_boneCount);
+	} else {
+		PMD_READ_BONE b0, b1;
+		for (int i = 0; i < m_boneCount; i++) {
+			GetBone(i, b0);
+			other.GetBone(i, b1);
+			if (b0.bone_name != b1.bone_name || b0.parent_bone_index != b1.parent_bone_index || b0.tail_pos_bone_index != b1.tail_pos_bone_index
+				|| b0.bone_type != b1.bone_type || b0.ik_parent_bone_index != b1.ik_parent_bone_index) {
+				AddMessage(retDiffs, maxDiffs, "bone[%d] : name/hierarchy/type differs.", i);
+			}
+			if (!IsNear(b0.bone_head_pos, b1.bone_head_pos, 3, tolerance)) {
+				AddMessage(retDiffs, maxDiffs, "bone[%d] : head position differs.", i);
+			}
+		}
+	}
+
+	// IK.
+	if (m_ikCount != other.m_ikCount) {
+		AddMessage(retDiffs, maxDiffs, "iks : count %d != %d.", m_ikCount, other.m_ikCount);
+	} else {
+		PMD_READ_IK ik0, ik1;
+		for (int i = 0; i < m_ikCount; i++) {
+			GetIK(i, ik0);
+			other.GetIK(i, ik1);
+			if (ik0.ik_bone_index != ik1.ik_bone_index || ik0.ik_target_bone_index != ik1.ik_target_bone_index || ik0.iterations != ik1.iterations
+				|| !IsNear(&ik0.control_weight, &ik1.control_weight, 1, tolerance) || ik0.ik_child_bone_index != ik1.ik_child_bone_index) {
+				AddMessage(retDiffs, maxDiffs, "ik[%d] : differs.", i);
+			}
+		}
+	}
+
+	// 表情.
+	if (m_skinCount != other.m_skinCount) {
+		AddMessage(retDiffs, maxDiffs, "skins : count %d != %d.", m_skinCount, other.m_skinCount);
+	} else {
+		PMD_READ_SKIN s0, s1;
+		PMD_READ_SKIN_VERTEX sv0, sv1;
+		for (int i = 0; i < m_skinCount; i++) {
+			GetSkin(i, s0);
+			other.GetSkin(i, s1);
+			if (s0.name != s1.name || s0.type != s1.type || s0.vertex_count != s1.vertex_count) {
+				AddMessage(retDiffs, maxDiffs, "skin[%d] : name/type/vertex count differs.", i);
+				continue;
+			}
+			for (int j = 0; j < s0.vertex_count; j++) {
+				GetSkinVertex(i, j, sv0);
+				other.GetSkinVertex(i, j, sv1);
+				if (sv0.vert_index != sv1.vert_index || !IsNear(sv0.pos, sv1.pos, 3, tolerance)) {
+					AddMessage(retDiffs, maxDiffs, "skin[%d] : vertex[%d] differs.", i, j);
+				}
+			}
+		}
+	}
+
+	// 以下は許容誤差なしで比較.
+	const struct {
+		int section;
+		const char* name;
+	} rawSections[] = {
+		{ pmd_section_skin_frames,   "skin frames" },
+		{ pmd_section_bone_frames,   "bone frames" },
+		{ pmd_section_bone_disps,    "bone display list" },
+		{ pmd_section_english,       "english" },
+		{ pmd_section_toon_textures, "toon textures" },
+		{ pmd_section_rigidbodies,   "rigid bodies" },
+		{ pmd_section_joints,        "joints" },
+	};
+	for (size_t i = 0; i < sizeof(rawSections) / sizeof(rawSections[0]); i++) {
+		const int section = rawSections[i].section;
+		if (m_hasSection[section] != other.m_hasSection[section] || m_sectionSize[section] != other.m_sectionSize[section]) {
+			AddMessage(retDiffs, maxDiffs, "%s : size differs.", rawSections[i].name);
+		} else if (m_hasSection[section] && memcmp(GetSectionData(section), other.GetSectionData(section), m_sectionSize[section]) != 0) {
+			AddMessage(retDiffs, maxDiffs, "%s : data differs.", rawSections[i].name);
+		}
+	}
+
+	return retDiffs.empty();
+}
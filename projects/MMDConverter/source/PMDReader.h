@@ -0,0 +1,284 @@
+﻿/**
+ *  @brief  PMDファイルの読み込みと構造の検証 (メモリマップ).
+ *  @date   2026.10.19
+ */
+
+#ifndef _PMDREADER_H
+#define _PMDREADER_H
+
+#include "GlobalHeader.h"
+#include "MappedFile.h"
+
+#include <vector>
+#include <string>
+
+/*
+	CPMDData::Exportで出力した各セクションを、メモリマップしたファイル上で直接参照する.
+	Openでは各セクションの位置とサイズのみを求める(頂点などの要素はコピーしない).
+	要素はGetVertexなどで、必要になった時点で1つずつ取り出す.
+
+	Validateでは、インデックスが参照先の範囲内にあるかを検証する.
+	Compareで、2つのPMDファイルの差分を取得できる.
+*/
+
+/**
+ * 頂点 (PMD_VERTEX_DATA_SIZEバイト).
+ */
+typedef struct {
+	float pos[3];
+	float normal[3];
+	float uv[2];
+	int bone_num[2];
+	int bone_weight;
+	int edge_flag;
+} PMD_READ_VERTEX;
+
+/**
+ * マテリアル (PMD_MATERIAL_DATA_SIZEバイト).
+ */
+typedef struct {
+	float diffuse_color[3];
+	float alpha;
+	float specular;
+	float specular_color[3];
+	float ambient_color[3];
+	int toon_index;
+	int edge_flag;
+	int face_vert_count;
+	std::string tex_file_name;
+} PMD_READ_MATERIAL;
+
+/**
+ * ボーン (PMD_BONE_DATA_SIZEバイト).
+ */
+typedef struct {
+	std::string bone_name;
+	int parent_bone_index;			///< ない場合は-1.
+	int tail_pos_bone_index;
+	int bone_type;
+	int ik_parent_bone_index;
+	float bone_head_pos[3];
+} PMD_READ_BONE;
+
+/**
+ * IK.
+ */
+typedef struct {
+	int ik_bone_index;
+	int ik_target_bone_index;
+	int iterations;
+	float control_weight;
+	std::vector<int> ik_child_bone_index;
+} PMD_READ_IK;
+
+/**
+ * 表情.
+ */
+typedef struct {
+	std::string name;
+	int type;
+	int vertex_count;
+} PMD_READ_SKIN;
+
+/**
+ * 表情の頂点.
+ */
+typedef struct {
+	int vert_index;					///< baseの場合は頂点番号、base以外はbaseの表情内での番号.
+	float pos[3];
+} PMD_READ_SKIN_VERTEX;
+
+/**
+ * ボーン枠用表示リストの要素.
+ */
+typedef struct {
+	int bone_index;
+	int bone_disp_index;			///< ボーン枠の番号 (1 - ).
+} PMD_READ_BONE_DISP_ITEM;
+
+/**
+ * 剛体 (PMD_RIGIDBODY_DATA_SIZEバイト).
+ */
+typedef struct {
+	std::string name;
+	int bone_index;					///< ない場合は-1.
+	int group_index;
+	int group_target;
+	int type;
+	float shape_size[3];
+	float pos[3];
+	float rot[3];
+	float weight;
+	float pos_dim;
+	float rot_dim;
+	float recoil;
+	float friction;
+	int rigidbody_type;
+} PMD_READ_RIGIDBODY;
+
+/**
+ * 剛体のジョイント (PMD_RIGIDBODY_JOINT_DATA_SIZEバイト).
+ */
+typedef struct {
+	std::string name;
+	int joint_a;
+	int joint_b;
+	float pos[3];
+	float rot[3];
+	float constrain_pos1[3];
+	float constrain_pos2[3];
+	float constrain_rot1[3];
+	float constrain_rot2[3];
+	float spring_pos[3];
+	float spring_rot[3];
+} PMD_READ_RIGIDBODY_JOINT;
+
+/**
+ * PMDのセクション.
+ */
+enum {
+	pmd_section_header = 0,			///< ヘッダ.
+	pmd_section_vertices,			///< 頂点.
+	pmd_section_faces,				///< 面の頂点番号.
+	pmd_section_materials,			///< マテリアル.
+	pmd_section_bones,				///< ボーン.
+	pmd_section_iks,				///< IK.
+	pmd_section_skins,				///< 表情.
+	pmd_section_skin_frames,		///< 表情枠.
+	pmd_section_bone_frames,		///< ボーン枠名.
+	pmd_section_bone_disps,			///< ボーン枠用表示リスト.
+	pmd_section_english,			///< 英語情報.
+	pmd_section_toon_textures,		///< トゥーンテクスチャリスト.
+	pmd_section_rigidbodies,		///< 剛体.
+	pmd_section_joints,				///< ジョイント.
+
+	pmd_section_count,
+};
+
+class CPMDReader
+{
+private:
+	CMappedFile m_file;
+	const unsigned char* m_pData;
+	size_t m_size;
+
+	size_t m_sectionOffset[pmd_section_count];		///< セクションの要素の開始位置 (要素数の後).
+	size_t m_sectionSize[pmd_section_count];		///< セクションの要素のバイト数 (要素数を除く).
+	bool m_hasSection[pmd_section_count];			///< セクションが存在するか.
+
+	int m_vertexCount;
+	int m_faceVertCount;
+	int m_materialCount;
+	int m_boneCount;
+	int m_ikCount;
+	int m_skinCount;
+	int m_skinFrameCount;
+	int m_boneFrameCount;
+	int m_boneDispCount;
+	int m_rigidBodyCount;
+	int m_jointCount;
+	bool m_hasEnglish;
+
+	std::vector<size_t> m_ikOffsets;				///< IKごとの開始位置 (可変長のため).
+	std::vector<size_t> m_skinOffsets;				///< 表情ごとの開始位置 (可変長のため).
+
+	std::string m_errorMessage;
+
+	/**
+	 * セクションの位置を求める.
+	 */
+	bool m_Parse();
+
+	/**
+	 * 要素数(countSizeバイト)と、固定長の要素が続くセクションの位置を求める.
+	 */
+	bool m_ParseFixedSection(size_t& pos, const int section, const int countSize, const size_t elementSize, int& retCount);
+
+	/**
+	 * 指定位置からのバイト数が残っているか.
+	 */
+	bool m_Has(const size_t pos, const size_t size) const { return (pos <= m_size && size <= m_size - pos); }
+
+	/**
+	 * エラーを記録してfalseを返す.
+	 */
+	bool m_Error(const char* message);
+
+public:
+	CPMDReader();
+	virtual ~CPMDReader();
+
+	/**
+	 * PMDファイルを開いて、各セクションの位置を求める (パスはUTF-8).
+	 * @return 途中で切れている場合などはfalse (GetErrorMessageで理由を取得).
+	 */
+	bool Open(const std::string& filePath);
+
+	/**
+	 * メモリ上のPMDデータを参照 (dataはCloseまで保持しておくこと).
+	 */
+	bool OpenMemory(const unsigned char* data, const size_t size);
+
+	void Close();
+
+	const std::string& GetErrorMessage() const { return m_errorMessage; }
+
+	/**
+	 * セクションの情報.
+	 */
+	bool HasSection(const int section) const { return m_hasSection[section]; }
+	size_t GetSectionSize(const int section) const { return m_sectionSize[section]; }
+	const unsigned char* GetSectionData(const int section) const { return m_hasSection[section] ? (m_pData + m_sectionOffset[section]) : NULL; }
+
+	std::string GetModelName() const;
+	std::string GetComment() const;
+	std::string GetModelNameEnglish() const;
+	std::string GetCommentEnglish() const;
+
+	int GetVerticesCount() const { return m_vertexCount; }
+	int GetFaceVerticesCount() const { return m_faceVertCount; }
+	int GetMaterialsCount() const { return m_materialCount; }
+	int GetBonesCount() const { return m_boneCount; }
+	int GetIKsCount() const { return m_ikCount; }
+	int GetSkinsCount() const { return m_skinCount; }
+	int GetSkinFramesCount() const { return m_skinFrameCount; }
+	int GetBoneFramesCount() const { return m_boneFrameCount; }
+	int GetBoneDispsCount() const { return m_boneDispCount; }
+	int GetRigidBodiesCount() const { return m_rigidBodyCount; }
+	int GetJointsCount() const { return m_jointCount; }
+	bool HasEnglish() const { return m_hasEnglish; }
+
+	void GetVertex(const int index, PMD_READ_VERTEX& retData) const;
+	int GetFaceIndex(const int index) const;
+	void GetMaterial(const int index, PMD_READ_MATERIAL& retData) const;
+	void GetBone(const int index, PMD_READ_BONE& retData) const;
+	void GetIK(const int index, PMD_READ_IK& retData) const;
+	void GetSkin(const int index, PMD_READ_SKIN& retData) const;
+	void GetSkinVertex(const int skinIndex, const int index, PMD_READ_SKIN_VERTEX& retData) const;
+	int GetSkinFrame(const int index) const;
+	std::string GetBoneFrameName(const int index) const;
+	void GetBoneDisp(const int index, PMD_READ_BONE_DISP_ITEM& retData) const;
+	std::string GetBoneNameEnglish(const int index) const;
+	std::string GetSkinNameEnglish(const int index) const;		///< baseを除いた表情番号.
+	std::string GetBoneFrameNameEnglish(const int index) const;
+	std::string GetToonTextureName(const int index) const;
+	void GetRigidBody(const int index, PMD_READ_RIGIDBODY& retData) const;
+	void GetJoint(const int index, PMD_READ_RIGIDBODY_JOINT& retData) const;
+
+	/**
+	 * インデックスの範囲など、構造を検証.
+	 * @param[out] retErrors  見つかった問題 (最大maxErrors個).
+	 * @return 問題がない場合はtrue.
+	 */
+	bool Validate(std::vector<std::string>& retErrors, const int maxErrors = 100) const;
+
+	/**
+	 * 他のPMDとの差分を取得.
+	 * 頂点/ボーン/表情の座標は、tolerance以内の差は同一とみなす.
+	 * @param[out] retDiffs  差分の説明 (最大maxDiffs個).
+	 * @return 差分がない場合はtrue.
+	 */
+	bool Compare(const CPMDReader& other, const float tolerance, std::vector<std::string>& retDiffs, const int maxDiffs = 100) const;
+};
+
+#endif
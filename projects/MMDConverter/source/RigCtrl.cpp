@@ -5,6 +5,9 @@
 
 #include "RigCtrl.h"
 #include "Util.h"
+#include "ExportTask.h"
+
+#include <mutex>
 
 // ----------------------------------------------------.
 // 人体リグのボーン情報（MMDの初音ミクモデル、A-Pose）.
@@ -95,6 +98,25 @@ RIG_BONE_INFO rigBoneInfo [] = {
 	RIG_BONE_INFO( -1,   -1,   -1, ""              , ""                , "")
 };
 
+std::once_flag g_namesJPOnce;
+std::vector<std::string> g_namesJP;		///< rigBoneInfoのname_jpをUTF-8に変換したもの.
+
+/**
+ * rigBoneInfoのname_jpをUTF-8に変換したものを取得.
+ * 変換は初回のみ、表全体をまとめてメインスレッドで行う (ワーカースレッドからボーンごとに呼び出しを代行させない).
+ */
+const std::vector<std::string>& GetNamesJP(sxsdk::shade_interface& shade)
+{
+	std::call_once(g_namesJPOnce, [&shade]() {
+		CExportTask::CallOnMainThread([&shade]() {
+			for (int i = 0; rigBoneInfo[i].bone_index >= 0; i++) {
+				g_namesJP.push_back(Util::GetUTF8Text(shade, rigBoneInfo[i].name_jp));
+			}
+		});
+	});
+	return g_namesJP;
+}
+
 }
 
 CRigCtrl::CRigCtrl(sxsdk::shade_interface *shade) {
@@ -115,6 +137,17 @@ float CRigCtrl::CheckMMDBones(sxsdk::shape_class& bone_root, int* pRetHumanRigTy
 	// ボーン名を取得.
 	std::vector<std::string> bonesName;
 	m_GetBonesName(0, bone_root, bonesName);
+	return CheckMMDBones(bonesName, pRetHumanRigType);
+}
+
+/**
+ * 指定のボーン名のリストがMMDで使用するものとほぼ一致するか調べる.
+ * @param[in]  bonesName          ボーン名のリスト.
+ * @param[out] pRetHumanRigType   リグの種類（human_rig_type_default/human_rig_type_mmd_jp/human_rig_type_mmd_en）.
+ * @return  完全一致の場合は1.0を返す。1.0に近づくほどMMDのボーンの可能性が高い.
+ */
+float CRigCtrl::CheckMMDBones(const std::vector<std::string>& bonesName, int* pRetHumanRigType)
+{
 	if (bonesName.size() == 0) return 0.0f;
 
 	// 比較する最低限のボーンの数.
@@ -202,6 +235,14 @@ void CRigCtrl::m_GetBonesName(const int depth, sxsdk::shape_class& shape, std::v
 	}
 }
 
+/**
+ * ボーン名の変換表を準備 (エクスポートの開始時に、メインスレッドから呼ぶ).
+ */
+void CRigCtrl::PrepareNames(sxsdk::shade_interface *shade)
+{
+	GetNamesJP(*shade);
+}
+
 /**
  * 人体リグの、指定のボーン名に対応するインデックスを取得.
  */
@@ -219,8 +260,7 @@ int CRigCtrl::GetHumanBoneIndex(sxsdk::shade_interface *shade, std::string boneN
 				break;
 			}
 		} else if (rigType == human_rig_type_mmd_jp) {
-			const std::string nameUTF8 = Util::GetUTF8Text(*shade, rInfo.name_jp);
-			if (nameUTF8.compare(boneName) == 0) {
+			if (GetNamesJP(*shade)[iPos].compare(boneName) == 0) {
 				index = iPos;
 				break;
 			}
@@ -247,8 +287,7 @@ std::string CRigCtrl::GetHumanBoneName(sxsdk::shade_interface *shade, const int
 		return rigBoneInfo[index].name_default;
 	}
 	if (rigType == human_rig_type_mmd_jp) {
-		const std::string nameUTF8 = Util::GetUTF8Text(*shade, rigBoneInfo[index].name_jp);
-		return nameUTF8;
+		return GetNamesJP(*shade)[index];
 	}
 	if (rigType == human_rig_type_mmd_en) {
 		return rigBoneInfo[index].name_en;
@@ -54,6 +54,20 @@ public:
 	 */
 	float CheckMMDBones(sxsdk::shape_class& bone_root, int* pRetHumanRigType);
 
+	/**
+	 * 指定のボーン名のリストがMMDで使用するものとほぼ一致するか調べる.
+	 * @param[in]  bonesName          ボーン名のリスト.
+	 * @param[out] pRetHumanRigType   リグの種類（human_rig_type_default/human_rig_type_mmd_jp/human_rig_type_mmd_en）.
+	 * @return  完全一致の場合は1.0を返す。1.0に近づくほどMMDのボーンの可能性が高い.
+	 */
+	float CheckMMDBones(const std::vector<std::string>& bonesName, int* pRetHumanRigType);
+
+	/**
+	 * ボーン名の変換表を準備 (エクスポートの開始時に、メインスレッドから呼ぶ).
+	 * MMDの日本語のボーン名をUTF-8に変換して保持する。呼ばなかった場合は、初回の参照時に変換する.
+	 */
+	static void PrepareNames(sxsdk::shade_interface *shade);
+
 	/**
 	 * 人体リグの、指定のボーン名に対応するインデックスを取得.
 	 */
@@ -0,0 +1,570 @@
+﻿/**
+ *  @brief  変換に必要なシーン情報のスナップショット.
+ *  @date   2026.10.19
+ */
+
+#include "SceneSnapshot.h"
+#include "RigCtrl.h"
+#include "StageCache.h"
+#include "Util.h"
+#include "VertexTransform.h"
+
+#include <map>
+
+namespace {
+	/**
+	 * [skin]パート内の、表情の種類ごとのパート名 (skin_type_xxxの順).
+	 */
+	const char* g_skinTypeName[] = {
+		"base", "eyebrow", "eye", "mouth", "other"
+	};
+	const int g_skinTypeCount = sizeof(g_skinTypeName) / sizeof(g_skinTypeName[0]);
+
+	void* g_exportSceneHandle = NULL;		///< 前回エクスポートしたシーン (ルート形状のハンドル).
+
+	/**
+	 * 指定の形状の子から、指定の名前の形状を探す.
+	 */
+	sxsdk::shape_class* FindSon(sxsdk::shape_class& shape, const char* name)
+	{
+		if (!shape.has_son()) return NULL;
+
+		sxsdk::shape_class* pShape = shape.get_son();
+		while (pShape->has_bro()) {
+			pShape = pShape->get_bro();
+			if (strcmp(pShape->get_name(), name) == 0) return pShape;
+		}
+		return NULL;
+	}
+}
+
+CModelSnapshot::CModelSnapshot()
+{
+}
+
+void CModelSnapshot::Clear()
+{
+	name = "";
+	positions.clear();
+	faceOffsets.clear();
+	faceIndices.clear();
+	faceNormals.clear();
+	faceUVs.clear();
+	faceGroups.clear();
+	bindOffsets.clear();
+	binds.clear();
+	bindNames.clear();
+	skeleton.reset();
+	boneHeadPositions.clear();
+	iks.clear();
+	materials.clear();
+	morphs.clear();
+	morphGroupIndex.clear();
+}
+
+/**
+ * 指定のポリゴンメッシュと、関連するボーン/IK/表面材質/表情のスナップショットを取得.
+ */
+bool CModelSnapshot::Capture(sxsdk::shade_interface& shade, sxsdk::shape_class& shape, const bool captureMorphs, const bool captureNormals)
+{
+	Clear();
+	if (shape.get_type() != sxsdk::enums::polygon_mesh) return false;
+
+	name = shape.get_name();
+
+	// 一度シーケンスOffにする（初期姿勢になるわけではないが、、、）.
+	compointer<sxsdk::scene_interface> scene(shape.get_scene_interface());
+	const bool dirtyF       = scene->get_dirty();
+	const bool sequenceMode = scene->get_sequence_mode();
+	if (sequenceMode) scene->set_sequence_mode(false);
+
+	bool ret = false;
+	try {
+		if (m_CaptureMesh(shape, captureNormals)) {
+			m_CaptureBones(shade, scene, shape);
+			m_CaptureMaterials(scene, shape);
+			if (captureMorphs) m_CaptureMorphs(scene);
+			ret = true;
+		}
+	} catch (...) { }
+
+	scene->set_sequence_mode(sequenceMode);
+	scene->set_dirty(dirtyF);		// 保存フラグを元に戻す.
+
+	return ret;
+}
+
+/**
+ * 同じボーン構造を持つポリゴンメッシュのスナップショットを末尾に連結.
+ */
+bool CModelSnapshot::Append(const CModelSnapshot& src)
+{
+	if (skeleton != src.skeleton || src.positions.empty()) return false;
+
+	const int vertexOffset = positions.size();
+	const int cornerOffset = faceIndices.size();
+	const int bindOffset   = binds.size();
+
+	// 頂点位置.
+	positions.insert(positions.end(), src.positions.begin(), src.positions.end());
+
+	// 面情報 (面頂点の開始位置と頂点番号をずらす).
+	if (faceOffsets.empty()) faceOffsets.push_back(0);
+	for (int i = 1; i < src.faceOffsets.size(); i++) {
+		faceOffsets.push_back(src.faceOffsets[i] + cornerOffset);
+	}
+	faceIndices.reserve(faceIndices.size() + src.faceIndices.size());
+	for (int i = 0; i < src.faceIndices.size(); i++) {
+		faceIndices.push_back(src.faceIndices[i] + vertexOffset);
+	}
+	faceNormals.insert(faceNormals.end(), src.faceNormals.begin(), src.faceNormals.end());
+	faceUVs.insert(faceUVs.end(), src.faceUVs.begin(), src.faceUVs.end());
+
+	// スキンのバインド (バインド先の形状名は名前で統合).
+	std::map<std::string, int> bindNameIndex;
+	for (int i = 0; i < bindNames.size(); i++) bindNameIndex[bindNames[i]] = i;
+	std::vector<int> srcBindNameIndex(src.bindNames.size());
+	for (int i = 0; i < src.bindNames.size(); i++) {
+		std::map<std::string, int>::const_iterator it = bindNameIndex.find(src.bindNames[i]);
+		if (it != bindNameIndex.end()) {
+			srcBindNameIndex[i] = it->second;
+		} else {
+			srcBindNameIndex[i] = bindNames.size();
+			bindNameIndex[src.bindNames[i]] = bindNames.size();
+			bindNames.push_back(src.bindNames[i]);
+		}
+	}
+	if (bindOffsets.empty()) bindOffsets.push_back(0);
+	for (int i = 1; i < src.bindOffsets.size(); i++) {
+		bindOffsets.push_back(src.bindOffsets[i] + bindOffset);
+	}
+	binds.reserve(binds.size() + src.binds.size());
+	for (int i = 0; i < src.binds.size(); i++) {
+		SNAPSHOT_SKIN_BIND bind = src.binds[i];
+		if (bind.name_index >= 0 && bind.name_index < srcBindNameIndex.size()) bind.name_index = srcBindNameIndex[bind.name_index];
+		binds.push_back(bind);
+	}
+
+	// 表面材質.
+	// 連結するメッシュの表面材質は、形状自身のものも含めてフェイスグループとして追加する.
+	// ([0]のみ連結先の形状自身の表面材質とし、表面材質を持たない面はこれを参照する).
+	if (materials.empty()) materials.resize(1);
+	const int groupOffset = (int)materials.size() - 1;
+	const int srcFaceGroupCou = (int)src.materials.size() - 1;
+	const bool srcHasSurface = !src.materials.empty() && src.materials[0].has_surface;
+	faceGroups.reserve(faceGroups.size() + src.faceGroups.size());
+	for (int i = 0; i < src.faceGroups.size(); i++) {
+		const int fIndex = src.faceGroups[i];
+		if (fIndex >= 0 && fIndex < srcFaceGroupCou && src.materials[1 + fIndex].has_surface) {
+			faceGroups.push_back(groupOffset + 1 + fIndex);
+		} else {
+			faceGroups.push_back(srcHasSurface ? groupOffset : -1);
+		}
+	}
+	materials.insert(materials.end(), src.materials.begin(), src.materials.end());
+
+	return true;
+}
+
+/**
+ * ポリゴンメッシュの頂点/面/スキンを取得.
+ */
+bool CModelSnapshot::m_CaptureMesh(sxsdk::shape_class& shape, const bool captureNormals)
+{
+	sxsdk::polygon_mesh_class& pmesh = shape.get_polygon_mesh();
+	const int verCou = pmesh.get_total_number_of_control_points();
+	if (verCou <= 0) return false;
+
+	const sxsdk::mat4 lwMat = shape.get_local_to_world_matrix();
+
+	// 頂点位置とスキンのバインド.
+	// 頂点位置はローカル座標で取得し、ワールド変換はまとめて行う.
+	std::map<sxsdk::shape_class *, int> bindShapeIndex;
+	CVec3ArraySoA localPositions;
+	localPositions.Resize(verCou);
+	bindOffsets.resize(verCou + 1, 0);
+	for (int i = 0; i < verCou; i++) {
+		sxsdk::vertex_class& v = pmesh.vertex(i);
+		localPositions.Set(i, v.get_position());
+
+		bindOffsets[i + 1] = bindOffsets[i];
+		sxsdk::skin_class& skin = v.get_skin();
+		const int bindCou = skin.get_number_of_binds();
+		for (int j = 0; j < bindCou; j++) {
+			sxsdk::skin_bind_class& skinBind = skin.get_bind(j);
+			sxsdk::shape_class* pBindShape = skinBind.get_shape();
+
+			SNAPSHOT_SKIN_BIND bind;
+			bind.weight = skinBind.get_weight();
+			std::map<sxsdk::shape_class *, int>::const_iterator it = bindShapeIndex.find(pBindShape);
+			if (it != bindShapeIndex.end()) {
+				bind.name_index = it->second;
+			} else {
+				bind.name_index = bindNames.size();
+				bindNames.push_back(pBindShape->get_name());
+				bindShapeIndex[pBindShape] = bind.name_index;
+			}
+			binds.push_back(bind);
+			bindOffsets[i + 1]++;
+		}
+	}
+
+	VertexTransform::TransformPositions(localPositions, lwMat);
+	localPositions.Store(positions);
+
+	if (captureNormals) pmesh.setup_normal();
+
+	// 面情報 (面ごとの頂点番号/法線/UVを、面頂点の並びで格納).
+	const int faceCou = pmesh.get_number_of_faces();
+	faceOffsets.resize(faceCou + 1, 0);
+	faceGroups.resize(faceCou, -1);
+	{
+		int indicesList[512];
+		std::vector<sxsdk::vec3> normals;
+		normals.resize(512);
+		for (int i = 0; i < faceCou; i++) {
+			faceOffsets[i + 1] = faceOffsets[i];
+			faceGroups[i] = pmesh.get_face_group_index(i);
+
+			sxsdk::face_class& f = pmesh.face(i);
+			const int vCou = f.get_number_of_vertices();
+			if (vCou > 510) continue;
+			if (captureNormals) pmesh.get_face_n_deprecated(i, indicesList, &(normals[0]));		// 法線はこれじゃないと正しく取得できない.
+			f.get_vertex_indices(indicesList);
+
+			for (int j = 0; j < vCou; j++) {
+				faceIndices.push_back(indicesList[j]);
+				if (captureNormals) faceNormals.push_back(normals[j]);
+				faceUVs.push_back(f.get_face_uv(0, j));
+			}
+			faceOffsets[i + 1] += vCou;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * ボーンとIKを取得.
+ */
+void CModelSnapshot::m_CaptureBones(sxsdk::shade_interface& shade, sxsdk::scene_interface* scene, sxsdk::shape_class& shape)
+{
+	if (shape.get_skin_type() != 1) return;		// 頂点ブレンドのスキンでない場合はスキップ.
+
+	sxsdk::shape_class *pBoneRoot = Util::GetBoneRoot(shape);
+	if (!pBoneRoot) return;
+
+	// ボーンの構造はキャッシュを使用し、位置のみ取得.
+	std::vector<sxsdk::shape_class *> boneShapes;
+	std::vector<sxsdk::shape_class *> goalShapes;
+	skeleton = SkeletonCache::Get(shade, scene, *pBoneRoot, &boneShapes, &goalShapes);
+
+	boneHeadPositions.resize(boneShapes.size());
+	for (int i = 0; i < boneShapes.size(); i++) {
+		sxsdk::shape_class* pBoneShape = boneShapes[i];
+		boneHeadPositions[i] = sxsdk::vec3(0, 0, 0) * (pBoneShape->get_transformation()) * (pBoneShape->get_local_to_world_matrix());
+	}
+
+	// IK Endを持つボーンごとに、IK root/endのボーン番号とgoalの位置を取得.
+	try {
+		for (int i = 0; i < skeleton->ikChains.size(); i++) {
+			const SKELETON_IK_CHAIN& chain = skeleton->ikChains[i];
+			if (!chain.has_root || !chain.has_end || !chain.has_goal) continue;
+
+			SNAPSHOT_IK ikSnapshot;
+			ikSnapshot.root_bone = chain.root_bone;
+			ikSnapshot.end_bone  = chain.end_bone;
+
+			// ※ IKでのgoalはボールジョイント.
+			sxsdk::shape_class* ikGoalShape = goalShapes[i];
+			if (ikGoalShape->get_type() == sxsdk::enums::part) {
+				if (ikGoalShape->get_part().get_part_type() == sxsdk::enums::ball_joint) {
+					compointer<sxsdk::ball_joint_interface> ball(ikGoalShape->get_ball_joint_interface());
+					ikSnapshot.goal_pos = (ball->get_position()) * (ikGoalShape->get_local_to_world_matrix());
+				}
+			}
+			iks.push_back(ikSnapshot);
+		}
+	} catch (...) { }
+}
+
+/**
+ * 表面材質と、面から参照されるテクスチャのピクセルを取得.
+ */
+void CModelSnapshot::m_CaptureMaterials(sxsdk::scene_interface* scene, sxsdk::shape_class& shape)
+{
+	sxsdk::polygon_mesh_class& pmesh = shape.get_polygon_mesh();
+	const int faceGroupCou = pmesh.get_number_of_face_groups();
+
+	std::vector<sxsdk::surface_class *> surfaces;
+	surfaces.push_back(shape.has_surface() ? shape.get_surface() : NULL);
+	for (int i = 0; i < faceGroupCou; i++) {
+		sxsdk::master_surface_class *mSurface = pmesh.get_face_group_surface(i);
+		surfaces.push_back(mSurface ? mSurface->get_surface() : NULL);
+	}
+
+	// 面から参照される表面材質 (表面材質のないフェイスグループの面は、形状自身の表面材質を参照).
+	std::vector<bool> usedSurfaces(surfaces.size(), false);
+	usedSurfaces[0] = true;
+	for (int i = 0; i < faceGroups.size(); i++) {
+		const int fIndex = faceGroups[i];
+		if (fIndex >= 0 && fIndex < faceGroupCou && surfaces[1 + fIndex] != NULL) usedSurfaces[1 + fIndex] = true;
+	}
+
+	// 環境光の影響は、光源から取得.
+	sxsdk::rgb_class ambientCol = sxsdk::rgb_class(0.2f, 0.2f, 0.2f);
+	{
+		compointer<sxsdk::distant_light_interface> distantLight(scene->get_distant_light_interface());
+		if (distantLight) {
+			if ((distantLight->get_number_of_lights()) > 0) {
+				sxsdk::distant_light_item_class& LInfo = distantLight->distant_light_item(0);
+				const float ambVal = LInfo.get_ambient();
+				const sxsdk::rgb_class ambCol = LInfo.get_light_color();
+				ambientCol = ambCol * ambVal;
+			}
+		}
+	}
+
+	materials.resize(surfaces.size());
+	for (int loop = 0; loop < surfaces.size(); loop++) {
+		sxsdk::surface_class* pSurface = surfaces[loop];
+		if (!pSurface) continue;
+
+		SNAPSHOT_MATERIAL& material = materials[loop];
+		material.has_surface = true;
+
+		sxsdk::rgb_class col = (pSurface->get_diffuse_color()) * (pSurface->get_diffuse());
+		material.diffuse_color = sxsdk::vec3(col.red, col.green, col.blue);
+
+		float specularVal = pSurface->get_highlight();
+		if (specularVal < 0.0f) specularVal = 0.0f;
+		if (specularVal > 1.0f) specularVal = 1.0f;
+		material.specular = (pSurface->get_highlight_size()) * 20.0f;
+		col = (pSurface->get_highlight_color()) * specularVal;
+		material.specular_color = sxsdk::vec3(col.red, col.green, col.blue);
+
+		material.alpha = 1.0f - (pSurface->get_transparency());
+
+		sxsdk::rgb_class ambCol = ambientCol;
+		if (pSurface->get_has_ambient()) {
+			ambCol = ambCol * ((pSurface->get_ambient_color()) * (pSurface->get_ambient()));
+		}
+		material.ambient_color = sxsdk::vec3(ambCol.red, ambCol.green, ambCol.blue);
+
+		// テクスチャはフェイスグループの表面材質のみ対象.
+		if (loop == 0 || !usedSurfaces[loop]) continue;
+
+		const int mappingCou = pSurface->get_number_of_mapping_layers();
+		int mappingIndex = -1;
+		for (int i = 0; i < mappingCou; i++) {
+			sxsdk::mapping_layer_class& mLayer = pSurface->mapping_layer(i);
+			if (mLayer.get_type() == sxsdk::enums::diffuse_mapping && mLayer.get_pattern() == sxsdk::enums::image_pattern) {
+				mappingIndex = i;
+				break;
+			}
+		}
+		if (mappingIndex < 0) continue;
+
+		sxsdk::mapping_layer_class& mLayer = pSurface->mapping_layer(mappingIndex);
+		compointer<sxsdk::image_interface> image(mLayer.get_image_interface());
+		if (!image || !(image->has_image())) continue;
+
+		// テクスチャ名は20バイト以内.
+		char szName[64];
+		sprintf(szName, "tex_%d.png", loop);
+		material.tex_file_name = szName;
+
+		sxsdk::master_image_class* pMImage = Util::GetMasterImageFromImage(scene, image);
+		if (pMImage) {
+			std::string name = pMImage->get_name();
+
+			// 末尾から見て「\」「/」がある場合はカット.
+			{
+				int pos = name.find_last_of("\\");
+				if (pos != std::string::npos) {
+					name = name.substr(pos + 1);
+				}
+				pos = name.find_last_of("/");
+				if (pos != std::string::npos) {
+					name = name.substr(pos + 1);
+				}
+			}
+
+			// 末尾の「.」以降をカット.
+			{
+				int pos = name.find_last_of(".");
+				if (pos != std::string::npos) {
+					name = name.substr(0, pos);
+				}
+			}
+			name = name + ".png";
+
+			if (name.length() < 20) {
+				strcpy(szName, name.c_str());
+				material.tex_file_name = szName;
+			}
+		}
+		material.texture_layer_index = mappingIndex;
+
+		// ピクセルを取得.
+		const sx::vec<int,2> size = image->get_size();
+		if (size.x <= 0 || size.y <= 0) continue;
+		material.tex_width  = size.x;
+		material.tex_height = size.y;
+		material.tex_pixels.resize(size.x * size.y);
+		image->get_pixels_rgba(0, 0, size.x, size.y, &(material.tex_pixels[0]));
+	}
+}
+
+/**
+ * [skin]パート内の、表情用のポリゴンメッシュを取得.
+ * 表情の種類ごとのパート内で、先頭のポリゴンメッシュがbaseとなる.
+ */
+void CModelSnapshot::m_CaptureMorphs(sxsdk::scene_interface* scene)
+{
+	sxsdk::shape_class* pSkinPart = FindSon(scene->get_shape(), "skin");
+	if (!pSkinPart) return;
+
+	for (int loop = 1; loop < g_skinTypeCount; loop++) {
+		sxsdk::shape_class* pTypePart = FindSon(*pSkinPart, g_skinTypeName[loop]);
+		if (!pTypePart || !(pTypePart->has_son())) continue;
+
+		const int skinIndex = morphs.size();
+		bool firstF = true;
+		sxsdk::shape_class *pShape = pTypePart->get_son();
+		while (pShape->has_bro()) {
+			pShape = pShape->get_bro();
+			const bool baseF = firstF;
+			firstF = false;
+			if (pShape->get_type() != sxsdk::enums::polygon_mesh) continue;
+
+			sxsdk::polygon_mesh_class& pmesh = pShape->get_polygon_mesh();
+			const int verCou = pmesh.get_total_number_of_control_points();
+			if (verCou <= 0) continue;
+			if (!baseF && skinIndex >= morphs.size()) continue;		// baseがない.
+
+			// ここではローカル座標の頂点位置と変換行列のみを取得する.
+			// ワールド変換とbaseとの頂点数の判定は、CFacialSkin::SetSnapshotで表情ごとに並列に行う.
+			morphs.push_back(SNAPSHOT_MORPH());
+			SNAPSHOT_MORPH& morph = morphs.back();
+			morph.name           = pShape->get_name();
+			morph.type           = loop;
+			morph.base_skin      = baseF;
+			morph.local_to_world = pShape->get_local_to_world_matrix();
+
+			morph.positions.Resize(verCou);
+			for (int i = 0; i < verCou; i++) {
+				morph.positions.Set(i, pmesh.vertex(i).get_position());
+			}
+		}
+		if (skinIndex < morphs.size()) {
+			morphGroupIndex.push_back(skinIndex);
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------.
+
+CMotionSnapshot::CMotionSnapshot()
+{
+}
+
+void CMotionSnapshot::Clear()
+{
+	modelName = "";
+	skeleton.reset();
+	tracks.clear();
+}
+
+/**
+ * 指定のポリゴンメッシュに関連するボーンのモーションのスナップショットを取得.
+ */
+bool CMotionSnapshot::Capture(sxsdk::shade_interface& shade, sxsdk::scene_interface* scene, sxsdk::shape_class& shapeMesh)
+{
+	Clear();
+
+	sxsdk::shape_class* pBoneRoot = Util::GetBoneRoot(shapeMesh);
+	if (!pBoneRoot) return false;
+
+	// ボーンの構造はキャッシュを使用 (PMDのエクスポートと共有).
+	std::vector<sxsdk::shape_class *> bonesList;
+	std::vector<sxsdk::shape_class *> goalShapes;
+	skeleton = SkeletonCache::Get(shade, scene, *pBoneRoot, &bonesList, &goalShapes);
+	if (bonesList.size() == 0) return false;
+
+	modelName = shapeMesh.get_name();
+
+	// モーションを持つボーン.
+	for (int loop = 0; loop < bonesList.size(); loop++) {
+		sxsdk::shape_class* pShape = bonesList[loop];
+		if (!(pShape->has_motion())) continue;
+
+		SNAPSHOT_MOTION_TRACK track;
+		track.name       = skeleton->bones[loop].name;
+		track.bone_index = loop;
+		m_CaptureMotionPoints(pShape, track);
+		tracks.push_back(track);
+	}
+
+	// ボーンのツリー外にあるIKのGoalノード.
+	for (int loop = 0; loop < skeleton->ikChains.size(); loop++) {
+		const SKELETON_IK_CHAIN& chain = skeleton->ikChains[loop];
+		if (!chain.has_root || chain.goal_in_tree) continue;
+
+		sxsdk::shape_class* pGoalShape = goalShapes[loop];
+		if (!pGoalShape || !(pGoalShape->has_motion())) continue;
+
+		SNAPSHOT_MOTION_TRACK track;
+		track.name     = chain.goal_name;
+		track.ik_goal  = true;
+		track.ik_chain = loop;
+		m_CaptureMotionPoints(pGoalShape, track);
+		tracks.push_back(track);
+	}
+
+	return true;
+}
+
+/**
+ * 指定形状のモーションポイントを取得.
+ */
+void CMotionSnapshot::m_CaptureMotionPoints(sxsdk::shape_class* pShape, SNAPSHOT_MOTION_TRACK& track)
+{
+	try {
+		compointer<sxsdk::motion_interface> motion(pShape->get_motion_interface());
+		const int mCou = motion->get_number_of_motion_points();
+
+		SNAPSHOT_MOTION_POINT point;
+		for (int i = 0; i < mCou; i++) {
+			compointer<sxsdk::motion_point_interface> mp(motion->get_motion_point_interface(i));
+			if (!mp) continue;
+
+			const sxsdk::quaternion_class qt = mp->get_rotation();
+			point.sequence = mp->get_sequence();
+			point.offset   = mp->get_offset();
+			point.rotation = sxsdk::vec4(qt.x, qt.y, qt.z, qt.w);
+			track.points.push_back(point);
+		}
+	} catch (...) { }
+}
+
+//---------------------------------------------------------------------------------------.
+
+/**
+ * エクスポートの開始時に、前回と異なるシーンの場合はキャッシュを破棄.
+ * シーンはルート形状のハンドルで識別する。形状のハンドルはシーンを閉じると再利用されるため、
+ * ボーンの有無にかかわらず、シーンが切り替わった時点でどちらのキャッシュも破棄する.
+ * ボーン名の変換表は、ワーカースレッドから呼び出しを代行させないように、ここでメインスレッドで準備する.
+ */
+void SceneSnapshot::BeginExport(sxsdk::shade_interface& shade, sxsdk::scene_interface* scene)
+{
+	CRigCtrl::PrepareNames(&shade);
+
+	if (!scene) return;
+	void* sceneHandle = scene->get_shape().get_handle();
+	if (sceneHandle == g_exportSceneHandle) return;
+	g_exportSceneHandle = sceneHandle;
+
+	SkeletonCache::Clear();
+	StageCache::Clear();
+}
@@ -0,0 +1,245 @@
+﻿/**
+ *  @brief  変換に必要なシーン情報のスナップショット.
+ *  @date   2026.10.19
+ */
+
+#ifndef _SCENESNAPSHOT_H
+#define _SCENESNAPSHOT_H
+
+#include "GlobalHeader.h"
+#include "SkeletonModel.h"
+#include "VertexTransform.h"
+
+#include <vector>
+#include <string>
+
+/*
+	Shade 3DのSDKの呼び出し(頂点/面/スキン/ボーン/IK/表面材質/イメージ/モーション)は、
+	Captureでまとめて行い、平坦な配列に格納する.
+	以降の変換処理はスナップショットのみを参照するため、シーンの参照を持たずに任意のスレッドで実行できる.
+*/
+
+/**
+ * 頂点に割り当てられたスキンのバインド.
+ */
+class SNAPSHOT_SKIN_BIND {
+public:
+	int name_index;					///< バインド先の形状名 (CModelSnapshot::bindNamesの番号).
+	float weight;					///< ウエイト値.
+
+	SNAPSHOT_SKIN_BIND() {
+		name_index = -1;
+		weight     = 0.0f;
+	}
+};
+
+/**
+ * IK (IK Endを持つボーンごと).
+ */
+class SNAPSHOT_IK {
+public:
+	int root_bone;					///< IK rootのボーン番号 (ボーンのツリーにない場合は-1).
+	int end_bone;					///< IK endのボーン番号 (ボーンのツリーにない場合は-1).
+	sxsdk::vec3 goal_pos;			///< ワールド座標でのgoalの位置 (goalがボールジョイントでない場合は原点).
+
+	SNAPSHOT_IK() {
+		root_bone = end_bone = -1;
+		goal_pos  = sxsdk::vec3(0, 0, 0);
+	}
+};
+
+/**
+ * 表面材質 (形状自身の表面材質と、フェイスグループごと).
+ */
+class SNAPSHOT_MATERIAL {
+public:
+	bool has_surface;				///< 表面材質を持つか.
+	sxsdk::vec3 diffuse_color;		///< デフューズ色.
+	float alpha;					///< アルファ値.
+	float specular;					///< スペキュラ値.
+	sxsdk::vec3 specular_color;		///< スペキュラ色.
+	sxsdk::vec3 ambient_color;		///< 環境光色 (光源の環境光を反映済み).
+
+	std::string tex_file_name;					///< テクスチャの出力ファイル名 (ない場合は空).
+	int texture_layer_index;					///< テクスチャとするマッピングレイヤ番号 (ない場合は-1).
+	int tex_width, tex_height;					///< テクスチャサイズ.
+	std::vector<sx::rgba8_class> tex_pixels;	///< テクスチャのピクセル (面から参照される場合のみ取得).
+
+	SNAPSHOT_MATERIAL() {
+		has_surface    = false;
+		diffuse_color  = sxsdk::vec3(1, 1, 1);
+		alpha          = 1.0f;
+		specular       = 0.0f;
+		specular_color = sxsdk::vec3(0.3f, 0.3f, 0.3f);
+		ambient_color  = sxsdk::vec3(0.1f, 0.1f, 0.1f);
+		texture_layer_index = -1;
+		tex_width = tex_height = 0;
+	}
+};
+
+/**
+ * 表情用のポリゴンメッシュ.
+ * ワールド座標への変換と頂点数の判定は、変換処理(CFacialSkin)で表情ごとに並列に行う.
+ */
+class SNAPSHOT_MORPH {
+public:
+	std::string name;						///< 形状名.
+	int type;								///< 表情の種類 (skin_type_xxx).
+	bool base_skin;							///< グループの先頭 (base).
+	CVec3ArraySoA positions;				///< ローカル座標での頂点位置.
+	sxsdk::mat4 local_to_world;				///< ローカル座標からワールド座標への変換行列.
+
+	SNAPSHOT_MORPH() {
+		type      = 0;
+		base_skin = false;
+		local_to_world = sxsdk::mat4::identity;
+	}
+};
+
+/**
+ * PMDのエクスポートで使用するシーン情報.
+ */
+class CModelSnapshot {
+public:
+	std::string name;								///< 形状名.
+
+	// ポリゴンメッシュ.
+	std::vector<sxsdk::vec3> positions;				///< ワールド座標での頂点位置.
+	std::vector<int> faceOffsets;					///< 面ごとの面頂点の開始位置 (面数 + 1個).
+	std::vector<int> faceIndices;					///< 面頂点ごとの頂点番号.
+	std::vector<sxsdk::vec3> faceNormals;			///< 面頂点ごとの法線 (法線を生成する場合は、変換時に格納).
+	std::vector<sxsdk::vec2> faceUVs;				///< 面頂点ごとのUV.
+	std::vector<int> faceGroups;					///< 面ごとのフェイスグループ番号 (ない場合は-1).
+
+	// スキン.
+	std::vector<int> bindOffsets;					///< 頂点ごとのバインドの開始位置 (頂点数 + 1個).
+	std::vector<SNAPSHOT_SKIN_BIND> binds;			///< バインド (頂点ごとに、Shade 3Dでの並び順).
+	std::vector<std::string> bindNames;				///< バインド先の形状名.
+
+	// ボーン (構造はキャッシュを共有し、位置のみスナップショットごとに取得).
+	std::shared_ptr<const CSkeletonModel> skeleton;
+	std::vector<sxsdk::vec3> boneHeadPositions;		///< ワールド座標でのボーンの位置 (skeleton->bonesの順).
+	std::vector<SNAPSHOT_IK> iks;
+
+	// 表面材質 ([0]は形状自身、[1]以降はフェイスグループごと).
+	std::vector<SNAPSHOT_MATERIAL> materials;
+
+	// 表情.
+	std::vector<SNAPSHOT_MORPH> morphs;
+	std::vector<int> morphGroupIndex;				///< 表情の種類ごとの先頭のインデックス.
+
+private:
+	/**
+	 * ポリゴンメッシュの頂点/面/スキンを取得.
+	 */
+	bool m_CaptureMesh(sxsdk::shape_class& shape, const bool captureNormals);
+
+	/**
+	 * ボーンとIKを取得.
+	 */
+	void m_CaptureBones(sxsdk::shade_interface& shade, sxsdk::scene_interface* scene, sxsdk::shape_class& shape);
+
+	/**
+	 * 表面材質と、面から参照されるテクスチャのピクセルを取得.
+	 */
+	void m_CaptureMaterials(sxsdk::scene_interface* scene, sxsdk::shape_class& shape);
+
+	/**
+	 * [skin]パート内の、表情用のポリゴンメッシュを取得.
+	 */
+	void m_CaptureMorphs(sxsdk::scene_interface* scene);
+
+public:
+	CModelSnapshot();
+
+	void Clear();
+
+	/**
+	 * 指定のポリゴンメッシュと、関連するボーン/IK/表面材質/表情のスナップショットを取得.
+	 * メインスレッドから呼ぶこと.
+	 * @param[in] captureMorphs   表情を取得するか (Appendで連結するスナップショットでは不要).
+	 * @param[in] captureNormals  Shade 3Dの法線を取得するか (法線をプラグイン内で生成する場合は不要で、faceNormalsは空になる).
+	 */
+	bool Capture(sxsdk::shade_interface& shade, sxsdk::shape_class& shape, const bool captureMorphs = true, const bool captureNormals = true);
+
+	/**
+	 * 同じボーン構造を持つポリゴンメッシュのスナップショットを末尾に連結し、1つのモデルとする.
+	 * 頂点番号/バインド先/フェイスグループは連結後の番号に付け替える.
+	 * ボーン/IK/表情はシーン単位のため、このスナップショットのものをそのまま使用する
+	 * (表情の頂点は位置で対応付けるため、連結後の頂点に対して求まる).
+	 * @return ボーン構造が異なる場合はfalse.
+	 */
+	bool Append(const CModelSnapshot& src);
+};
+
+/**
+ * モーションポイント.
+ */
+class SNAPSHOT_MOTION_POINT {
+public:
+	float sequence;					///< シーケンス位置.
+	sxsdk::vec3 offset;				///< オフセット.
+	sxsdk::vec4 rotation;			///< 回転のクォータニオン (XYZW).
+
+	SNAPSHOT_MOTION_POINT() {
+		sequence = 0.0f;
+		offset   = sxsdk::vec3(0, 0, 0);
+		rotation = sxsdk::vec4(0, 0, 0, 1);
+	}
+};
+
+/**
+ * モーションを持つボーン、またはボーンのツリー外にあるIK goal.
+ */
+class SNAPSHOT_MOTION_TRACK {
+public:
+	std::string name;							///< 形状名.
+	bool ik_goal;								///< IK goalの場合はtrue.
+	int bone_index;								///< ボーンの場合の、ボーン番号 (CSkeletonModel::bones).
+	int ik_chain;								///< IK goalの場合の、IK番号 (CSkeletonModel::ikChains).
+	std::vector<SNAPSHOT_MOTION_POINT> points;	///< モーションポイント.
+
+	SNAPSHOT_MOTION_TRACK() {
+		ik_goal    = false;
+		bone_index = -1;
+		ik_chain   = -1;
+	}
+};
+
+/**
+ * VMDのエクスポートで使用するシーン情報.
+ */
+class CMotionSnapshot {
+public:
+	std::string modelName;						///< 形状名.
+	std::shared_ptr<const CSkeletonModel> skeleton;	///< ボーン構造 (PMDのエクスポートとキャッシュを共有).
+	std::vector<SNAPSHOT_MOTION_TRACK> tracks;	///< モーション (ボーンの順、続いてIK goal).
+
+private:
+	/**
+	 * 指定形状のモーションポイントを取得.
+	 */
+	void m_CaptureMotionPoints(sxsdk::shape_class* pShape, SNAPSHOT_MOTION_TRACK& track);
+
+public:
+	CMotionSnapshot();
+
+	void Clear();
+
+	/**
+	 * 指定のポリゴンメッシュに関連するボーンのモーションのスナップショットを取得.
+	 * メインスレッドから呼ぶこと.
+	 */
+	bool Capture(sxsdk::shade_interface& shade, sxsdk::scene_interface* scene, sxsdk::shape_class& shapeMesh);
+};
+
+namespace SceneSnapshot {
+	/**
+	 * エクスポートの開始時に、メインスレッドから呼ぶ.
+	 * 前回のエクスポートと異なるシーンの場合は、前のシーンのキャッシュ (SkeletonCache/StageCache) を破棄する.
+	 * ワーカースレッドで使用するボーン名の変換表 (CRigCtrl::PrepareNames) もここで準備する.
+	 */
+	void BeginExport(sxsdk::shade_interface& shade, sxsdk::scene_interface* scene);
+}
+
+#endif
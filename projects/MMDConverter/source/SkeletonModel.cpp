@@ -0,0 +1,225 @@
+﻿/**
+ *  @brief  PMD/VMDのエクスポートで共有する、ボーン構造のキャッシュ.
+ *  @date   2026.10.19
+ */
+
+#include "SkeletonModel.h"
+#include "RigCtrl.h"
+#include "Util.h"
+
+#include <map>
+#include <mutex>
+
+namespace {
+	/**
+	 * ボーンのルートのハンドルごとのキャッシュ.
+	 */
+	std::map<void *, std::shared_ptr<const CSkeletonModel> > g_skeletonCache;
+	std::mutex g_skeletonCacheMutex;
+
+	/**
+	 * 指定のボーンから再帰でたどり、ボーンの構造を取得.
+	 */
+	void GetBonesLoop(const int depth, const int parentIndex, sxsdk::shape_class* pBoneShape, std::vector<SKELETON_BONE>& bones, std::vector<sxsdk::shape_class *>& boneShapes)
+	{
+		if (!Util::IsBone(*pBoneShape)) return;
+
+		SKELETON_BONE bone;
+		bone.name         = pBoneShape->get_name();
+		bone.parent_index = parentIndex;
+		bone.depth        = depth;
+		bone.has_son      = pBoneShape->has_son();
+
+		const int curIndex = bones.size();
+		bones.push_back(bone);
+		boneShapes.push_back(pBoneShape);
+
+		if (pBoneShape->has_son()) {
+			sxsdk::shape_class* pShape = pBoneShape->get_son();
+			while (pShape->has_bro()) {
+				pShape = pShape->get_bro();
+				GetBonesLoop(depth + 1, curIndex, pShape, bones, boneShapes);
+			}
+		}
+	}
+
+	/**
+	 * IK Endを持つボーンごとに、IKの構成を取得.
+	 */
+	void GetIKChains(sxsdk::scene_interface* scene, sxsdk::shape_class& boneRoot, const std::vector<sxsdk::shape_class *>& boneShapes, std::vector<SKELETON_IK_CHAIN>& ikChains, std::vector<std::string>& rootNames, std::vector<sxsdk::shape_class *>& goalShapes)
+	{
+		try {
+			sxsdk::ik_class& ik = scene->get_ik();
+			if (ik.get_number_of_ik() == 0) return;
+
+			for (int i = 0; i < boneShapes.size(); i++) {
+				const int ikType = ik.has_ik(*boneShapes[i], false);
+				if (!(ikType & 0x02)) continue;
+
+				sxsdk::ik_data_class& ikData = ik.get_ik_data(*boneShapes[i]);
+				sxsdk::shape_class* ikRootShape = ikData.get_root_shape();
+				sxsdk::shape_class* ikEndShape  = ikData.get_end_shape();
+				sxsdk::shape_class* ikGoalShape = ikData.get_goal_shape();
+
+				SKELETON_IK_CHAIN chain;
+				chain.owner_bone = i;
+				chain.has_root   = (ikRootShape != NULL);
+				chain.has_end    = (ikEndShape != NULL);
+				chain.has_goal   = (ikGoalShape != NULL);
+				for (int j = 0; j < boneShapes.size(); j++) {
+					if (boneShapes[j] == ikRootShape && chain.root_bone < 0) chain.root_bone = j;
+					if (boneShapes[j] == ikEndShape && chain.end_bone < 0) chain.end_bone = j;
+				}
+
+				// 親をたどっていくと、ボーンのルートにたどり着く場合はツリー内.
+				if (ikGoalShape) {
+					chain.goal_name = ikGoalShape->get_name();
+					sxsdk::shape_class* pShape = ikGoalShape;
+					while (pShape->has_dad()) {
+						pShape = pShape->get_dad();
+						if ((pShape->get_handle()) == (boneRoot.get_handle())) {
+							chain.goal_in_tree = true;
+							break;
+						}
+					}
+				}
+
+				ikChains.push_back(chain);
+				rootNames.push_back(ikRootShape ? std::string(ikRootShape->get_name()) : std::string(""));
+				goalShapes.push_back(ikGoalShape);
+			}
+		} catch (...) { }
+	}
+
+	/**
+	 * ボーン構造のハッシュ値を計算.
+	 * シーンが切り替わった場合はキャッシュごと破棄されるため、シーンはキーに含めない.
+	 */
+	uint64_t CalcSkeletonKey(const std::vector<SKELETON_BONE>& bones, const std::vector<SKELETON_IK_CHAIN>& ikChains, const std::vector<std::string>& rootNames)
+	{
+		const int counts[2] = {(int)bones.size(), (int)ikChains.size()};
+		uint64_t hash = Util::CalcHash(counts, sizeof(counts));
+		for (int i = 0; i < bones.size(); i++) {
+			const SKELETON_BONE& bone = bones[i];
+			const int iDat[2] = {bone.parent_index, bone.has_son ? 1 : 0};
+			hash = Util::CalcHash(bone.name.c_str(), bone.name.length() + 1, hash);
+			hash = Util::CalcHash(iDat, sizeof(iDat), hash);
+		}
+		for (int i = 0; i < ikChains.size(); i++) {
+			const SKELETON_IK_CHAIN& chain = ikChains[i];
+			const int iDat[7] = {chain.owner_bone, chain.root_bone, chain.end_bone, chain.has_root ? 1 : 0, chain.has_end ? 1 : 0, chain.has_goal ? 1 : 0, chain.goal_in_tree ? 1 : 0};
+			hash = Util::CalcHash(iDat, sizeof(iDat), hash);
+			hash = Util::CalcHash(rootNames[i].c_str(), rootNames[i].length() + 1, hash);
+			hash = Util::CalcHash(chain.goal_name.c_str(), chain.goal_name.length() + 1, hash);
+		}
+		return hash;
+	}
+
+	/**
+	 * ボーン名の変換結果とリグの種類を計算して格納 (Shade 3Dを呼び出す).
+	 */
+	void StoreRigNames(sxsdk::shade_interface& shade, CSkeletonModel& skeleton, const std::vector<std::string>& rootNames)
+	{
+		// MMDのボーン名とどれくらい一致するか判定.
+		{
+			std::vector<std::string> bonesName;
+			bonesName.resize(skeleton.bones.size());
+			for (int i = 0; i < skeleton.bones.size(); i++) bonesName[i] = skeleton.bones[i].name;
+
+			CRigCtrl rigCtrl(&shade);
+			skeleton.rigNameCheck = rigCtrl.CheckMMDBones(bonesName, &skeleton.rigType);
+		}
+
+		// 人体リグの各命名規則でのボーン名.
+		for (int i = 0; i < skeleton.bones.size(); i++) {
+			SKELETON_BONE& bone = skeleton.bones[i];
+			bone.human_index = CRigCtrl::GetHumanBoneIndex(&shade, bone.name, skeleton.rigType);
+			if (bone.human_index >= 0) {
+				bone.name_jp = CRigCtrl::GetHumanBoneName(&shade, bone.human_index, human_rig_type_mmd_jp);
+				bone.name_en = CRigCtrl::GetHumanBoneName(&shade, bone.human_index, human_rig_type_mmd_en);
+			} else {
+				bone.name_jp = bone.name_en = bone.name;
+			}
+		}
+
+		// IK goalに対応するMMDのIK名.
+		for (int i = 0; i < skeleton.ikChains.size(); i++) {
+			SKELETON_IK_CHAIN& chain = skeleton.ikChains[i];
+			chain.root_name_ik = rootNames[i] + "_IK";
+
+			std::string ikRootName = rootNames[i];
+			std::string ikEndName  = skeleton.bones[chain.owner_bone].name_en;
+			const int index = CRigCtrl::GetHumanBoneIndex(&shade, ikRootName, skeleton.rigType);
+			if (index >= 0) {
+				ikRootName = CRigCtrl::GetHumanBoneName(&shade, index, human_rig_type_mmd_en);
+			}
+
+			int ikIndex = -1;
+			if (ikRootName.compare("leg_L") == 0 && ikEndName.compare("ankle_L") == 0) ikIndex = index_leg_IK_L;
+			if (ikRootName.compare("ankle_L") == 0 && ikEndName.compare("ankle_L2") == 0) ikIndex = index_toe_IK_L;
+			if (ikRootName.compare("leg_R") == 0 && ikEndName.compare("ankle_R") == 0) ikIndex = index_leg_IK_R;
+			if (ikRootName.compare("ankle_R") == 0 && ikEndName.compare("ankle_R2") == 0) ikIndex = index_toe_IK_R;
+			if (ikIndex >= 0) chain.goal_name_mmd = Util::GetUTF8Text(shade, leg_ik_name_jp[ikIndex]);
+		}
+	}
+}
+
+CSkeletonModel::CSkeletonModel()
+{
+	key          = 0;
+	rigNameCheck = 0.0f;
+	rigType      = human_rig_type_default;
+}
+
+/**
+ * 形状名からボーン番号を取得.
+ */
+int CSkeletonModel::FindBone(const std::string& name) const
+{
+	for (int i = 0; i < bones.size(); i++) {
+		if (bones[i].name == name) return i;
+	}
+	return -1;
+}
+
+/**
+ * 指定のボーンのルートに対応するCSkeletonModelを取得.
+ */
+std::shared_ptr<const CSkeletonModel> SkeletonCache::Get(sxsdk::shade_interface& shade, sxsdk::scene_interface* scene, sxsdk::shape_class& boneRoot, std::vector<sxsdk::shape_class *>* pRetBoneShapes, std::vector<sxsdk::shape_class *>* pRetGoalShapes)
+{
+	// ボーン構造をたどる (形状名とツリー構造のみで、文字コード変換は行わない).
+	std::shared_ptr<CSkeletonModel> skeleton(new CSkeletonModel());
+	std::vector<sxsdk::shape_class *> boneShapes;
+	std::vector<sxsdk::shape_class *> goalShapes;
+	std::vector<std::string> rootNames;
+	GetBonesLoop(0, -1, &boneRoot, skeleton->bones, boneShapes);
+	GetIKChains(scene, boneRoot, boneShapes, skeleton->ikChains, rootNames, goalShapes);
+	skeleton->key = CalcSkeletonKey(skeleton->bones, skeleton->ikChains, rootNames);
+
+	if (pRetBoneShapes) *pRetBoneShapes = boneShapes;
+	if (pRetGoalShapes) *pRetGoalShapes = goalShapes;
+
+	void* handle = boneRoot.get_handle();
+	{
+		std::lock_guard<std::mutex> lock(g_skeletonCacheMutex);
+		std::map<void *, std::shared_ptr<const CSkeletonModel> >::const_iterator iter = g_skeletonCache.find(handle);
+		if (iter != g_skeletonCache.end() && iter->second->key == skeleton->key) return iter->second;
+	}
+
+	// ボーン構造が変わった場合は、ボーン名の変換を行いキャッシュを置き換える.
+	StoreRigNames(shade, *skeleton, rootNames);
+	{
+		std::lock_guard<std::mutex> lock(g_skeletonCacheMutex);
+		g_skeletonCache[handle] = skeleton;
+	}
+	return skeleton;
+}
+
+/**
+ * キャッシュをすべて破棄.
+ */
+void SkeletonCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(g_skeletonCacheMutex);
+	g_skeletonCache.clear();
+}
@@ -0,0 +1,109 @@
+﻿/**
+ *  @brief  PMD/VMDのエクスポートで共有する、ボーン構造のキャッシュ.
+ *  @date   2026.10.19
+ */
+
+#ifndef _SKELETONMODEL_H
+#define _SKELETONMODEL_H
+
+#include "GlobalHeader.h"
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <stdint.h>
+
+/*
+	ボーンの並び順、人体リグの各命名規則でのボーン名、リグの種類、IKの構成は、
+	シーン上のボーン構造が変わらない限り同じ結果になる.
+	ボーンのルートごとにCSkeletonModelとして保持し、PMD/VMDのエクスポートで使い回す.
+	ボーンのツリーとIKの構成は照合のためにGetの呼び出しごとにたどり、
+	キャッシュにより省略されるのは、ボーン名の変換とリグの判定 (Shade 3Dのテキスト変換を伴う処理) のみ.
+	ボーンの位置やモーションはキャッシュに含めず、スナップショットの取得時に毎回取得する.
+*/
+
+/**
+ * ボーン.
+ */
+class SKELETON_BONE {
+public:
+	std::string name;				///< 形状名.
+	int parent_index;				///< 親ボーン番号 (ルートの場合は-1).
+	int depth;						///< ルートからの深さ.
+	bool has_son;					///< 子の形状を持つか.
+
+	int human_index;				///< 人体リグでのボーン番号 (対応しない場合は-1).
+	std::string name_jp;			///< MMDの日本語のボーン名 (対応しない場合は形状名).
+	std::string name_en;			///< MMDの英語のボーン名 (対応しない場合は形状名).
+
+	SKELETON_BONE() {
+		parent_index = -1;
+		depth        = 0;
+		has_son      = false;
+		human_index  = -1;
+	}
+};
+
+/**
+ * IK (IK Endを持つボーンごと).
+ */
+class SKELETON_IK_CHAIN {
+public:
+	int owner_bone;					///< IK Endを持つボーン番号.
+	int root_bone;					///< IK rootのボーン番号 (ないか、ボーンのツリーにない場合は-1).
+	int end_bone;					///< IK endのボーン番号 (ないか、ボーンのツリーにない場合は-1).
+	bool has_root;					///< IK rootの形状を持つか.
+	bool has_end;					///< IK endの形状を持つか.
+	bool has_goal;					///< goalの形状を持つか.
+	bool goal_in_tree;				///< goalがボーンのルートの下にあるか.
+
+	std::string goal_name;			///< goalの形状名.
+	std::string goal_name_mmd;		///< 足/つま先のIKの場合の、MMDの日本語のIK名 (それ以外は空).
+	std::string root_name_ik;		///< 人体リグに対応しない場合のIK名 (IK rootの形状名 + "_IK").
+
+	SKELETON_IK_CHAIN() {
+		owner_bone = root_bone = end_bone = -1;
+		has_root = has_end = has_goal = false;
+		goal_in_tree = false;
+	}
+};
+
+/**
+ * ボーンのルート以下の構造.
+ */
+class CSkeletonModel {
+public:
+	uint64_t key;								///< ボーン構造のハッシュ値 (キャッシュの照合に使用).
+	std::vector<SKELETON_BONE> bones;			///< ボーン (ルートから深さ優先の順).
+	std::vector<SKELETON_IK_CHAIN> ikChains;	///< IK.
+
+	float rigNameCheck;							///< MMDのボーン名とどれくらい一致するか (CRigCtrl::CheckMMDBones).
+	int rigType;								///< ボーン名の種類 (human_rig_type_default / human_rig_type_mmd_jp / human_rig_type_mmd_en).
+
+	CSkeletonModel();
+
+	/**
+	 * 形状名からボーン番号を取得.
+	 */
+	int FindBone(const std::string& name) const;
+};
+
+namespace SkeletonCache {
+	/**
+	 * 指定のボーンのルートに対応するCSkeletonModelを取得.
+	 * ボーンのツリーとIKは毎回たどり、ボーン構造が変わっていない場合はキャッシュ(ボーン名の変換結果)を返し、変わっている場合は作り直す.
+	 * メインスレッドから呼ぶこと.
+	 * @param[in]  scene             シーン.
+	 * @param[in]  boneRoot          ボーンのルート.
+	 * @param[out] pRetBoneShapes    ボーンの形状 (bonesの順).
+	 * @param[out] pRetGoalShapes    IK goalの形状 (ikChainsの順、ない場合はNULL).
+	 */
+	std::shared_ptr<const CSkeletonModel> Get(sxsdk::shade_interface& shade, sxsdk::scene_interface* scene, sxsdk::shape_class& boneRoot, std::vector<sxsdk::shape_class *>* pRetBoneShapes = NULL, std::vector<sxsdk::shape_class *>* pRetGoalShapes = NULL);
+
+	/**
+	 * キャッシュをすべて破棄.
+	 */
+	void Clear();
+}
+
+#endif
@@ -0,0 +1,109 @@
+﻿/**
+ *  @brief  変換ステージの出力キャッシュ (同一セッション内での再エクスポート用).
+ *  @date   2026.10.19
+ */
+
+#include "StageCache.h"
+
+#include <map>
+#include <list>
+#include <mutex>
+
+namespace {
+	/**
+	 * キャッシュの要素.
+	 */
+	typedef struct {
+		uint64_t key;
+		uint64_t lastUsed;						///< 最後に使用した順番 (g_useCounter).
+		std::vector<unsigned char> data;
+	} STAGE_CACHE_ENTRY;
+
+	typedef std::map< std::string, std::list<STAGE_CACHE_ENTRY> > STAGE_CACHE_MAP;
+
+	std::mutex g_mutex;
+	STAGE_CACHE_MAP g_stages;			///< ステージ名ごとのキャッシュ (先頭が最近使用したもの).
+	size_t g_totalSize = 0;				///< 保持している出力の合計バイト数.
+	uint64_t g_useCounter = 0;			///< 使用の順番.
+
+	/**
+	 * 合計サイズが上限以下になるまで、すべてのステージを通して最も古く使用したものから破棄 (g_mutexをロックして呼ぶ).
+	 * 各ステージの末尾が、そのステージで最も古く使用したもの.
+	 */
+	void TrimTotalSize() {
+		while (g_totalSize > STAGE_CACHE_MAX_TOTAL_SIZE) {
+			STAGE_CACHE_MAP::iterator oldestIt = g_stages.end();
+			for (STAGE_CACHE_MAP::iterator it = g_stages.begin(); it != g_stages.end(); ++it) {
+				if (it->second.empty()) continue;
+				if (oldestIt == g_stages.end() || it->second.back().lastUsed < oldestIt->second.back().lastUsed) oldestIt = it;
+			}
+			if (oldestIt == g_stages.end()) break;
+			g_totalSize -= oldestIt->second.back().data.size();
+			oldestIt->second.pop_back();
+		}
+	}
+}
+
+/**
+ * キャッシュを取得.
+ */
+bool StageCache::Load(const std::string& stageName, const uint64_t key, CBinaryBuffer& retBuffer)
+{
+	std::lock_guard<std::mutex> lock(g_mutex);
+
+	retBuffer.Clear();
+	std::map< std::string, std::list<STAGE_CACHE_ENTRY> >::iterator it = g_stages.find(stageName);
+	if (it == g_stages.end()) return false;
+
+	std::list<STAGE_CACHE_ENTRY>& entries = it->second;
+	for (std::list<STAGE_CACHE_ENTRY>::iterator eIt = entries.begin(); eIt != entries.end(); ++eIt) {
+		if (eIt->key != key) continue;
+		entries.splice(entries.begin(), entries, eIt);
+		entries.front().lastUsed = ++g_useCounter;
+		const std::vector<unsigned char>& data = entries.front().data;
+		if (!data.empty()) retBuffer.Write(data.size(), &(data[0]));
+		return true;
+	}
+	return false;
+}
+
+/**
+ * キャッシュに格納 (ステージごと、および合計サイズの上限を超えた分は古いものから破棄される).
+ */
+void StageCache::Store(const std::string& stageName, const uint64_t key, const CBinaryBuffer& buffer)
+{
+	std::lock_guard<std::mutex> lock(g_mutex);
+
+	std::list<STAGE_CACHE_ENTRY>& entries = g_stages[stageName];
+	for (std::list<STAGE_CACHE_ENTRY>::iterator eIt = entries.begin(); eIt != entries.end(); ++eIt) {
+		if (eIt->key == key) {
+			g_totalSize -= eIt->data.size();
+			entries.erase(eIt);
+			break;
+		}
+	}
+	if (buffer.GetSize() > STAGE_CACHE_MAX_TOTAL_SIZE) return;
+
+	STAGE_CACHE_ENTRY entry;
+	entry.key      = key;
+	entry.lastUsed = ++g_useCounter;
+	entries.push_front(entry);
+	if (buffer.GetSize() > 0) entries.front().data.assign(buffer.GetData(), buffer.GetData() + buffer.GetSize());
+	g_totalSize += buffer.GetSize();
+
+	while (entries.size() > STAGE_CACHE_ENTRIES_PER_STAGE) {
+		g_totalSize -= entries.back().data.size();
+		entries.pop_back();
+	}
+	TrimTotalSize();
+}
+
+/**
+ * すべてのキャッシュを破棄.
+ */
+void StageCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(g_mutex);
+	g_stages.clear();
+	g_totalSize = 0;
+}
@@ -0,0 +1,48 @@
+﻿/**
+ *  @brief  変換ステージの出力キャッシュ (同一セッション内での再エクスポート用).
+ *  @date   2026.10.19
+ */
+
+#ifndef _STAGECACHE_H
+#define _STAGECACHE_H
+
+#include "GlobalHeader.h"
+#include "BinaryBuffer.h"
+
+#include <stdint.h>
+#include <string>
+
+/*
+	SetModelの各ステージ(三角形分割、頂点の分割、表情の頂点対応付けなど)の出力を、
+	入力データのハッシュ値をキーとしてプラグインのプロセス内に保持する.
+	同じ形状を繰り返しエクスポートする場合、入力が変わっていないステージは再計算せずに結果を再利用する.
+	合計サイズがSTAGE_CACHE_MAX_TOTAL_SIZEを超える場合は、すべてのステージを通して最も古く使用したものから破棄する.
+	エクスポートするシーンが切り替わった場合は、SceneSnapshot::BeginExportからClearが呼ばれる.
+*/
+
+#define STAGE_CACHE_ENTRIES_PER_STAGE	8						///< ステージごとに保持する結果の数.
+#define STAGE_CACHE_MAX_TOTAL_SIZE		(256 * 1024 * 1024)		///< 保持する結果の合計の最大バイト数.
+
+namespace StageCache {
+	/**
+	 * キャッシュを取得.
+	 * @param[in]  stageName   ステージ名.
+	 * @param[in]  key         入力データのハッシュ値.
+	 * @param[out] retBuffer   格納されていた出力 (読み込み位置は先頭).
+	 * @return 見つからない場合はfalse.
+	 */
+	bool Load(const std::string& stageName, const uint64_t key, CBinaryBuffer& retBuffer);
+
+	/**
+	 * キャッシュに格納 (ステージごと、および合計サイズの上限を超えた分は古いものから破棄される).
+	 * 上限より大きい出力は格納しない.
+	 */
+	void Store(const std::string& stageName, const uint64_t key, const CBinaryBuffer& buffer);
+
+	/**
+	 * すべてのキャッシュを破棄.
+	 */
+	void Clear();
+}
+
+#endif
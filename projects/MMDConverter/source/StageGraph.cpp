@@ -0,0 +1,175 @@
+﻿/**
+ *  @brief  依存関係を持つ処理(ステージ)の並列実行.
+ *  @date   2026.10.19
+ */
+
+#include "StageGraph.h"
+
+#include <thread>
+
+CStageGraph::CStageGraph()
+{
+	m_queuedCount   = 0;
+	m_finishedCount = 0;
+	m_canceled      = false;
+	m_pPool         = NULL;
+	m_pProgress     = NULL;
+}
+
+CStageGraph::~CStageGraph()
+{
+}
+
+/**
+ * ステージを追加.
+ */
+int CStageGraph::AddStage(const STAGE_FUNC& func, const bool callerThread)
+{
+	STAGE_DATA stage;
+	stage.func         = func;
+	stage.callerThread = callerThread;
+	m_stages.push_back(stage);
+	return (int)m_stages.size() - 1;
+}
+
+/**
+ * 依存関係を追加.
+ */
+void CStageGraph::AddDependency(const int stage, const int dependStage)
+{
+	if (stage < 0 || stage >= m_stages.size()) return;
+	if (dependStage < 0 || dependStage >= stage) return;
+
+	m_stages[dependStage].dependents.push_back(stage);
+	m_stages[stage].dependCount++;
+}
+
+/**
+ * すべてのステージを実行し、完了するまで待つ.
+ */
+bool CStageGraph::Run(CThreadPool* pPool, CExportProgress* pProgress)
+{
+	const int stageCou = m_stages.size();
+	m_pPool         = pPool;
+	m_pProgress     = pProgress;
+	m_queuedCount   = 0;
+	m_finishedCount = 0;
+	m_canceled      = false;
+	m_error         = std::exception_ptr();
+	m_callerQueue.clear();
+
+	// プールがない場合は、登録順に逐次実行 (依存先は常に先に登録されている).
+	if (!pPool || pPool->GetThreadCount() <= 1) {
+		for (int i = 0; i < stageCou; i++) {
+			if (m_canceled) break;
+			if (pProgress && pProgress->IsCanceled()) {
+				m_canceled = true;
+				break;
+			}
+			m_stages[i].func();
+		}
+		return !m_canceled;
+	}
+
+	// 依存先のないステージから開始 (積んだ時点で実行され始めるため、先に一覧を作る).
+	std::vector<int> readyStages;
+	m_waitCount.resize(stageCou);
+	for (int i = 0; i < stageCou; i++) {
+		m_waitCount[i] = m_stages[i].dependCount;
+		if (m_waitCount[i] == 0) readyStages.push_back(i);
+	}
+	for (int i = 0; i < readyStages.size(); i++) m_PushStage(readyStages[i]);
+
+	while (true) {
+		int index = -1;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			if (m_finishedCount >= stageCou) break;
+			if (m_callerQueue.empty() && m_queuedCount == 0) {
+				m_cond.wait(lock, [this, stageCou]() { return m_finishedCount >= stageCou || !m_callerQueue.empty() || m_queuedCount > 0; });
+				if (m_finishedCount >= stageCou) break;
+			}
+			if (!m_callerQueue.empty()) {
+				index = m_callerQueue.front();
+				m_callerQueue.pop_front();
+			}
+		}
+
+		if (index >= 0) {
+			m_RunStage(index);
+		} else {
+			// プールに積んだステージの実行を手伝う.
+			if (!pPool->RunOne()) std::this_thread::yield();
+		}
+	}
+
+	m_pPool     = NULL;
+	m_pProgress = NULL;
+	if (m_error) std::rethrow_exception(m_error);
+	return !m_canceled;
+}
+
+/**
+ * ステージを、実行するスレッドに応じて積む.
+ */
+void CStageGraph::m_PushStage(const int index)
+{
+	if (m_stages[index].callerThread) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_callerQueue.push_back(index);
+		m_cond.notify_all();
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_queuedCount++;
+		m_cond.notify_all();
+	}
+	m_pPool->Submit([this, index]() {
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_queuedCount--;
+		}
+		m_RunStage(index);
+	});
+}
+
+/**
+ * ステージを実行し、依存するステージを実行可能にする.
+ * キャンセル後のステージは処理を行わずに完了扱いにする.
+ */
+void CStageGraph::m_RunStage(const int index)
+{
+	STAGE_DATA& stage = m_stages[index];
+
+	bool skip = false;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_canceled && m_pProgress && m_pProgress->IsCanceled()) m_canceled = true;
+		skip = m_canceled;
+	}
+	if (!skip) {
+		try {
+			stage.func();
+		} catch (...) {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (!m_error) m_error = std::current_exception();
+			m_canceled = true;
+		}
+	}
+
+	std::vector<int> readyStages;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (int i = 0; i < stage.dependents.size(); i++) {
+			const int dIndex = stage.dependents[i];
+			if (--m_waitCount[dIndex] == 0) readyStages.push_back(dIndex);
+		}
+	}
+	for (int i = 0; i < readyStages.size(); i++) m_PushStage(readyStages[i]);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_finishedCount++;
+	m_cond.notify_all();
+}
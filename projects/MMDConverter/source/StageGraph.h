@@ -0,0 +1,107 @@
+﻿/**
+ *  @brief  依存関係を持つ処理(ステージ)の並列実行.
+ *  @date   2026.10.19
+ */
+
+#ifndef _STAGEGRAPH_H
+#define _STAGEGRAPH_H
+
+#include "GlobalHeader.h"
+#include "ThreadPool.h"
+#include "ExportTask.h"
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+
+/*
+	ステージは、依存するステージがすべて完了した時点で実行可能になる.
+	依存先は自分より先に登録したステージのみ指定できるため、循環することはない.
+
+	Shade 3Dを呼び出すステージ (CExportTask::CallOnMainThreadを経由するもの) は、
+	callerThreadを指定して、Runの呼び出し元のスレッドで実行する.
+	それ以外のステージはスレッドプールのタスクとして実行する.
+
+	各ステージは互いに異なるデータを更新すること.
+	同じデータを扱うステージ間には依存関係を指定するため、実行の順序によらず結果は同じになる.
+	プールがNULLの場合は、登録順に逐次実行する.
+*/
+
+class CStageGraph
+{
+public:
+	typedef std::function<void()> STAGE_FUNC;
+
+private:
+	/**
+	 * ステージ情報.
+	 */
+	class STAGE_DATA {
+	public:
+		STAGE_FUNC func;					///< 処理.
+		bool callerThread;					///< Runの呼び出し元のスレッドで実行する.
+		std::vector<int> dependents;		///< このステージに依存するステージ.
+		int dependCount;					///< 依存するステージの数.
+
+		STAGE_DATA() {
+			callerThread = false;
+			dependCount  = 0;
+		}
+	};
+
+	std::vector<STAGE_DATA> m_stages;
+
+	// Runでの実行状態.
+	std::mutex m_mutex;
+	std::condition_variable m_cond;
+	std::vector<int> m_waitCount;			///< ステージごとの、完了を待っている依存先の数.
+	std::deque<int> m_callerQueue;			///< 呼び出し元のスレッドで実行するステージ.
+	int m_queuedCount;						///< プールに積んで、まだ開始していないステージ数.
+	int m_finishedCount;					///< 完了したステージ数.
+	bool m_canceled;						///< キャンセルまたは例外により、以降のステージを実行しない.
+	std::exception_ptr m_error;				///< ステージで発生した例外.
+	CThreadPool* m_pPool;
+	CExportProgress* m_pProgress;
+
+	/**
+	 * ステージを実行し、依存するステージを実行可能にする.
+	 */
+	void m_RunStage(const int index);
+
+	/**
+	 * ステージを、実行するスレッドに応じて積む.
+	 */
+	void m_PushStage(const int index);
+
+public:
+	CStageGraph();
+	virtual ~CStageGraph();
+
+	/**
+	 * ステージを追加.
+	 * @param[in] func           処理.
+	 * @param[in] callerThread   Runの呼び出し元のスレッドで実行する場合はtrue (Shade 3Dを呼び出すステージ).
+	 * @return ステージ番号.
+	 */
+	int AddStage(const STAGE_FUNC& func, const bool callerThread = false);
+
+	/**
+	 * 依存関係を追加 (stageはdependStageの完了後に実行される).
+	 * dependStageは、stageより先に追加したステージであること.
+	 */
+	void AddDependency(const int stage, const int dependStage);
+
+	/**
+	 * すべてのステージを実行し、完了するまで待つ.
+	 * ステージで例外が発生した場合は、実行中のステージの完了を待ってから再送出する.
+	 * @param[in] pPool       スレッドプール (NULLの場合は登録順に逐次実行).
+	 * @param[in] pProgress   キャンセルの確認用 (NULL可).
+	 * @return キャンセルされた場合はfalse.
+	 */
+	bool Run(CThreadPool* pPool, CExportProgress* pProgress = NULL);
+};
+
+#endif
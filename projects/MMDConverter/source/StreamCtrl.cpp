@@ -20,8 +20,9 @@ CPMDDlgInfo StreamCtrl::LoadPMDDlgInfo(sxsdk::shade_interface* shade)
 		stream->set_pointer(0);
 
 		int iDat = 0;
-		stream->read_int(iDat);
-		if (iDat != MMD_PMD_DLG_VERSION) return data;
+		int version = 0;
+		stream->read_int(version);
+		if (version < MMD_PMD_DLG_VERSION_100 || version > MMD_PMD_DLG_VERSION) return data;
 
 		stream->read_float(data.scale);
 
@@ -42,7 +43,57 @@ CPMDDlgInfo StreamCtrl::LoadPMDDlgInfo(sxsdk::shade_interface* shade)
 		data.note_jp = szStr;
 		stream->read(256, szStr);
 		data.note_en = szStr;
-		
+
+		if (version >= MMD_PMD_DLG_VERSION_101) {
+			stream->read_int(iDat);
+			data.mergeMaterials = iDat ? true : false;
+		}
+		if (version >= MMD_PMD_DLG_VERSION_102) {
+			stream->read_int(iDat);
+			data.textureAtlas = iDat ? true : false;
+		}
+		if (version >= MMD_PMD_DLG_VERSION_103) {
+			stream->read_int(iDat);
+			data.textureCache = iDat ? true : false;
+		}
+		if (version >= MMD_PMD_DLG_VERSION_104) {
+			stream->read_int(data.textureMaxSize);
+
+			stream->read_int(iDat);
+			data.texturePowerOfTwo = iDat ? true : false;
+		}
+		if (version >= MMD_PMD_DLG_VERSION_105) {
+			stream->read_int(iDat);
+			data.writeModelCache = iDat ? true : false;
+		}
+		if (version >= MMD_PMD_DLG_VERSION_106) {
+			stream->read_int(data.threadCount);
+		}
+		if (version >= MMD_PMD_DLG_VERSION_107) {
+			stream->read_int(iDat);
+			data.exportAllMeshes = iDat ? true : false;
+		}
+		if (version >= MMD_PMD_DLG_VERSION_108) {
+			stream->read_int(iDat);
+			data.mergeMeshes = iDat ? true : false;
+		}
+		if (version >= MMD_PMD_DLG_VERSION_109) {
+			stream->read_int(iDat);
+			data.generateNormals = iDat ? true : false;
+
+			stream->read_float(data.smoothingAngle);
+		}
+		if (version >= MMD_PMD_DLG_VERSION_10A) {
+			stream->read_int(iDat);
+			data.weldVertices = iDat ? true : false;
+
+			stream->read_float(data.weldNormalAngle);
+			stream->read_float(data.weldUVDistance);
+		}
+		if (version >= MMD_PMD_DLG_VERSION_10B) {
+			stream->read_int(iDat);
+			data.removeDuplicateMorphs = iDat ? true : false;
+		}
 	} catch (...) { }
 
 	return data;
@@ -93,6 +144,45 @@ void StreamCtrl::SavePMDDlgInfo(sxsdk::shade_interface* shade, const CPMDDlgInfo
 		}
 		stream->write(256, szStr);
 
+		iDat = data.mergeMaterials ? 1 : 0;
+		stream->write_int(iDat);
+
+		iDat = data.textureAtlas ? 1 : 0;
+		stream->write_int(iDat);
+
+		iDat = data.textureCache ? 1 : 0;
+		stream->write_int(iDat);
+
+		stream->write_int(data.textureMaxSize);
+
+		iDat = data.texturePowerOfTwo ? 1 : 0;
+		stream->write_int(iDat);
+
+		iDat = data.writeModelCache ? 1 : 0;
+		stream->write_int(iDat);
+
+		stream->write_int(data.threadCount);
+
+		iDat = data.exportAllMeshes ? 1 : 0;
+		stream->write_int(iDat);
+
+		iDat = data.mergeMeshes ? 1 : 0;
+		stream->write_int(iDat);
+
+		iDat = data.generateNormals ? 1 : 0;
+		stream->write_int(iDat);
+
+		stream->write_float(data.smoothingAngle);
+
+		iDat = data.weldVertices ? 1 : 0;
+		stream->write_int(iDat);
+
+		stream->write_float(data.weldNormalAngle);
+		stream->write_float(data.weldUVDistance);
+
+		iDat = data.removeDuplicateMorphs ? 1 : 0;
+		stream->write_int(iDat);
+
 	} catch (...) { }
 }
 
@@ -112,13 +202,19 @@ CVMDDlgInfo StreamCtrl::LoadVMDDlgInfo(sxsdk::shade_interface* shade)
 		stream->set_pointer(0);
 
 		int iDat = 0;
-		stream->read_int(iDat);
-		if (iDat != MMD_VMD_DLG_VERSION) return data;
+		int version = 0;
+		stream->read_int(version);
+		if (version < MMD_VMD_DLG_VERSION_100 || version > MMD_VMD_DLG_VERSION) return data;
 
 		stream->read_float(data.scale);
 
 		stream->read_int(iDat);
 		data.humanConvertBoneName = iDat ? true : false;
+
+		if (version >= MMD_VMD_DLG_VERSION_101) {
+			stream->read_int(iDat);
+			data.exportAllMeshes = iDat ? true : false;
+		}
 	} catch (...) { }
 
 	return data;
@@ -145,6 +241,9 @@ void StreamCtrl::SaveVMDDlgInfo(sxsdk::shade_interface* shade, const CVMDDlgInfo
 
 		iDat = data.humanConvertBoneName ? 1 : 0;
 		stream->write_int(iDat);
+
+		iDat = data.exportAllMeshes ? 1 : 0;
+		stream->write_int(iDat);
 	} catch (...) { }
 }
 
@@ -0,0 +1,275 @@
+﻿/**
+ *  @brief  テクスチャアトラスの作成 (スカイライン法でのパッキング).
+ *  @date   2026.10.19
+ */
+
+#include "TextureAtlas.h"
+
+#include <algorithm>
+
+namespace {
+	/**
+	 * 指定値以上の2の累乗値を取得.
+	 */
+	int GetPowerOfTwo(const int v) {
+		int size = 1;
+		while (size < v) size <<= 1;
+		return size;
+	}
+
+	/**
+	 * 配置順 (高さの大きい順) の比較用.
+	 */
+	class CTextureSortFunc {
+	private:
+		const std::vector<ATLAS_TEXTURE_DATA>& m_textures;
+	public:
+		CTextureSortFunc(const std::vector<ATLAS_TEXTURE_DATA>& textures) : m_textures(textures) { }
+		bool operator()(const int i0, const int i1) const {
+			const ATLAS_TEXTURE_DATA& t0 = m_textures[i0];
+			const ATLAS_TEXTURE_DATA& t1 = m_textures[i1];
+			if (t0.height != t1.height) return (t0.height > t1.height);
+			if (t0.width != t1.width) return (t0.width > t1.width);
+			return (i0 < i1);
+		}
+	};
+}
+
+//-------------------------------------------------------------.
+// CSkylinePacker.
+//-------------------------------------------------------------.
+CSkylinePacker::CSkylinePacker(const int width, const int height)
+{
+	m_width  = width;
+	m_height = height;
+	m_usedWidth  = 0;
+	m_usedHeight = 0;
+
+	SKYLINE_NODE node;
+	node.x     = 0;
+	node.y     = 0;
+	node.width = width;
+	m_skyline.push_back(node);
+}
+
+/**
+ * 指定のスカイライン位置に矩形を置いた場合の高さを取得 (置けない場合は-1).
+ */
+int CSkylinePacker::m_Fit(const int index, const int width, const int height)
+{
+	const int x = m_skyline[index].x;
+	if (x + width > m_width) return -1;
+
+	int widthLeft = width;
+	int i = index;
+	int y = m_skyline[index].y;
+	while (widthLeft > 0) {
+		if (i >= m_skyline.size()) return -1;
+		y = std::max(y, m_skyline[i].y);
+		if (y + height > m_height) return -1;
+		widthLeft -= m_skyline[i].width;
+		i++;
+	}
+	return y;
+}
+
+/**
+ * 矩形を格納.
+ */
+bool CSkylinePacker::Insert(const int width, const int height, int* pRetX, int* pRetY)
+{
+	if (width <= 0 || height <= 0) return false;
+
+	// 矩形の上端が最も低くなる位置を探す.
+	int bestIndex  = -1;
+	int bestBottom = m_height + 1;
+	int bestWidth  = m_width + 1;
+	int bestY      = 0;
+	for (int i = 0; i < m_skyline.size(); i++) {
+		const int y = m_Fit(i, width, height);
+		if (y < 0) continue;
+		if (y + height < bestBottom || (y + height == bestBottom && m_skyline[i].width < bestWidth)) {
+			bestIndex  = i;
+			bestBottom = y + height;
+			bestWidth  = m_skyline[i].width;
+			bestY      = y;
+		}
+	}
+	if (bestIndex < 0) return false;
+
+	SKYLINE_NODE newNode;
+	newNode.x     = m_skyline[bestIndex].x;
+	newNode.y     = bestY + height;
+	newNode.width = width;
+	m_skyline.insert(m_skyline.begin() + bestIndex, newNode);
+
+	// 新しいノードに隠れるノードを縮める.
+	for (int i = bestIndex + 1; i < m_skyline.size(); ) {
+		const SKYLINE_NODE& prev = m_skyline[i - 1];
+		SKYLINE_NODE& node = m_skyline[i];
+		if (node.x >= prev.x + prev.width) break;
+
+		const int shrink = (prev.x + prev.width) - node.x;
+		node.x     += shrink;
+		node.width -= shrink;
+		if (node.width > 0) break;
+		m_skyline.erase(m_skyline.begin() + i);
+	}
+
+	// 同じ高さで隣接するノードを結合.
+	for (int i = 0; i + 1 < m_skyline.size(); ) {
+		if (m_skyline[i].y == m_skyline[i + 1].y) {
+			m_skyline[i].width += m_skyline[i + 1].width;
+			m_skyline.erase(m_skyline.begin() + (i + 1));
+		} else {
+			i++;
+		}
+	}
+
+	*pRetX = newNode.x;
+	*pRetY = bestY;
+	m_usedWidth  = std::max(m_usedWidth, newNode.x + width);
+	m_usedHeight = std::max(m_usedHeight, bestY + height);
+
+	return true;
+}
+
+//-------------------------------------------------------------.
+// CTextureAtlas.
+//-------------------------------------------------------------.
+CTextureAtlas::CTextureAtlas()
+{
+}
+
+void CTextureAtlas::Clear()
+{
+	m_textures.clear();
+	m_atlases.clear();
+}
+
+/**
+ * テクスチャを追加.
+ * ピクセルは内部に移動するため、pixelsは空になる.
+ */
+int CTextureAtlas::AddTexture(const int width, const int height, std::vector<sx::rgba8_class>& pixels)
+{
+	ATLAS_TEXTURE_DATA texData;
+	m_textures.push_back(texData);
+
+	ATLAS_TEXTURE_DATA& tex = m_textures.back();
+	tex.width  = width;
+	tex.height = height;
+	tex.pixels.swap(pixels);
+
+	return m_textures.size() - 1;
+}
+
+/**
+ * テクスチャを配置し、アトラス画像を作成.
+ */
+int CTextureAtlas::Build(const int maxSize, CThreadPool* pPool)
+{
+	m_atlases.clear();
+	const int texCou = m_textures.size();
+	if (texCou == 0) return 0;
+
+	// 高さの大きい順に配置する.
+	std::vector<int> order;
+	order.resize(texCou);
+	for (int i = 0; i < texCou; i++) order[i] = i;
+	std::sort(order.begin(), order.end(), CTextureSortFunc(m_textures));
+
+	const int padding = TEXTURE_ATLAS_PADDING;
+	std::vector<CSkylinePacker> packers;
+	for (int loop = 0; loop < texCou; loop++) {
+		ATLAS_TEXTURE_DATA& tex = m_textures[order[loop]];
+		tex.atlas_index = -1;
+		const int w = tex.width  + padding * 2;
+		const int h = tex.height + padding * 2;
+		if (w > maxSize || h > maxSize) continue;
+
+		int x, y;
+		for (int i = 0; i < packers.size(); i++) {
+			if (packers[i].Insert(w, h, &x, &y)) {
+				tex.atlas_index = i;
+				break;
+			}
+		}
+		if (tex.atlas_index < 0) {
+			packers.push_back(CSkylinePacker(maxSize, maxSize));
+			if (!packers.back().Insert(w, h, &x, &y)) continue;
+			tex.atlas_index = packers.size() - 1;
+		}
+		tex.x = x + padding;
+		tex.y = y + padding;
+	}
+
+	// アトラスのサイズは、使用領域を包む2の累乗とする.
+	m_atlases.resize(packers.size());
+	for (int i = 0; i < packers.size(); i++) {
+		ATLAS_IMAGE_DATA& atlas = m_atlases[i];
+		atlas.width  = std::min(GetPowerOfTwo(packers[i].GetUsedWidth()), maxSize);
+		atlas.height = std::min(GetPowerOfTwo(packers[i].GetUsedHeight()), maxSize);
+
+		sx::rgba8_class col;
+		col.red = col.green = col.blue = col.alpha = 0;
+		atlas.pixels.resize(atlas.width * atlas.height, col);
+	}
+
+	// 配置された矩形は重ならないため、テクスチャ単位で並列に書き込む.
+	if (pPool) {
+		pPool->ParallelFor(0, texCou, [this](int index) { m_ComposeAtlas(index); });
+	} else {
+		for (int i = 0; i < texCou; i++) m_ComposeAtlas(i);
+	}
+
+	// 元のピクセルは不要になるため解放.
+	for (int i = 0; i < texCou; i++) {
+		std::vector<sx::rgba8_class>().swap(m_textures[i].pixels);
+	}
+
+	return m_atlases.size();
+}
+
+/**
+ * 指定のテクスチャのピクセルを、格納先のアトラスに書き込む.
+ * 余白部分は、テクスチャの端のピクセルを引き伸ばして埋める.
+ */
+void CTextureAtlas::m_ComposeAtlas(const int textureIndex)
+{
+	const ATLAS_TEXTURE_DATA& tex = m_textures[textureIndex];
+	if (tex.atlas_index < 0 || tex.width <= 0 || tex.height <= 0) return;
+	if (tex.pixels.size() < tex.width * tex.height) return;
+
+	ATLAS_IMAGE_DATA& atlas = m_atlases[tex.atlas_index];
+	const int padding = TEXTURE_ATLAS_PADDING;
+
+	for (int py = -padding; py < tex.height + padding; py++) {
+		const int dstY = tex.y + py;
+		if (dstY < 0 || dstY >= atlas.height) continue;
+		const int srcY = std::max(0, std::min(tex.height - 1, py));
+		const sx::rgba8_class* pSrc = &(tex.pixels[srcY * tex.width]);
+		sx::rgba8_class* pDst = &(atlas.pixels[dstY * atlas.width]);
+
+		for (int px = -padding; px < tex.width + padding; px++) {
+			const int dstX = tex.x + px;
+			if (dstX < 0 || dstX >= atlas.width) continue;
+			const int srcX = std::max(0, std::min(tex.width - 1, px));
+			pDst[dstX] = pSrc[srcX];
+		}
+	}
+}
+
+/**
+ * テクスチャ上のUVを、アトラス上のUVに変換.
+ */
+sxsdk::vec2 CTextureAtlas::ConvUV(const int textureIndex, const sxsdk::vec2& uv) const
+{
+	const ATLAS_TEXTURE_DATA& tex = m_textures[textureIndex];
+	if (tex.atlas_index < 0) return uv;
+	const ATLAS_IMAGE_DATA& atlas = m_atlases[tex.atlas_index];
+
+	const float u = ((float)tex.x + uv.x * (float)tex.width)  / (float)atlas.width;
+	const float v = ((float)tex.y + uv.y * (float)tex.height) / (float)atlas.height;
+	return sxsdk::vec2(u, v);
+}
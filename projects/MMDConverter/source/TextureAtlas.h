@@ -0,0 +1,129 @@
+﻿/**
+ *  @brief  テクスチャアトラスの作成 (スカイライン法でのパッキング).
+ *  @date   2026.10.19
+ */
+
+#ifndef _TEXTUREATLAS_H
+#define _TEXTUREATLAS_H
+
+#include "GlobalHeader.h"
+#include "ThreadPool.h"
+
+#include <vector>
+
+#define TEXTURE_ATLAS_MAX_SIZE		2048		///< アトラスの最大サイズ.
+#define TEXTURE_ATLAS_PADDING		2			///< テクスチャ間の余白(ピクセル).
+
+/**
+ * アトラスに格納するテクスチャ.
+ */
+class ATLAS_TEXTURE_DATA {
+public:
+	int width, height;							///< テクスチャサイズ.
+	std::vector<sx::rgba8_class> pixels;		///< ピクセル (width * height).
+
+	int atlas_index;							///< 格納先のアトラス番号.
+	int x, y;									///< アトラス上での左上位置 (余白を含まない).
+
+	ATLAS_TEXTURE_DATA() {
+		width = height = 0;
+		atlas_index = -1;
+		x = y = 0;
+	}
+};
+
+/**
+ * 作成されたアトラス画像.
+ */
+class ATLAS_IMAGE_DATA {
+public:
+	int width, height;							///< アトラスのサイズ.
+	std::vector<sx::rgba8_class> pixels;		///< ピクセル (width * height).
+
+	ATLAS_IMAGE_DATA() {
+		width = height = 0;
+	}
+};
+
+/**
+ * スカイライン法による矩形のパッキング.
+ */
+class CSkylinePacker
+{
+private:
+	typedef struct {
+		int x, y;			///< スカイラインの左端と高さ.
+		int width;			///< 幅.
+	} SKYLINE_NODE;
+
+	int m_width, m_height;
+	std::vector<SKYLINE_NODE> m_skyline;
+
+	int m_usedWidth, m_usedHeight;		///< 使用済み領域.
+
+	/**
+	 * 指定のスカイライン位置に矩形を置いた場合の高さを取得 (置けない場合は-1).
+	 */
+	int m_Fit(const int index, const int width, const int height);
+
+public:
+	CSkylinePacker(const int width, const int height);
+
+	/**
+	 * 矩形を格納.
+	 * @param[in]  width, height   矩形のサイズ.
+	 * @param[out] pRetX, pRetY    格納位置.
+	 * @return 格納できない場合はfalse.
+	 */
+	bool Insert(const int width, const int height, int* pRetX, int* pRetY);
+
+	int GetUsedWidth() const { return m_usedWidth; }
+	int GetUsedHeight() const { return m_usedHeight; }
+};
+
+/**
+ * テクスチャアトラスの作成クラス.
+ */
+class CTextureAtlas
+{
+private:
+	std::vector<ATLAS_TEXTURE_DATA> m_textures;		///< 格納するテクスチャ.
+	std::vector<ATLAS_IMAGE_DATA> m_atlases;		///< 作成されたアトラス.
+
+	/**
+	 * 指定のテクスチャのピクセルを、格納先のアトラスに書き込む.
+	 */
+	void m_ComposeAtlas(const int textureIndex);
+
+public:
+	CTextureAtlas();
+
+	void Clear();
+
+	/**
+	 * テクスチャを追加.
+	 * @return テクスチャ番号.
+	 */
+	int AddTexture(const int width, const int height, std::vector<sx::rgba8_class>& pixels);
+
+	/**
+	 * テクスチャを配置し、アトラス画像を作成 (ピクセルの書き込みはテクスチャごとに並列で処理).
+	 * @param[in] maxSize   アトラスの最大サイズ.
+	 * @param[in] pPool     書き込みに使用するスレッドプール (NULLの場合は逐次処理).
+	 * @return 作成されたアトラス数.
+	 */
+	int Build(const int maxSize = TEXTURE_ATLAS_MAX_SIZE, CThreadPool* pPool = NULL);
+
+	int GetTexturesCount() const { return m_textures.size(); }
+	const ATLAS_TEXTURE_DATA& GetTexture(const int index) const { return m_textures[index]; }
+
+	int GetAtlasesCount() const { return m_atlases.size(); }
+	const ATLAS_IMAGE_DATA& GetAtlas(const int index) const { return m_atlases[index]; }
+
+	/**
+	 * テクスチャ上のUVを、アトラス上のUVに変換.
+	 */
+	sxsdk::vec2 ConvUV(const int textureIndex, const sxsdk::vec2& uv) const;
+};
+
+#endif
@@ -0,0 +1,330 @@
+﻿/**
+ *  @brief  テクスチャのファイル出力 (スレッドプールでPNGにエンコードして保存).
+ *  @date   2026.10.19
+ */
+
+#include "TextureWriter.h"
+#include "ImageUtil.h"
+#include "Util.h"
+
+#include <string.h>
+#include <algorithm>
+
+CTextureCache::CTextureCache(const std::string& filePath, const bool useCache)
+{
+	m_filePath    = filePath;
+	m_useCache    = useCache;
+	m_changed     = false;
+	m_nameCounter = 0;
+
+	if (m_useCache) m_Load();
+}
+
+CTextureCache::~CTextureCache()
+{
+}
+
+/**
+ * 出力ファイルのフルパスを取得.
+ */
+std::string CTextureCache::GetFullPath(const std::string& fileName) const
+{
+#if SXWINDOWS
+	return m_filePath + "\\" + fileName;
+#else
+	return m_filePath + "/" + fileName;
+#endif
+}
+
+/**
+ * 指定のファイルのバイト数を取得 (存在しない場合は-1).
+ */
+long CTextureCache::GetFileSize(const std::string& fileName) const
+{
+	FILE* fp = Util::OpenFile(GetFullPath(fileName), "rb");
+	if (!fp) return -1;
+	fseek(fp, 0, SEEK_END);
+	const long size = ftell(fp);
+	fclose(fp);
+	return size;
+}
+
+/**
+ * キャッシュ情報を読み込み.
+ * 1行ごとに「ハッシュ値(16進数) 幅 高さ バイト数 ファイル名」が格納される.
+ */
+void CTextureCache::m_Load()
+{
+	m_cache.clear();
+
+	FILE* fp = Util::OpenFile(GetFullPath(TEXTURE_CACHE_FILE_NAME), "rb");
+	if (!fp) return;
+
+	char szLine[1024];
+	if (fgets(szLine, 1000, fp) && strncmp(szLine, "MMDTextureCache 1", 17) == 0) {
+		while (fgets(szLine, 1000, fp)) {
+			unsigned long long hash = 0;
+			int width = 0, height = 0, pos = 0;
+			long fileSize = 0;
+			if (sscanf(szLine, "%llx %d %d %ld %n", &hash, &width, &height, &fileSize, &pos) < 4 || pos <= 0) continue;
+
+			std::string name = szLine + pos;
+			while (name.length() > 0 && (name[name.length() - 1] == '\n' || name[name.length() - 1] == '\r')) name = name.substr(0, name.length() - 1);
+			if (name.length() == 0) continue;
+
+			TEXTURE_CACHE_DATA cData;
+			cData.hash      = (uint64_t)hash;
+			cData.width     = width;
+			cData.height    = height;
+			cData.file_size = fileSize;
+			m_cache[name] = cData;
+		}
+	}
+	fclose(fp);
+}
+
+/**
+ * キャッシュ情報を保存 (更新がない場合は何もしない).
+ */
+void CTextureCache::Save()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (!m_useCache || !m_changed) return;
+	m_changed = false;
+
+	FILE* fp = Util::OpenFile(GetFullPath(TEXTURE_CACHE_FILE_NAME), "wb");
+	if (!fp) return;
+	fprintf(fp, "MMDTextureCache 1\n");
+	for (std::map<std::string, TEXTURE_CACHE_DATA>::const_iterator it = m_cache.begin(); it != m_cache.end(); ++it) {
+		const TEXTURE_CACHE_DATA& cData = it->second;
+		fprintf(fp, "%016llx %d %d %ld %s\n", (unsigned long long)cData.hash, cData.width, cData.height, cData.file_size, it->first.c_str());
+	}
+	fclose(fp);
+}
+
+/**
+ * 他のテクスチャと重ならないファイル名を割り当てる.
+ */
+std::string CTextureCache::AssignFileName(const std::string& fileName, const uint64_t hash, const int width, const int height, std::vector<sx::rgba8_class>& pixels, std::shared_ptr< const std::vector<sx::rgba8_class> >& retPixels)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	// 同一のテクスチャが登録済みの場合は、そのファイルを参照する.
+	// ハッシュ値の衝突で別のテクスチャを参照しないように、サイズとピクセルも比較する.
+	typedef std::multimap<uint64_t, std::string>::const_iterator HASH_ITERATOR;
+	const std::pair<HASH_ITERATOR, HASH_ITERATOR> range = m_hashFileNames.equal_range(hash);
+	for (HASH_ITERATOR it = range.first; it != range.second; ++it) {
+		const TEXTURE_NAME_DATA& nameData = m_fileNames[it->second];
+		if (nameData.width != width || nameData.height != height || nameData.pixels->size() != pixels.size()) continue;
+		if (pixels.size() > 0 && memcmp(&((*nameData.pixels)[0]), &(pixels[0]), sizeof(sx::rgba8_class) * pixels.size()) != 0) continue;
+		std::vector<sx::rgba8_class>().swap(pixels);
+		retPixels = nameData.pixels;
+		return it->second;
+	}
+
+	std::string name = fileName;
+	if (name.length() == 0 || m_fileNames.find(name) != m_fileNames.end()) {
+		// テクスチャ名は20バイト以内.
+		char szName[64];
+		while (true) {
+			sprintf(szName, "tex_%d.png", m_nameCounter++);
+			if (m_fileNames.find(szName) == m_fileNames.end()) break;
+		}
+		name = szName;
+	}
+	std::shared_ptr< std::vector<sx::rgba8_class> > newPixels(new std::vector<sx::rgba8_class>());
+	newPixels->swap(pixels);
+
+	TEXTURE_NAME_DATA& nameData = m_fileNames[name];
+	nameData.hash   = hash;
+	nameData.width  = width;
+	nameData.height = height;
+	nameData.pixels = newPixels;
+	m_hashFileNames.insert(std::make_pair(hash, name));
+
+	retPixels = newPixels;
+	return name;
+}
+
+/**
+ * 指定のファイルの保存を開始する (他のCTextureWriterが保存を開始済みの場合はfalse).
+ */
+bool CTextureCache::BeginWrite(const std::string& fileName)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_writeFileNames.insert(fileName).second;
+}
+
+/**
+ * 指定のテクスチャが前回の出力から変わらず、ファイルが残っているか.
+ */
+bool CTextureCache::IsUpToDate(const std::string& fileName, const uint64_t hash, const int width, const int height, long* pRetFileSize)
+{
+	if (!m_useCache) return false;
+
+	TEXTURE_CACHE_DATA cData;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		std::map<std::string, TEXTURE_CACHE_DATA>::const_iterator it = m_cache.find(fileName);
+		if (it == m_cache.end()) return false;
+		cData = it->second;
+	}
+	if (cData.hash != hash || cData.width != width || cData.height != height) return false;
+	if (cData.file_size != GetFileSize(fileName)) return false;
+
+	*pRetFileSize = cData.file_size;
+	return true;
+}
+
+/**
+ * 保存したテクスチャの情報でキャッシュ情報を更新.
+ */
+void CTextureCache::Update(const std::string& fileName, const uint64_t hash, const int width, const int height, const long fileSize)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	TEXTURE_CACHE_DATA& cData = m_cache[fileName];
+	if (cData.hash == hash && cData.width == width && cData.height == height && cData.file_size == fileSize) return;
+	cData.hash      = hash;
+	cData.width     = width;
+	cData.height    = height;
+	cData.file_size = fileSize;
+	m_changed = true;
+}
+
+CTextureWriter::CTextureWriter(const std::string& filePath, const bool useCache, CThreadPool* pPool, CTextureCache* pSharedCache)
+{
+	m_pTaskGroup   = new CTaskGroup(pPool);
+	m_failedCount  = 0;
+	m_skippedCount = 0;
+	m_maxSize      = 0;
+	m_powerOfTwo   = false;
+
+	m_pCache   = pSharedCache ? pSharedCache : new CTextureCache(filePath, useCache);
+	m_ownCache = (pSharedCache == NULL);
+}
+
+CTextureWriter::~CTextureWriter()
+{
+	Wait();
+	delete m_pTaskGroup;
+	for (int i = 0; i < m_textures.size(); i++) delete m_textures[i];
+	m_textures.clear();
+	if (m_ownCache) delete m_pCache;
+}
+
+/**
+ * 保存時のリサイズ指定 (AddTextureの前に呼ぶこと).
+ */
+void CTextureWriter::SetResize(const int maxSize, const bool powerOfTwo)
+{
+	m_maxSize    = std::max(0, maxSize);
+	m_powerOfTwo = powerOfTwo;
+}
+
+/**
+ * テクスチャを登録 (この時点では保存しない).
+ */
+int CTextureWriter::AddTexture(const int width, const int height, std::vector<sx::rgba8_class>& pixels, const std::string& fileName)
+{
+	if (width <= 0 || height <= 0 || pixels.size() != (size_t)width * (size_t)height) return -1;
+
+	uint64_t hash = Util::CalcHash(&width, sizeof(int));
+	hash = Util::CalcHash(&height, sizeof(int), hash);
+	hash = Util::CalcHash(&(pixels[0]), sizeof(sx::rgba8_class) * pixels.size(), hash);
+
+	// リサイズ指定が変わった場合にキャッシュと一致しないように、指定もハッシュに含める.
+	if (m_maxSize > 0 || m_powerOfTwo) {
+		const int resizeParams[2] = { m_maxSize, m_powerOfTwo ? 1 : 0 };
+		hash = Util::CalcHash(resizeParams, sizeof(int) * 2, hash);
+	}
+
+	// ピクセルが同一のテクスチャを探す.
+	std::vector<int>& list = m_hashTextures[hash];
+	for (int i = 0; i < list.size(); i++) {
+		const TEXTURE_WRITER_DATA& tex = *(m_textures[list[i]]);
+		if (!tex.pixels || tex.width != width || tex.height != height || tex.pixels->size() != pixels.size()) continue;
+		if (memcmp(&((*tex.pixels)[0]), &(pixels[0]), sizeof(sx::rgba8_class) * pixels.size()) == 0) return list[i];
+	}
+
+	TEXTURE_WRITER_DATA* pTex = new TEXTURE_WRITER_DATA();
+	pTex->width     = width;
+	pTex->height    = height;
+	pTex->hash      = hash;
+	pTex->file_name = m_pCache->AssignFileName(fileName, hash, width, height, pixels, pTex->pixels);
+
+	const int index = m_textures.size();
+	m_textures.push_back(pTex);
+	list.push_back(index);
+
+	return index;
+}
+
+/**
+ * 指定のテクスチャの保存を開始 (保存済みの場合は何もしない).
+ */
+void CTextureWriter::Write(const int index)
+{
+	if (index < 0 || index >= m_textures.size()) return;
+	TEXTURE_WRITER_DATA* pTex = m_textures[index];
+	if (pTex->queued) return;
+	pTex->queued = true;
+
+	// 他のCTextureWriterが保存を開始したテクスチャ、またはキャッシュと一致しファイルが残っている場合は保存を省略.
+	long fileSize = 0;
+	if (!m_pCache->BeginWrite(pTex->file_name)) pTex->shared = true;
+	if (pTex->shared || m_pCache->IsUpToDate(pTex->file_name, pTex->hash, pTex->width, pTex->height, &fileSize)) {
+		pTex->written   = true;
+		pTex->file_size = fileSize;
+		pTex->pixels.reset();
+		m_skippedCount++;
+		return;
+	}
+
+	m_pTaskGroup->Run([this, pTex]() { m_EncodeTexture(pTex); });
+}
+
+/**
+ * 指定のテクスチャを保存.
+ */
+void CTextureWriter::m_EncodeTexture(TEXTURE_WRITER_DATA* pTex)
+{
+	// 指定に応じてリサイズしてから保存.
+	bool ret;
+	int width, height;
+	if (ImageUtil::CalcResizeSize(pTex->width, pTex->height, m_maxSize, m_powerOfTwo, &width, &height)) {
+		std::vector<sx::rgba8_class> pixels;
+		ImageUtil::Resize(pTex->width, pTex->height, &((*pTex->pixels)[0]), width, height, pixels);
+		pTex->pixels.reset();
+		ret = ImageUtil::SavePNG(m_pCache->GetFullPath(pTex->file_name), width, height, &(pixels[0]));
+	} else {
+		ret = ImageUtil::SavePNG(m_pCache->GetFullPath(pTex->file_name), pTex->width, pTex->height, &((*pTex->pixels)[0]));
+		pTex->pixels.reset();
+	}
+	const long fileSize = ret ? m_pCache->GetFileSize(pTex->file_name) : 0;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		pTex->written   = ret;
+		pTex->file_size = fileSize;
+		if (!ret) m_failedCount++;
+	}
+}
+
+/**
+ * すべての保存が完了するのを待つ.
+ */
+bool CTextureWriter::Wait()
+{
+	m_pTaskGroup->Wait();
+
+	// キャッシュ情報の更新は、このクラスで保存したテクスチャのみ.
+	for (int i = 0; i < m_textures.size(); i++) {
+		const TEXTURE_WRITER_DATA& tex = *(m_textures[i]);
+		if (tex.written && !tex.shared) m_pCache->Update(tex.file_name, tex.hash, tex.width, tex.height, tex.file_size);
+	}
+
+	// 共有しているキャッシュ情報は、共有元ですべての出力が終わってから一度だけ保存する.
+	if (m_ownCache) m_pCache->Save();
+
+	return (m_failedCount == 0);
+}
@@ -0,0 +1,247 @@
+﻿/**
+ *  @brief  テクスチャのファイル出力 (スレッドプールでPNGにエンコードして保存).
+ *  @date   2026.10.19
+ */
+
+#ifndef _TEXTUREWRITER_H
+#define _TEXTUREWRITER_H
+
+#include "GlobalHeader.h"
+#include "ThreadPool.h"
+
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include <map>
+#include <set>
+#include <mutex>
+#include <memory>
+
+#define TEXTURE_CACHE_FILE_NAME		"mmd_texture_cache.txt"		///< テクスチャのキャッシュ情報のファイル名.
+
+/**
+ * 出力するテクスチャ.
+ */
+class TEXTURE_WRITER_DATA {
+public:
+	int width, height;							///< テクスチャサイズ.
+	std::shared_ptr< const std::vector<sx::rgba8_class> > pixels;	///< ピクセル (width * height)。CTextureCacheと共有し、保存後は参照を外す.
+	uint64_t hash;								///< ピクセルのハッシュ値.
+	std::string file_name;						///< 出力ファイル名.
+
+	bool shared;								///< 同じキャッシュを共有する他のCTextureWriterが保存した.
+	bool queued;								///< 保存キューに積まれた.
+	bool written;								///< 保存に成功した (キャッシュにより保存を省略した場合も含む).
+	long file_size;								///< 保存したファイルのバイト数.
+
+	TEXTURE_WRITER_DATA() {
+		width = height = 0;
+		hash      = 0;
+		shared    = false;
+		queued    = false;
+		written   = false;
+		file_size = 0;
+	}
+};
+
+/**
+ * テクスチャのキャッシュ情報 (前回出力したテクスチャ).
+ */
+class TEXTURE_CACHE_DATA {
+public:
+	uint64_t hash;								///< ピクセルのハッシュ値.
+	int width, height;							///< テクスチャサイズ.
+	long file_size;								///< 出力ファイルのバイト数.
+
+	TEXTURE_CACHE_DATA() {
+		hash = 0;
+		width = height = 0;
+		file_size = 0;
+	}
+};
+
+/**
+ * 割り当て済みのファイル名に対応するテクスチャ.
+ */
+class TEXTURE_NAME_DATA {
+public:
+	uint64_t hash;								///< ピクセルのハッシュ値.
+	int width, height;							///< テクスチャサイズ.
+	std::shared_ptr< const std::vector<sx::rgba8_class> > pixels;	///< ピクセル (同一かの比較用).
+
+	TEXTURE_NAME_DATA() {
+		hash = 0;
+		width = height = 0;
+	}
+};
+
+/**
+ * 出力先のディレクトリでの、テクスチャのキャッシュ情報と使用済みのファイル名.
+ * 同じディレクトリに出力する複数のCTextureWriterで共有できる (一括出力で、モデルごとの変換を並列に行う場合).
+ * 共有した場合、ピクセルが同一のテクスチャには同じファイル名を割り当て、最初に保存を開始したCTextureWriterのみが保存する.
+ * 同一かの比較のため、割り当てたファイル名のピクセルはこのクラスを破棄するまで保持する.
+ */
+class CTextureCache
+{
+private:
+	std::string m_filePath;								///< 出力先のディレクトリ.
+	bool m_useCache;									///< キャッシュ情報を使用するか.
+
+	std::mutex m_mutex;
+	std::map<std::string, TEXTURE_CACHE_DATA> m_cache;	///< ファイル名に対応するキャッシュ情報.
+	bool m_changed;										///< キャッシュ情報が更新された.
+
+	std::map<std::string, TEXTURE_NAME_DATA> m_fileNames;	///< 使用済みのファイル名と、そのテクスチャ.
+	std::multimap<uint64_t, std::string> m_hashFileNames;	///< ハッシュ値に対応するファイル名 (ハッシュ値の衝突時は複数).
+	std::set<std::string> m_writeFileNames;				///< 保存を開始したファイル名.
+	int m_nameCounter;									///< 自動で割り当てるファイル名の番号.
+
+	/**
+	 * キャッシュ情報を読み込み.
+	 */
+	void m_Load();
+
+public:
+	/**
+	 * @param[in] filePath   出力先のディレクトリ.
+	 * @param[in] useCache   キャッシュ情報を使用して、変更のないテクスチャの保存を省略するか.
+	 */
+	CTextureCache(const std::string& filePath, const bool useCache);
+	virtual ~CTextureCache();
+
+	bool IsUseCache() const { return m_useCache; }
+
+	/**
+	 * 出力ファイルのフルパスを取得.
+	 */
+	std::string GetFullPath(const std::string& fileName) const;
+
+	/**
+	 * 指定のファイルのバイト数を取得 (存在しない場合は-1).
+	 */
+	long GetFileSize(const std::string& fileName) const;
+
+	/**
+	 * 他のテクスチャと重ならないファイル名を割り当てる.
+	 * ハッシュ値が一致し、サイズとピクセルも同一のテクスチャが登録済みの場合は、そのファイル名を返す.
+	 * ピクセルは出力が終わるまで保持し、同一かの比較に使用する.
+	 * @param[in]     fileName        出力ファイル名の候補。使用済みの場合は別名が割り当てられる.
+	 * @param[in]     hash            ピクセルのハッシュ値.
+	 * @param[in]     width, height   テクスチャサイズ.
+	 * @param[in/out] pixels          ピクセル。内部バッファと入れ替えるため、呼び出し後は空になる.
+	 * @param[out]    retPixels       ファイル名に対応するピクセル (同一のテクスチャが登録済みの場合は、そのピクセル).
+	 */
+	std::string AssignFileName(const std::string& fileName, const uint64_t hash, const int width, const int height, std::vector<sx::rgba8_class>& pixels, std::shared_ptr< const std::vector<sx::rgba8_class> >& retPixels);
+
+	/**
+	 * 指定のファイルの保存を開始する (他のCTextureWriterが保存を開始済みの場合はfalse).
+	 */
+	bool BeginWrite(const std::string& fileName);
+
+	/**
+	 * 指定のテクスチャが前回の出力から変わらず、ファイルが残っているか.
+	 */
+	bool IsUpToDate(const std::string& fileName, const uint64_t hash, const int width, const int height, long* pRetFileSize);
+
+	/**
+	 * 保存したテクスチャの情報でキャッシュ情報を更新.
+	 */
+	void Update(const std::string& fileName, const uint64_t hash, const int width, const int height, const long fileSize);
+
+	/**
+	 * キャッシュ情報を保存 (更新がない場合は何もしない).
+	 * 今回保存したテクスチャの情報で更新し、それ以外のテクスチャの情報は残す.
+	 */
+	void Save();
+};
+
+/**
+ * テクスチャの出力クラス.
+ * ピクセルの内容が同一のテクスチャは1つにまとめ、一度だけ保存する.
+ * AddTextureは1つのスレッドから呼び、エンコードと保存はスレッドプールのタスクとして行う.
+ * キャッシュを使用する場合は、出力先に前回出力したテクスチャの一覧(TEXTURE_CACHE_FILE_NAME)を保持し、
+ * ピクセルが同一でファイルが残っているテクスチャは保存を省略する.
+ */
+class CTextureWriter
+{
+private:
+	std::vector<TEXTURE_WRITER_DATA *> m_textures;		///< 登録されたテクスチャ.
+	std::map< uint64_t, std::vector<int> > m_hashTextures;	///< ハッシュ値に対応するテクスチャ番号.
+
+	CTaskGroup* m_pTaskGroup;							///< 保存タスク (完了の待機用).
+	std::mutex m_mutex;
+	int m_failedCount;									///< 保存に失敗した数.
+
+	CTextureCache* m_pCache;							///< キャッシュ情報と使用済みのファイル名.
+	bool m_ownCache;									///< m_pCacheをこのクラスで破棄するか.
+	int m_skippedCount;									///< キャッシュにより保存を省略した数.
+
+	int m_maxSize;										///< 保存時の最大サイズ (0の場合は制限なし).
+	bool m_powerOfTwo;									///< 保存時にサイズを2の累乗にする.
+
+	/**
+	 * 指定のテクスチャを、指定に応じてリサイズしてPNGで保存 (スレッドプールから呼ばれる).
+	 */
+	void m_EncodeTexture(TEXTURE_WRITER_DATA* pTex);
+
+public:
+	/**
+	 * @param[in] filePath       出力先のディレクトリ.
+	 * @param[in] useCache       キャッシュを使用して、変更のないテクスチャの保存を省略するか.
+	 * @param[in] pPool          保存に使用するスレッドプール (NULLの場合はWriteの時点で保存する).
+	 *                           プールはこのクラスより後に破棄すること.
+	 * @param[in] pSharedCache   他のCTextureWriterと共有するキャッシュ (NULLの場合はfilePath/useCacheから作成).
+	 *                           指定した場合はfilePath/useCacheは使用しない。このクラスより後に破棄すること.
+	 */
+	CTextureWriter(const std::string& filePath, const bool useCache = false, CThreadPool* pPool = NULL, CTextureCache* pSharedCache = NULL);
+	virtual ~CTextureWriter();
+
+	/**
+	 * テクスチャを登録 (この時点では保存しない).
+	 * ピクセルが同一のテクスチャが登録済みの場合は、そのテクスチャ番号を返す.
+	 * @param[in]     width, height   テクスチャサイズ.
+	 * @param[in/out] pixels          ピクセル。内部バッファと入れ替えるため、呼び出し後は空になる.
+	 * @param[in]     fileName        出力ファイル名の候補。使用済みの場合は別名が割り当てられる.
+	 * @return テクスチャ番号.
+	 */
+	int AddTexture(const int width, const int height, std::vector<sx::rgba8_class>& pixels, const std::string& fileName);
+
+	/**
+	 * 保存時のリサイズ指定 (AddTextureの前に呼ぶこと).
+	 * リサイズは保存時にスレッドプールで行われる。登録したピクセルは元のサイズのまま.
+	 * @param[in] maxSize      縦横の最大サイズ (0の場合は制限なし).
+	 * @param[in] powerOfTwo   縦横それぞれを、近い2の累乗にする.
+	 */
+	void SetResize(const int maxSize, const bool powerOfTwo);
+
+	int GetTexturesCount() const { return m_textures.size(); }
+
+	/**
+	 * テクスチャ情報を取得 (ピクセルはWriteを呼ぶまで参照可能).
+	 */
+	const TEXTURE_WRITER_DATA& GetTexture(const int index) const { return *(m_textures[index]); }
+
+	/**
+	 * 指定のテクスチャの保存を開始 (保存済み、またはキャッシュと一致する場合は何もしない).
+	 */
+	void Write(const int index);
+
+	/**
+	 * キャッシュにより保存を省略したテクスチャ数.
+	 */
+	int GetSkippedCount() const { return m_skippedCount; }
+
+	/**
+	 * 保存に失敗したテクスチャ数 (Waitの後に参照すること).
+	 */
+	int GetFailedCount() const { return m_failedCount; }
+
+	/**
+	 * すべての保存が完了するのを待ち、キャッシュ情報を更新する.
+	 * 共有したキャッシュの場合、キャッシュ情報の保存(CTextureCache::Save)は呼び出し側で行う.
+	 * @return 保存に失敗したテクスチャがある場合はfalse.
+	 */
+	bool Wait();
+};
+
+#endif
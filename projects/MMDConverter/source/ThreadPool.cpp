@@ -0,0 +1,277 @@
+﻿/**
+ *  @brief  ワーカースレッドのプール (work stealing) と並列処理.
+ *  @date   2026.10.19
+ */
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace {
+	// 現在のスレッドが属するプールとワーカー番号.
+	thread_local const CThreadPool* g_pCurrentPool = NULL;
+	thread_local int g_currentWorkerIndex = -1;
+}
+
+CThreadPool::CThreadPool(const int threadCount) : m_pendingCount(0), m_nextQueue(0), m_stop(false)
+{
+	int cou = threadCount;
+	if (cou <= 0) cou = std::max(1, (int)std::thread::hardware_concurrency());
+
+	const int workerCou = cou - 1;
+	for (int i = 0; i < workerCou; i++) m_queues.push_back(new WORKER_QUEUE());
+	for (int i = 0; i < workerCou; i++) {
+		m_threads.push_back(std::thread(&CThreadPool::m_WorkerLoop, this, i));
+	}
+}
+
+CThreadPool::~CThreadPool()
+{
+	// 残っているタスクはワーカーが実行してから終了する.
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+		m_stop = true;
+	}
+	m_wakeCond.notify_all();
+	for (int i = 0; i < m_threads.size(); i++) m_threads[i].join();
+	m_threads.clear();
+
+	for (int i = 0; i < m_queues.size(); i++) delete m_queues[i];
+	m_queues.clear();
+}
+
+/**
+ * 現在のスレッドが、このプールのワーカーの場合はその番号を返す.
+ */
+int CThreadPool::m_GetCurrentWorkerIndex() const
+{
+	return (g_pCurrentPool == this) ? g_currentWorkerIndex : -1;
+}
+
+/**
+ * タスクを積む.
+ */
+void CThreadPool::Submit(const TASK& task)
+{
+	if (m_queues.empty()) {
+		task();
+		return;
+	}
+
+	// ワーカーからはそのワーカーのキューに、それ以外からは順番に各キューに積む.
+	int index = m_GetCurrentWorkerIndex();
+	if (index < 0) index = (int)(m_nextQueue++ % (unsigned int)m_queues.size());
+	{
+		std::lock_guard<std::mutex> lock(m_queues[index]->mutex);
+		m_queues[index]->tasks.push_back(task);
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+		m_pendingCount++;
+	}
+	m_wakeCond.notify_one();
+}
+
+/**
+ * タスクを1つ取り出す.
+ */
+bool CThreadPool::m_PopTask(const int workerIndex, TASK& retTask)
+{
+	const int qCou = m_queues.size();
+	if (qCou == 0 || m_pendingCount.load() <= 0) return false;
+
+	// 自分のキューの末尾から.
+	if (workerIndex >= 0) {
+		WORKER_QUEUE* pQueue = m_queues[workerIndex];
+		std::lock_guard<std::mutex> lock(pQueue->mutex);
+		if (!pQueue->tasks.empty()) {
+			retTask = pQueue->tasks.back();
+			pQueue->tasks.pop_back();
+			m_pendingCount--;
+			return true;
+		}
+	}
+
+	// 他のキューの先頭から.
+	const int start = (workerIndex >= 0) ? (workerIndex + 1) : 0;
+	for (int i = 0; i < qCou; i++) {
+		const int index = (start + i) % qCou;
+		if (index == workerIndex) continue;
+		WORKER_QUEUE* pQueue = m_queues[index];
+		std::lock_guard<std::mutex> lock(pQueue->mutex);
+		if (!pQueue->tasks.empty()) {
+			retTask = pQueue->tasks.front();
+			pQueue->tasks.pop_front();
+			m_pendingCount--;
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * 積まれているタスクを1つ実行.
+ */
+bool CThreadPool::RunOne()
+{
+	TASK task;
+	if (!m_PopTask(m_GetCurrentWorkerIndex(), task)) return false;
+	task();
+	return true;
+}
+
+/**
+ * ワーカースレッドの処理.
+ */
+void CThreadPool::m_WorkerLoop(const int workerIndex)
+{
+	g_pCurrentPool        = this;
+	g_currentWorkerIndex  = workerIndex;
+
+	TASK task;
+	while (true) {
+		if (m_PopTask(workerIndex, task)) {
+			task();
+			task = TASK();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_wakeMutex);
+		if (m_pendingCount.load() > 0) continue;
+		if (m_stop) break;
+		m_wakeCond.wait(lock, [this]() { return m_stop || m_pendingCount.load() > 0; });
+	}
+
+	g_pCurrentPool       = NULL;
+	g_currentWorkerIndex = -1;
+}
+
+/**
+ * [begin, end)の分割サイズと分割数を求める.
+ */
+void CThreadPool::CalcChunks(const int begin, const int end, const int minChunkSize, int* pRetChunkSize, int* pRetChunkCount)
+{
+	const int cou = std::max(0, end - begin);
+	int chunkSize = std::max(1, minChunkSize);
+	chunkSize = std::max(chunkSize, (cou + THREAD_POOL_CHUNK_COUNT - 1) / THREAD_POOL_CHUNK_COUNT);
+	*pRetChunkSize  = chunkSize;
+	*pRetChunkCount = (cou + chunkSize - 1) / chunkSize;
+}
+
+/**
+ * [begin, end)を連続した範囲に分け、func(chunkBegin, chunkEnd)を並列に呼ぶ.
+ */
+void CThreadPool::ParallelForRange(const int begin, const int end, const std::function<void(int, int)>& func, const int minChunkSize)
+{
+	int chunkSize, chunkCou;
+	CalcChunks(begin, end, minChunkSize, &chunkSize, &chunkCou);
+	if (chunkCou == 0) return;
+	if (chunkCou == 1 || m_queues.empty()) {
+		func(begin, end);
+		return;
+	}
+
+	CTaskGroup group(this);
+	for (int i = 1; i < chunkCou; i++) {
+		const int b = begin + i * chunkSize;
+		const int e = std::min(end, b + chunkSize);
+		group.Run([&func, b, e]() { func(b, e); });
+	}
+	func(begin, std::min(end, begin + chunkSize));		// 先頭の範囲は呼び出し元で実行.
+	group.Wait();
+}
+
+/**
+ * [begin, end)の各要素でfunc(i)を並列に呼ぶ.
+ */
+void CThreadPool::ParallelFor(const int begin, const int end, const std::function<void(int)>& func, const int minChunkSize)
+{
+	ParallelForRange(begin, end, [&func](int b, int e) {
+		for (int i = b; i < e; i++) func(i);
+	}, minChunkSize);
+}
+
+/*****************************************************/
+
+CTaskGroup::CTaskGroup(CThreadPool* pPool) : m_pPool(pPool), m_runningCount(0)
+{
+}
+
+CTaskGroup::~CTaskGroup()
+{
+	// 例外による巻き戻し中にも呼ばれるため、ここでは投げ直さない.
+	m_WaitTasks();
+}
+
+/**
+ * タスクを積む.
+ */
+void CTaskGroup::Run(const CThreadPool::TASK& task)
+{
+	if (!m_pPool) {
+		// プールを使う場合と同じく、例外はWaitで投げ直す.
+		try {
+			task();
+		} catch (...) {
+			m_StoreError(std::current_exception());
+		}
+		return;
+	}
+
+	m_runningCount++;
+	m_pPool->Submit([this, task]() {
+		try {
+			task();
+		} catch (...) {
+			m_StoreError(std::current_exception());
+		}
+
+		// 待機側がロックを取得するまで、このグループは破棄されない.
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (--m_runningCount == 0) m_doneCond.notify_all();
+	});
+}
+
+/**
+ * 発生した例外を保持 (最初の例外のみ).
+ */
+void CTaskGroup::m_StoreError(const std::exception_ptr& error)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (!m_error) m_error = error;
+}
+
+/**
+ * すべてのタスクの完了を待つ (例外は投げ直さない).
+ */
+void CTaskGroup::m_WaitTasks()
+{
+	if (!m_pPool) return;
+
+	while (true) {
+		if (m_runningCount.load() > 0 && m_pPool->RunOne()) continue;
+
+		// 実行できるタスクがない場合は、最後のタスクの完了通知まで待機する.
+		// 実行中のタスクが新たにタスクを積む場合に備え、一定時間ごとに起きてプールを確認する.
+		std::unique_lock<std::mutex> lock(m_mutex);
+		if (m_runningCount.load() == 0) break;
+		m_doneCond.wait_for(lock, std::chrono::milliseconds(2), [this]() { return m_runningCount.load() == 0; });
+		if (m_runningCount.load() == 0) break;
+	}
+}
+
+/**
+ * すべてのタスクの完了を待ち、タスクで発生した例外を投げ直す.
+ */
+void CTaskGroup::Wait()
+{
+	m_WaitTasks();
+
+	std::exception_ptr error;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		error.swap(m_error);
+	}
+	if (error) std::rethrow_exception(error);
+}
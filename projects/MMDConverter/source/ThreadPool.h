@@ -0,0 +1,172 @@
+﻿/**
+ *  @brief  ワーカースレッドのプール (work stealing) と並列処理.
+ *  @date   2026.10.19
+ */
+
+#ifndef _THREADPOOL_H
+#define _THREADPOOL_H
+
+#include "GlobalHeader.h"
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <exception>
+
+/*
+	エクスポートごとに作成し、エクスポートの終了時に破棄する.
+
+	各ワーカーは自分のキューを持ち、自分のキューの末尾からタスクを取り出す.
+	自分のキューが空の場合は、他のワーカーのキューの先頭からタスクを取る(work stealing).
+	CTaskGroup::Waitで待っているスレッドも、タスクの実行を手伝う.
+
+	ParallelFor/ParallelReduceの分割はスレッド数に依存しないため、
+	結果(格納順や浮動小数点の加算順)はスレッド数によらず同じになる.
+*/
+
+#define THREAD_POOL_CHUNK_COUNT		64		///< ParallelFor/ParallelReduceでの最大分割数.
+
+class CThreadPool
+{
+public:
+	typedef std::function<void()> TASK;
+
+private:
+	/**
+	 * ワーカーごとのタスクキュー.
+	 */
+	class WORKER_QUEUE {
+	public:
+		std::mutex mutex;
+		std::deque<TASK> tasks;
+	};
+
+	std::vector<WORKER_QUEUE *> m_queues;			///< ワーカーごとのキュー.
+	std::vector<std::thread> m_threads;				///< ワーカースレッド.
+
+	std::mutex m_wakeMutex;
+	std::condition_variable m_wakeCond;
+	std::atomic<int> m_pendingCount;				///< キューに積まれているタスク数.
+	std::atomic<unsigned int> m_nextQueue;			///< ワーカー以外から積む場合のキュー番号.
+	bool m_stop;									///< 終了要求.
+
+	/**
+	 * ワーカースレッドの処理.
+	 */
+	void m_WorkerLoop(const int workerIndex);
+
+	/**
+	 * タスクを1つ取り出す (自分のキューの末尾、なければ他のキューの先頭から).
+	 * @param[in] workerIndex   呼び出し元のワーカー番号 (ワーカー以外の場合は-1).
+	 */
+	bool m_PopTask(const int workerIndex, TASK& retTask);
+
+	/**
+	 * 現在のスレッドが、このプールのワーカーの場合はその番号を返す (それ以外は-1).
+	 */
+	int m_GetCurrentWorkerIndex() const;
+
+public:
+	/**
+	 * @param[in] threadCount   呼び出し元のスレッドを含めた並列数 (0の場合はCPUのコア数).
+	 *                          1の場合はワーカースレッドを作成せず、すべて呼び出し元で実行する.
+	 */
+	CThreadPool(const int threadCount = 0);
+	virtual ~CThreadPool();
+
+	/**
+	 * 呼び出し元のスレッドを含めた並列数.
+	 */
+	int GetThreadCount() const { return (int)m_threads.size() + 1; }
+
+	/**
+	 * タスクを積む (完了を待つ場合はCTaskGroupを使用すること).
+	 */
+	void Submit(const TASK& task);
+
+	/**
+	 * 積まれているタスクを1つ実行 (待機中のスレッドが手伝う場合に使用).
+	 * @return 実行するタスクがなかった場合はfalse.
+	 */
+	bool RunOne();
+
+	/**
+	 * [begin, end)を最大THREAD_POOL_CHUNK_COUNT個の連続した範囲に分け、func(chunkBegin, chunkEnd)を並列に呼ぶ.
+	 * @param[in] minChunkSize   1つの範囲の最小要素数.
+	 */
+	void ParallelForRange(const int begin, const int end, const std::function<void(int, int)>& func, const int minChunkSize = 1);
+
+	/**
+	 * [begin, end)の各要素でfunc(i)を並列に呼ぶ.
+	 */
+	void ParallelFor(const int begin, const int end, const std::function<void(int)>& func, const int minChunkSize = 1);
+
+	/**
+	 * [begin, end)を分割してfunc(chunkBegin, chunkEnd)で部分的な結果を求め、範囲の順にcombineでまとめる.
+	 * 分割はスレッド数に依存しないため、結果は常に同じになる.
+	 */
+	template<typename T> T ParallelReduce(const int begin, const int end, const T& identity, const std::function<T(int, int)>& func, const std::function<T(const T&, const T&)>& combine, const int minChunkSize = 1) {
+		int chunkSize, chunkCou;
+		CalcChunks(begin, end, minChunkSize, &chunkSize, &chunkCou);
+		std::vector<T> results(chunkCou, identity);
+		ParallelFor(0, chunkCou, [&](int chunk) {
+			const int b = begin + chunk * chunkSize;
+			results[chunk] = func(b, std::min(end, b + chunkSize));
+		});
+		T ret = identity;
+		for (int i = 0; i < chunkCou; i++) ret = combine(ret, results[i]);
+		return ret;
+	}
+
+	/**
+	 * [begin, end)の分割サイズと分割数を求める.
+	 */
+	static void CalcChunks(const int begin, const int end, const int minChunkSize, int* pRetChunkSize, int* pRetChunkCount);
+};
+
+/**
+ * タスクのグループ。Runで積んだタスクの完了をWaitで待つ.
+ * プールがNULLの場合は、Runの時点で呼び出し元で実行する.
+ * タスクで例外が発生した場合は (プールがNULLの場合も)、最初の例外をWaitで投げ直す.
+ */
+class CTaskGroup
+{
+private:
+	CThreadPool* m_pPool;
+	std::atomic<int> m_runningCount;		///< 完了していないタスク数.
+	std::mutex m_mutex;						///< m_runningCountの減算とm_errorの保護.
+	std::condition_variable m_doneCond;		///< 最後のタスクの完了を通知.
+	std::exception_ptr m_error;				///< タスクで発生した最初の例外.
+
+	/**
+	 * 発生した例外を保持 (最初の例外のみ).
+	 */
+	void m_StoreError(const std::exception_ptr& error);
+
+	/**
+	 * すべてのタスクの完了を待つ (例外は投げ直さない).
+	 */
+	void m_WaitTasks();
+
+public:
+	CTaskGroup(CThreadPool* pPool);
+	virtual ~CTaskGroup();
+
+	/**
+	 * タスクを積む.
+	 */
+	void Run(const CThreadPool::TASK& task);
+
+	/**
+	 * すべてのタスクの完了を待つ.
+	 * 待っている間はプールのタスクを実行し、実行できるタスクがない場合は完了の通知まで待機する.
+	 * タスクで例外が発生していた場合は、すべての完了後に投げ直す.
+	 */
+	void Wait();
+};
+
+#endif
@@ -4,13 +4,21 @@
  */
 
 #include "Util.h"
+#include "ExportTask.h"
+
+#if SXWINDOWS
+#include <windows.h>
+#endif
 
 /**
  * テキストをSJISに変換.
  */
 std::string Util::ConvUTF8ToSJIS(sxsdk::shade_interface& shade, const std::string str)
 {
-	std::string str2 = shade.encode(str.c_str(), sxsdk::enums::shift_jis_encoding);
+	std::string str2;
+	CExportTask::CallOnMainThread([&]() {
+		str2 = shade.encode(str.c_str(), sxsdk::enums::shift_jis_encoding);
+	});
 	return str2;
 }
 
@@ -19,7 +27,10 @@ std::string Util::ConvUTF8ToSJIS(sxsdk::shade_interface& shade, const std::strin
  */
 std::string Util::ConvSJISToUTF8(sxsdk::shade_interface& shade, const std::string str)
 {
-	std::string str2 = shade.decode(str.c_str(), sxsdk::enums::shift_jis_encoding);
+	std::string str2;
+	CExportTask::CallOnMainThread([&]() {
+		str2 = shade.decode(str.c_str(), sxsdk::enums::shift_jis_encoding);
+	});
 	return str2;
 }
 
@@ -71,6 +82,48 @@ std::string Util::GetFileNameToStream(sxsdk::stream_interface* stream)
 	return name;
 }
 
+/**
+ * streamより、出力先のディレクトリを取得.
+ */
+std::string Util::GetDirectoryToStream(sxsdk::stream_interface* stream)
+{
+	// ファイル名のフルパスより、セパレータ以降のファイル名をカット.
+	char *pPos;
+	char szFilePath[512];
+	strcpy(szFilePath, stream->get_name());
+
+#if SXWINDOWS
+	pPos = strrchr(szFilePath, '\\');
+	if(pPos) *pPos = '\0';
+#else
+	pPos = strrchr(szFilePath, '/');
+	if(pPos) *pPos = '\0';
+#endif
+	return szFilePath;
+}
+
+/**
+ * 一括出力での、形状名に対応する出力ファイル名を取得.
+ */
+std::string Util::GetBatchFileName(const std::string& shapeName, const char* ext, std::set<std::string>& usedFileNames)
+{
+	std::string baseName = shapeName;
+	for (size_t i = 0; i < baseName.length(); i++) {
+		const char c = baseName[i];
+		if (c == '\\' || c == '/' || c == ':' || c == '*' || c == '?' || c == '"' || c == '<' || c == '>' || c == '|') baseName[i] = '_';
+	}
+	if (baseName.length() == 0) baseName = "model";
+
+	std::string fileName = baseName + ext;
+	for (int i = 2; usedFileNames.find(fileName) != usedFileNames.end(); i++) {
+		char szNo[32];
+		sprintf(szNo, "_%d", i);
+		fileName = baseName + std::string(szNo) + ext;
+	}
+	usedFileNames.insert(fileName);
+	return fileName;
+}
+
 /**
  * 指定の形状がボーンかどうか.
  */
@@ -216,3 +269,36 @@ int Util::GetBoneMeshsList(sxsdk::scene_interface* scene, std::vector<sxsdk::sha
 	return retMeshList.size();
 }
 
+/**
+ * 指定のバイト列のハッシュ値を計算 (FNV-1a 64bit).
+ */
+uint64_t Util::CalcHash(const void* data, const size_t size, const uint64_t hash)
+{
+	const unsigned char* pData = (const unsigned char *)data;
+	uint64_t h = hash;
+	for (size_t i = 0; i < size; i++) {
+		h ^= (uint64_t)pData[i];
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+
+/**
+ * ファイルを開く (パスはUTF-8).
+ */
+FILE* Util::OpenFile(const std::string& filePath, const char* mode)
+{
+#if SXWINDOWS
+	// Windowsの場合は、UTF-16に変換してから開く.
+	const int pathLen = ::MultiByteToWideChar(CP_UTF8, 0, filePath.c_str(), -1, NULL, 0);
+	const int modeLen = ::MultiByteToWideChar(CP_UTF8, 0, mode, -1, NULL, 0);
+	if (pathLen <= 0 || modeLen <= 0) return NULL;
+	std::vector<wchar_t> wPath(pathLen), wMode(modeLen);
+	::MultiByteToWideChar(CP_UTF8, 0, filePath.c_str(), -1, &(wPath[0]), pathLen);
+	::MultiByteToWideChar(CP_UTF8, 0, mode, -1, &(wMode[0]), modeLen);
+	return _wfopen(&(wPath[0]), &(wMode[0]));
+#else
+	return fopen(filePath.c_str(), mode);
+#endif
+}
@@ -8,14 +8,20 @@
 
 #include "GlobalHeader.h"
 
+#include <stdint.h>
+#include <stdio.h>
+#include <set>
+
 namespace Util {
 	/**
 	 * テキストをSJISに変換.
+	 * ワーカースレッドから呼ばれた場合は、メインスレッドで変換する (CExportTask::CallOnMainThread).
 	 */
 	std::string ConvUTF8ToSJIS(sxsdk::shade_interface& shade, const std::string str);
 
 	/**
 	 * テキストをSJISからUTF-8に変換.
+	 * ワーカースレッドから呼ばれた場合は、メインスレッドで変換する (CExportTask::CallOnMainThread).
 	 */
 	std::string ConvSJISToUTF8(sxsdk::shade_interface& shade, const std::string str);
 
@@ -56,6 +62,34 @@ namespace Util {
 	 */
 	std::string GetFileNameToStream(sxsdk::stream_interface* stream);
 
+	/**
+	 * streamより、出力先のディレクトリを取得.
+	 */
+	std::string GetDirectoryToStream(sxsdk::stream_interface* stream);
+
+	/**
+	 * 一括出力での、形状名に対応する出力ファイル名を取得.
+	 * ファイル名に使用できない文字は置き換え、usedFileNamesと重なる場合は番号を付ける.
+	 * @param[in]     shapeName       形状名.
+	 * @param[in]     ext             拡張子 (".pmd"など).
+	 * @param[in/out] usedFileNames   使用済みのファイル名。取得したファイル名が追加される.
+	 */
+	std::string GetBatchFileName(const std::string& shapeName, const char* ext, std::set<std::string>& usedFileNames);
+
+	/**
+	 * 指定のバイト列のハッシュ値を計算 (FNV-1a 64bit).
+	 * @param[in] data   データの先頭.
+	 * @param[in] size   バイト数.
+	 * @param[in] hash   ハッシュの初期値。続けて計算する場合は前回の戻り値を渡す.
+	 */
+	uint64_t CalcHash(const void* data, const size_t size, const uint64_t hash = 14695981039346656037ULL);
+
+	/**
+	 * ファイルを開く (パスはUTF-8).
+	 * Shade 3Dを介さずにファイル入出力する場合に使用。ワーカースレッドからも呼び出し可能.
+	 */
+	FILE* OpenFile(const std::string& filePath, const char* mode);
+
 }
 
 #endif
@@ -5,7 +5,6 @@
 
 #include "VMDData.h"
 #include "Util.h"
-#include "RigCtrl.h"
 
 CVMDData::CVMDData(sxsdk::shade_interface *shade) : m_shade(shade)
 {
@@ -30,198 +29,130 @@ void CVMDData::Clear()
 /**
  * モーションデータの格納.
  */
-bool CVMDData::SetMotion(sxsdk::scene_interface* scene, sxsdk::shape_class& shapeMesh, const CVMDDlgInfo& dlgData)
+bool CVMDData::SetMotion(const CMotionSnapshot& snapshot, const CVMDDlgInfo& dlgData)
 {
 	Clear();
 
 	m_scale                = dlgData.scale;
 	m_humanConvertBoneName = dlgData.humanConvertBoneName;
 
-	sxsdk::shape_class* pBoneRoot = Util::GetBoneRoot(shapeMesh);
-	if (!pBoneRoot) return false;
+	if (!snapshot.skeleton || snapshot.skeleton->bones.size() == 0) return false;
+	const CSkeletonModel& skeleton = *(snapshot.skeleton);
 
-	// ボーンリストを取得.
-	std::vector<sxsdk::shape_class *> bonesList;
-	m_GetBonesList(*pBoneRoot, bonesList);
-	if (bonesList.size() == 0) return false;
+	m_modelName = snapshot.modelName;
 
-	m_modelName = shapeMesh.get_name();
-
-	// MMDのボーン名とどれくらい一致するか判定.
+	// MMDのボーン名とどれくらい一致するかは、ボーン構造のキャッシュで判定済み.
 	m_humanRigBonesNameCheck = 0.0f;
 	m_humanRigBonesType      = human_rig_type_default;
 	if (m_humanConvertBoneName) {
-		CRigCtrl rigCtrl(m_shade);
-		m_humanRigBonesNameCheck = rigCtrl.CheckMMDBones(*pBoneRoot, &m_humanRigBonesType);
+		m_humanRigBonesNameCheck = skeleton.rigNameCheck;
+		m_humanRigBonesType      = skeleton.rigType;
 	}
 
-	for (int loop = 0; loop < bonesList.size(); loop++) {
-		sxsdk::shape_class* pShape = bonesList[loop];
-		if (!(pShape->has_motion())) continue;
+	for (int loop = 0; loop < snapshot.tracks.size(); loop++) {
+		const SNAPSHOT_MOTION_TRACK& track = snapshot.tracks[loop];
+		if (track.ik_goal) continue;
 
-		std::string boneName = pShape->get_name();
+		std::string boneName = track.name;
 		// MMDの日本語のボーン名に変換.
 		if (m_humanConvertBoneName && m_humanRigBonesNameCheck > 0.5f) {
-			const int index = CRigCtrl::GetHumanBoneIndex(m_shade, boneName, m_humanRigBonesType);
-			if (index >= 0) {
-				boneName = CRigCtrl::GetHumanBoneName(m_shade, index, human_rig_type_mmd_jp);
-			}
+			boneName = skeleton.bones[track.bone_index].name_jp;
 		}
 
 		// モーション情報を格納.
-		m_StoreMotionFrames(pShape, boneName);
+		m_StoreMotionFrames(track, boneName);
 	}
 
 	//----------------------------------------------------.
-	// IKのGoalノードを取得して出力.
+	// ボーンのツリー外にあるIKのGoalノードを出力.
 	//----------------------------------------------------.
-	{
-		sxsdk::ik_class& ikC = scene->get_ik();
-		for (int loop = 0; loop < bonesList.size(); loop++) {
-			sxsdk::shape_class* pShape = bonesList[loop];
-
-			const int ikType = ikC.has_ik(*pShape, false);
-			if (!(ikType & 0x02)) continue;		// IKエンドを持たない場合はスキップ.
-
-			// goalの形状を取得.
-			sxsdk::ik_data_class& ikData = ikC.get_ik_data(*pShape);
-			sxsdk::shape_class* pGoalShape = ikData.get_goal_shape();
-			if (!pGoalShape || !(pGoalShape->has_motion()) || !(ikData.get_root_shape())) continue;
-
-			// 親をたどっていくと、pBoneRootにたどり着く場合はすでに処理済.
-			bool chkF = false;
-			sxsdk::shape_class* pShape2 = pGoalShape;
-			while (pShape2->has_dad()) {
-				pShape2 = pShape2->get_dad();
-				if ((pShape2->get_handle()) == (pBoneRoot->get_handle())) {
-					chkF = true;
-					break;
-				}
-			}
-			if (chkF) continue;
-
-			// IK root/endに対応するボーン名を取得.
-			std::string ikRootName = ikData.get_root_shape()->get_name();
-			std::string ikEndName  = pShape->get_name();
-			std::string ikGoalName = pGoalShape->get_name();
-
-			// MMDのボーン名に変換.
-			if (m_humanConvertBoneName && m_humanRigBonesNameCheck > 0.5f) {
-				int index = CRigCtrl::GetHumanBoneIndex(m_shade, ikRootName, m_humanRigBonesType);
-				if (index >= 0) {
-					ikRootName = CRigCtrl::GetHumanBoneName(m_shade, index, human_rig_type_mmd_en);
-				}
-				index = CRigCtrl::GetHumanBoneIndex(m_shade, ikEndName, m_humanRigBonesType);
-				if (index >= 0) {
-					ikEndName = CRigCtrl::GetHumanBoneName(m_shade, index, human_rig_type_mmd_en);
-				}
-
-				if (ikRootName.compare("leg_L") == 0 && ikEndName.compare("ankle_L") == 0) {
-					ikGoalName = Util::GetUTF8Text(*m_shade, leg_ik_name_jp[index_leg_IK_L]);
-				}
-				if (ikRootName.compare("ankle_L") == 0 && ikEndName.compare("ankle_L2") == 0) {
-					ikGoalName = Util::GetUTF8Text(*m_shade, leg_ik_name_jp[index_toe_IK_L]);
-				}
-				if (ikRootName.compare("leg_R") == 0 && ikEndName.compare("ankle_R") == 0) {
-					ikGoalName = Util::GetUTF8Text(*m_shade, leg_ik_name_jp[index_leg_IK_R]);
-				}
-				if (ikRootName.compare("ankle_R") == 0 && ikEndName.compare("ankle_R2") == 0) {
-					ikGoalName = Util::GetUTF8Text(*m_shade, leg_ik_name_jp[index_toe_IK_R]);
-				}
-			} else {
-				// 通常のIK割り当ての場合、IK root名 + "_IK" がIKゴールに相当.
-				ikGoalName = ikRootName + "_IK";
-			}
-
-			// モーション情報を格納.
-			m_StoreMotionFrames(pGoalShape, ikGoalName);
+	for (int loop = 0; loop < snapshot.tracks.size(); loop++) {
+		const SNAPSHOT_MOTION_TRACK& track = snapshot.tracks[loop];
+		if (!track.ik_goal) continue;
+
+		const SKELETON_IK_CHAIN& chain = skeleton.ikChains[track.ik_chain];
+		std::string ikGoalName = track.name;
+
+		// MMDのボーン名に変換 (IK root/endが足/つま先の場合のIK名は、ボーン構造のキャッシュで判定済み).
+		if (m_humanConvertBoneName && m_humanRigBonesNameCheck > 0.5f) {
+			if (!chain.goal_name_mmd.empty()) ikGoalName = chain.goal_name_mmd;
+		} else {
+			// 通常のIK割り当ての場合、IK root名 + "_IK" がIKゴールに相当.
+			ikGoalName = chain.root_name_ik;
 		}
+
+		// モーション情報を格納.
+		m_StoreMotionFrames(track, ikGoalName);
 	}
 
 	return true;
 }
 
 /**
- * 指定形状のモーションをm_frameDataに格納.
+ * 指定のモーションをm_frameDataに格納.
  */
-void CVMDData::m_StoreMotionFrames(sxsdk::shape_class* pShape, const std::string& name)
+void CVMDData::m_StoreMotionFrames(const SNAPSHOT_MOTION_TRACK& track, const std::string& name)
 {
-	if (!(pShape->has_motion())) return;
-
 	VMD_FRAME_DATA frameData;
 	frameData.boneName = name;
-	try {
-		compointer<sxsdk::motion_interface> motion(pShape->get_motion_interface());
-		const int mCou = motion->get_number_of_motion_points();
-
-		for (int i = 0; i < mCou; i++) {
-			compointer<sxsdk::motion_point_interface> mp(motion->get_motion_point_interface(i));
-			if (mp) {
-				const sxsdk::vec3 offsetPos = mp->get_offset();
-				const sxsdk::quaternion_class qt = mp->get_rotation();
-				const sxsdk::vec4 q(qt.x, qt.y, qt.z, qt.w);
-
-				frameData.frameNo = (int)(mp->get_sequence());
-				frameData.pos     = offsetPos;
-				frameData.quat    = q;
-
-				// モーションカーブは線形に近くないと、カクカクになってしまうのでできるだけ線形に.
-				{
-					frameData.Xax = frameData.Yax = frameData.Zax = frameData.Rax =  30;
-					frameData.Xay = frameData.Yay = frameData.Zay = frameData.Ray =  30;
-					frameData.Xbx = frameData.Ybx = frameData.Zbx = frameData.Rbx =  97;
-					frameData.Xby = frameData.Yby = frameData.Zby = frameData.Rby =  97;
-				}
-				m_frameData.push_back(frameData);
-			}
+
+	for (int i = 0; i < track.points.size(); i++) {
+		const SNAPSHOT_MOTION_POINT& point = track.points[i];
+		frameData.frameNo = (int)(point.sequence);
+		frameData.pos     = point.offset;
+		frameData.quat    = point.rotation;
+
+		// モーションカーブは線形に近くないと、カクカクになってしまうのでできるだけ線形に.
+		{
+			frameData.Xax = frameData.Yax = frameData.Zax = frameData.Rax =  30;
+			frameData.Xay = frameData.Yay = frameData.Zay = frameData.Ray =  30;
+			frameData.Xbx = frameData.Ybx = frameData.Zbx = frameData.Rbx =  97;
+			frameData.Xby = frameData.Yby = frameData.Zby = frameData.Rby =  97;
 		}
-	} catch (...) { }
+		m_frameData.push_back(frameData);
+	}
 }
 
 /**
- * ボーンリストを取得.
+ * モーションデータのエクスポート.
  */
-void CVMDData::m_GetBonesList(sxsdk::shape_class& boneRoot, std::vector<sxsdk::shape_class *>& bonesList)
+void CVMDData::Export(sxsdk::stream_interface *stream)
 {
-	bonesList.clear();
-	m_GetBonesListLoop(boneRoot, bonesList);
-}
-
-void CVMDData::m_GetBonesListLoop(sxsdk::shape_class& shape, std::vector<sxsdk::shape_class *>& bonesList)
-{
-	if (!Util::IsBone(shape)) return;
-	bonesList.push_back(&shape);
-
-	if (shape.has_son()) {
-		sxsdk::shape_class* pShape = shape.get_son();
-		while (pShape->has_bro()) {
-			pShape = pShape->get_bro();
-			m_GetBonesListLoop(*pShape, bonesList);
-		}
-	}
+	CBinaryBuffer buff;
+	m_WriteHeader(buff);
+	m_WriteFrameData(buff);
+	m_WriteSkinData(buff);
+	if (buff.GetSize() > 0) stream->write(buff.GetSize(), buff.GetData());
 }
 
 /**
- * モーションデータのエクスポート.
+ * モーションデータをファイルにエクスポート.
  */
-void CVMDData::Export(sxsdk::stream_interface *stream)
+bool CVMDData::Export(const std::string& filePath)
 {
-	m_WriteHeader(stream);
-	m_WriteFrameData(stream);
-	m_WriteSkinData(stream);
+	CBinaryBuffer buff;
+	m_WriteHeader(buff);
+	m_WriteFrameData(buff);
+	m_WriteSkinData(buff);
+
+	FILE* fp = Util::OpenFile(filePath, "wb");
+	if (!fp) return false;
+	const bool ret = (buff.GetSize() == 0 || fwrite(buff.GetData(), 1, buff.GetSize(), fp) == buff.GetSize());
+	fclose(fp);
+	return ret;
 }
 
 /**
  * ヘッダ部の出力.
  */
-void CVMDData::m_WriteHeader(sxsdk::stream_interface *stream)
+void CVMDData::m_WriteHeader(CBinaryBuffer& buff)
 {
 	char szStr[64];
 
 	// ヘッダのテキストは固定.
 	memset(szStr, 0, 40);
 	strcpy(szStr, "Vocaloid Motion Data 0002");
-	stream->write(30, szStr);
+	buff.Write(30, szStr);
 
 	// モデル名.
 	memset(szStr, 0, 20);
@@ -231,16 +162,16 @@ void CVMDData::m_WriteHeader(sxsdk::stream_interface *stream)
 		strncpy(szStr, str.c_str(), 19);
 	}
 
-	stream->write(20, szStr);
+	buff.Write(20, szStr);
 }
 
 /**
  * フレームデータの出力.
  */
-void CVMDData::m_WriteFrameData(sxsdk::stream_interface *stream)
+void CVMDData::m_WriteFrameData(CBinaryBuffer& buff)
 {
 	int frameCou = m_frameData.size();
-	stream->write(4, &frameCou);
+	buff.Write(4, &frameCou);
 
 	char szStr[32];
 	unsigned char Interpolation[64];
@@ -250,21 +181,21 @@ void CVMDData::m_WriteFrameData(sxsdk::stream_interface *stream)
 		std::string str = Util::ConvUTF8ToSJIS(*m_shade, frameData.boneName);
 		memset(szStr, 0, 20);
 		if (str.length() < 15) strcpy(szStr, str.c_str());
-		stream->write(15, szStr);
-		stream->write(4, &frameData.frameNo);
+		buff.Write(15, szStr);
+		buff.Write(4, &frameData.frameNo);
 
 		sxsdk::vec3 pos = frameData.pos * m_scale;
 		pos.z = -pos.z;
-		stream->write(4, &pos.x);
-		stream->write(4, &pos.y);
-		stream->write(4, &pos.z);
+		buff.Write(4, &pos.x);
+		buff.Write(4, &pos.y);
+		buff.Write(4, &pos.z);
 
 		sxsdk::vec4 q = frameData.quat;
 		q.z = -q.z;
-		stream->write(4, &q.x);
-		stream->write(4, &q.y);
-		stream->write(4, &q.z);
-		stream->write(4, &q.w);
+		buff.Write(4, &q.x);
+		buff.Write(4, &q.y);
+		buff.Write(4, &q.z);
+		buff.Write(4, &q.w);
 
 		// 補間データ.
 		// http://blog.goo.ne.jp/torisu_tetosuki/e/bc9f1c4d597341b394bd02b64597499d  参考.
@@ -288,17 +219,17 @@ void CVMDData::m_WriteFrameData(sxsdk::stream_interface *stream)
 		Interpolation[56] = frameData.Rbx; Interpolation[57] = frameData.Xby; Interpolation[58] = frameData.Yby; Interpolation[59] = frameData.Zby;
 		Interpolation[60] = frameData.Rby; Interpolation[61] =          0x01; Interpolation[62] =          0x00; Interpolation[63] =          0x00;
 
-		stream->write(64, Interpolation);
+		buff.Write(64, Interpolation);
 	}
 }
 
 /**
  * スキン（表情）モーションの出力.
  */
-void CVMDData::m_WriteSkinData(sxsdk::stream_interface *stream)
+void CVMDData::m_WriteSkinData(CBinaryBuffer& buff)
 {
 	int skinCou = m_skinData.size();
-	stream->write(4, &skinCou);
+	buff.Write(4, &skinCou);
 
 	char szStr[32];
 	for (int i = 0; i < skinCou; i++) {
@@ -306,8 +237,8 @@ void CVMDData::m_WriteSkinData(sxsdk::stream_interface *stream)
 		std::string str = Util::ConvUTF8ToSJIS(*m_shade, skinData.skinName);
 		memset(szStr, 0, 20);
 		if (str.length() < 15) strcpy(szStr, str.c_str());
-		stream->write(15, szStr);
-		stream->write(4, &skinData.frameNo);
-		stream->write(4, &skinData.weight);
+		buff.Write(15, szStr);
+		buff.Write(4, &skinData.frameNo);
+		buff.Write(4, &skinData.weight);
 	}
 }
@@ -7,6 +7,8 @@
 #define _VMDDATA_H
 
 #include "GlobalHeader.h"
+#include "SceneSnapshot.h"
+#include "BinaryBuffer.h"
 
 /**
  * フレームデータ.
@@ -74,30 +76,24 @@ private:
 	float m_scale;								///< 出力時のスケーリング.
 
 	/**
-	 * ボーンリストを取得.
+	 * 指定のモーションをm_frameDataに格納.
 	 */
-	void m_GetBonesList(sxsdk::shape_class& boneRoot, std::vector<sxsdk::shape_class *>& bonesList); 
-	void m_GetBonesListLoop(sxsdk::shape_class& shape, std::vector<sxsdk::shape_class *>& bonesList); 
-
-	/**
-	 * 指定形状のモーションをm_frameDataに格納.
-	 */
-	void m_StoreMotionFrames(sxsdk::shape_class* pShape, const std::string& name);
+	void m_StoreMotionFrames(const SNAPSHOT_MOTION_TRACK& track, const std::string& name);
 
 	/**
 	 * ヘッダ部の出力.
 	 */
-	void m_WriteHeader(sxsdk::stream_interface *stream);
+	void m_WriteHeader(CBinaryBuffer& buff);
 
 	/**
 	 * フレームデータの出力.
 	 */
-	void m_WriteFrameData(sxsdk::stream_interface *stream);
+	void m_WriteFrameData(CBinaryBuffer& buff);
 
 	/**
 	 * スキン（表情）モーションの出力.
 	 */
-	void m_WriteSkinData(sxsdk::stream_interface *stream);
+	void m_WriteSkinData(CBinaryBuffer& buff);
 
 public:
 	CVMDData(sxsdk::shade_interface *shade);
@@ -106,14 +102,21 @@ public:
 
 	/**
 	 * モーションデータの格納.
+	 * @param[in] snapshot   CMotionSnapshot::Captureで取得したモーション.
 	 */
-	bool SetMotion(sxsdk::scene_interface* scene, sxsdk::shape_class& shapeMesh, const CVMDDlgInfo& dlgData);
+	bool SetMotion(const CMotionSnapshot& snapshot, const CVMDDlgInfo& dlgData);
 
 	/**
 	 * モーションデータのエクスポート.
 	 */
 	void Export(sxsdk::stream_interface *stream);
 
+	/**
+	 * モーションデータをファイルにエクスポート (一括出力で、stream以外に出力する場合).
+	 * @param[in]  filePath  ファイルのフルパス (UTF-8).
+	 */
+	bool Export(const std::string& filePath);
+
 };
 
 #endif
@@ -7,10 +7,13 @@
 #include "VMDData.h"
 #include "StreamCtrl.h"
 #include "Util.h"
+#include "ThreadPool.h"
+#include "SceneSnapshot.h"
 
 enum {
 	dlg_scale_id = 101,						// scale.
 	dlg_human_conv_bones_name_id = 201,		// 人体ボーンの名称をMMD向けに変更.
+	dlg_export_all_meshes_id = 301,			// ボーンの割り当てられたすべてのメッシュを出力.
 };
 
 CVMDExporter::CVMDExporter(sxsdk::shade_interface &shade) : shade(shade)
@@ -51,6 +54,9 @@ void CVMDExporter::do_export (sxsdk::plugin_exporter_interface *plugin_exporter,
 
 	compointer<sxsdk::scene_interface> scene(shade.get_scene_interface());
 
+	// シーンが切り替わった場合は、前のシーンのキャッシュを破棄 (ボーン名の変換表もここで準備).
+	SceneSnapshot::BeginExport(shade, scene);
+
 	//------------------------------------------------------//
 	//	ボーンの割り当てられたポリゴンメッシュを選択		//
 	//------------------------------------------------------//
@@ -82,32 +88,31 @@ void CVMDExporter::do_export (sxsdk::plugin_exporter_interface *plugin_exporter,
 		}
 	}
 	if (!chkF) {
-		if (meshShapeList.size() == 1) {
+		if (meshShapeList.size() == 1 || m_dlgData.exportAllMeshes) {
 			targetShape = meshShapeList[0];
 		}
 	}
 
+	//------------------------------------------------------//
+	//	一括出力											//
+	//------------------------------------------------------//
+	if (m_dlgData.exportAllMeshes && meshShapeList.size() > 1) {
+		try {
+			m_ExportAllMeshes(scene, meshShapeList, targetShape);
+		} catch (...) { }
+
+		// ダイアログのstream情報を保存.
+		StreamCtrl::SaveVMDDlgInfo(&shade, m_dlgData);
+		return;
+	}
+
 	//------------------------------------------------------//
 	//	条件に合うかチェック								//
 	//------------------------------------------------------//
 	{
-		if (targetShape->get_type() != sxsdk::enums::polygon_mesh) {
-			shade.show_message_box(shade.gettext("msg_select_polygonmesh"), false);
-			return;
-		}
-		const int skin_type = targetShape->get_skin_type();
-		if (skin_type != 1) {		// 頂点ブレンドのスキンでない場合はスキップ.
-			shade.show_message_box(shade.gettext("msg_skin_vertex_blend"), false);
-			return;
-		}
-
-		sxsdk::polygon_mesh_class& pmesh = targetShape->get_polygon_mesh();
-		if (pmesh.get_number_of_faces() > 65535) {
-			shade.show_message_box(shade.gettext("msg_mesh_triangle_65535"), false);
-			return;
-		}
-		if (pmesh.get_total_number_of_control_points() > 65535) {
-			shade.show_message_box(shade.gettext("msg_mesh_vertex_65535"), false);
+		const char* errorID = m_GetMeshErrorID(*targetShape);
+		if (errorID) {
+			shade.show_message_box(shade.gettext(errorID), false);
 			return;
 		}
 	}
@@ -117,8 +122,10 @@ void CVMDExporter::do_export (sxsdk::plugin_exporter_interface *plugin_exporter,
 	//------------------------------------------------------//
 	try {
 		// 指定のポリゴンメッシュに割り当てられたボーンより、モーションデータを出力.
+		// シーンのモーションは、スナップショットとしてまとめて取得してから変換する.
+		CMotionSnapshot snapshot;
 		CVMDData vmdData(&shade);
-		if (vmdData.SetMotion(scene, *targetShape, m_dlgData)) {
+		if (snapshot.Capture(shade, scene, *targetShape) && vmdData.SetMotion(snapshot, m_dlgData)) {
 			vmdData.Export(m_stream);
 
 			{
@@ -133,6 +140,91 @@ void CVMDExporter::do_export (sxsdk::plugin_exporter_interface *plugin_exporter,
 	StreamCtrl::SaveVMDDlgInfo(&shade, m_dlgData);
 }
 
+/**
+ * 出力できないポリゴンメッシュの場合は、メッセージのIDを返す.
+ */
+const char* CVMDExporter::m_GetMeshErrorID(sxsdk::shape_class& shape)
+{
+	if (shape.get_type() != sxsdk::enums::polygon_mesh) return "msg_select_polygonmesh";
+
+	const int skin_type = shape.get_skin_type();
+	if (skin_type != 1) return "msg_skin_vertex_blend";		// 頂点ブレンドのスキンでない場合はスキップ.
+
+	sxsdk::polygon_mesh_class& pmesh = shape.get_polygon_mesh();
+	if (pmesh.get_number_of_faces() > 65535) return "msg_mesh_triangle_65535";
+	if (pmesh.get_total_number_of_control_points() > 65535) return "msg_mesh_vertex_65535";
+
+	return NULL;
+}
+
+/**
+ * ボーンの割り当てられたすべてのポリゴンメッシュのモーションを、それぞれのVMDファイルに出力 (一括出力).
+ * モーションはメインスレッドですべてスナップショットとして取得し、VMDのデータへの変換はモデルごとに並列に行う.
+ */
+void CVMDExporter::m_ExportAllMeshes(sxsdk::scene_interface* scene, const std::vector<sxsdk::shape_class *>& meshShapeList, sxsdk::shape_class* targetShape)
+{
+	const std::string streamFileName = Util::GetFileNameToStream(m_stream);
+	const std::string dirPath        = Util::GetDirectoryToStream(m_stream);
+
+	// 出力ファイル名が重ならないように、使用済みの名前を保持.
+	std::set<std::string> usedFileNames;
+	usedFileNames.insert(streamFileName);
+
+	// シーンのモーションは、メインスレッドでスナップショットとして取得.
+	std::vector<sxsdk::shape_class *> shapes;
+	std::vector<CMotionSnapshot> snapshots;
+	snapshots.reserve(meshShapeList.size());
+	for (int i = 0; i < meshShapeList.size(); i++) {
+		sxsdk::shape_class* pShape = meshShapeList[i];
+		const char* errorID = m_GetMeshErrorID(*pShape);
+		if (errorID) {
+			const std::string str = std::string(pShape->get_name()) + std::string(" : ") + shade.gettext(errorID);
+			shade.message(str.c_str());
+			continue;
+		}
+
+		snapshots.push_back(CMotionSnapshot());
+		if (!snapshots.back().Capture(shade, scene, *pShape)) {
+			snapshots.pop_back();
+			continue;
+		}
+		shapes.push_back(pShape);
+	}
+
+	// スナップショットからVMDのデータに変換 (シーンを参照しないため、モデルごとに並列に行う).
+	std::vector<CVMDData *> vmdDataList(shapes.size(), NULL);
+	std::vector<char> convertedList(shapes.size(), 0);
+	{
+		CThreadPool pool;
+		const CVMDDlgInfo dlgData = m_dlgData;
+		pool.ParallelFor(0, shapes.size(), [&](int i) {
+			vmdDataList[i] = new CVMDData(&shade);
+			convertedList[i] = vmdDataList[i]->SetMotion(snapshots[i], dlgData) ? 1 : 0;
+		});
+	}
+
+	// VMD形式で出力.
+	for (int i = 0; i < shapes.size(); i++) {
+		if (convertedList[i]) {
+			std::string fileName = streamFileName;
+			bool writeF = true;
+			if (shapes[i] == targetShape) {
+				vmdDataList[i]->Export(m_stream);
+			} else {
+				fileName = Util::GetBatchFileName(shapes[i]->get_name(), ".vmd", usedFileNames);
+#if SXWINDOWS
+				writeF = vmdDataList[i]->Export(dirPath + "\\" + fileName);
+#else
+				writeF = vmdDataList[i]->Export(dirPath + "/" + fileName);
+#endif
+			}
+			const std::string str = fileName + std::string(" ") + shade.gettext(writeF ? "msg_finish_export" : "msg_export_write_failed");
+			shade.message(str.c_str());
+		}
+		delete vmdDataList[i];
+	}
+}
+
 /****************************************************************/
 /* ダイアログイベント											*/
 /****************************************************************/
@@ -151,6 +243,9 @@ void CVMDExporter::load_dialog_data (sxsdk::dialog_interface &d,void *)
 
 	item = &(d.get_dialog_item(dlg_human_conv_bones_name_id));
 	item->set_bool(m_dlgData.humanConvertBoneName);
+
+	item = &(d.get_dialog_item(dlg_export_all_meshes_id));
+	item->set_bool(m_dlgData.exportAllMeshes);
 }
 
 void CVMDExporter::save_dialog_data (sxsdk::dialog_interface &dialog,void *)
@@ -171,6 +266,11 @@ bool CVMDExporter::respond (sxsdk::dialog_interface &dialog, sxsdk::dialog_item_
 		return true;
 	}
 
+	if (id == dlg_export_all_meshes_id) {
+		m_dlgData.exportAllMeshes = item.get_bool();
+		return true;
+	}
+
 	return false;
 }
 
@@ -19,6 +19,17 @@ private:
 
 	CVMDDlgInfo m_dlgData;						///< Exportダイアログの情報.
 
+	/**
+	 * 出力できないポリゴンメッシュの場合は、メッセージのIDを返す.
+	 */
+	const char* m_GetMeshErrorID(sxsdk::shape_class& shape);
+
+	/**
+	 * ボーンの割り当てられたすべてのポリゴンメッシュのモーションを、それぞれのVMDファイルに出力 (一括出力).
+	 * targetShapeはstreamに、それ以外はstreamと同じディレクトリの「形状名.vmd」に出力する.
+	 */
+	void m_ExportAllMeshes(sxsdk::scene_interface* scene, const std::vector<sxsdk::shape_class *>& meshShapeList, sxsdk::shape_class* targetShape);
+
 	virtual sx::uuid_class get_uuid (void *) { return MMD_VMD_EXPORTER_INTERFACE_ID; }
 	virtual int get_shade_version () const { return SHADE_BUILD_NUMBER; }
 
@@ -0,0 +1,379 @@
+﻿/**
+ *  @brief  VMDファイルの読み込み (メモリマップ) とモーションの差分.
+ *  @date   2026.10.19
+ */
+
+#include "VMDReader.h"
+
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+
+#define VMD_HEADER_SIZE			(30 + 20)		///< ヘッダのバイト数.
+#define VMD_FRAME_DATA_SIZE		111				///< ボーンのフレームのバイト数.
+#define VMD_SKIN_DATA_SIZE		23				///< 表情のフレームのバイト数.
+#define VMD_NAME_SIZE			15				///< ボーン名/表情名のバイト数.
+
+namespace {
+	inline int ReadInt(const unsigned char* p) {
+		int v;
+		memcpy(&v, p, 4);
+		return v;
+	}
+	inline unsigned int ReadU32(const unsigned char* p) { return (unsigned int)p[0] | ((unsigned int)p[1] << 8) | ((unsigned int)p[2] << 16) | ((unsigned int)p[3] << 24); }
+
+	std::string ReadString(const unsigned char* p, const size_t size) {
+		size_t len = 0;
+		while (len < size && p[len] != 0) len++;
+		return std::string((const char *)p, len);
+	}
+
+	/**
+	 * フレーム番号順に並び替える (同一フレームは元の順番).
+	 */
+	class CFrameNoLess {
+	private:
+		const CVMDReader& m_reader;
+		const bool m_skin;
+	public:
+		CFrameNoLess(const CVMDReader& reader, const bool skin) : m_reader(reader), m_skin(skin) { }
+		int frameNo(const int index) const {
+			if (!m_skin) return m_reader.GetFrameNo(index);
+			VMD_READ_SKIN skinData;
+			m_reader.GetSkin(index, skinData);
+			return skinData.frameNo;
+		}
+		bool operator()(const int a, const int b) const { return frameNo(a) < frameNo(b); }
+	};
+
+	/**
+	 * 2つの回転(クォータニオン)の角度差 (ラジアン).
+	 */
+	float QuatAngle(const float* qa, const float* qb) {
+		const float la = sqrtf(qa[0] * qa[0] + qa[1] * qa[1] + qa[2] * qa[2] + qa[3] * qa[3]);
+		const float lb = sqrtf(qb[0] * qb[0] + qb[1] * qb[1] + qb[2] * qb[2] + qb[3] * qb[3]);
+		if (la < 1e-8f || lb < 1e-8f) return (la < 1e-8f && lb < 1e-8f) ? 0.0f : 3.14159265f;
+		float d = (qa[0] * qb[0] + qa[1] * qb[1] + qa[2] * qb[2] + qa[3] * qb[3]) / (la * lb);
+		d = std::min(1.0f, fabsf(d));			// qと-qは同じ回転.
+		return 2.0f * acosf(d);
+	}
+}
+
+CVMDReader::CVMDReader()
+{
+	m_pData = NULL;
+	m_size  = 0;
+	Close();
+}
+
+CVMDReader::~CVMDReader()
+{
+	Close();
+}
+
+void CVMDReader::Close()
+{
+	m_file.Close();
+	m_pData       = NULL;
+	m_size        = 0;
+	m_frameOffset = 0;
+	m_frameCount  = 0;
+	m_skinOffset  = 0;
+	m_skinCount   = 0;
+	m_errorMessage = "";
+}
+
+/**
+ * VMDファイルを開く (パスはUTF-8).
+ */
+bool CVMDReader::Open(const std::string& filePath)
+{
+	Close();
+	if (!m_file.Open(filePath)) {
+		m_errorMessage = "Failed to open file.";
+		return false;
+	}
+	m_pData = m_file.GetData();
+	m_size  = m_file.GetSize();
+	return m_Parse();
+}
+
+/**
+ * メモリ上のVMDデータを参照.
+ */
+bool CVMDReader::OpenMemory(const unsigned char* data, const size_t size)
+{
+	Close();
+	m_pData = data;
+	m_size  = size;
+	return m_Parse();
+}
+
+/**
+ * セクションの位置を求める.
+ */
+bool CVMDReader::m_Parse()
+{
+	if (m_size < VMD_HEADER_SIZE || memcmp(m_pData, "Vocaloid Motion Data", 20) != 0) {
+		m_errorMessage = "Invalid header.";
+		return false;
+	}
+	size_t pos = VMD_HEADER_SIZE;
+
+	if (m_size - pos < 4) {
+		m_errorMessage = "Frame section is truncated.";
+		return false;
+	}
+	const unsigned int frameCou = ReadU32(m_pData + pos);
+	pos += 4;
+	if ((unsigned long long)frameCou * VMD_FRAME_DATA_SIZE > (unsigned long long)(m_size - pos)) {
+		m_errorMessage = "Frame section is truncated.";
+		return false;
+	}
+	m_frameOffset = pos;
+	m_frameCount  = (int)frameCou;
+	pos += (size_t)frameCou * VMD_FRAME_DATA_SIZE;
+
+	// 表情のフレームは省略される場合もある.
+	if (pos == m_size) return true;
+	if (m_size - pos < 4) {
+		m_errorMessage = "Skin section is truncated.";
+		return false;
+	}
+	const unsigned int skinCou = ReadU32(m_pData + pos);
+	pos += 4;
+	if ((unsigned long long)skinCou * VMD_SKIN_DATA_SIZE > (unsigned long long)(m_size - pos)) {
+		m_errorMessage = "Skin section is truncated.";
+		return false;
+	}
+	m_skinOffset = pos;
+	m_skinCount  = (int)skinCou;
+
+	return true;
+}
+
+std::string CVMDReader::GetModelName() const
+{
+	return m_pData ? ReadString(m_pData + 30, 20) : std::string("");
+}
+
+void CVMDReader::GetFrame(const int index, VMD_READ_FRAME& retData) const
+{
+	const unsigned char* p = m_pData + m_frameOffset + (size_t)index * VMD_FRAME_DATA_SIZE;
+	retData.boneName = ReadString(p, VMD_NAME_SIZE);
+	retData.frameNo  = ReadInt(p + 15);
+	memcpy(retData.pos, p + 19, 12);
+	memcpy(retData.quat, p + 31, 16);
+	memcpy(retData.interpolation, p + 47, 64);
+}
+
+void CVMDReader::GetSkin(const int index, VMD_READ_SKIN& retData) const
+{
+	const unsigned char* p = m_pData + m_skinOffset + (size_t)index * VMD_SKIN_DATA_SIZE;
+	retData.skinName = ReadString(p, VMD_NAME_SIZE);
+	retData.frameNo  = ReadInt(p + 15);
+	memcpy(&retData.weight, p + 19, 4);
+}
+
+/**
+ * ボーンのフレームのボーン名のみを取得.
+ */
+std::string CVMDReader::GetFrameBoneName(const int index) const
+{
+	return ReadString(m_pData + m_frameOffset + (size_t)index * VMD_FRAME_DATA_SIZE, VMD_NAME_SIZE);
+}
+
+int CVMDReader::GetFrameNo(const int index) const
+{
+	return ReadInt(m_pData + m_frameOffset + (size_t)index * VMD_FRAME_DATA_SIZE + 15);
+}
+
+/*****************************************************/
+
+CVMDDiff::CVMDDiff(const VMD_DIFF_OPTION& option) : m_option(option)
+{
+}
+
+/**
+ * ボーン名ごとにフレームを分類 (フレーム番号順).
+ */
+void CVMDDiff::m_GroupFrames(const CVMDReader& reader, const bool skin, std::map< std::string, std::vector<int> >& retGroups)
+{
+	retGroups.clear();
+	const int cou = skin ? reader.GetSkinsCount() : reader.GetFramesCount();
+	VMD_READ_SKIN skinData;
+	for (int i = 0; i < cou; i++) {
+		if (skin) {
+			reader.GetSkin(i, skinData);
+			retGroups[skinData.skinName].push_back(i);
+		} else {
+			retGroups[reader.GetFrameBoneName(i)].push_back(i);
+		}
+	}
+
+	CFrameNoLess frameNoLess(reader, skin);
+	for (std::map< std::string, std::vector<int> >::iterator it = retGroups.begin(); it != retGroups.end(); ++it) {
+		std::stable_sort(it->second.begin(), it->second.end(), frameNoLess);
+	}
+}
+
+/**
+ * 同じ名前のボーン(表情)のキーを比較.
+ */
+void CVMDDiff::m_CompareKeys(const CVMDReader& a, const CVMDReader& b, const bool skin, const std::string& name, const std::vector<int>* pKeysA, const std::vector<int>* pKeysB)
+{
+	static const std::vector<int> emptyKeys;
+	const std::vector<int>& keysA = pKeysA ? (*pKeysA) : emptyKeys;
+	const std::vector<int>& keysB = pKeysB ? (*pKeysB) : emptyKeys;
+
+	VMD_DIFF_SUMMARY summary;
+	summary.name      = name;
+	summary.skin      = skin;
+	summary.keyCountA = (int)keysA.size();
+	summary.keyCountB = (int)keysB.size();
+
+	const CFrameNoLess frameNoA(a, skin);
+	const CFrameNoLess frameNoB(b, skin);
+
+	VMD_DIFF_ITEM item;
+	item.skin = skin;
+	item.name = name;
+
+	VMD_READ_FRAME frameA, frameB;
+	VMD_READ_SKIN skinA, skinB;
+	size_t iA = 0, iB = 0;
+	while (iA < keysA.size() || iB < keysB.size()) {
+		const int fA = (iA < keysA.size()) ? frameNoA.frameNo(keysA[iA]) : 0x7fffffff;
+		const int fB = (iB < keysB.size()) ? frameNoB.frameNo(keysB[iB]) : 0x7fffffff;
+
+		if (fA != fB) {
+			item.type    = (fA < fB) ? vmd_diff_missing_b : vmd_diff_missing_a;
+			item.frameNo = std::min(fA, fB);
+			item.error   = 0.0f;
+			m_items.push_back(item);
+			summary.diffCount++;
+			if (fA < fB) iA++;
+			else iB++;
+			continue;
+		}
+
+		item.frameNo = fA;
+		if (skin) {
+			a.GetSkin(keysA[iA], skinA);
+			b.GetSkin(keysB[iB], skinB);
+			const float err = fabsf(skinA.weight - skinB.weight);
+			summary.maxWeightError = std::max(summary.maxWeightError, err);
+			if (err > m_option.weightTolerance) {
+				item.type  = vmd_diff_weight;
+				item.error = err;
+				m_items.push_back(item);
+				summary.diffCount++;
+			}
+		} else {
+			a.GetFrame(keysA[iA], frameA);
+			b.GetFrame(keysB[iB], frameB);
+
+			const float dx = frameA.pos[0] - frameB.pos[0];
+			const float dy = frameA.pos[1] - frameB.pos[1];
+			const float dz = frameA.pos[2] - frameB.pos[2];
+			const float posErr = sqrtf(dx * dx + dy * dy + dz * dz);
+			summary.maxPosError = std::max(summary.maxPosError, posErr);
+			if (posErr > m_option.posTolerance) {
+				item.type  = vmd_diff_pos;
+				item.error = posErr;
+				m_items.push_back(item);
+				summary.diffCount++;
+			}
+
+			const float rotErr = QuatAngle(frameA.quat, frameB.quat);
+			summary.maxRotError = std::max(summary.maxRotError, rotErr);
+			if (rotErr > m_option.rotTolerance) {
+				item.type  = vmd_diff_rot;
+				item.error = rotErr;
+				m_items.push_back(item);
+				summary.diffCount++;
+			}
+
+			if (m_option.compareInterpolation && memcmp(frameA.interpolation, frameB.interpolation, 64) != 0) {
+				item.type  = vmd_diff_interpolation;
+				item.error = 0.0f;
+				m_items.push_back(item);
+				summary.diffCount++;
+			}
+		}
+		iA++;
+		iB++;
+	}
+
+	m_summary.push_back(summary);
+}
+
+/**
+ * 2つのモーションを比較.
+ */
+bool CVMDDiff::Compare(const CVMDReader& a, const CVMDReader& b)
+{
+	m_items.clear();
+	m_summary.clear();
+
+	for (int loop = 0; loop < 2; loop++) {
+		const bool skin = (loop == 1);
+		std::map< std::string, std::vector<int> > groupsA, groupsB;
+		m_GroupFrames(a, skin, groupsA);
+		m_GroupFrames(b, skin, groupsB);
+
+		// 名前順に、両方のボーン(表情)をたどる.
+		std::map< std::string, std::vector<int> >::const_iterator itA = groupsA.begin();
+		std::map< std::string, std::vector<int> >::const_iterator itB = groupsB.begin();
+		while (itA != groupsA.end() || itB != groupsB.end()) {
+			if (itB == groupsB.end() || (itA != groupsA.end() && itA->first < itB->first)) {
+				m_CompareKeys(a, b, skin, itA->first, &(itA->second), NULL);
+				++itA;
+			} else if (itA == groupsA.end() || itB->first < itA->first) {
+				m_CompareKeys(a, b, skin, itB->first, NULL, &(itB->second));
+				++itB;
+			} else {
+				m_CompareKeys(a, b, skin, itA->first, &(itA->second), &(itB->second));
+				++itA;
+				++itB;
+			}
+		}
+	}
+
+	return m_items.empty();
+}
+
+/**
+ * 差分をテキストで取得.
+ */
+std::string CVMDDiff::GetReport(const int maxItems) const
+{
+	static const char* typeNames[] = { "missing in A", "missing in B", "position", "rotation", "interpolation", "weight" };
+
+	std::string str;
+	char szStr[512];
+	for (size_t i = 0; i < m_summary.size(); i++) {
+		const VMD_DIFF_SUMMARY& summary = m_summary[i];
+		if (summary.diffCount == 0) continue;
+		if (summary.skin) {
+			snprintf(szStr, sizeof(szStr), "[skin] %s : keys %d / %d, diffs %d, max weight %g\n", summary.name.c_str(), summary.keyCountA, summary.keyCountB, summary.diffCount, summary.maxWeightError);
+		} else {
+			snprintf(szStr, sizeof(szStr), "[bone] %s : keys %d / %d, diffs %d, max pos %g, max rot %g\n", summary.name.c_str(), summary.keyCountA, summary.keyCountB, summary.diffCount, summary.maxPosError, summary.maxRotError);
+		}
+		str += szStr;
+	}
+
+	const int cou = std::min((int)m_items.size(), maxItems);
+	for (int i = 0; i < cou; i++) {
+		const VMD_DIFF_ITEM& item = m_items[i];
+		snprintf(szStr, sizeof(szStr), "%s %s frame %d : %s %g\n", item.skin ? "skin" : "bone", item.name.c_str(), item.frameNo, typeNames[item.type], item.error);
+		str += szStr;
+	}
+	if ((int)m_items.size() > cou) {
+		snprintf(szStr, sizeof(szStr), "... %d more\n", (int)m_items.size() - cou);
+		str += szStr;
+	}
+
+	return str;
+}
@@ -0,0 +1,205 @@
+﻿/**
+ *  @brief  VMDファイルの読み込み (メモリマップ) とモーションの差分.
+ *  @date   2026.10.19
+ */
+
+#ifndef _VMDREADER_H
+#define _VMDREADER_H
+
+#include "GlobalHeader.h"
+#include "MappedFile.h"
+
+#include <vector>
+#include <string>
+#include <map>
+
+/*
+	CVMDData::Exportで出力したヘッダ/ボーンのフレーム/表情のフレームを、メモリマップしたファイル上で参照する.
+	要素はGetFrameなどで、必要になった時点で1つずつ取り出す.
+	表情のフレームの後のカメラ/照明などのデータは読み飛ばす.
+
+	CVMDDiffで、2つのVMDファイルをボーン(表情)ごと、フレームごとに比較する.
+*/
+
+/**
+ * ボーンのフレーム (111バイト).
+ */
+typedef struct {
+	std::string boneName;			///< ボーン名 (Shift-JIS).
+	int frameNo;					///< フレーム番号.
+	float pos[3];					///< 位置.
+	float quat[4];					///< 回転 (XYZW).
+	unsigned char interpolation[64];	///< 補間パラメータ.
+} VMD_READ_FRAME;
+
+/**
+ * 表情のフレーム (23バイト).
+ */
+typedef struct {
+	std::string skinName;			///< 表情名 (Shift-JIS).
+	int frameNo;					///< フレーム番号.
+	float weight;					///< ウエイト値.
+} VMD_READ_SKIN;
+
+class CVMDReader
+{
+private:
+	CMappedFile m_file;
+	const unsigned char* m_pData;
+	size_t m_size;
+
+	size_t m_frameOffset;			///< ボーンのフレームの開始位置.
+	int m_frameCount;				///< ボーンのフレーム数.
+	size_t m_skinOffset;			///< 表情のフレームの開始位置.
+	int m_skinCount;				///< 表情のフレーム数.
+
+	std::string m_errorMessage;
+
+	/**
+	 * セクションの位置を求める.
+	 */
+	bool m_Parse();
+
+public:
+	CVMDReader();
+	virtual ~CVMDReader();
+
+	/**
+	 * VMDファイルを開く (パスはUTF-8).
+	 * @return 途中で切れている場合などはfalse (GetErrorMessageで理由を取得).
+	 */
+	bool Open(const std::string& filePath);
+
+	/**
+	 * メモリ上のVMDデータを参照 (dataはCloseまで保持しておくこと).
+	 */
+	bool OpenMemory(const unsigned char* data, const size_t size);
+
+	void Close();
+
+	const std::string& GetErrorMessage() const { return m_errorMessage; }
+
+	std::string GetModelName() const;
+
+	int GetFramesCount() const { return m_frameCount; }
+	int GetSkinsCount() const { return m_skinCount; }
+
+	void GetFrame(const int index, VMD_READ_FRAME& retData) const;
+	void GetSkin(const int index, VMD_READ_SKIN& retData) const;
+
+	/**
+	 * ボーンのフレームのボーン名のみを取得 (フレーム全体を取り出さずに分類する場合に使用).
+	 */
+	std::string GetFrameBoneName(const int index) const;
+	int GetFrameNo(const int index) const;
+};
+
+/**
+ * モーション比較時の許容誤差.
+ */
+class VMD_DIFF_OPTION {
+public:
+	float posTolerance;				///< 位置の許容誤差.
+	float rotTolerance;				///< 回転の許容誤差 (ラジアン).
+	float weightTolerance;			///< 表情のウエイトの許容誤差.
+	bool compareInterpolation;		///< 補間パラメータも比較するか.
+
+	VMD_DIFF_OPTION() {
+		posTolerance         = 1e-4f;
+		rotTolerance         = 1e-4f;
+		weightTolerance      = 1e-4f;
+		compareInterpolation = true;
+	}
+};
+
+/**
+ * 差分の種類.
+ */
+enum {
+	vmd_diff_missing_a = 0,			///< Aにのみキーがない.
+	vmd_diff_missing_b,				///< Bにのみキーがない.
+	vmd_diff_pos,					///< 位置が異なる.
+	vmd_diff_rot,					///< 回転が異なる.
+	vmd_diff_interpolation,			///< 補間パラメータが異なる.
+	vmd_diff_weight,				///< 表情のウエイトが異なる.
+};
+
+/**
+ * 1つの差分.
+ */
+class VMD_DIFF_ITEM {
+public:
+	int type;						///< 差分の種類 (vmd_diff_xxx).
+	bool skin;						///< 表情のフレームの場合はtrue.
+	std::string name;				///< ボーン名(表情名).
+	int frameNo;					///< フレーム番号.
+	float error;					///< 差の大きさ (位置は距離、回転は角度(ラジアン)).
+
+	VMD_DIFF_ITEM() {
+		type    = vmd_diff_missing_a;
+		skin    = false;
+		name    = "";
+		frameNo = 0;
+		error   = 0.0f;
+	}
+};
+
+/**
+ * ボーン(表情)ごとの差分の集計.
+ */
+class VMD_DIFF_SUMMARY {
+public:
+	std::string name;				///< ボーン名(表情名).
+	bool skin;						///< 表情の場合はtrue.
+	int keyCountA;					///< Aのキー数.
+	int keyCountB;					///< Bのキー数.
+	int diffCount;					///< 差分の数.
+	float maxPosError;				///< 位置の最大誤差.
+	float maxRotError;				///< 回転の最大誤差 (ラジアン).
+	float maxWeightError;			///< ウエイトの最大誤差.
+
+	VMD_DIFF_SUMMARY() {
+		name      = "";
+		skin      = false;
+		keyCountA = keyCountB = 0;
+		diffCount = 0;
+		maxPosError = maxRotError = maxWeightError = 0.0f;
+	}
+};
+
+class CVMDDiff
+{
+private:
+	VMD_DIFF_OPTION m_option;
+	std::vector<VMD_DIFF_ITEM> m_items;				///< 差分 (名前、フレーム番号順).
+	std::vector<VMD_DIFF_SUMMARY> m_summary;		///< ボーン(表情)ごとの集計 (名前順).
+
+	/**
+	 * ボーン名ごとにフレームを分類 (フレーム番号順).
+	 */
+	void m_GroupFrames(const CVMDReader& reader, const bool skin, std::map< std::string, std::vector<int> >& retGroups);
+
+	/**
+	 * 同じ名前のボーン(表情)のキーを比較.
+	 */
+	void m_CompareKeys(const CVMDReader& a, const CVMDReader& b, const bool skin, const std::string& name, const std::vector<int>* pKeysA, const std::vector<int>* pKeysB);
+
+public:
+	CVMDDiff(const VMD_DIFF_OPTION& option = VMD_DIFF_OPTION());
+
+	/**
+	 * 2つのモーションを比較.
+	 * @return 差分がない場合はtrue.
+	 */
+	bool Compare(const CVMDReader& a, const CVMDReader& b);
+
+	const std::vector<VMD_DIFF_ITEM>& GetItems() const { return m_items; }
+	const std::vector<VMD_DIFF_SUMMARY>& GetSummary() const { return m_summary; }
+
+	/**
+	 * 差分をテキストで取得 (ボーンごとの集計と、先頭からmaxItems個の差分).
+	 */
+	std::string GetReport(const int maxItems = 100) const;
+};
+
+#endif
@@ -0,0 +1,181 @@
+﻿/**
+ *  @brief  頂点の座標変換 (ワールド変換、PMD出力用のスケールと座標系の変換をまとめて行う).
+ *  @date   2026.10.19
+ */
+
+#include "VertexTransform.h"
+
+#include <algorithm>
+#include <string.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define VERTEXTRANSFORM_USE_SSE2
+#endif
+
+/**
+ * vec3の配列から格納.
+ */
+void CVec3ArraySoA::Load(const std::vector<sxsdk::vec3>& src)
+{
+	const int count = src.size();
+	Resize(count);
+	for (int i = 0; i < count; i++) {
+		x[i] = src[i].x;
+		y[i] = src[i].y;
+		z[i] = src[i].z;
+	}
+}
+
+/**
+ * vec3の配列に出力.
+ */
+void CVec3ArraySoA::Store(std::vector<sxsdk::vec3>& dst) const
+{
+	const int count = Size();
+	dst.resize(count);
+	for (int i = 0; i < count; i++) {
+		dst[i] = sxsdk::vec3(x[i], y[i], z[i]);
+	}
+}
+
+/**
+ * 位置に行列を掛ける (v * m).
+ */
+void VertexTransform::TransformPositions(CVec3ArraySoA& positions, const sxsdk::mat4& m)
+{
+	const int count = positions.Size();
+	if (count <= 0) return;
+
+	// 射影成分を持つ行列は、wでの除算が必要になるためsxsdkの演算を使用.
+	if (m[0][3] != 0.0f || m[1][3] != 0.0f || m[2][3] != 0.0f || m[3][3] != 1.0f) {
+		for (int i = 0; i < count; i++) {
+			positions.Set(i, positions.Get(i) * m);
+		}
+		return;
+	}
+
+	float* px = &(positions.x[0]);
+	float* py = &(positions.y[0]);
+	float* pz = &(positions.z[0]);
+	int i = 0;
+
+#if defined(VERTEXTRANSFORM_USE_SSE2)
+	const __m128 m00 = _mm_set1_ps(m[0][0]), m01 = _mm_set1_ps(m[0][1]), m02 = _mm_set1_ps(m[0][2]);
+	const __m128 m10 = _mm_set1_ps(m[1][0]), m11 = _mm_set1_ps(m[1][1]), m12 = _mm_set1_ps(m[1][2]);
+	const __m128 m20 = _mm_set1_ps(m[2][0]), m21 = _mm_set1_ps(m[2][1]), m22 = _mm_set1_ps(m[2][2]);
+	const __m128 m30 = _mm_set1_ps(m[3][0]), m31 = _mm_set1_ps(m[3][1]), m32 = _mm_set1_ps(m[3][2]);
+	for (; i + 4 <= count; i += 4) {
+		const __m128 vx = _mm_loadu_ps(px + i);
+		const __m128 vy = _mm_loadu_ps(py + i);
+		const __m128 vz = _mm_loadu_ps(pz + i);
+		_mm_storeu_ps(px + i, _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, m00), _mm_mul_ps(vy, m10)), _mm_mul_ps(vz, m20)), m30));
+		_mm_storeu_ps(py + i, _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, m01), _mm_mul_ps(vy, m11)), _mm_mul_ps(vz, m21)), m31));
+		_mm_storeu_ps(pz + i, _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, m02), _mm_mul_ps(vy, m12)), _mm_mul_ps(vz, m22)), m32));
+	}
+#endif
+
+	for (; i < count; i++) {
+		const float x = px[i];
+		const float y = py[i];
+		const float z = pz[i];
+		px[i] = x * m[0][0] + y * m[1][0] + z * m[2][0] + m[3][0];
+		py[i] = x * m[0][1] + y * m[1][1] + z * m[2][1] + m[3][1];
+		pz[i] = x * m[0][2] + y * m[1][2] + z * m[2][2] + m[3][2];
+	}
+}
+
+/**
+ * スケールを掛け、Zを反転する.
+ * -(z * scale)とz * (-scale)は同じ値になるため、Zは符号を反転したスケールを掛ける.
+ */
+void VertexTransform::ScaleFlipZ(CVec3ArraySoA& vertices, const float scale)
+{
+	const int count = vertices.Size();
+	if (count <= 0) return;
+
+	float* px = &(vertices.x[0]);
+	float* py = &(vertices.y[0]);
+	float* pz = &(vertices.z[0]);
+	int i = 0;
+
+#if defined(VERTEXTRANSFORM_USE_SSE2)
+	const __m128 s  = _mm_set1_ps(scale);
+	const __m128 sz = _mm_set1_ps(-scale);
+	for (; i + 4 <= count; i += 4) {
+		_mm_storeu_ps(px + i, _mm_mul_ps(_mm_loadu_ps(px + i), s));
+		_mm_storeu_ps(py + i, _mm_mul_ps(_mm_loadu_ps(py + i), s));
+		_mm_storeu_ps(pz + i, _mm_mul_ps(_mm_loadu_ps(pz + i), sz));
+	}
+#endif
+
+	for (; i < count; i++) {
+		px[i] *= scale;
+		py[i] *= scale;
+		pz[i] *= -scale;
+	}
+}
+
+/**
+ * スケールを掛けてZを反転した位置 (または差分) を、頂点番号と合わせて16バイトのレコードとして出力.
+ */
+void VertexTransform::PackScaleFlipZ(const int* indices, const int indexStart, const CVec3ArraySoA& vertices, const CVec3ArraySoA* baseVertices, const float scale, unsigned char* dst)
+{
+	const int count = vertices.Size();
+	if (count <= 0 || !dst) return;
+
+	const float* px = &(vertices.x[0]);
+	const float* py = &(vertices.y[0]);
+	const float* pz = &(vertices.z[0]);
+	const float* bx = baseVertices ? &(baseVertices->x[0]) : NULL;
+	const float* by = baseVertices ? &(baseVertices->y[0]) : NULL;
+	const float* bz = baseVertices ? &(baseVertices->z[0]) : NULL;
+	int i = 0;
+
+#if defined(VERTEXTRANSFORM_USE_SSE2)
+	// 4頂点分の (番号, X, Y, Z) を転置して、4つのレコードとして書き込む.
+	const __m128 s  = _mm_set1_ps(scale);
+	const __m128 sz = _mm_set1_ps(-scale);
+	const __m128i seq = _mm_set_epi32(3, 2, 1, 0);
+	for (; i + 4 <= count; i += 4) {
+		__m128 vx = _mm_loadu_ps(px + i);
+		__m128 vy = _mm_loadu_ps(py + i);
+		__m128 vz = _mm_loadu_ps(pz + i);
+		if (bx) {
+			vx = _mm_sub_ps(vx, _mm_loadu_ps(bx + i));
+			vy = _mm_sub_ps(vy, _mm_loadu_ps(by + i));
+			vz = _mm_sub_ps(vz, _mm_loadu_ps(bz + i));
+		}
+		vx = _mm_mul_ps(vx, s);
+		vy = _mm_mul_ps(vy, s);
+		vz = _mm_mul_ps(vz, sz);
+
+		const __m128i vi = indices ? _mm_loadu_si128((const __m128i*)(indices + i)) : _mm_add_epi32(_mm_set1_epi32(indexStart + i), seq);
+		__m128 r0 = _mm_castsi128_ps(vi);
+		_MM_TRANSPOSE4_PS(r0, vx, vy, vz);
+
+		float* pDst = (float *)(dst + (size_t)i * 16);
+		_mm_storeu_ps(pDst,      r0);
+		_mm_storeu_ps(pDst + 4,  vx);
+		_mm_storeu_ps(pDst + 8,  vy);
+		_mm_storeu_ps(pDst + 12, vz);
+	}
+#endif
+
+	for (; i < count; i++) {
+		const int index = indices ? indices[i] : (indexStart + i);
+		float v[3];
+		if (bx) {
+			v[0] = (px[i] - bx[i]) * scale;
+			v[1] = (py[i] - by[i]) * scale;
+			v[2] = (pz[i] - bz[i]) * (-scale);
+		} else {
+			v[0] = px[i] * scale;
+			v[1] = py[i] * scale;
+			v[2] = pz[i] * (-scale);
+		}
+		unsigned char* pDst = dst + (size_t)i * 16;
+		memcpy(pDst, &index, 4);
+		memcpy(pDst + 4, v, 12);
+	}
+}
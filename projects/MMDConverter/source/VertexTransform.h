@@ -0,0 +1,84 @@
+﻿/**
+ *  @brief  頂点の座標変換 (ワールド変換、PMD出力用のスケールと座標系の変換をまとめて行う).
+ *  @date   2026.10.19
+ */
+
+#ifndef _VERTEXTRANSFORM_H
+#define _VERTEXTRANSFORM_H
+
+#include "GlobalHeader.h"
+
+#include <vector>
+
+/*
+	頂点をX/Y/Zごとの配列(SoA)に格納し、4頂点ずつSSE2で変換する (SSE2が使えない環境と、4頂点に満たない端数はスカラーで処理).
+	SSE2とスカラーの処理は同じ順番で演算を行うため、両者の結果は一致する.
+	変更前の頂点ごとのsxsdkの演算との差と処理時間は、tools/VertexTransformBenchで確認できる
+	(TransformPositionsはSDK内部の演算順に依存するため、丸め誤差の範囲の差を許容して確認する).
+*/
+
+/**
+ * X/Y/Zごとに格納したvec3の配列.
+ */
+class CVec3ArraySoA {
+public:
+	std::vector<float> x, y, z;
+
+	CVec3ArraySoA() { }
+
+	int Size() const { return (int)x.size(); }
+
+	void Resize(const int count) {
+		x.resize(count);
+		y.resize(count);
+		z.resize(count);
+	}
+
+	void Set(const int index, const sxsdk::vec3& v) {
+		x[index] = v.x;
+		y[index] = v.y;
+		z[index] = v.z;
+	}
+
+	sxsdk::vec3 Get(const int index) const {
+		return sxsdk::vec3(x[index], y[index], z[index]);
+	}
+
+	/**
+	 * vec3の配列から格納.
+	 */
+	void Load(const std::vector<sxsdk::vec3>& src);
+
+	/**
+	 * vec3の配列に出力.
+	 */
+	void Store(std::vector<sxsdk::vec3>& dst) const;
+};
+
+namespace VertexTransform {
+	/**
+	 * 位置に行列を掛ける (v * m).
+	 * アフィン変換の行列の場合は一括で変換し、それ以外の場合は頂点ごとにsxsdkの演算を使用する.
+	 */
+	void TransformPositions(CVec3ArraySoA& positions, const sxsdk::mat4& m);
+
+	/**
+	 * スケールを掛け、Zを反転する (Shade 3Dの右手座標系 -> PMDの左手座標系).
+	 * 法線の場合は、scaleに1.0を指定する.
+	 */
+	void ScaleFlipZ(CVec3ArraySoA& vertices, const float scale);
+
+	/**
+	 * スケールを掛けてZを反転した位置 (baseVerticesを指定した場合は差分) を、頂点番号と合わせて
+	 * 16バイトのレコード (int32の頂点番号、float x 3) として出力する (PMDの表情の頂点用).
+	 * @param[in]  indices       頂点ごとの頂点番号 (NULLの場合は、indexStartからの連番).
+	 * @param[in]  indexStart    indicesがNULLの場合の、先頭の頂点番号.
+	 * @param[in]  vertices      頂点位置.
+	 * @param[in]  baseVertices  差分の基準とする頂点位置 (NULLの場合は差分を取らない。verticesと同じ頂点数であること).
+	 * @param[in]  scale         スケール.
+	 * @param[out] dst           出力先 (頂点数 x 16バイト).
+	 */
+	void PackScaleFlipZ(const int* indices, const int indexStart, const CVec3ArraySoA& vertices, const CVec3ArraySoA* baseVertices, const float scale, unsigned char* dst);
+}
+
+#endif
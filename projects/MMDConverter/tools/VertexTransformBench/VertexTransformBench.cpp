@@ -0,0 +1,276 @@
+﻿/**
+ *  @brief  VertexTransformの一致確認と速度計測 (プラグインとは別にビルドするコンソールプログラム).
+ *  @date   2026.10.19
+ */
+
+/*
+	VertexTransformの各関数の結果を、変更前の頂点ごとのsxsdkの演算 (スカラー) と比較し、
+	それぞれの処理時間を表示する. 許容範囲を超える差がある場合は、終了コード1を返す.
+
+	ScaleFlipZ/PackScaleFlipZは、変更前と同じ乗算のためビット単位の一致を確認する.
+	TransformPositionsは、sxsdkのv * mを基準とする. SDK内部の演算順は公開されていないため、
+	演算順の違いによる丸め誤差として、4項の絶対値の和のTRANSFORM_MAX_ULP倍までの差を許容する
+	(4項の和はそれぞれ最大3回丸められるため、2つの演算順の差は和の6ulp以内に収まる).
+	ビット単位で一致しなかった数も表示する.
+
+	ビルド (Shade 3D Plugin SDKのincludeと、sourceのVertexTransform.cppを使用).
+	  Windows : cl /O2 /EHsc /DSXWINDOWS /I<SDK>\include /I..\..\source VertexTransformBench.cpp ..\..\source\VertexTransform.cpp
+	  Mac     : clang++ -O2 -std=c++11 -I<SDK>/include -I../../source VertexTransformBench.cpp ../../source/VertexTransform.cpp
+
+	実行.
+	  VertexTransformBench [頂点数] [繰り返し回数]
+*/
+
+#include "VertexTransform.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include <chrono>
+
+#define TRANSFORM_MAX_ULP		6		///< TransformPositionsで許容する差 (4項の絶対値の和のulp単位).
+
+namespace {
+	int g_failedCount = 0;		///< 許容範囲を超える差があった確認の数.
+
+	/**
+	 * 再現性のある乱数 (-range - +range).
+	 */
+	class CRandom {
+	private:
+		unsigned int m_state;
+
+	public:
+		CRandom(const unsigned int seed) : m_state(seed) { }
+
+		float Next(const float range) {
+			m_state = m_state * 1664525u + 1013904223u;
+			return ((float)(m_state >> 8) / (float)(1 << 24) * 2.0f - 1.0f) * range;
+		}
+	};
+
+	/**
+	 * 指定の頂点数の位置を作成.
+	 */
+	void MakeVertices(const int count, const unsigned int seed, std::vector<sxsdk::vec3>& retVertices) {
+		CRandom rnd(seed);
+		retVertices.resize(count);
+		for (int i = 0; i < count; i++) {
+			retVertices[i] = sxsdk::vec3(rnd.Next(1000.0f), rnd.Next(2000.0f), rnd.Next(500.0f));
+		}
+	}
+
+	/**
+	 * アフィン変換の行列を作成.
+	 */
+	sxsdk::mat4 MakeAffineMatrix() {
+		CRandom rnd(7);
+		sxsdk::mat4 m = sxsdk::mat4::identity;
+		for (int i = 0; i < 4; i++) {
+			for (int j = 0; j < 3; j++) m[i][j] = rnd.Next((i == 3) ? 100.0f : 2.0f);
+		}
+		return m;
+	}
+
+	/**
+	 * 2つの値がビット単位で一致するか.
+	 */
+	bool IsSameBits(const float v0, const float v1) {
+		return memcmp(&v0, &v1, sizeof(float)) == 0;
+	}
+
+	bool IsSameBits(const sxsdk::vec3& v0, const float x, const float y, const float z) {
+		return IsSameBits(v0.x, x) && IsSameBits(v0.y, y) && IsSameBits(v0.z, z);
+	}
+
+	/**
+	 * v * mの1成分について、VertexTransformの値が許容範囲内か.
+	 * 許容範囲は、4項の絶対値の和のTRANSFORM_MAX_ULP倍.
+	 */
+	bool IsWithinTransformTolerance(const float refValue, const float value, const sxsdk::vec3& v, const sxsdk::mat4& m, const int column) {
+		const float sumAbs = fabsf(v.x * m[0][column]) + fabsf(v.y * m[1][column]) + fabsf(v.z * m[2][column]) + fabsf(m[3][column]);
+		const float ulp    = nextafterf(sumAbs, HUGE_VALF) - sumAbs;
+		return fabsf(refValue - value) <= ulp * (float)TRANSFORM_MAX_ULP;
+	}
+
+	void ReportResult(const char* name, const int count, const int mismatchCount) {
+		if (mismatchCount == 0) return;
+		printf("  NG : %s (vertices %d) : %d mismatches\n", name, count, mismatchCount);
+		g_failedCount++;
+	}
+
+	//---------------------------------------------------------------------------------------.
+	// 変更前の処理 (頂点ごとのsxsdkの演算).
+	//---------------------------------------------------------------------------------------.
+
+	void RefTransformPositions(std::vector<sxsdk::vec3>& vertices, const sxsdk::mat4& m) {
+		for (size_t i = 0; i < vertices.size(); i++) {
+			vertices[i] = vertices[i] * m;
+		}
+	}
+
+	void RefScaleFlipZ(std::vector<sxsdk::vec3>& vertices, const float scale) {
+		for (size_t i = 0; i < vertices.size(); i++) {
+			sxsdk::vec3 v = vertices[i] * scale;
+			v.z = -v.z;
+			vertices[i] = v;
+		}
+	}
+
+	void RefPackScaleFlipZ(const int* indices, const int indexStart, const std::vector<sxsdk::vec3>& vertices, const std::vector<sxsdk::vec3>* baseVertices, const float scale, unsigned char* dst) {
+		for (size_t i = 0; i < vertices.size(); i++) {
+			const int index = indices ? indices[i] : (indexStart + (int)i);
+			sxsdk::vec3 v = baseVertices ? ((vertices[i] - (*baseVertices)[i]) * scale) : (vertices[i] * scale);
+			v.z = -v.z;
+			unsigned char* pDst = dst + i * 16;
+			memcpy(pDst, &index, 4);
+			memcpy(pDst + 4, &(v.x), 4);
+			memcpy(pDst + 8, &(v.y), 4);
+			memcpy(pDst + 12, &(v.z), 4);
+		}
+	}
+
+	//---------------------------------------------------------------------------------------.
+	// 一致確認.
+	//---------------------------------------------------------------------------------------.
+
+	void CheckTransformPositions(const int count) {
+		std::vector<sxsdk::vec3> vertices, ref;
+		MakeVertices(count, 1, vertices);
+		ref = vertices;
+		CVec3ArraySoA soa;
+		soa.Load(vertices);
+
+		const sxsdk::mat4 m = MakeAffineMatrix();
+		RefTransformPositions(ref, m);
+		VertexTransform::TransformPositions(soa, m);
+
+		int mismatchCount = 0;
+		int differentBitsCount = 0;
+		for (int i = 0; i < count; i++) {
+			if (!IsWithinTransformTolerance(ref[i].x, soa.x[i], vertices[i], m, 0) ||
+				!IsWithinTransformTolerance(ref[i].y, soa.y[i], vertices[i], m, 1) ||
+				!IsWithinTransformTolerance(ref[i].z, soa.z[i], vertices[i], m, 2)) mismatchCount++;
+			if (!IsSameBits(ref[i], soa.x[i], soa.y[i], soa.z[i])) differentBitsCount++;
+		}
+		ReportResult("TransformPositions", count, mismatchCount);
+		if (differentBitsCount > 0) printf("  info : TransformPositions (vertices %d) : %d not bit-identical to sxsdk v * m\n", count, differentBitsCount);
+	}
+
+	void CheckScaleFlipZ(const int count) {
+		std::vector<sxsdk::vec3> ref;
+		MakeVertices(count, 2, ref);
+		CVec3ArraySoA soa;
+		soa.Load(ref);
+
+		const float scale = 0.0125f;
+		RefScaleFlipZ(ref, scale);
+		VertexTransform::ScaleFlipZ(soa, scale);
+
+		int mismatchCount = 0;
+		for (int i = 0; i < count; i++) {
+			if (!IsSameBits(ref[i], soa.x[i], soa.y[i], soa.z[i])) mismatchCount++;
+		}
+		ReportResult("ScaleFlipZ", count, mismatchCount);
+	}
+
+	void CheckPackScaleFlipZ(const int count) {
+		std::vector<sxsdk::vec3> vertices, baseVertices;
+		MakeVertices(count, 3, vertices);
+		MakeVertices(count, 4, baseVertices);
+		CVec3ArraySoA soa, baseSoa;
+		soa.Load(vertices);
+		baseSoa.Load(baseVertices);
+
+		std::vector<int> indices(count + 1);
+		for (int i = 0; i < count; i++) indices[i] = (i * 7919) % 65536;
+
+		const float scale = 0.0125f;
+		std::vector<unsigned char> ref((size_t)count * 16 + 1), dst((size_t)count * 16 + 1);
+		for (int mode = 0; mode < 4; mode++) {
+			const int* pIndices = (mode & 1) ? &(indices[0]) : NULL;
+			const bool useBase  = (mode & 2) != 0;
+			RefPackScaleFlipZ(pIndices, 100, vertices, useBase ? &baseVertices : NULL, scale, &(ref[0]));
+			VertexTransform::PackScaleFlipZ(pIndices, 100, soa, useBase ? &baseSoa : NULL, scale, &(dst[0]));
+
+			int mismatchCount = 0;
+			for (int i = 0; i < count; i++) {
+				if (memcmp(&(ref[(size_t)i * 16]), &(dst[(size_t)i * 16]), 16) != 0) mismatchCount++;
+			}
+			const char* names[] = { "PackScaleFlipZ", "PackScaleFlipZ (indices)", "PackScaleFlipZ (base)", "PackScaleFlipZ (indices, base)" };
+			ReportResult(names[mode], count, mismatchCount);
+		}
+	}
+
+	//---------------------------------------------------------------------------------------.
+	// 速度計測.
+	//---------------------------------------------------------------------------------------.
+
+	template<class FUNC> double MeasureMSec(const int repeatCount, FUNC func) {
+		const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+		for (int i = 0; i < repeatCount; i++) func();
+		const std::chrono::steady_clock::time_point endTime = std::chrono::steady_clock::now();
+		return std::chrono::duration<double, std::milli>(endTime - startTime).count() / (double)repeatCount;
+	}
+
+	void PrintTime(const char* name, const double refMSec, const double msec) {
+		printf("  %-20s : sxsdk %8.3f ms, VertexTransform %8.3f ms (x%.2f)\n", name, refMSec, msec, (msec > 0.0) ? (refMSec / msec) : 0.0);
+	}
+
+	void Benchmark(const int count, const int repeatCount) {
+		std::vector<sxsdk::vec3> vertices, baseVertices;
+		MakeVertices(count, 5, vertices);
+		MakeVertices(count, 6, baseVertices);
+		CVec3ArraySoA soa, baseSoa;
+		soa.Load(vertices);
+		baseSoa.Load(baseVertices);
+		std::vector<unsigned char> dst((size_t)count * 16 + 1);
+
+		// 繰り返しても値が変わらないように、単位行列とスケール1.0を使用.
+		const sxsdk::mat4 m = sxsdk::mat4::identity;
+		const float scale = 1.0f;
+
+		printf("vertices %d, repeat %d\n", count, repeatCount);
+		{
+			const double refMSec = MeasureMSec(repeatCount, [&]() { RefTransformPositions(vertices, m); });
+			const double msec    = MeasureMSec(repeatCount, [&]() { VertexTransform::TransformPositions(soa, m); });
+			PrintTime("TransformPositions", refMSec, msec);
+		}
+		{
+			const double refMSec = MeasureMSec(repeatCount, [&]() { RefScaleFlipZ(vertices, scale); });
+			const double msec    = MeasureMSec(repeatCount, [&]() { VertexTransform::ScaleFlipZ(soa, scale); });
+			PrintTime("ScaleFlipZ", refMSec, msec);
+		}
+		{
+			const double refMSec = MeasureMSec(repeatCount, [&]() { RefPackScaleFlipZ(NULL, 0, vertices, &baseVertices, 0.0125f, &(dst[0])); });
+			const double msec    = MeasureMSec(repeatCount, [&]() { VertexTransform::PackScaleFlipZ(NULL, 0, soa, &baseSoa, 0.0125f, &(dst[0])); });
+			PrintTime("PackScaleFlipZ", refMSec, msec);
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const int count       = (argc > 1) ? atoi(argv[1]) : 200000;
+	const int repeatCount = (argc > 2) ? atoi(argv[2]) : 100;
+
+	// SSE2で処理する4頂点単位と、端数のスカラー処理の組み合わせを確認する.
+	printf("equivalence\n");
+	const int checkCounts[] = { 0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 1023, 65535 };
+	for (int i = 0; i < (int)(sizeof(checkCounts) / sizeof(int)); i++) {
+		CheckTransformPositions(checkCounts[i]);
+		CheckScaleFlipZ(checkCounts[i]);
+		CheckPackScaleFlipZ(checkCounts[i]);
+	}
+	if (g_failedCount == 0) {
+		printf("  OK : ScaleFlipZ/PackScaleFlipZ bit-identical, TransformPositions within %d ulp of sxsdk v * m\n", TRANSFORM_MAX_ULP);
+	} else {
+		printf("  NG\n");
+	}
+
+	if (count > 0 && repeatCount > 0) Benchmark(count, repeatCount);
+
+	return (g_failedCount == 0) ? 0 : 1;
+}